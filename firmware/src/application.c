@@ -36,7 +36,9 @@
  *  Version 2: Changes behaviour based on Pre-defined name (FSR and LIGHT) and uses Time to disable FSRs
  */
 
- #ifndef WISUN_NCP_ENABLE
+ #include "trace_config.h"
+ // The application trace is built whenever its group has a level, see trace_config.h
+ #if TRACE_CONFIG_MAIN != TRACE_CONFIG_NONE
  #undef EXCLUDE_TRACE
  #endif
  #include "mbed_config_app.h"
@@ -68,6 +70,7 @@
  #include "net_interface.h"
  #include "wisun_tasklet.h"
  #include "ns_trace.h"
+ #include "trace_config.h"
  #include "fhss_config.h"
  #include "randLIB.h"
  #include "ws_management_api.h"
@@ -84,6 +87,7 @@
  #include "6LoWPAN/ws/ws_bootstrap.h"
  
  #include "nsdynmemLIB.h"
+ #include "common_functions.h"
  
  #include "net_rpl.h"
  #include "RPL/rpl_protocol.h"
@@ -99,13 +103,27 @@
  #include "otsupport/otrtosapi.h"
  #include "openthread/ncp.h"
  #include "platform/system.h"
+ #include "ncp_transport.h"
  #elif defined(COAP_SERVICE_ENABLE)
  #include "coap_service_api.h"
  #include "eventOS_event_timer.h"
+ #else
+ #include "eventOS_event_timer.h"
  #endif
  
  #include "application.h"
  #include "ti_wisunfan_features.h"
+ #include "metrics_tlv.h"
+ #include "dhcpv6_client_stats.h"
+ #include "task_stats.h"
+ #include "low_power.h"
+ #include "heap_track.h"
+ #include "link_quality.h"
+ #include "rpl_events.h"
+ #include "channel_policy.h"
+ #include "telemetry.h"
+ #include "time_sync.h"
+ #include "node_state.h"
  
  #ifdef COAP_OAD_ENABLE
  #include "oad.h"
@@ -122,28 +140,97 @@
  #define APIMAC_SADDR_EXT_LEN 8
  
  #define TRACE_GROUP "main"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_MAIN
  
  #define SEND_BUF_SIZE 20
+ #define RECV_BUF_SIZE 32   // Fits the "Id:<slot>:bfio:<bfio>" MPL test payload plus a terminator
  #define multicast_addr_str "ff15::810a:64d1"
  #define UDP_PORT 1234
  #define UDP_PORT_ECHO              7        /* Echo Protocol - RFC 862 */
  #define MASTER_GROUP 0
  #define MY_GROUP 1
+
+ /* Light control multicast frame, fixed layout, multi byte fields big endian:
+  * version(1) type(1) state(1) reserved(1) group bitmap(4) sequence(2) timestamp ms(4) */
+ #define LIGHT_CTRL_VERSION          1
+ #define LIGHT_CTRL_TYPE_SET         1
+ #define LIGHT_CTRL_VERSION_OFFSET   0
+ #define LIGHT_CTRL_TYPE_OFFSET      1
+ #define LIGHT_CTRL_STATE_OFFSET     2
+ #define LIGHT_CTRL_GROUPS_OFFSET    4
+ #define LIGHT_CTRL_SEQ_OFFSET       8
+ #define LIGHT_CTRL_TIMESTAMP_OFFSET 10
+ #define LIGHT_CTRL_FRAME_LEN        14
+ // Bit of a group in the group bitmap, groups 0-31 can be addressed by one frame
+ #define LIGHT_CTRL_GROUP_BIT(group) (1UL << (group))
+
+ /* Plain UDP light control demo, runs when neither the CoAP service nor the network test is built */
+ #if !defined(WISUN_NCP_ENABLE) && !defined(NWK_TEST) && !defined(COAP_SERVICE_ENABLE)
+ #define UDP_DEMO_ENABLE
+ #define UDP_DEMO_UNICAST_EVT            1
+ #define UDP_DEMO_BCAST_EVT              2
+ #define UDP_DEMO_UNICAST_TIMER_ID       0
+ #define UDP_DEMO_BCAST_TIMER_ID         1
+ #define UDP_DEMO_DAO_POLL_MS            1000    // Unicast to the border router waits for the DAO
+ #define UDP_DEMO_BCAST_INTERVAL_MS      10000
+ #endif
  #define NOT_INITIALIZED -1
+
+ #ifdef WISUN_TEST_MPL_UDP
+ /* MPL latency histogram in ms. Latencies below 2 * MPL_LAT_SUB_COUNT get a bucket each, every
+  * power of two range above is split in MPL_LAT_SUB_COUNT buckets, so a bucket spans at most
+  * 1/8 of its values. The last bucket starts at 245760 ms and also takes anything larger. */
+ #define MPL_LAT_SUB_BITS            3
+ #define MPL_LAT_SUB_COUNT           (1U << MPL_LAT_SUB_BITS)
+ #define MPL_LAT_BUCKETS             128
+ /* Exported record, multi byte fields big endian:
+  * version(1) sub bits(1) count(4) min(4) max(4) mean(4) p50(4) p90(4) p99(4)
+  * bucket entries(1), then per non-empty bucket: index(1) count(2) */
+ #define MPL_LAT_RECORD_VERSION      1
+ #define MPL_LAT_SUMMARY_LEN         31
+ #define MPL_LAT_RECORD_MAX_LEN      (MPL_LAT_SUMMARY_LEN + 3 * MPL_LAT_BUCKETS)
+ #define METRICS_MPL_RECORD_MAX_LEN  MPL_LAT_RECORD_MAX_LEN
+ #else
+ #define METRICS_MPL_RECORD_MAX_LEN  0
+ #endif
+ #define METRICS_RECORD_MAX_LEN      (METRICS_MPL_RECORD_MAX_LEN > TASK_STATS_RECORD_MAX_LEN ? \
+                                      METRICS_MPL_RECORD_MAX_LEN : TASK_STATS_RECORD_MAX_LEN)
  
  #ifdef COAP_SERVICE_ENABLE
  #define COAP_JOIN_URI "join"
  #define COAP_LED_URI "led"
  #define COAP_RSSI_URI "rssi"
+ #define COAP_RSSI_MAX_LEN (1 + SIZE_OF_NEIGH_LIST * 18)    // Schema version, nested neighbor fields
  
  #define COAP_VENDOR_CLASS_URI "vendor_class"
 
  #ifdef FSR
  #define COAP_FSR_ACTIVATED_CLASS_URI "fsr_activated"
+ /* Payload direction(1) event time(8) trace ID(4), big endian. The event time is in ms since
+  * the Unix epoch, 0 without TIME_SYNC_ENABLE or before the clock is synchronized. The trace
+  * ID is random and follows the event through the server to the lights it turns on. */
+ #define FSR_EVENT_LEN 13
  #define PRESSURE_THRESHOLD 50
+ #define FSR_CHANNELS 4
+ #define FSR_TRIGGER_HOLDOFF_S 1             // A pressed sensor is reported again after this long
+ /* The ADCs are sampled from an eventOS timer, the node can sleep in between */
+ #ifndef FSR_SAMPLE_INTERVAL_MS
+ #define FSR_SAMPLE_INTERVAL_MS 100
+ #endif
+ #define FSR_SAMPLE_EVT 1
+ #define FSR_SAMPLE_TIMER_ID 0
  #elif defined(LIGHT)
  #define COAP_ACTIVATE_LIGHT_URI "activate_light"
  #define COAP_ACTIVATE_LIGHT_MANUAL_URI "activate_light_manual"
+ /* The activate_light response is sent once the light is on, a timer turns it off again.
+  * It carries the time the light went on(8) in ms since the Unix epoch and the trace ID(4)
+  * of the request, big endian. The time is 0 when the light was not turned on or the clock
+  * is not synchronized, without either the response is empty. */
+ #define LIGHT_ACK_LEN 12
+ #define LIGHT_OFF_EVT 1
+ #define LIGHT_OFF_TIMER_ID 0
+ // Query of activate_light with the trace ID of the event, 8 hex digits
+ #define COAP_ACTIVATE_LIGHT_TRACE "trace="
  #endif
  
  #define COAP_SENSOR_URI "fs"
@@ -151,6 +238,36 @@
  #define COAP_LIGHT_URI "light"
  
  #define COAP_TEST_METRICS_URI "metrics"
+ // Schema version, the integer fields and the records, see metrics_tlv.h
+ #define COAP_TEST_METRICS_INTS (6 + METRICS_TLV_JOIN_TIME_COUNT + METRICS_TLV_MAC_DEBUG_COUNT + \
+                                 METRICS_TLV_MAC_PERF_COUNT)
+ #define COAP_TEST_METRICS_MAX_LEN (1 + COAP_TEST_METRICS_INTS * METRICS_TLV_UINT_MAX_LEN + \
+                                    4 + METRICS_MPL_RECORD_MAX_LEN + 3 + TASK_STATS_RECORD_MAX_LEN)
+ #define COAP_DHCP_STATS_URI "dhcp"
+ #define COAP_TASK_STATS_URI "tasks"
+ #ifdef LOW_POWER_ENABLE
+ #define COAP_POWER_URI "power"
+ #endif
+ #ifdef HEAP_TRACK_ENABLE
+ #define COAP_HEAP_TRACK_URI "heap"
+ #endif
+ #ifdef LINK_QUALITY_ENABLE
+ #define COAP_LINK_QUALITY_URI "linkq"
+ #endif
+ #ifdef RPL_EVENTS_ENABLE
+ #define COAP_RPL_EVENTS_URI "rplev"
+ #define COAP_RPL_EVENTS_SINCE "since="
+ #endif
+ #ifdef CHANNEL_POLICY_ENABLE
+ #define COAP_CHANNEL_POLICY_URI "chpol"
+ #endif
+ #ifdef TELEMETRY_ENABLE
+ #define COAP_TELEMETRY_URI "telem"
+ #endif
+ #ifdef TIME_SYNC_ENABLE
+ #define COAP_TIME_SYNC_URI "tsync"
+ #endif
+ #define COAP_MPL_LATENCY_URI "mpllat"
  #ifdef COAP_PANID_LIST
  #define COAP_PANID_LIST_ALLOW_URI "panid/allow"
  #define COAP_PANID_LIST_DENY_URI "panid/deny"
@@ -202,18 +319,21 @@
  static bool _configured = false;
  
  static int8_t socket_id;
- static uint8_t send_buf[SEND_BUF_SIZE] = {0};
+ static uint8_t light_ctrl_buf[LIGHT_CTRL_FRAME_LEN] = {0};
  static uint8_t send_buf_unicast[SEND_BUF_SIZE] = {0};
  
- static uint8_t recv_buffer[SEND_BUF_SIZE] = {0};
+ static uint8_t recv_buffer[RECV_BUF_SIZE] = {0};
  static uint8_t multi_cast_addr[16] = {0};
  static uint8_t uni_cast_addr[16] = {0};
  static ns_address_t send_addr = {0};
  static ns_address_t send_addr_unicast = {0};
- extern bool sent_dao;
- extern uint8_t root_unicast_addr[16];
  static bool bcast_send = false;
  static bool unicast_send = true;
+ #ifdef UDP_DEMO_ENABLE
+ static int8_t udp_demo_tasklet_id = -1;
+ static void udp_demo_tasklet_start(void);
+ static void handle_message(const uint8_t *msg, int16_t len);
+ #endif
  
  #ifdef NWK_TEST
  uint32_t ticks_before_joining = 0;
@@ -227,18 +347,14 @@
  #ifdef LIGHT
  static bool manual_light_mode = false;
  static bool light_activated = false;
+ static int8_t light_tasklet_id = -1;
  #endif
  
  #ifdef FSR
- static bool adc_0_activated = false;
- static bool adc_1_activated = false;
- static bool adc_2_activated = false;
- static bool adc_3_activated = false;
- static time_t currentTime;
- static time_t adc0Time;
- static time_t adc1Time;
- static time_t adc2Time;
- static time_t adc3Time;
+ static ADC_Handle fsr_adc[FSR_CHANNELS];
+ static bool fsr_activated[FSR_CHANNELS] = {false};
+ static time_t fsr_trigger_time[FSR_CHANNELS] = {0};
+ static int8_t fsr_tasklet_id = -1;
  #endif
 
  #ifdef COAP_PANID_LIST
@@ -262,10 +378,22 @@
  
  #ifdef WISUN_TEST_METRICS
  static uint32_t num_pkts = 0;
- static void handle_message(char* msg);
  
  #ifdef WISUN_TEST_MPL_UDP
- static void get_txFrameInfo(char* msg, uint16_t* txIdx, uint32_t* txbfio);
+ typedef struct {
+     uint32_t count;
+     uint32_t min;
+     uint32_t max;
+     uint64_t sum;
+     uint16_t buckets[MPL_LAT_BUCKETS];   // Saturate at 0xFFFF
+ } mpl_latency_hist_t;
+
+ static mpl_latency_hist_t mpl_latency_hist = {.min = UINT32_MAX};
+
+ static bool get_txFrameInfo(char* msg, uint16_t* txIdx, uint32_t* txbfio);
+ static void mpl_latency_hist_add(uint32_t latency);
+ uint16_t mpl_latency_hist_write(uint8_t *buf);
+ void mpl_latency_hist_reset(void);
  extern void timac_GetBC_Slot_BFIO(uint16_t *slot, uint32_t *bfio);
  #endif
  
@@ -358,21 +486,55 @@
                   uint16_t source_port, sn_coap_hdr_s *request_ptr);
  static int coap_handle_activate_light_manual(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ static void light_tasklet_start(void);
  // coap client
 #elif defined(FSR)
  static void coap_fsr_trigger_input_send_request(uint8_t direction);
+ static void fsr_sample_tasklet_start(void);
 #endif
 
  #ifdef WISUN_TEST_METRICS
  static int coap_recv_cb_tstmetrics(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr);
  #endif
+ #ifdef WISUN_TEST_MPL_UDP
+ static int coap_recv_cb_mpl_latency(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
  #endif
- 
- #ifdef WISUN_TEST_METRICS
- void get_test_metrics(test_metrics_s *test_metrics);
+ static int coap_recv_cb_dhcp_stats(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ static int coap_recv_cb_task_stats(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #ifdef LOW_POWER_ENABLE
+ static int coap_recv_cb_power(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
  #endif
- 
+ #ifdef HEAP_TRACK_ENABLE
+ static int coap_recv_cb_heap_track(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #ifdef LINK_QUALITY_ENABLE
+ static int coap_recv_cb_link_quality(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #ifdef RPL_EVENTS_ENABLE
+ static int coap_recv_cb_rpl_events(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #ifdef CHANNEL_POLICY_ENABLE
+ static int coap_recv_cb_channel_policy(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #ifdef TELEMETRY_ENABLE
+ static int coap_recv_cb_telemetry(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #ifdef TIME_SYNC_ENABLE
+ static int coap_recv_cb_time_sync(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr);
+ #endif
+ #endif
+  
  /******************************************************************************
  Function definitions
   *****************************************************************************/
@@ -443,11 +605,9 @@
  void socket_callback(void *cb)
  {
      socket_callback_t *sock_cb = (socket_callback_t *) cb;
- 
- #ifdef WISUN_TEST_METRICS
      int16_t len;
      ns_address_t source_addr;
- #endif
+
      tr_debug("socket_callback() sock=%d, event=0x%x, interface=%d, data len=%d",
               sock_cb->socket_id, sock_cb->event_type, sock_cb->interface_id, sock_cb->d_len);
  
@@ -455,22 +615,32 @@
          case SOCKET_DATA:
              tr_info("socket_callback: SOCKET_DATA, sock=%d, bytes=%d", sock_cb->socket_id, sock_cb->d_len);
  
+             // Data is read as soon as it arrives, nothing polls the socket
+             len = socket_recvfrom(socket_id, recv_buffer, sizeof(recv_buffer) - 1, 0, &source_addr);
+ #ifdef UDP_DEMO_ENABLE
+             if (len > 0) {
+                 handle_message(recv_buffer, len);
+             }
+ #endif
  #ifdef WISUN_TEST_METRICS
  //            tr_mpl("socket_callback: SOCKET_DATA, sock=%d, bytes=%d", sock_cb->socket_id, sock_cb->d_len);
  
-             /* Convert string addr to ipaddr array */
-             len = socket_recvfrom(socket_id, recv_buffer, sizeof(recv_buffer), 0, &source_addr);
              if(len > 0)
                {
                    num_pkts++;
  #ifdef WISUN_TEST_MPL_UDP
                    uint16_t slotIdx_tx, slotIdx_rx;
                    uint32_t bfio_tx, bfio_rx, latency, macBcInterval;
-                   get_txFrameInfo ((char*)recv_buffer, &slotIdx_tx, &bfio_tx);
-                   timac_GetBC_Slot_BFIO(&slotIdx_rx, &bfio_rx);
-                   MAP_FHPIB_get(FHPIB_BC_INTERVAL, &macBcInterval);
-                   latency = (bfio_rx - bfio_tx) + (slotIdx_rx - slotIdx_tx) * macBcInterval;
-                   tr_mpl("Latency: %d L:%d B1:%d S1:%d B2:%d S2:%d BI:%d\r\n", latency, len, bfio_tx, slotIdx_tx, bfio_rx, slotIdx_rx, macBcInterval);
+                   recv_buffer[len] = '\0';
+                   if (get_txFrameInfo((char*)recv_buffer, &slotIdx_tx, &bfio_tx))
+                   {
+                       timac_GetBC_Slot_BFIO(&slotIdx_rx, &bfio_rx);
+                       MAP_FHPIB_get(FHPIB_BC_INTERVAL, &macBcInterval);
+                       // Slot index wraps at 16 bits
+                       latency = (bfio_rx - bfio_tx) + (uint16_t)(slotIdx_rx - slotIdx_tx) * macBcInterval;
+                       mpl_latency_hist_add(latency);
+                       tr_mpl("Latency: %d L:%d B1:%d S1:%d B2:%d S2:%d BI:%d\r\n", latency, len, bfio_tx, slotIdx_tx, bfio_rx, slotIdx_rx, macBcInterval);
+                   }
  #else
                    tr_mpl("Recv[%d]: %s, Pkts:%d", len, recv_buffer, num_pkts);
  #endif
@@ -479,6 +649,10 @@
                {
                    tr_mpl("Recv error %x", len);
                }
+ #else
+             if (len < 0 && NS_EWOULDBLOCK != len) {
+                 tr_info("Recv error %x", len);
+             }
  #endif
              break;
          case SOCKET_CONNECT_DONE:
@@ -733,65 +907,289 @@
  }
  #endif //WISUN_NCP_ENABLE, NWK_TEST
  
- 
+ #ifdef UDP_DEMO_ENABLE
  /*!
-  * Process received message
+  * Write a light control frame for the groups in the bitmap, returns the frame length
   */
- static void handle_message(char* msg) {
-     uint8_t state=0;
-     uint16_t group=0xffff;
- 
-     if (strstr(msg, "t:lights;") == NULL) {
-        return;
+ static uint16_t light_ctrl_frame_write(uint8_t *buf, uint32_t groups, uint8_t state)
+ {
+     static bool seq_init = false;
+     static uint16_t seq;
+
+     // Random start so receivers do not take a rebooted sender's first frame as a repeat
+     if (!seq_init) {
+         seq = randLIB_get_16bit();
+         seq_init = true;
      }
- 
-     if (strstr(msg, "s:1;") != NULL) {
-         state = 1;
+
+     buf[LIGHT_CTRL_VERSION_OFFSET] = LIGHT_CTRL_VERSION;
+     buf[LIGHT_CTRL_TYPE_OFFSET] = LIGHT_CTRL_TYPE_SET;
+     buf[LIGHT_CTRL_STATE_OFFSET] = state;
+     buf[LIGHT_CTRL_STATE_OFFSET + 1] = 0;
+     common_write_32_bit(groups, buf + LIGHT_CTRL_GROUPS_OFFSET);
+     common_write_16_bit(seq++, buf + LIGHT_CTRL_SEQ_OFFSET);
+     common_write_32_bit((uint32_t)(((uint64_t)ClockP_getSystemTicks() * ClockP_getSystemTickPeriod()) / 1000),
+                         buf + LIGHT_CTRL_TIMESTAMP_OFFSET);
+     return LIGHT_CTRL_FRAME_LEN;
+ }
+
+ /*!
+  * Process received light control frame, fields are read in place from the receive buffer
+  */
+ static void handle_message(const uint8_t *msg, int16_t len) {
+     static bool last_seq_valid = false;
+     static uint16_t last_seq;
+
+     // Longer frames are accepted so later versions can append fields
+     if (len < LIGHT_CTRL_FRAME_LEN ||
+         msg[LIGHT_CTRL_VERSION_OFFSET] != LIGHT_CTRL_VERSION ||
+         msg[LIGHT_CTRL_TYPE_OFFSET] != LIGHT_CTRL_TYPE_SET) {
+        return;
      }
-     else if (strstr(msg, "s:0;") != NULL) {
-         state = 0;
+
+     // A repeated frame is only applied once
+     uint16_t seq = common_read_16_bit(msg + LIGHT_CTRL_SEQ_OFFSET);
+     if (last_seq_valid && seq == last_seq) {
+         return;
      }
- 
+     last_seq_valid = true;
+     last_seq = seq;
+
+     uint32_t groups = common_read_32_bit(msg + LIGHT_CTRL_GROUPS_OFFSET);
+     uint8_t state = msg[LIGHT_CTRL_STATE_OFFSET] ? 1 : 0;
+     tr_debug("Light control seq:%d groups:0x%x state:%d sent:%d ms", seq, (unsigned int)groups, state,
+              (int)common_read_32_bit(msg + LIGHT_CTRL_TIMESTAMP_OFFSET));
+
      // 0==master, 1==default group
-     char *msg_ptr = strstr(msg, "g:");
-     if (msg_ptr) {
-         char *ptr;
-         group = strtol(msg_ptr, &ptr, 10);
-     }
- 
-     // in this example we only use one group
-     if (group==MASTER_GROUP || group==MY_GROUP) {
+     if (groups & (LIGHT_CTRL_GROUP_BIT(MASTER_GROUP) | LIGHT_CTRL_GROUP_BIT(MY_GROUP))) {
          GPIO_write(CONFIG_GPIO_RLED, state);
      }
  }
+
+ /*!
+  * UDP demo sends: the unicast to the border router once the DAO is out, and the
+  * multicast light toggle every UDP_DEMO_BCAST_INTERVAL_MS while bcast_send is set
+  */
+ static void udp_demo_tasklet(arm_event_s *event)
+ {
+     static bool prev_bcast_send = false;
+     static bool light_state = false;
+     int16_t ret;
+
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             udp_demo_tasklet_id = event->receiver;
+             eventOS_event_timer_request(UDP_DEMO_UNICAST_TIMER_ID, UDP_DEMO_UNICAST_EVT,
+                                         udp_demo_tasklet_id, UDP_DEMO_DAO_POLL_MS);
+             eventOS_event_timer_request(UDP_DEMO_BCAST_TIMER_ID, UDP_DEMO_BCAST_EVT,
+                                         udp_demo_tasklet_id, UDP_DEMO_BCAST_INTERVAL_MS);
+             break;
+         case UDP_DEMO_UNICAST_EVT:
+             if (!unicast_send) {
+                 break;
+             }
+             if (sent_dao == true) //&& !addr_ipv6_equal((const uint8_t*)root_unicast_addr, ns_in6addr_any))
+             {
+                 memcpy(send_addr_unicast.address, root_unicast_addr, 16);
+                 tr_info("Sending unicast packet from Router to Border Router");
+                 ret = socket_sendto(socket_id, &send_addr_unicast, send_buf_unicast, sizeof(send_buf_unicast));
+                 tr_info("Sendto returned: %d", ret);
+                 unicast_send = false;
+                 break;
+             }
+             eventOS_event_timer_request(UDP_DEMO_UNICAST_TIMER_ID, UDP_DEMO_UNICAST_EVT,
+                                         udp_demo_tasklet_id, UDP_DEMO_DAO_POLL_MS);
+             break;
+         case UDP_DEMO_BCAST_EVT:
+             if (prev_bcast_send != bcast_send) {
+                 tr_info(bcast_send ? "bcast_send enabled, sending light toggle every 10s" : "bcast_send disabled");
+             }
+             prev_bcast_send = bcast_send;
+
+             if (bcast_send) {
+                 /* toggle light state */
+                 light_state ^= 1;
+                 /* Multicast light control frame, see LIGHT_CTRL_* for the layout */
+                 uint16_t frame_len = light_ctrl_frame_write(light_ctrl_buf, LIGHT_CTRL_GROUP_BIT(MY_GROUP), light_state);
+                 tr_debug("Sending lightcontrol message: group:%d state:%d", MY_GROUP, light_state);
+                 tr_info("Sending multicast packet");
+                 ret = socket_sendto(socket_id, &send_addr, light_ctrl_buf, frame_len);
+                 tr_info("Sendto returned: %d", ret);
+
+                 GPIO_toggle(CONFIG_GPIO_GLED);
+             }
+             eventOS_event_timer_request(UDP_DEMO_BCAST_TIMER_ID, UDP_DEMO_BCAST_EVT,
+                                         udp_demo_tasklet_id, UDP_DEMO_BCAST_INTERVAL_MS);
+             break;
+         default:
+             break;
+     }
+ }
+
+ static void udp_demo_tasklet_start(void)
+ {
+     eventOS_event_handler_create(&udp_demo_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+ }
+ #endif // UDP_DEMO_ENABLE
  
  #ifdef WISUN_TEST_MPL_UDP
  /*!
-  * Retrieve Idx and BFIO from received message
+  * Retrieve Idx and BFIO from a NUL terminated received message,
+  * returns false when the payload does not carry them
   */
- void get_txFrameInfo(char* msg, uint16_t* txIdx, uint32_t* txbfio) {
+ static bool get_txFrameInfo(char* msg, uint16_t* txIdx, uint32_t* txbfio) {
      char *txinfo;
+     char *ptr;
  
      // Format from Border Router for the payload is as follows
      // snprintf(send_buf, sizeof(send_buf), "Id:%d:bfio:%u", slotIdx,bfio);
+     *txIdx = 0;
+     *txbfio = 0;
      txinfo = strstr(msg, "Id:");
      if (txinfo == NULL)
      {
          // Idx and BFIO for tx is not in the message payload
-         *txIdx = 0;
-         *txbfio = 0;
+         return false;
      }
-     else
-     {
-         char *ptr;
-         // Retrieve slot ID index
-         *txIdx = strtol(txinfo+3, &ptr, 10);
+     // Retrieve slot ID index
+     *txIdx = strtoul(txinfo+3, &ptr, 10);
  
-         // Retrieve BFIO
-         txinfo = strstr(ptr, "bfio:");
-         *txbfio = strtol(txinfo+5, &ptr, 10);
+     // Retrieve BFIO
+     txinfo = strstr(ptr, "bfio:");
+     if (txinfo == NULL)
+     {
+         return false;
+     }
+     *txbfio = strtoul(txinfo+5, &ptr, 10);
+     return true;
+ }
+
+ /*!
+  * Histogram bucket of a latency
+  */
+ static uint8_t mpl_latency_bucket(uint32_t latency)
+ {
+     uint32_t idx;
+     uint8_t shift = 0;
+
+     if (latency < 2 * MPL_LAT_SUB_COUNT) {
+         return latency;
+     }
+     while ((latency >> shift) >= 2 * MPL_LAT_SUB_COUNT) {
+         shift++;
+     }
+     idx = (shift + 1) * MPL_LAT_SUB_COUNT + (latency >> shift) - MPL_LAT_SUB_COUNT;
+     return idx < MPL_LAT_BUCKETS ? idx : MPL_LAT_BUCKETS - 1;
+ }
+
+ /*!
+  * Highest latency counted in a bucket
+  */
+ static uint32_t mpl_latency_bucket_high(uint8_t idx)
+ {
+     uint8_t shift;
+
+     if (idx < 2 * MPL_LAT_SUB_COUNT) {
+         return idx;
      }
-     return;
+     shift = idx / MPL_LAT_SUB_COUNT - 1;
+     return (((uint32_t)(idx % MPL_LAT_SUB_COUNT) + MPL_LAT_SUB_COUNT + 1) << shift) - 1;
+ }
+
+ static void mpl_latency_hist_add(uint32_t latency)
+ {
+     mpl_latency_hist_t *hist = &mpl_latency_hist;
+     uint8_t idx = mpl_latency_bucket(latency);
+
+     hist->count++;
+     hist->sum += latency;
+     if (latency < hist->min) {
+         hist->min = latency;
+     }
+     if (latency > hist->max) {
+         hist->max = latency;
+     }
+     if (hist->buckets[idx] < UINT16_MAX) {
+         hist->buckets[idx]++;
+     }
+ }
+
+ /*!
+  * Estimate a percentile as the top of the bucket holding it, clamped to the
+  * recorded min and max. Ranks are taken over the bucket counts so that a
+  * saturated bucket does not push every percentile to the max.
+  */
+ static uint32_t mpl_latency_percentile(uint8_t percent)
+ {
+     const mpl_latency_hist_t *hist = &mpl_latency_hist;
+     uint32_t total = 0;
+     uint32_t seen = 0;
+     uint32_t rank;
+     uint32_t value;
+     uint8_t idx;
+
+     for (idx = 0; idx < MPL_LAT_BUCKETS; idx++) {
+         total += hist->buckets[idx];
+     }
+     if (!total) {
+         return 0;
+     }
+     rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+     for (idx = 0; idx < MPL_LAT_BUCKETS; idx++) {
+         seen += hist->buckets[idx];
+         if (seen >= rank) {
+             break;
+         }
+     }
+     value = mpl_latency_bucket_high(idx < MPL_LAT_BUCKETS ? idx : MPL_LAT_BUCKETS - 1);
+     if (value > hist->max) {
+         value = hist->max;
+     }
+     if (value < hist->min) {
+         value = hist->min;
+     }
+     return value;
+ }
+
+ /*!
+  * Serialize the histogram as described at MPL_LAT_RECORD_VERSION, buf must
+  * hold MPL_LAT_RECORD_MAX_LEN bytes. Returns the record length.
+  */
+ uint16_t mpl_latency_hist_write(uint8_t *buf)
+ {
+     const mpl_latency_hist_t *hist = &mpl_latency_hist;
+     uint8_t *ptr = buf;
+     uint8_t *entries;
+     uint8_t idx;
+
+     *ptr++ = MPL_LAT_RECORD_VERSION;
+     *ptr++ = MPL_LAT_SUB_BITS;
+     ptr = common_write_32_bit(hist->count, ptr);
+     ptr = common_write_32_bit(hist->count ? hist->min : 0, ptr);
+     ptr = common_write_32_bit(hist->max, ptr);
+     ptr = common_write_32_bit(hist->count ? (uint32_t)(hist->sum / hist->count) : 0, ptr);
+     ptr = common_write_32_bit(mpl_latency_percentile(50), ptr);
+     ptr = common_write_32_bit(mpl_latency_percentile(90), ptr);
+     ptr = common_write_32_bit(mpl_latency_percentile(99), ptr);
+     entries = ptr++;
+     *entries = 0;
+     for (idx = 0; idx < MPL_LAT_BUCKETS; idx++) {
+         if (hist->buckets[idx]) {
+             *ptr++ = idx;
+             ptr = common_write_16_bit(hist->buckets[idx], ptr);
+             (*entries)++;
+         }
+     }
+     return ptr - buf;
+ }
+
+ /*!
+  * Clear the MPL latency histogram, e.g. before the next test run
+  */
+ void mpl_latency_hist_reset(void)
+ {
+     memset(&mpl_latency_hist, 0, sizeof(mpl_latency_hist));
+     mpl_latency_hist.min = UINT32_MAX;
  }
  #endif
  
@@ -888,54 +1286,392 @@
  
  
  /*!
-  * Callback for processing received coap message
+  * Callback for processing received coap message
+  */
+ static int coap_recv_cb(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+ 
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         // Send LED states as [RLED_STATE, GLED_STATE] in CoAP response payload
+         led_state[COAP_RLED_ID] = GPIO_read(CONFIG_GPIO_RLED);
+         led_state[COAP_GLED_ID] = GPIO_read(CONFIG_GPIO_GLED);
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
+                                    COAP_CT_TEXT_PLAIN, (uint8_t *) &led_state, sizeof(led_state));
+     }
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST ||
+              request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT)
+     {
+         bool success = true;
+         if (request_ptr->payload_len != 2 || request_ptr->payload_ptr == NULL)
+         {
+             // Invalid payload length
+             success = false;
+         }
+         else if ((request_ptr->payload_ptr[0] != 0 && request_ptr->payload_ptr[0] != 1) ||
+                  (request_ptr->payload_ptr[1] != 0 && request_ptr->payload_ptr[1] != 1))
+         {
+             // Invalid payload contents
+             success = false;
+         }
+         else
+         {
+             // Set LED state from payload: [target LED, LED state]
+             if (request_ptr->payload_ptr[0] == COAP_RLED_ID)
+             {
+                 GPIO_write(CONFIG_GPIO_RLED, request_ptr->payload_ptr[1]);
+             }
+             else if (request_ptr->payload_ptr[0] == COAP_GLED_ID)
+             {
+                 GPIO_write(CONFIG_GPIO_GLED, request_ptr->payload_ptr[1]);
+             }
+             else
+             {
+                 success = false;
+             }
+         }
+ 
+         if (success)
+         {
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                        COAP_CT_TEXT_PLAIN, NULL, 0);
+         }
+         else
+         {
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_BAD_REQUEST,
+                                        COAP_CT_TEXT_PLAIN, NULL, 0);
+         }
+     }
+     else
+     {
+         // Delete resource not supported
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ 
+ #ifdef WISUN_TEST_METRICS
+ /*!
+  * Callback for processing received coap message for Test metrics
+  */
+ static int coap_recv_cb_tstmetrics(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         /* Fields of metrics_tlv.h: the test metrics, the MPL latency record
+          * (WISUN_TEST_MPL_UDP builds) and the task stack and CPU record */
+         static uint8_t metrics_buf[COAP_TEST_METRICS_MAX_LEN];
+         static uint8_t record_buf[METRICS_RECORD_MAX_LEN];
+         static test_metrics_s test_metrics;
+         metrics_tlv_t tlv;
+         uint16_t len;
+
+         get_test_metrics(&test_metrics);
+         metrics_tlv_start(&tlv, metrics_buf, sizeof(metrics_buf));
+         metrics_tlv_uint(&tlv, METRICS_TLV_REVISION, test_metrics.revision);
+         metrics_tlv_members(&tlv, metrics_tlv_join_time, METRICS_TLV_JOIN_TIME_COUNT,
+                             &test_metrics.join_time, sizeof(test_metrics.join_time));
+         metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_SIZE, test_metrics.heap_debug.heap_sector_size);
+         metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_ALLOCATED, test_metrics.heap_debug.heap_sector_allocated_bytes);
+         metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_ALLOCATED_MAX, test_metrics.heap_debug.heap_sector_allocated_bytes_max);
+         metrics_tlv_members(&tlv, metrics_tlv_mac_debug, METRICS_TLV_MAC_DEBUG_COUNT,
+                             &test_metrics.mac_debug, sizeof(test_metrics.mac_debug));
+         metrics_tlv_members(&tlv, metrics_tlv_mac_perf, METRICS_TLV_MAC_PERF_COUNT,
+                             &test_metrics.mac_perf_data, sizeof(test_metrics.mac_perf_data));
+         metrics_tlv_uint(&tlv, METRICS_TLV_UDP_RECEIVED, test_metrics.udpPktCnt);
+         metrics_tlv_uint(&tlv, METRICS_TLV_RANK, test_metrics.current_rank);
+ #ifdef WISUN_TEST_MPL_UDP
+         len = mpl_latency_hist_write(record_buf);
+         metrics_tlv_bytes(&tlv, METRICS_TLV_MPL_LATENCY, record_buf, len);
+ #endif
+         len = task_stats_write(record_buf, sizeof(record_buf));
+         metrics_tlv_bytes(&tlv, METRICS_TLV_TASK_STATS, record_buf, len);
+         len = metrics_tlv_end(&tlv);
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR,
+                                    COAP_CT_TEXT_PLAIN, metrics_buf, len);
+     }
+     else
+     {
+         // Post, Put, and Delete resource are not supported for now
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+
+ #ifdef WISUN_TEST_MPL_UDP
+ /*!
+  * Callback for processing received coap message for the MPL latency histogram,
+  * GET reads the record and PUT or POST resets the histogram
+  */
+ static int coap_recv_cb_mpl_latency(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         static uint8_t mpl_latency_buf[MPL_LAT_RECORD_MAX_LEN];
+         uint16_t len = mpl_latency_hist_write(mpl_latency_buf);
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
+                                    COAP_CT_TEXT_PLAIN, mpl_latency_buf, len);
+     }
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT ||
+              request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST)
+     {
+         mpl_latency_hist_reset();
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+ 
+ /*!
+  * Callback for processing received coap message for DHCPv6 renew timing stats
+  */
+ static int coap_recv_cb_dhcp_stats(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         uint8_t dhcp_stats[DHCP_CLIENT_STATS_LEN];
+         uint16_t len = dhcp_client_stats_write(interface_id, dhcp_stats, sizeof(dhcp_stats));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, dhcp_stats, len);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+
+ /*!
+  * Callback for the stack high water mark and CPU load of every task
+  */
+ static int coap_recv_cb_task_stats(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         uint8_t task_stats[TASK_STATS_RECORD_MAX_LEN];
+         uint16_t len = task_stats_write(task_stats, sizeof(task_stats));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, task_stats, len);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+
+ #ifdef LOW_POWER_ENABLE
+ /*!
+  * Callback for the duty cycle and charge estimate. GET reads it,
+  * PUT/POST with a one byte payload turns trace output (and with it
+  * the standby block) on (1) or off (0).
+  */
+ static int coap_recv_cb_power(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         uint8_t power_stats[LOW_POWER_RECORD_LEN];
+         uint16_t len = low_power_stats_write(power_stats, sizeof(power_stats));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, power_stats, len);
+     }
+     else if ((request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT ||
+               request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST) &&
+              request_ptr->payload_len == 1 && request_ptr->payload_ptr[0] <= 1)
+     {
+         // Respond first, with trace on the node stays awake from here
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+         low_power_trace_set(request_ptr->payload_ptr[0]);
+     }
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT ||
+              request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST)
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_BAD_REQUEST,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif // LOW_POWER_ENABLE
+
+ #ifdef HEAP_TRACK_ENABLE
+ /*!
+  * Callback for the heap fragmentation and the live bytes of each allocation site
+  */
+ static int coap_recv_cb_heap_track(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         static uint8_t heap_track_buf[HEAP_TRACK_RECORD_MAX_LEN];
+         uint16_t len = heap_track_write(heap_track_buf, sizeof(heap_track_buf));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, heap_track_buf, len);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+
+ #ifdef LINK_QUALITY_ENABLE
+ /*!
+  * Callback for the signal level and ETX trends of the neighbors
+  */
+ static int coap_recv_cb_link_quality(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         static uint8_t link_quality_buf[LINK_QUALITY_RECORD_MAX_LEN];
+         uint16_t len = link_quality_write(link_quality_buf, sizeof(link_quality_buf));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, link_quality_buf, len);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+
+ #ifdef RPL_EVENTS_ENABLE
+ /*!
+  * Callback for the RPL topology changes. The query since=<sequence> returns the events
+  * after the given one, without it the log is read from its oldest event.
+  */
+ static int coap_recv_cb_rpl_events(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         static uint8_t rpl_events_buf[RPL_EVENTS_RECORD_MAX_LEN];
+         const uint8_t *query = NULL;
+         uint16_t query_len = 0, i, len;
+         uint32_t since = 0;
+
+         if (request_ptr->options_list_ptr)
+         {
+             query = request_ptr->options_list_ptr->uri_query_ptr;
+             query_len = request_ptr->options_list_ptr->uri_query_len;
+         }
+         // Query options arrive joined with '&'
+         for (i = 0; query && i + sizeof(COAP_RPL_EVENTS_SINCE) - 1 <= query_len; i++)
+         {
+             if ((i == 0 || query[i - 1] == '&') &&
+                 !memcmp(&query[i], COAP_RPL_EVENTS_SINCE, sizeof(COAP_RPL_EVENTS_SINCE) - 1))
+             {
+                 for (i += sizeof(COAP_RPL_EVENTS_SINCE) - 1; i < query_len && query[i] >= '0' && query[i] <= '9'; i++)
+                 {
+                     since = since * 10 + (query[i] - '0');
+                 }
+                 break;
+             }
+         }
+         len = rpl_events_write(since, rpl_events_buf, sizeof(rpl_events_buf));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, rpl_events_buf, len);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+
+ #ifdef CHANNEL_POLICY_ENABLE
+ /*!
+  * Callback for the excluded channels and the failures per channel.
+  * PUT or POST allows all configured channels again.
+  */
+ static int coap_recv_cb_channel_policy(int8_t service_id, uint8_t source_address[static 16],
+                  uint16_t source_port, sn_coap_hdr_s *request_ptr)
+ {
+     if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
+     {
+         static uint8_t channel_policy_buf[CHANNEL_POLICY_RECORD_MAX_LEN];
+         uint16_t len = channel_policy_write(channel_policy_buf, sizeof(channel_policy_buf));
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_NOT_FOUND,
+                                    COAP_CT_TEXT_PLAIN, channel_policy_buf, len);
+     }
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT || request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST)
+     {
+         channel_policy_reset();
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     else
+     {
+         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
+                                    COAP_CT_TEXT_PLAIN, NULL, 0);
+     }
+     return 0;
+ }
+ #endif
+
+ #ifdef TELEMETRY_ENABLE
+ /*!
+  * Callback for the telemetry settings. PUT or POST sets them from
+  * [interval s(2)], [interval s(2), port(2)] or [interval s(2), port(2), collector(16)],
+  * big endian, an interval of 0 stops the records and no collector sends to the border router.
   */
- static int coap_recv_cb(int8_t service_id, uint8_t source_address[static 16],
+ static int coap_recv_cb_telemetry(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
  {
- 
      if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
      {
-         // Send LED states as [RLED_STATE, GLED_STATE] in CoAP response payload
-         led_state[COAP_RLED_ID] = GPIO_read(CONFIG_GPIO_RLED);
-         led_state[COAP_GLED_ID] = GPIO_read(CONFIG_GPIO_GLED);
+         uint8_t telemetry_config[TELEMETRY_CONFIG_LEN];
+         uint16_t len = telemetry_write_config(telemetry_config, sizeof(telemetry_config));
          coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
-                                    COAP_CT_TEXT_PLAIN, (uint8_t *) &led_state, sizeof(led_state));
+                                    COAP_CT_TEXT_PLAIN, telemetry_config, len);
      }
-     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST ||
-              request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT)
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT || request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST)
      {
-         bool success = true;
-         if (request_ptr->payload_len != 2 || request_ptr->payload_ptr == NULL)
-         {
-             // Invalid payload length
-             success = false;
-         }
-         else if ((request_ptr->payload_ptr[0] != 0 && request_ptr->payload_ptr[0] != 1) ||
-                  (request_ptr->payload_ptr[1] != 0 && request_ptr->payload_ptr[1] != 1))
-         {
-             // Invalid payload contents
-             success = false;
-         }
-         else
-         {
-             // Set LED state from payload: [target LED, LED state]
-             if (request_ptr->payload_ptr[0] == COAP_RLED_ID)
-             {
-                 GPIO_write(CONFIG_GPIO_RLED, request_ptr->payload_ptr[1]);
-             }
-             else if (request_ptr->payload_ptr[0] == COAP_GLED_ID)
-             {
-                 GPIO_write(CONFIG_GPIO_GLED, request_ptr->payload_ptr[1]);
-             }
-             else
-             {
-                 success = false;
-             }
-         }
- 
-         if (success)
+         const uint8_t *payload = request_ptr->payload_ptr;
+         uint16_t payload_len = payload ? request_ptr->payload_len : 0;
+
+         if (payload_len == 2 || payload_len == 4 || payload_len == 20)
          {
+             telemetry_set(common_read_16_bit(payload),
+                           payload_len == 20 ? payload + 4 : NULL,
+                           payload_len >= 4 ? common_read_16_bit(payload + 2) : 0);
              coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
                                         COAP_CT_TEXT_PLAIN, NULL, 0);
          }
@@ -947,38 +1683,55 @@
      }
      else
      {
-         // Delete resource not supported
          coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
                                     COAP_CT_TEXT_PLAIN, NULL, 0);
      }
      return 0;
  }
- 
- #ifdef WISUN_TEST_METRICS
+ #endif
+
+ #ifdef TIME_SYNC_ENABLE
  /*!
-  * Callback for processing received coap message for Test metrics
+  * Callback for the network time. GET returns the state, see time_sync_write_status().
+  * PUT or POST sets [interval s(2)] or [interval s(2), server(16)], big endian,
+  * an interval of 0 stops the exchanges and no server asks the border router.
   */
- static int coap_recv_cb_tstmetrics(int8_t service_id, uint8_t source_address[static 16],
+ static int coap_recv_cb_time_sync(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
  {
      if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
      {
-         test_metrics_s test_metrics;
-         // Send test metrics data
-         get_test_metrics(&test_metrics);
+         uint8_t time_sync_status[TIME_SYNC_STATUS_LEN];
+         uint16_t len = time_sync_write_status(time_sync_status, sizeof(time_sync_status));
          coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
-                                    COAP_CT_TEXT_PLAIN, (uint8_t *) &test_metrics, sizeof(test_metrics_s));
+                                    COAP_CT_TEXT_PLAIN, time_sync_status, len);
+     }
+     else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT || request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST)
+     {
+         const uint8_t *payload = request_ptr->payload_ptr;
+         uint16_t payload_len = payload ? request_ptr->payload_len : 0;
+
+         if (payload_len == 2 || payload_len == 18)
+         {
+             time_sync_set(common_read_16_bit(payload), payload_len == 18 ? payload + 2 : NULL);
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                        COAP_CT_TEXT_PLAIN, NULL, 0);
+         }
+         else
+         {
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_BAD_REQUEST,
+                                        COAP_CT_TEXT_PLAIN, NULL, 0);
+         }
      }
      else
      {
-         // Post, Put, and Delete resource are not supported for now
          coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_METHOD_NOT_ALLOWED,
                                     COAP_CT_TEXT_PLAIN, NULL, 0);
      }
      return 0;
  }
  #endif
- 
+
  #ifdef COAP_PANID_LIST
  static int coap_panid_list_cb(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
@@ -1147,8 +1900,14 @@
      if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
      {
          payload_index = 1; // Reserve index 0 for payload length
-         payload = (uint16_t *) malloc(panid_list_len * sizeof(uint16_t));
-         memset((uint8_t *)payload, 0, sizeof(panid_list_len * sizeof(uint16_t)));
+         // One more than the list, index 0 holds the count
+         payload = ns_dyn_mem_temporary_alloc((panid_list_len + 1) * sizeof(uint16_t));
+         if (payload == NULL)
+         {
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR,
+                                        COAP_CT_TEXT_PLAIN, NULL, 0);
+             return 0;
+         }
  
          // Populate payload with all used PAN IDs
          for(i = 0; i < panid_list_len; i++)
@@ -1164,6 +1923,7 @@
          // Send used PAN IDs
          coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
                                     COAP_CT_TEXT_PLAIN, (uint8_t *)payload, sizeof(uint16_t)*(payload_index));
+         ns_dyn_mem_free(payload);
      }
      // Handle POST/PUT request
      else if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST ||
@@ -1207,7 +1967,7 @@
  }
  #endif // COAP_PANID_LIST
  
- void fetch_neighbor_details();
+ uint8_t fetch_neighbor_details();
  
  static int coap_recv_cb_rssi(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
@@ -1215,10 +1975,25 @@
  
      if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_GET)
      {
-         fetch_neighbor_details();
- 
-         coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CONTENT,
-                                    COAP_CT_TEXT_PLAIN, (uint8_t *) nbr_nodes_metrics, sizeof(nbr_nodes_metrics));
+         // One METRICS_TLV_NEIGHBOR field per neighbor found, see metrics_tlv.h
+         static uint8_t rssi_buf[COAP_RSSI_MAX_LEN];
+         uint8_t num_nbrs = fetch_neighbor_details();
+         metrics_tlv_t tlv;
+         uint16_t len;
+
+         metrics_tlv_start(&tlv, rssi_buf, sizeof(rssi_buf));
+         for (uint8_t i = 0; i < num_nbrs; i++)
+         {
+             uint8_t *mark = metrics_tlv_open(&tlv, METRICS_TLV_NEIGHBOR);
+             metrics_tlv_bytes(&tlv, METRICS_TLV_NEIGHBOR_MAC, nbr_nodes_metrics[i].mac_eui, sizeof(sAddrExt_t));
+             metrics_tlv_uint(&tlv, METRICS_TLV_NEIGHBOR_RSSI_IN, nbr_nodes_metrics[i].rssi_in);
+             metrics_tlv_uint(&tlv, METRICS_TLV_NEIGHBOR_RSSI_OUT, nbr_nodes_metrics[i].rssi_out);
+             metrics_tlv_close(&tlv, mark);
+         }
+         len = metrics_tlv_end(&tlv);
+         coap_service_response_send(service_id, 0, request_ptr,
+                                    len ? COAP_MSG_CODE_RESPONSE_CONTENT : COAP_MSG_CODE_RESPONSE_INTERNAL_SERVER_ERROR,
+                                    COAP_CT_TEXT_PLAIN, rssi_buf, len);
      }
      else
      {
@@ -1237,28 +2012,17 @@
   */
  void *mainThread(void *arg0)
  {
-     int16_t ret;
-
      #ifdef FSR
-     ADC_Handle adcHandles[4];
      ADC_Params adcParams;
-     int_fast16_t status;
-     uint16_t adcValues[4];
-     currentTime = time(NULL);
- 
-     /* 1 second delay */
-     //uint32_t time = 1;
-
-     
  
      /* Configure the ADC pin */
      ADC_Params_init(&adcParams);
-     adcHandles[0] = ADC_open(CONFIG_ADC_A, &adcParams);
-     adcHandles[1] = ADC_open(CONFIG_ADC_B, &adcParams);
-     adcHandles[2] = ADC_open(CONFIG_ADC_C, &adcParams);
-     adcHandles[3] = ADC_open(CONFIG_ADC_D, &adcParams);
+     fsr_adc[0] = ADC_open(CONFIG_ADC_A, &adcParams);
+     fsr_adc[1] = ADC_open(CONFIG_ADC_B, &adcParams);
+     fsr_adc[2] = ADC_open(CONFIG_ADC_C, &adcParams);
+     fsr_adc[3] = ADC_open(CONFIG_ADC_D, &adcParams);
  
-     if ((adcHandles[0] == NULL) || (adcHandles[1] == NULL) || (adcHandles[2] == NULL) || (adcHandles[3] == NULL)) {
+     if ((fsr_adc[0] == NULL) || (fsr_adc[1] == NULL) || (fsr_adc[2] == NULL) || (fsr_adc[3] == NULL)) {
         while (1);
      }
      #endif
@@ -1340,6 +2104,7 @@
      coap_service_register_uri(service_id, COAP_ACTIVATE_LIGHT_MANUAL_URI,
                                COAP_SERVICE_ACCESS_POST_ALLOWED,
                                coap_handle_activate_light_manual);
+     light_tasklet_start();
     #endif
 
  #ifdef WISUN_TEST_METRICS
@@ -1347,6 +2112,71 @@
                                COAP_SERVICE_ACCESS_GET_ALLOWED,
                                coap_recv_cb_tstmetrics);
  #endif
+ #ifdef WISUN_TEST_MPL_UDP
+     coap_service_register_uri(service_id, COAP_MPL_LATENCY_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED |
+                               COAP_SERVICE_ACCESS_PUT_ALLOWED |
+                               COAP_SERVICE_ACCESS_POST_ALLOWED,
+                               coap_recv_cb_mpl_latency);
+     // The MPL test frames still arrive on the plain UDP socket
+     if(udpSocketSetup() == false)
+     {
+         tr_debug("Socket setup failed");
+     }
+ #endif
+     coap_service_register_uri(service_id, COAP_DHCP_STATS_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED,
+                               coap_recv_cb_dhcp_stats);
+     coap_service_register_uri(service_id, COAP_TASK_STATS_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED,
+                               coap_recv_cb_task_stats);
+ #ifdef LOW_POWER_ENABLE
+     coap_service_register_uri(service_id, COAP_POWER_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED |
+                               COAP_SERVICE_ACCESS_PUT_ALLOWED |
+                               COAP_SERVICE_ACCESS_POST_ALLOWED,
+                               coap_recv_cb_power);
+ #endif
+ #ifdef HEAP_TRACK_ENABLE
+     coap_service_register_uri(service_id, COAP_HEAP_TRACK_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED,
+                               coap_recv_cb_heap_track);
+ #endif
+ #ifdef LINK_QUALITY_ENABLE
+     coap_service_register_uri(service_id, COAP_LINK_QUALITY_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED,
+                               coap_recv_cb_link_quality);
+ #endif
+ #ifdef RPL_EVENTS_ENABLE
+     coap_service_register_uri(service_id, COAP_RPL_EVENTS_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED,
+                               coap_recv_cb_rpl_events);
+     rpl_events_init();
+ #endif
+ #ifdef CHANNEL_POLICY_ENABLE
+     coap_service_register_uri(service_id, COAP_CHANNEL_POLICY_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED |
+                               COAP_SERVICE_ACCESS_PUT_ALLOWED |
+                               COAP_SERVICE_ACCESS_POST_ALLOWED,
+                               coap_recv_cb_channel_policy);
+     channel_policy_init(interface_id, cfg_props.uc_channel_list, sizeof(cfg_props.uc_channel_list));
+ #endif
+ #ifdef TELEMETRY_ENABLE
+     coap_service_register_uri(service_id, COAP_TELEMETRY_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED |
+                               COAP_SERVICE_ACCESS_PUT_ALLOWED |
+                               COAP_SERVICE_ACCESS_POST_ALLOWED,
+                               coap_recv_cb_telemetry);
+     telemetry_init();
+ #endif
+ #ifdef TIME_SYNC_ENABLE
+     coap_service_register_uri(service_id, COAP_TIME_SYNC_URI,
+                               COAP_SERVICE_ACCESS_GET_ALLOWED |
+                               COAP_SERVICE_ACCESS_PUT_ALLOWED |
+                               COAP_SERVICE_ACCESS_POST_ALLOWED,
+                               coap_recv_cb_time_sync);
+     time_sync_init();
+ #endif
  
  #ifdef COAP_PANID_LIST
      coap_service_register_uri(service_id, COAP_PANID_LIST_ALLOW_URI,
@@ -1409,81 +2239,8 @@
      send_addr_unicast.type = ADDRESS_IPV6;
      send_addr_unicast.identifier = UDP_PORT_ECHO;
  
-     while (1) {
-         int16_t len;
-         static uint32_t bcast_delay_count = 0;
-         static uint32_t unicast_delay_count = 0;
-         static bool prev_bcast_send = false;
-         static bool prev_unicast_send = false;
-         static ns_address_t source_addr = {0};
- 
-         if(prev_bcast_send != bcast_send)
-         {
-             if(bcast_send)
-             {
-                 tr_info("bcast_send enabled, sending light toggle every 10s");
-                 bcast_delay_count = 100;
-             }
-             else
-             {
-                 tr_info("bcast_send disabled");
-             }
-         }
-         prev_bcast_send = bcast_send;
- 
-         if(bcast_send)
-         {
-             if(bcast_delay_count==100)
-             {
-                 static bool light_state = false;
- 
-                 /* toggle light state */
-                 light_state ^= 1;
-                 /**
-                 * Multicast control message is a NUL terminated string of semicolon separated
-                 * <field identifier>:<value> pairs.
-                 *
-                 * Light control message format:
-                 * t:lights;g:<group_id>;s:<1|0>;\0
-                 */
-                 snprintf(send_buf, sizeof(send_buf), "t:lights;g:%03d;s:%s;", MY_GROUP, (light_state ? "1" : "0"));
-                 tr_debug("Sending lightcontrol message: %s", send_buf);
-                 /* send every 20s */
-                 tr_info("Sending multicast packet");
-                 ret = socket_sendto(socket_id, &send_addr, send_buf, sizeof(send_buf));
-                 tr_info("Sendto returned: %d", ret);
- 
-                 GPIO_toggle(CONFIG_GPIO_GLED);
- 
-                 bcast_delay_count = 0;
-             }
-             bcast_delay_count++;
-         }
-         if(unicast_send)
-         {
-             if(sent_dao == true) //&& !addr_ipv6_equal((const uint8_t*)root_unicast_addr, ns_in6addr_any))
-              {
-                 memcpy(send_addr_unicast.address, root_unicast_addr, 16);
-                 tr_info("Sending unicast packet from Router to Border Router");
-                 ret = socket_sendto(socket_id, &send_addr_unicast, send_buf_unicast, sizeof(send_buf_unicast));
-                 tr_info("Sendto returned: %d", ret);
-                 unicast_send = false;
-              }
-         }
- 
-         len = socket_recvfrom(socket_id, recv_buffer, sizeof(recv_buffer), 0, &source_addr);
-         if(len > 0)
-         {
-             tr_info("Recv[%d]: %s, ", len, recv_buffer);
-             handle_message((char*)recv_buffer);
-         }
-         else if(NS_EWOULDBLOCK != len)
-         {
-             tr_info("Recv error %x", len);
-         }
- 
-         usleep(100000);
-     }
+     // Frames are received in socket_callback(), the tasklet times the sends
+     udp_demo_tasklet_start();
  #endif /* endif for NWK_TEST not defined */
      nanostack_wait_till_connect();
  #if defined(COAP_SERVICE_ENABLE) && defined(COAP_PANID_LIST)
@@ -1491,76 +2248,8 @@
  #endif
  
     #ifdef FSR
-     while(1) {
-        time(&currentTime);
-         for (int i = 0; i <= 3; i++) {
-            status = ADC_convert(adcHandles[i], &adcValues[i]);
-            if (status == ADC_STATUS_SUCCESS) {
-                if (adcValues[i] > PRESSURE_THRESHOLD) {
-                    switch (i) {
-                        case 0:
-                            if(!adc_0_activated && (currentTime - adc0Time >= 1))
-                            {
-                                adc_0_activated = true;
-                                coap_fsr_trigger_input_send_request(0);
-                                adc0Time = currentTime;
-                            }
-                            break;
-                        case 1:
-                            if(!adc_1_activated && (currentTime - adc1Time >= 1))
-                            {
-                                adc_1_activated = true;
-                                coap_fsr_trigger_input_send_request(1);
-                                adc1Time = currentTime;
-                            }
-                            break;
-                        case 2:
-                            if(!adc_2_activated && (currentTime - adc2Time >= 1))
-                            {
-                                adc_2_activated = true;
-                                coap_fsr_trigger_input_send_request(2);
-                                adc2Time = currentTime;
-                            }
-                           
-                            break;
-                        case 3:
-                            if(!adc_3_activated && (currentTime - adc3Time >= 1))
-                            {
-                                adc_3_activated = true;
-                                coap_fsr_trigger_input_send_request(3);
-                                adc3Time = currentTime;
-                            }
-                            break;
-                        default: 
-                            break;
-                    }
-                }
-                else
-                {
-                    if(adc_0_activated)
-                    {
-                        adc_0_activated = false;
-                    }
-
-                    if(adc_1_activated)
-                    {
-                        adc_1_activated = false;
-                    }
-
-                    if(adc_2_activated)
-                    {
-                        adc_2_activated = false;
-                    }
-
-                    if(adc_3_activated)
-                    {
-                        adc_3_activated = false;
-                    }
-                }
-            }
-        }
- 
-     }
+     // Sampling runs from eventOS timers, this thread is done
+     fsr_sample_tasklet_start();
     #endif
  
     return NULL;
@@ -1568,65 +2257,6 @@
  
  #else //WISUN_NCP_ENABLE
  
- /*!
-  * Signal NCP tasklet with the event NCP_SEND_RESPONSE_EVENT,
-  * so that NCP_tasklet can process the sending of a response
-  * back to the host, when the host sends a command.
-  * e.g. Response to a command from host to set/get configuration.
-  */
- void platformNcpSendRspSignal()
- {
-     //post an event to ncp_tasklet
-     arm_event_s event = {
-            .sender = 0,
-            .receiver = ncp_tasklet_id,
-            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
-            .event_type = NCP_SEND_RESPONSE_EVENT,
-            .event_id = 0,
-            .event_data = 0
-        };
- 
-    eventOS_event_send(&event);
- }
- 
- /*!
-  * Signal NCP tasklet with the event NCP_SEND_ASYNC_RSPONSE_EVENT
-  * so that NCP tasket can process the sending of an async response
-  * back to the host - e.g. reception of a packet by the NWP
-  */
- void platformNcpSendAsyncRspSignal()
- {
-     //post an event to ncp_tasklet
-     arm_event_s event = {
-            .sender = 0,
-            .receiver = ncp_tasklet_id,
-            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
-            .event_type = NCP_SEND_ASYNC_RSPONSE_EVENT,
-            .event_id = 0,
-            .event_data = 0
-        };
- 
-    eventOS_event_send(&event);
- }
- 
- /*!
-  * Callback from the UART module indicating need for processing.
-  */
- void platformUartSignal(uintptr_t arg)
- {
-     //post an event to ncp_tasklet
-     arm_event_s event = {
-            .sender = 0,
-            .receiver = ncp_tasklet_id,
-            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
-            .event_type = NCP_UART_EVENT,
-            .event_id = 0,
-            .event_data = arg
-        };
- 
-    eventOS_event_send(&event);
- }
- 
  #ifdef WISUN_AUTO_START
  /*!
   * Blink Leds continuously when an assert occurs
@@ -1678,6 +2308,7 @@
                  OtStack_instance = otInstanceInitSingle();
                  assert(OtStack_instance);
                  otNcpInit(OtStack_instance);
+                 ncp_transport_init();
  
                  GPIO_write(CONFIG_GPIO_RLED, 1);
  
@@ -1714,15 +2345,9 @@
  #endif //WISUN_AUTO_START
  
              case NCP_UART_EVENT:
-                 platformUartProcess(event->event_data);
-                 break;
- 
              case NCP_SEND_RESPONSE_EVENT:
-                 platformNcpSendProcess();
-                 break;
- 
              case NCP_SEND_ASYNC_RSPONSE_EVENT:
-                 platformNcpSendAsyncProcess();
+                 ncp_transport_event(event_type, event->event_id);
                  break;
  
              default:
@@ -1891,25 +2516,31 @@
  /*!
   * Helper function to get neighbor node metrics like rssi_in, rssi_out
   * Metrics are copied over to a global structure instance.
+  * Returns the number of neighbors copied.
   */
- void fetch_neighbor_details()
+ uint8_t fetch_neighbor_details()
  {
      protocol_interface_info_entry_t *cur;
      cur = protocol_stack_interface_info_get(IF_6LoWPAN);
      if(!cur || !cur->mac_parameters || !cur->mac_parameters->mac_neighbor_table)
      {
          tr_debug("fetch_neighbor_details: NULL pointer");
-         return;
+         return 0;
      }
  
      uint8_t max_nbrs, nbr_idx = 0;
  
      max_nbrs = cur->mac_parameters->mac_neighbor_table->list_total_size;
+     if(cur->mac_parameters->mac_neighbor_table->neighbour_list_size == 0)
+     {
+         // Nothing to copy, and the count below would wrap around
+         cur_num_nbrs = 0;
+         memset(nbr_nodes_metrics, 0, sizeof(nbr_nodes_metrics));
+         return 0;
+     }
      cur_num_nbrs = (cur->mac_parameters->mac_neighbor_table->neighbour_list_size) - 1;
-     
-     
  
-     for(uint8_t i = 0; i < max_nbrs; i++)
+     for(uint8_t i = 0; i < max_nbrs && nbr_idx < SIZE_OF_NEIGH_LIST; i++)
      {
          if(cur->mac_parameters->mac_neighbor_table->neighbor_entry_buffer[i].trusted_device == 1)
          {
@@ -1932,6 +2563,7 @@
          } //end of outer if
  
      }//end of for
+     return nbr_idx;
  }
  
  /*!
@@ -2086,9 +2718,8 @@
              heap_stats->heap_sector_allocated_bytes_max;
  
      timac_getMACPerfData(&test_metrics->mac_perf_data);
+     // Monotonic, readers take the difference between their reads
      test_metrics->udpPktCnt = num_pkts;
-     // Reset UDP packet count to 0 for next test
-     num_pkts = 0;
  
      // Get current rank
      rpl_inst = get_rpl_instance();
@@ -2100,12 +2731,52 @@
  #endif
 
  #ifdef LIGHT
+ /*!
+  * Trace ID from the query of an activate_light request, 0 if there is none
+  */
+ static uint32_t coap_activate_light_trace_id(const sn_coap_hdr_s *request_ptr)
+ {
+     const uint8_t *query = NULL;
+     uint16_t query_len = 0, i;
+     uint32_t trace_id = 0;
+     uint8_t digit;
+
+     if (request_ptr->options_list_ptr)
+     {
+         query = request_ptr->options_list_ptr->uri_query_ptr;
+         query_len = request_ptr->options_list_ptr->uri_query_len;
+     }
+     // Query options arrive joined with '&'
+     for (i = 0; query && i + sizeof(COAP_ACTIVATE_LIGHT_TRACE) - 1 <= query_len; i++)
+     {
+         if ((i == 0 || query[i - 1] == '&') &&
+             !memcmp(&query[i], COAP_ACTIVATE_LIGHT_TRACE, sizeof(COAP_ACTIVATE_LIGHT_TRACE) - 1))
+         {
+             for (i += sizeof(COAP_ACTIVATE_LIGHT_TRACE) - 1; i < query_len && query[i] != '&'; i++)
+             {
+                 digit = query[i] | 0x20;
+                 if (digit >= '0' && digit <= '9') {
+                     trace_id = (trace_id << 4) | (digit - '0');
+                 } else if (digit >= 'a' && digit <= 'f') {
+                     trace_id = (trace_id << 4) | (digit - 'a' + 10);
+                 } else {
+                     return 0;
+                 }
+             }
+             break;
+         }
+     }
+     return trace_id;
+ }
+
  static int coap_handle_activate_light(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
  {
      if (request_ptr->msg_code == COAP_MSG_CODE_REQUEST_POST || request_ptr->msg_code == COAP_MSG_CODE_REQUEST_PUT)
      {
          bool success = true;
+         uint64_t on_time_ms = 0;
+         uint32_t trace_id = coap_activate_light_trace_id(request_ptr);
          if (request_ptr->payload_ptr == NULL)
          {
              // Invalid payload length
@@ -2118,15 +2789,32 @@
                 light_activated = true;
                 uint8_t waitTime = request_ptr->payload_ptr[0];
                 GPIO_write(CONFIG_GPIO_LED_EX, 1);
+ #ifdef TIME_SYNC_ENABLE
+                on_time_ms = time_sync_now_ms();
+ #endif
                 //GPIO_write(CONFIG_GPIO_RLED, CONFIG_GPIO_LED_ON);
-                sleep(waitTime);
-                //GPIO_write(CONFIG_GPIO_RLED, CONFIG_GPIO_LED_OFF);
-                GPIO_write(CONFIG_GPIO_LED_EX, 0);
-                light_activated = false;
+                // Answer now, light_tasklet turns the light off without holding up the event loop
+                if (eventOS_event_timer_request(LIGHT_OFF_TIMER_ID, LIGHT_OFF_EVT, light_tasklet_id,
+                                                (uint32_t)waitTime * 1000) != 0)
+                {
+                    tr_warn("Light off timer failed");
+                    GPIO_write(CONFIG_GPIO_LED_EX, 0);
+                    light_activated = false;
+                    on_time_ms = 0;
+                }
             }
          }
  
-         if (success)
+         if (success && (on_time_ms || trace_id))
+         {
+             uint8_t light_ack[LIGHT_ACK_LEN];
+             tr_info("Light request trace %08lx answered", (unsigned long)trace_id);
+             common_write_64_bit(on_time_ms, light_ack);
+             common_write_32_bit(trace_id, light_ack + 8);
+             coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
+                                        COAP_CT_TEXT_PLAIN, light_ack, sizeof(light_ack));
+         }
+         else if (success)
          {
              coap_service_response_send(service_id, 0, request_ptr, COAP_MSG_CODE_RESPONSE_CHANGED,
                                         COAP_CT_TEXT_PLAIN, NULL, 0);
@@ -2146,6 +2834,33 @@
      return 0;
  }
 
+ /*!
+  * Turn the light off once the time of activate_light is over. Manual mode keeps the
+  * light as it was set there.
+  */
+ static void light_tasklet(arm_event_s *event)
+ {
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             light_tasklet_id = event->receiver;
+             break;
+         case LIGHT_OFF_EVT:
+             if (!manual_light_mode) {
+                 //GPIO_write(CONFIG_GPIO_RLED, CONFIG_GPIO_LED_OFF);
+                 GPIO_write(CONFIG_GPIO_LED_EX, 0);
+             }
+             light_activated = false;
+             break;
+         default:
+             break;
+     }
+ }
+
+ static void light_tasklet_start(void)
+ {
+     eventOS_event_handler_create(&light_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+ }
+
  static int coap_handle_activate_light_manual(int8_t service_id, uint8_t source_address[static 16],
                   uint16_t source_port, sn_coap_hdr_s *request_ptr)
  {
@@ -2201,9 +2916,21 @@
  #elif defined(FSR)
  static void coap_fsr_trigger_input_send_request(uint8_t direction)
  {
-     uint8_t send_direction = direction;
+     uint8_t fsr_event[FSR_EVENT_LEN];
+     uint64_t event_time_ms = 0;
+     // 0 is no trace
+     uint32_t trace_id = randLIB_get_32bit() | 1;
      const char *multicast_target_addr_str = "2020:abcd::";
      uint8_t multicast_target_addr[16];
+
+ #ifdef TIME_SYNC_ENABLE
+     // Stamped before the send so the server sees the whole trip
+     event_time_ms = time_sync_now_ms();
+ #endif
+     fsr_event[0] = direction;
+     common_write_64_bit(event_time_ms, fsr_event + 1);
+     common_write_32_bit(trace_id, fsr_event + 9);
+     tr_info("FSR %d event, trace %08lx", direction, (unsigned long)trace_id);
      stoip6(multicast_target_addr_str, strlen(multicast_target_addr_str), multicast_target_addr);
      coap_service_request_send(service_id, 0,
                              multicast_target_addr, COAP_PORT,
@@ -2211,8 +2938,48 @@
                              COAP_MSG_CODE_REQUEST_POST,
                              COAP_FSR_ACTIVATED_CLASS_URI, 
                              COAP_CT_TEXT_PLAIN,
-                             &send_direction, sizeof(send_direction), 0);
+                             fsr_event, sizeof(fsr_event), 0);
  
  
  }
+
+ /*!
+  * Sample the pressure sensors every FSR_SAMPLE_INTERVAL_MS. A sensor going over
+  * PRESSURE_THRESHOLD is reported once, and again after FSR_TRIGGER_HOLDOFF_S if it
+  * was released in between. Between samples the node is free to enter standby.
+  */
+ static void fsr_sample_tasklet(arm_event_s *event)
+ {
+     uint16_t adc_value;
+     time_t now;
+
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             fsr_tasklet_id = event->receiver;
+             break;
+         case FSR_SAMPLE_EVT:
+             time(&now);
+             for (int i = 0; i < FSR_CHANNELS; i++) {
+                 if (ADC_convert(fsr_adc[i], &adc_value) != ADC_STATUS_SUCCESS) {
+                     continue;
+                 }
+                 if (adc_value <= PRESSURE_THRESHOLD) {
+                     fsr_activated[i] = false;
+                 } else if (!fsr_activated[i] && (now - fsr_trigger_time[i] >= FSR_TRIGGER_HOLDOFF_S)) {
+                     fsr_activated[i] = true;
+                     fsr_trigger_time[i] = now;
+                     coap_fsr_trigger_input_send_request(i);
+                 }
+             }
+             break;
+         default:
+             return;
+     }
+     eventOS_event_timer_request(FSR_SAMPLE_TIMER_ID, FSR_SAMPLE_EVT, fsr_tasklet_id, FSR_SAMPLE_INTERVAL_MS);
+ }
+
+ static void fsr_sample_tasklet_start(void)
+ {
+     eventOS_event_handler_create(&fsr_sample_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+ }
  #endif
\ No newline at end of file
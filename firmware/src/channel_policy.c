@@ -0,0 +1,329 @@
+/*
+ *  ======== channel_policy.c ========
+ *  Adaptive unicast channel exclusion (CHANNEL_POLICY_ENABLE). Every frame the MAC finishes
+ *  is counted on the channel the radio is tuned to: sent, CCA failure or missing ACK. Every
+ *  CHANNEL_POLICY_PERIOD_S the failure ratio of each channel goes into an EWMA, channels
+ *  from CHANNEL_POLICY_EXCLUDE_PCT on are excluded and the unicast mask is applied with
+ *  ws_management_channel_mask_set(), which advertises the excluded channels to neighbors
+ *  so they stop sending to this node on them. A channel busy or lossy for the frames of
+ *  this node is taken as bad for receiving on it as well. An excluded channel is tried
+ *  again after CHANNEL_POLICY_HOLD_PERIODS, it has no traffic to judge it by while
+ *  excluded, and one more bad period excludes it again. The broadcast schedule is shared
+ *  by the network and is left alone.
+ *  The MAC completion is redirected here at link time, with the GNU linker:
+ *      -Wl,--wrap=macTxCompleteCallback
+ *  and with the TI linker by the symbol maps of link_hooks.cmd, with --define=CHANNEL_POLICY_ENABLE.
+ */
+
+ #ifdef CHANNEL_POLICY_ENABLE
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <string.h>
+ #include "eventOS_event.h"
+ #include "eventOS_event_timer.h"
+ #include "ws_management_api.h"
+ #include "platform/arm_hal_interrupt.h"
+ #include "common_functions.h"
+ #include "ns_trace.h"
+ #include "trace_config.h"
+ #include "channel_policy.h"
+
+ #define TRACE_GROUP "chpo"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_CHPO
+
+ // Channels tracked, 129 with FCC 200 kHz spacing
+ #ifndef CHANNEL_POLICY_CHANNELS
+ #define CHANNEL_POLICY_CHANNELS         129
+ #endif
+
+ #ifndef CHANNEL_POLICY_PERIOD_S
+ #define CHANNEL_POLICY_PERIOD_S         60
+ #endif
+ // Failure ratio EWMA from which a channel is excluded
+ #ifndef CHANNEL_POLICY_EXCLUDE_PCT
+ #define CHANNEL_POLICY_EXCLUDE_PCT      40
+ #endif
+ // Frames a channel needs in a period for its ratio to count
+ #ifndef CHANNEL_POLICY_MIN_FRAMES
+ #define CHANNEL_POLICY_MIN_FRAMES       8
+ #endif
+ #ifndef CHANNEL_POLICY_HOLD_PERIODS
+ #define CHANNEL_POLICY_HOLD_PERIODS     10
+ #endif
+ // Allowed channels kept at the least, the worst channels are excluded first
+ #ifndef CHANNEL_POLICY_MIN_CHANNELS
+ #define CHANNEL_POLICY_MIN_CHANNELS     8
+ #endif
+ // Weight of a new period in the EWMA, 1 / 2^shift
+ #define CHANNEL_POLICY_EWMA_SHIFT       2
+
+ // IEEE 802.15.4 MAC status of a finished frame
+ #define CHANNEL_POLICY_MAC_CCA_FAILURE  0xE1
+ #define CHANNEL_POLICY_MAC_NO_ACK       0xE9
+
+ #define CHANNEL_POLICY_PERIOD_EVT       1
+ #define CHANNEL_POLICY_TIMER_ID         0
+
+ typedef struct {
+     uint16_t frames;
+     uint16_t cca_fail;
+     uint16_t no_ack;
+ } channel_policy_count_t;
+
+ typedef struct {
+     channel_policy_count_t count;               // Counts of the period in progress
+     uint16_t ratio_acc;                         // Failure ratio EWMA, percent << CHANNEL_POLICY_EWMA_SHIFT
+     uint8_t ratio;                              // Failure ratio EWMA, percent, ratio_acc rounded
+     uint8_t hold;                               // Periods left excluded, 0 when allowed
+ } channel_policy_channel_t;
+
+ extern void __real_macTxCompleteCallback(uint8_t status);
+ // Channel the TI MAC radio is tuned to, set by the frequency hopping before each frame
+ extern uint8_t macPhyChannel;
+
+ static channel_policy_channel_t channel_policy_channels[CHANNEL_POLICY_CHANNELS];
+ static uint8_t channel_policy_configured[CHANNEL_POLICY_MASK_LEN];
+ static uint8_t channel_policy_excluded[CHANNEL_POLICY_MASK_LEN];
+ static int8_t channel_policy_interface_id = -1;
+ static int8_t channel_policy_tasklet_id = -1;
+
+ void __wrap_macTxCompleteCallback(uint8_t status)
+ {
+     uint8_t channel = macPhyChannel;
+     channel_policy_count_t *count;
+
+     if (channel < CHANNEL_POLICY_CHANNELS) {
+         count = &channel_policy_channels[channel].count;
+         if (count->frames < UINT16_MAX) {
+             count->frames++;
+             if (status == CHANNEL_POLICY_MAC_CCA_FAILURE) {
+                 count->cca_fail++;
+             } else if (status == CHANNEL_POLICY_MAC_NO_ACK) {
+                 count->no_ack++;
+             }
+         }
+     }
+     __real_macTxCompleteCallback(status);
+ }
+
+ static bool channel_policy_bit(const uint8_t *mask, uint16_t channel)
+ {
+     return mask[channel / 8] & (1 << (channel % 8));
+ }
+
+ static void channel_policy_bit_set(uint8_t *mask, uint16_t channel, bool set)
+ {
+     if (set) {
+         mask[channel / 8] |= 1 << (channel % 8);
+     } else {
+         mask[channel / 8] &= ~(1 << (channel % 8));
+     }
+ }
+
+ /*!
+  * Apply the configured unicast mask without the excluded channels
+  */
+ static void channel_policy_apply(void)
+ {
+     uint32_t channel_mask[8];
+     uint8_t i;
+
+     for (i = 0; i < 8; i++) {
+         channel_mask[i] = common_read_32_bit_inverse(&channel_policy_configured[i * 4]) &
+                           ~common_read_32_bit_inverse(&channel_policy_excluded[i * 4]);
+     }
+     if (ws_management_channel_mask_set(channel_policy_interface_id, channel_mask) < 0) {
+         tr_warn("Channel mask not applied");
+     }
+ }
+
+ /*!
+  * Fold the failure ratio of a period into the EWMA of a channel. The EWMA is kept scaled by
+  * 2^CHANNEL_POLICY_EWMA_SHIFT and rounded, so a constant ratio is reached exactly and a
+  * channel that recovers decays to 0, which a truncating division in percent does not do.
+  */
+ static void channel_policy_ewma(channel_policy_channel_t *state, uint8_t ratio)
+ {
+     const uint16_t half = (1 << CHANNEL_POLICY_EWMA_SHIFT) >> 1;
+
+     state->ratio_acc = state->ratio_acc + ratio - ((state->ratio_acc + half) >> CHANNEL_POLICY_EWMA_SHIFT);
+     state->ratio = (state->ratio_acc + half) >> CHANNEL_POLICY_EWMA_SHIFT;
+ }
+
+ /*!
+  * Fold the counts of the period into the EWMAs and update the excluded channels.
+  * Returns true if the excluded channels changed.
+  */
+ static bool channel_policy_update(void)
+ {
+     uint16_t allowed = 0, channel, worst;
+     bool changed = false;
+
+     for (channel = 0; channel < CHANNEL_POLICY_CHANNELS; channel++) {
+         channel_policy_channel_t *state = &channel_policy_channels[channel];
+         channel_policy_count_t count;
+
+         if (!channel_policy_bit(channel_policy_configured, channel)) {
+             continue;
+         }
+         platform_enter_critical();
+         count = state->count;
+         memset(&state->count, 0, sizeof(state->count));
+         platform_exit_critical();
+
+         if (state->hold) {
+             if (--state->hold == 0) {
+                 // On probation just under the threshold, one more bad period excludes it again
+                 state->ratio_acc = (CHANNEL_POLICY_EXCLUDE_PCT - 1) << CHANNEL_POLICY_EWMA_SHIFT;
+                 state->ratio = CHANNEL_POLICY_EXCLUDE_PCT - 1;
+                 channel_policy_bit_set(channel_policy_excluded, channel, false);
+                 changed = true;
+                 tr_info("Channel %u allowed again", channel);
+             }
+         } else if (count.frames >= CHANNEL_POLICY_MIN_FRAMES) {
+             uint8_t ratio = (uint32_t)(count.cca_fail + count.no_ack) * 100 / count.frames;
+             channel_policy_ewma(state, ratio);
+         }
+         if (!channel_policy_bit(channel_policy_excluded, channel)) {
+             allowed++;
+         }
+     }
+
+     // Exclude the worst channels over the threshold while enough channels are left
+     while (allowed > CHANNEL_POLICY_MIN_CHANNELS) {
+         worst = CHANNEL_POLICY_CHANNELS;
+         for (channel = 0; channel < CHANNEL_POLICY_CHANNELS; channel++) {
+             if (channel_policy_bit(channel_policy_configured, channel) &&
+                 !channel_policy_bit(channel_policy_excluded, channel) &&
+                 !channel_policy_channels[channel].hold &&
+                 channel_policy_channels[channel].ratio >= CHANNEL_POLICY_EXCLUDE_PCT &&
+                 (worst == CHANNEL_POLICY_CHANNELS ||
+                  channel_policy_channels[channel].ratio > channel_policy_channels[worst].ratio)) {
+                 worst = channel;
+             }
+         }
+         if (worst == CHANNEL_POLICY_CHANNELS) {
+             break;
+         }
+         channel_policy_bit_set(channel_policy_excluded, worst, true);
+         channel_policy_channels[worst].hold = CHANNEL_POLICY_HOLD_PERIODS;
+         allowed--;
+         changed = true;
+         tr_info("Channel %u excluded, %u%% failures", worst, channel_policy_channels[worst].ratio);
+     }
+     return changed;
+ }
+
+ static void channel_policy_tasklet(arm_event_s *event)
+ {
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             channel_policy_tasklet_id = event->receiver;
+             break;
+         case CHANNEL_POLICY_PERIOD_EVT:
+             if (channel_policy_update()) {
+                 channel_policy_apply();
+             }
+             break;
+         default:
+             return;
+     }
+     eventOS_event_timer_request(CHANNEL_POLICY_TIMER_ID, CHANNEL_POLICY_PERIOD_EVT, channel_policy_tasklet_id,
+                                 CHANNEL_POLICY_PERIOD_S * 1000);
+ }
+
+ /*!
+  * Start the policy on the interface. uc_channel_list is the configured unicast mask
+  * of mask_len bytes, channel 0 in bit 0 of byte 0.
+  */
+ void channel_policy_init(int8_t interface_id, const uint8_t *uc_channel_list, uint8_t mask_len)
+ {
+     memset(channel_policy_configured, 0, sizeof(channel_policy_configured));
+     memcpy(channel_policy_configured, uc_channel_list,
+            mask_len < CHANNEL_POLICY_MASK_LEN ? mask_len : CHANNEL_POLICY_MASK_LEN);
+     channel_policy_interface_id = interface_id;
+     if (channel_policy_tasklet_id < 0) {
+         eventOS_event_handler_create(&channel_policy_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+     }
+ }
+
+ /*!
+  * Allow all configured channels again and forget their history
+  */
+ void channel_policy_reset(void)
+ {
+     platform_enter_critical();
+     memset(channel_policy_channels, 0, sizeof(channel_policy_channels));
+     platform_exit_critical();
+     memset(channel_policy_excluded, 0, sizeof(channel_policy_excluded));
+     if (channel_policy_interface_id >= 0) {
+         channel_policy_apply();
+     }
+ }
+
+ /*!
+  * Serialize the excluded channels and the channels with the most failures, see channel_policy.h
+  */
+ uint16_t channel_policy_write(uint8_t *buf, uint16_t buf_len)
+ {
+     static uint8_t order[CHANNEL_POLICY_CHANNELS];
+     static channel_policy_channel_t channels[CHANNEL_POLICY_CHANNELS];
+     uint16_t used = 0, channel, i, j;
+     uint8_t excluded = 0, allowed = 0, count = 0, tmp;
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < CHANNEL_POLICY_HEADER_LEN) {
+         return 0;
+     }
+
+     platform_enter_critical();
+     memcpy(channels, channel_policy_channels, sizeof(channels));
+     platform_exit_critical();
+
+     for (channel = 0; channel < CHANNEL_POLICY_CHANNELS; channel++) {
+         if (!channel_policy_bit(channel_policy_configured, channel)) {
+             continue;
+         }
+         if (channel_policy_bit(channel_policy_excluded, channel)) {
+             excluded++;
+         } else {
+             allowed++;
+         }
+         if (channels[channel].count.frames || channels[channel].ratio || channels[channel].hold) {
+             order[used++] = channel;
+         }
+     }
+     // Sort by failure ratio, the channels with a history are few
+     for (i = 1; i < used; i++) {
+         for (j = i; j > 0 && channels[order[j]].ratio > channels[order[j - 1]].ratio; j--) {
+             tmp = order[j];
+             order[j] = order[j - 1];
+             order[j - 1] = tmp;
+         }
+     }
+
+     *ptr++ = CHANNEL_POLICY_RECORD_VERSION;
+     ptr++;                                      // Channel count, written last
+     *ptr++ = excluded;
+     *ptr++ = allowed;
+     ptr = common_write_16_bit(CHANNEL_POLICY_PERIOD_S, ptr);
+     *ptr++ = CHANNEL_POLICY_EXCLUDE_PCT;
+     *ptr++ = CHANNEL_POLICY_HOLD_PERIODS;
+     memcpy(ptr, channel_policy_excluded, CHANNEL_POLICY_MASK_LEN);
+     ptr += CHANNEL_POLICY_MASK_LEN;
+
+     for (i = 0; i < used && ptr + CHANNEL_POLICY_ENTRY_LEN <= buf + buf_len; i++) {
+         const channel_policy_channel_t *state = &channels[order[i]];
+         *ptr++ = order[i];
+         *ptr++ = state->ratio;
+         ptr = common_write_16_bit(state->count.frames, ptr);
+         ptr = common_write_16_bit(state->count.cca_fail, ptr);
+         ptr = common_write_16_bit(state->count.no_ack, ptr);
+         count++;
+     }
+     buf[1] = count;
+     return ptr - buf;
+ }
+
+ #endif // CHANNEL_POLICY_ENABLE
@@ -0,0 +1,48 @@
+/*
+ *  ======== channel_policy.h ========
+ *  Adaptive unicast channel exclusion, see channel_policy.c
+ */
+
+ #ifndef CHANNEL_POLICY_H
+ #define CHANNEL_POLICY_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP, multi byte fields big endian:
+  * version(1) channels(1) excluded(1) allowed(1) period s(2) exclude pct(1) hold periods(1)
+  * excluded mask(CHANNEL_POLICY_MASK_LEN, channel 0 in bit 0 of byte 0),
+  * then per channel with a failure history or traffic, highest failure ratio first:
+  * channel(1) failure ratio EWMA pct(1) frames(2) CCA failures(2) no ACK(2)
+  * The counts are of the period in progress. */
+ #define CHANNEL_POLICY_RECORD_VERSION   1
+ #define CHANNEL_POLICY_HEADER_LEN       (8 + CHANNEL_POLICY_MASK_LEN)
+ #define CHANNEL_POLICY_ENTRY_LEN        8
+
+ // Bytes of the Wi-SUN channel mask
+ #define CHANNEL_POLICY_MASK_LEN         32
+
+ // Channels in a record read over CoAP, the ones with the highest failure ratio
+ #ifndef CHANNEL_POLICY_RECORD_CHANNELS
+ #define CHANNEL_POLICY_RECORD_CHANNELS  32
+ #endif
+ #define CHANNEL_POLICY_RECORD_MAX_LEN   (CHANNEL_POLICY_HEADER_LEN + \
+                                          CHANNEL_POLICY_RECORD_CHANNELS * CHANNEL_POLICY_ENTRY_LEN)
+
+ /*!
+  * Start the policy on the interface. uc_channel_list is the configured unicast mask
+  * of mask_len bytes, channel 0 in bit 0 of byte 0.
+  */
+ void channel_policy_init(int8_t interface_id, const uint8_t *uc_channel_list, uint8_t mask_len);
+
+ /*!
+  * Allow all configured channels again and forget their history
+  */
+ void channel_policy_reset(void);
+
+ /*!
+  * Serialize the excluded channels and the channels with the most failures, as many as
+  * buf_len holds. Returns bytes written, 0 if the buffer cannot hold the header.
+  */
+ uint16_t channel_policy_write(uint8_t *buf, uint16_t buf_len);
+
+ #endif //CHANNEL_POLICY_H
@@ -25,6 +25,7 @@
  #include <string.h>
  #include <ns_types.h>
  #include <ns_trace.h>
+ #include "trace_config.h"
  #include "nsdynmemLIB.h"
  #include "ns_list.h"
  #include "common_functions.h"
@@ -32,12 +33,17 @@
  #ifdef HAVE_DHCPV6
  #include "dhcp_service_api.h"
  #include "dhcpv6_client_api.h"
+ #include "dhcpv6_client_stats.h"
  #include "libDHCPv6/libDHCPv6.h"
  #include "NWK_INTERFACE/Include/protocol.h"
+ #include "eventOS_event_timer.h"
+ #include "randLIB.h"
+ #ifdef NV_RESTORE
+ #include "nvintf.h"
+ #endif
 
 #if defined(FSR) || defined (LIGHT)
  #include "coap_service_api.h"
- #include "eventOS_event_timer.h"
  #include "ip6string.h"
  #include <stdint.h>
  #include <stddef.h>
@@ -47,6 +53,7 @@
  #endif
 
  #define TRACE_GROUP "DHP"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_DHP
 
  #ifdef FSR
   #define VENDOR_ID_CLASS "fsr"
@@ -61,7 +68,135 @@
  #define COAP_CONNECT_WEB_APP_URI "connect_web_app"
  #define COAP_PORT 5683
  extern int8_t service_id;
- 
+ #ifdef NV_RESTORE
+ extern NVINTF_nvFuncts_t *pNV;
+ #endif
+
+ #define VENDOR_ID_ENTERPRISE_NUMBER 294
+
+ /* Vendor-specific Information option (17) sub-options describing the node. The border router
+  * registers devices from these through the Kea forensic log, see bp-files/kea-dhcp6.conf */
+ #define VENDOR_OPT_DEVICE_CLASS     1           // string, same as the vendor class
+ #define VENDOR_OPT_FW_VERSION       2           // string
+ #define VENDOR_OPT_CAPABILITIES     3           // uint16 bitmap of VENDOR_CAP_*
+ #define VENDOR_OPT_CHANNEL_COUNT    4           // uint8 sensor channels
+
+ #define VENDOR_CAP_SENSOR           0x0001
+ #define VENDOR_CAP_ACTUATOR         0x0002
+ #define VENDOR_CAP_BORDER_ROUTER    0x0004
+ #define VENDOR_CAP_COAP             0x0008
+
+ #ifndef VENDOR_FW_VERSION
+ #define VENDOR_FW_VERSION "1.0.0"
+ #endif
+
+ #ifdef FSR
+  #define VENDOR_CAPABILITIES     (VENDOR_CAP_SENSOR | VENDOR_CAP_COAP)
+  #define VENDOR_CHANNEL_COUNT    4
+ #elif defined(LIGHT)
+  #define VENDOR_CAPABILITIES     (VENDOR_CAP_ACTUATOR | VENDOR_CAP_COAP)
+  #define VENDOR_CHANNEL_COUNT    0
+ #else
+  #define VENDOR_CAPABILITIES     VENDOR_CAP_BORDER_ROUTER
+  #define VENDOR_CHANNEL_COUNT    0
+ #endif
+
+ /* Announce the node to the web app with a connect_web_app CoAP request after getting an address.
+  * Set to 0 when the border router registers devices from the DHCPv6 vendor options instead. */
+ #ifndef DHCPV6_CLIENT_COAP_REGISTRATION
+ #define DHCPV6_CLIENT_COAP_REGISTRATION 1
+ #endif
+
+ /* Rapid Commit (RFC 8415 option 14) lets the server answer the Solicit directly with a Reply.
+  * Set to 0 to always use the four message Solicit/Advertise/Request/Reply exchange. */
+ #ifndef DHCPV6_CLIENT_RAPID_COMMIT
+ #define DHCPV6_CLIENT_RAPID_COMMIT 1
+ #endif
+
+ #define DHCPV6_MSG_HEADER_LEN           4
+ #define DHCPV6_OPTION_HEADER_LEN        4
+ #define DHCPV6_RAPID_COMMIT_OPTION_CODE 14
+
+ #ifndef DHCPV6_ADVERTISMENT_TYPE
+ #define DHCPV6_ADVERTISMENT_TYPE 2
+ #endif
+ #ifndef DHCPV6_REQUEST_TYPE
+ #define DHCPV6_REQUEST_TYPE 3
+ #endif
+ #ifndef DHCPV6_REBIND_TYPE
+ #define DHCPV6_REBIND_TYPE 6
+ #endif
+
+ // Option codes and field offsets patched in the prebuilt renew template
+ #define DHCPV6_SERVER_ID_OPTION_CODE    2
+ #define DHCPV6_IA_NA_OPTION_CODE        3
+ #define DHCPV6_IAADDR_OPTION_CODE       5
+ #define DHCPV6_IA_NA_FIXED_LEN          12  // IAID + T1 + T2
+ #define DHCPV6_IA_NA_T1_OFFSET          (DHCPV6_OPTION_HEADER_LEN + 4)
+ #define DHCPV6_IA_NA_T2_OFFSET          (DHCPV6_OPTION_HEADER_LEN + 8)
+ #define DHCPV6_IAADDR_ADDRESS_OFFSET    DHCPV6_OPTION_HEADER_LEN
+ #define DHCPV6_IAADDR_PREFERRED_OFFSET  (DHCPV6_OPTION_HEADER_LEN + 16)
+ #define DHCPV6_IAADDR_VALID_OFFSET      (DHCPV6_OPTION_HEADER_LEN + 20)
+
+ /* Renew spreading: every renew is pulled earlier by a fraction of up to DHCPV6_RENEW_JITTER_PERCENT
+  * of the server given renew time, so nodes that got their lease together do not renew together.
+  * The fraction mixes a hash of the EUI-64 with a random value. Set to 0 to renew exactly at T1. */
+ #ifndef DHCPV6_RENEW_JITTER_PERCENT
+ #define DHCPV6_RENEW_JITTER_PERCENT 20
+ #endif
+ // Jitter never pulls a renew below this many 100ms ticks
+ #ifndef DHCPV6_RENEW_MIN_TICKS
+ #define DHCPV6_RENEW_MIN_TICKS 600
+ #endif
+
+ /* Lease kept in NV so a rebooted node can Rebind its previous address instead of Soliciting a new one */
+ #define DHCPV6_LEASE_NV_ITEM_ID     0x0040
+ #define DHCPV6_LEASE_NV_VERSION     1
+ #define DHCPV6_LEASE_NV_DUID_MAX    32
+ // Rebind is only retried a few times before falling back to Solicit
+ #define DHCPV6_REBIND_TIMEOUT       10
+ #define DHCPV6_REBIND_MAX_RT        30
+ #define DHCPV6_REBIND_MAX_RC        3
+
+ typedef struct {
+     uint8_t version;
+     uint8_t server_duid_length;
+     uint16_t server_duid_type;
+     uint32_t iaid;
+     uint32_t t1;
+     uint32_t t2;
+     uint32_t preferred_lifetime;
+     uint32_t valid_lifetime;
+     uint8_t address[16];
+     uint8_t server_duid[DHCPV6_LEASE_NV_DUID_MAX];
+ } dhcp_client_nv_lease_t;
+
+ /* Renew timing of this node, to check that renews reaching the border router are spread out */
+ typedef struct {
+     uint32_t renew_ticks;                       /*!< Renew time given by the lease, 100ms ticks */
+     uint32_t jitter_ticks;                      /*!< Amount the last renew was pulled earlier, 100ms ticks */
+     uint32_t last_renew_tick;                   /*!< eventOS tick of the last renew sent */
+     uint32_t last_interval_s;                   /*!< Seconds between the last two renews */
+     uint32_t min_interval_s;
+     uint32_t max_interval_s;
+     uint16_t renew_count;
+     uint16_t renew_fail_count;
+ } dhcp_client_renew_stats_t;
+
+ /* Per message type counters, used to check that renews are sent from the template without re-encoding */
+ typedef struct {
+     uint16_t encode_count;                      /*!< Messages encoded option by option */
+     uint16_t alloc_count;                       /*!< Send buffers allocated when the message is sent */
+     uint16_t template_count;                    /*!< Messages sent by patching the prebuilt template */
+ } dhcp_client_msg_counter_t;
+
+ typedef struct {
+     dhcp_client_msg_counter_t solicit;
+     dhcp_client_msg_counter_t request;
+     dhcp_client_msg_counter_t renew;
+     dhcp_client_msg_counter_t rebind;           /*!< Rebinds of the lease stored in NV after a reboot */
+ } dhcp_client_msg_stats_t;
+
  typedef struct {
      dhcp_client_global_adress_cb *global_address_cb;
      dhcp_client_options_notify_cb *option_information_cb;
@@ -76,14 +211,30 @@
      bool renew_uses_solicit: 1;
      bool one_instance_interface: 1;
      bool no_address_hint: 1;
+     bool rapid_commit: 1;                       /*!< Ask for Rapid Commit in Solicit, cleared once the server answers with Advertise */
+     uint8_t *renew_template;                    /*!< Renew (or Solicit) message built once per lease, patched in place for each renew */
+     uint16_t renew_template_len;
+     uint8_t *renew_send_buf;                    /*!< Copy of the template reserved for the next renew, handed to the DHCP service when sent */
+     uint16_t template_ia_offset;                /*!< IA_NA option offset in the template, 0 if not present */
+     uint16_t template_iaaddr_offset;            /*!< IA Address option offset in the template, 0 if not present */
+     uint32_t template_iaid;
+     dhcp_client_msg_stats_t msg_stats;
+     dhcp_client_renew_stats_t renew_stats;
+     uint32_t nv_lease_hash;                     /*!< Identity of the lease last written to NV, avoids rewriting on every renew */
+     uint8_t registered_address[16];             /*!< Address last announced to the web app */
+     bool address_registered: 1;
+     bool nv_lease_checked: 1;                   /*!< Stored lease is only tried on the first address request after boot */
      ns_list_link_t      link;                   /*!< List link entry */
  } dhcp_client_class_t;
  
  static NS_LARGE NS_LIST_DEFINE(dhcp_client_list, dhcp_client_class_t, link);
  
  static bool dhcpv6_client_set_address(int8_t interface_id, dhcpv6_client_server_data_t *srv_data_ptr);
+ static int dhcp_client_request_send(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr, dhcp_ia_non_temporal_params_t *advertised);
  void dhcpv6_renew(protocol_interface_info_entry_t *interface, if_address_entry_t *addr, if_address_callback_t reason);
- 
+ static void dhcp_client_template_free(dhcp_client_class_t *dhcp_client);
+ static void dhcp_client_renew_stats_update(dhcp_client_class_t *dhcp_client, bool sent);
+
  
  
  static dhcp_client_class_t *dhcpv6_client_entry_allocate(int8_t interface, uint8_t duid_length)
@@ -103,6 +254,7 @@
      entry->duid.duid = duid;
      entry->duid.duid_length = duid_length;
      entry->duid.type = DHCPV6_DUID_LINK_LAYER_TYPE;
+     entry->rapid_commit = DHCPV6_CLIENT_RAPID_COMMIT;
      ns_list_add_to_end(&dhcp_client_list, entry);
      return entry;
  }
@@ -138,6 +290,7 @@
          dhcp_client->renew_uses_solicit = false;
          dhcp_client->one_instance_interface = false;
          dhcp_client->no_address_hint = false;
+         dhcp_client->rapid_commit = DHCPV6_CLIENT_RAPID_COMMIT;
          dhcp_client->service_instance = dhcp_service_init(interface, DHCP_INSTANCE_CLIENT, NULL);
          dhcp_client->libDhcp_instance = libdhcpv6_nonTemporal_entry_get_unique_instance_id();
          return;
@@ -168,6 +321,8 @@
      dhcp_client->renew_uses_solicit = renew_uses_solicit;
      dhcp_client->one_instance_interface = one_client_for_this_interface;
      dhcp_client->no_address_hint = no_address_hint;
+     // Renew message layout depends on these flags
+     dhcp_client_template_free(dhcp_client);
  }
  
  void dhcp_client_solicit_timeout_set(int8_t interface, uint16_t timeout, uint16_t max_rt, uint8_t max_rc)
@@ -228,6 +383,7 @@
  
  
      dhcp_service_delete(dhcp_client->service_instance);
+     dhcp_client_template_free(dhcp_client);
  
  
      cur = protocol_stack_interface_info_get_by_id(interface);
@@ -328,7 +484,407 @@
          ptr += length;
      }
  }
- 
+
+ // Vendor-specific Information option data after the enterprise number
+ #define VENDOR_OPTS_DATA_LEN (DHCPV6_OPTION_HEADER_LEN + sizeof(VENDOR_ID_CLASS) - 1 + \
+                               DHCPV6_OPTION_HEADER_LEN + sizeof(VENDOR_FW_VERSION) - 1 + \
+                               DHCPV6_OPTION_HEADER_LEN + 2 + \
+                               DHCPV6_OPTION_HEADER_LEN + 1)
+
+ /* Size of the Vendor Class (16) and Vendor-specific Information (17) options including option headers */
+ static uint16_t dhcp_client_vendor_options_len(void)
+ {
+     // option header(4) + enterprise number(4) + data length(2) + data
+     uint16_t vendor_class_len = DHCPV6_OPTION_HEADER_LEN + 4 + 2 + sizeof(VENDOR_ID_CLASS) - 1;
+     // option header(4) + enterprise number(4) + sub-options
+     return vendor_class_len + DHCPV6_OPTION_HEADER_LEN + 4 + VENDOR_OPTS_DATA_LEN;
+ }
+
+ static uint8_t *dhcp_client_vendor_sub_option_write(uint8_t *ptr, uint16_t code, const void *data, uint16_t len)
+ {
+     ptr = common_write_16_bit(code, ptr);
+     ptr = common_write_16_bit(len, ptr);
+     memcpy(ptr, data, len);
+     return ptr + len;
+ }
+
+ static uint8_t *dhcp_client_vendor_options_write(uint8_t *ptr)
+ {
+     const char *vendor_class_str = VENDOR_ID_CLASS;
+     uint16_t vendor_class_len = sizeof(VENDOR_ID_CLASS) - 1;
+
+     ptr = common_write_16_bit(DHCPV6_OPTION_VENDOR_CLASS, ptr);
+     ptr = common_write_16_bit(4 + 2 + vendor_class_len, ptr); // Option length
+     ptr = common_write_32_bit(VENDOR_ID_ENTERPRISE_NUMBER, ptr); // Enterprise number
+     ptr = common_write_16_bit(vendor_class_len, ptr); // Vendor class data length
+     memcpy(ptr, vendor_class_str, vendor_class_len); // Vendor class data
+     ptr += vendor_class_len;
+
+     uint8_t capabilities[2];
+     uint8_t channel_count = VENDOR_CHANNEL_COUNT;
+     common_write_16_bit(VENDOR_CAPABILITIES, capabilities);
+
+     ptr = common_write_16_bit(DHCPV6_OPTION_VENDOR_SPECIFIC_INFO, ptr);
+     ptr = common_write_16_bit(4 + VENDOR_OPTS_DATA_LEN, ptr); // Option length
+     ptr = common_write_32_bit(VENDOR_ID_ENTERPRISE_NUMBER, ptr); // Enterprise number
+     ptr = dhcp_client_vendor_sub_option_write(ptr, VENDOR_OPT_DEVICE_CLASS, VENDOR_ID_CLASS, sizeof(VENDOR_ID_CLASS) - 1);
+     ptr = dhcp_client_vendor_sub_option_write(ptr, VENDOR_OPT_FW_VERSION, VENDOR_FW_VERSION, sizeof(VENDOR_FW_VERSION) - 1);
+     ptr = dhcp_client_vendor_sub_option_write(ptr, VENDOR_OPT_CAPABILITIES, capabilities, sizeof(capabilities));
+     return dhcp_client_vendor_sub_option_write(ptr, VENDOR_OPT_CHANNEL_COUNT, &channel_count, 1);
+ }
+
+ /* Locate a top level option in an option list, returns NULL if not present */
+ static uint8_t *dhcp_client_option_find(uint8_t *ptr, uint16_t data_len, uint16_t option_type)
+ {
+     while (data_len >= DHCPV6_OPTION_HEADER_LEN) {
+         uint16_t type = common_read_16_bit(ptr);
+         uint16_t length = common_read_16_bit(ptr + 2);
+         if (data_len - DHCPV6_OPTION_HEADER_LEN < length) {
+             return NULL;
+         }
+         if (type == option_type) {
+             return ptr;
+         }
+         ptr += DHCPV6_OPTION_HEADER_LEN + length;
+         data_len -= DHCPV6_OPTION_HEADER_LEN + length;
+     }
+     return NULL;
+ }
+
+ /*
+  * Add or strip the Rapid Commit option so a built Solicit matches the client setting.
+  * Buffer must have DHCPV6_OPTION_HEADER_LEN spare bytes after msg_len. Returns the new message length.
+  */
+ static uint16_t dhcp_client_rapid_commit_apply(uint8_t *msg_ptr, uint16_t msg_len, bool enable)
+ {
+     if (msg_len < DHCPV6_MSG_HEADER_LEN) {
+         return msg_len;
+     }
+
+     uint8_t *option = dhcp_client_option_find(msg_ptr + DHCPV6_MSG_HEADER_LEN, msg_len - DHCPV6_MSG_HEADER_LEN, DHCPV6_RAPID_COMMIT_OPTION_CODE);
+
+     if (enable && !option) {
+         uint8_t *ptr = common_write_16_bit(DHCPV6_RAPID_COMMIT_OPTION_CODE, msg_ptr + msg_len);
+         common_write_16_bit(0, ptr);
+         return msg_len + DHCPV6_OPTION_HEADER_LEN;
+     }
+
+     if (!enable && option) {
+         uint8_t *end = msg_ptr + msg_len;
+         memmove(option, option + DHCPV6_OPTION_HEADER_LEN, end - option - DHCPV6_OPTION_HEADER_LEN);
+         return msg_len - DHCPV6_OPTION_HEADER_LEN;
+     }
+
+     return msg_len;
+ }
+
+ static bool dhcp_client_server_duid_store(dhcpv6_client_server_data_t *srv_data_ptr, dhcp_duid_options_params_t *serverId)
+ {
+     //Allocate dynamically new Server DUID if needed
+     if (!srv_data_ptr->serverDynamic_DUID || serverId->duid_length > srv_data_ptr->dyn_server_duid_length) {
+         //Allocate dynamic new bigger
+         srv_data_ptr->dyn_server_duid_length = 0;
+         ns_dyn_mem_free(srv_data_ptr->serverDynamic_DUID);
+         srv_data_ptr->serverDynamic_DUID = ns_dyn_mem_alloc(serverId->duid_length);
+         if (!srv_data_ptr->serverDynamic_DUID) {
+             return false;
+         }
+         srv_data_ptr->dyn_server_duid_length = serverId->duid_length;
+     }
+
+     //Copy Server DUID
+     srv_data_ptr->serverDUID.duid = srv_data_ptr->serverDynamic_DUID;
+     srv_data_ptr->serverDUID.type = serverId->type;
+     srv_data_ptr->serverDUID.duid_length = serverId->duid_length;
+     memcpy(srv_data_ptr->serverDUID.duid, serverId->duid, serverId->duid_length);
+     return true;
+ }
+
+ #define DHCP_CLIENT_FNV_OFFSET 2166136261u
+
+ /* FNV-1a, used for the EUI-64 renew spread and to tell stored leases apart */
+ static uint32_t dhcp_client_fnv1a(uint32_t hash, const uint8_t *data, uint16_t len)
+ {
+     while (len--) {
+         hash = (hash ^ *data++) * 16777619u;
+     }
+     return hash;
+ }
+
+ #ifdef NV_RESTORE
+ static NVINTF_itemID_t dhcp_client_nv_lease_id(void)
+ {
+     NVINTF_itemID_t id;
+     id.systemID = NVINTF_SYSID_APP;
+     id.itemID = DHCPV6_LEASE_NV_ITEM_ID;
+     id.subID = 0;
+     return id;
+ }
+
+ /* Lifetimes change on every renew and are not written, only a new address, IAID or server causes an NV write */
+ static uint32_t dhcp_client_nv_lease_hash(const dhcp_client_nv_lease_t *lease)
+ {
+     uint32_t hash = dhcp_client_fnv1a(DHCP_CLIENT_FNV_OFFSET, lease->address, 16);
+     hash = dhcp_client_fnv1a(hash, (const uint8_t *)&lease->iaid, sizeof(lease->iaid));
+     return dhcp_client_fnv1a(hash, lease->server_duid, lease->server_duid_length);
+ }
+ #endif
+
+ static void dhcp_client_nv_lease_store(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr)
+ {
+ #ifdef NV_RESTORE
+     if (!pNV || !pNV->writeItem || srv_data_ptr->serverDUID.duid_length > DHCPV6_LEASE_NV_DUID_MAX) {
+         return;
+     }
+
+     dhcp_client_nv_lease_t lease = {0};
+     lease.version = DHCPV6_LEASE_NV_VERSION;
+     lease.server_duid_length = srv_data_ptr->serverDUID.duid_length;
+     lease.server_duid_type = srv_data_ptr->serverDUID.type;
+     lease.iaid = srv_data_ptr->IAID;
+     lease.t1 = srv_data_ptr->T0;
+     lease.t2 = srv_data_ptr->T1;
+     lease.preferred_lifetime = srv_data_ptr->iaNontemporalAddress.preferredTime;
+     lease.valid_lifetime = srv_data_ptr->iaNontemporalAddress.validLifetime;
+     memcpy(lease.address, srv_data_ptr->iaNontemporalAddress.addressPrefix, 16);
+     memcpy(lease.server_duid, srv_data_ptr->serverDUID.duid, lease.server_duid_length);
+
+     uint32_t hash = dhcp_client_nv_lease_hash(&lease);
+     if (hash == dhcp_client->nv_lease_hash) {
+         return;
+     }
+
+     if (pNV->writeItem(dhcp_client_nv_lease_id(), sizeof(lease), &lease) == NVINTF_SUCCESS) {
+         dhcp_client->nv_lease_hash = hash;
+         tr_debug("DHCP lease stored");
+     } else {
+         tr_warn("DHCP lease store failed");
+     }
+ #else
+     (void)dhcp_client;
+     (void)srv_data_ptr;
+ #endif
+ }
+
+ static bool dhcp_client_nv_lease_load(dhcp_client_class_t *dhcp_client, dhcp_client_nv_lease_t *lease)
+ {
+ #ifdef NV_RESTORE
+     if (!pNV || !pNV->readItem) {
+         return false;
+     }
+     if (pNV->readItem(dhcp_client_nv_lease_id(), 0, sizeof(*lease), lease) != NVINTF_SUCCESS) {
+         return false;
+     }
+     if (lease->version != DHCPV6_LEASE_NV_VERSION || lease->server_duid_length > DHCPV6_LEASE_NV_DUID_MAX || !lease->valid_lifetime) {
+         return false;
+     }
+     dhcp_client->nv_lease_hash = dhcp_client_nv_lease_hash(lease);
+     return true;
+ #else
+     (void)dhcp_client;
+     (void)lease;
+     return false;
+ #endif
+ }
+
+ static void dhcp_client_nv_lease_delete(dhcp_client_class_t *dhcp_client)
+ {
+ #ifdef NV_RESTORE
+     if (pNV && pNV->deleteItem && dhcp_client->nv_lease_hash) {
+         pNV->deleteItem(dhcp_client_nv_lease_id());
+     }
+ #endif
+     dhcp_client->nv_lease_hash = 0;
+ }
+
+ static void dhcp_client_template_free(dhcp_client_class_t *dhcp_client)
+ {
+     ns_dyn_mem_free(dhcp_client->renew_template);
+     dhcp_client->renew_template = NULL;
+     ns_dyn_mem_free(dhcp_client->renew_send_buf);
+     dhcp_client->renew_send_buf = NULL;
+     dhcp_client->renew_template_len = 0;
+     dhcp_client->template_ia_offset = 0;
+     dhcp_client->template_iaaddr_offset = 0;
+ }
+
+ /* Encode a complete Renew message, or Solicit when renew_uses_solicit is set. Returns NULL on failure */
+ static uint8_t *dhcp_client_renew_message_encode(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr, uint16_t *msg_len)
+ {
+     uint16_t payload_len;
+     bool skip_address_info = dhcp_client->no_address_hint;
+     uint16_t vendor_options_len = dhcp_client_vendor_options_len();
+
+     // Allocate enough space for a Solicit message if enabled, otherwise allocate enough for a Renew message. It's okay to over-allocate if some options go unused.
+     if (dhcp_client->renew_uses_solicit)
+     {
+         payload_len = libdhcpv6_solication_message_length(srv_data_ptr->clientDUID.duid_length, skip_address_info, 0) + vendor_options_len + DHCPV6_OPTION_HEADER_LEN;
+     }
+     else
+     {
+         payload_len = libdhcpv6_address_request_message_len(srv_data_ptr->clientDUID.duid_length, srv_data_ptr->serverDUID.duid_length, 0, !skip_address_info) + vendor_options_len;
+     }
+
+     uint8_t *payload_ptr = ns_dyn_mem_alloc(payload_len);
+     if (payload_ptr == NULL) {
+         return NULL;
+     }
+     dhcpv6_solication_base_packet_s packetReq = {
+         .messageType = DHCPV6_RENEW_TYPE,
+         .clientDUID = srv_data_ptr->clientDUID,
+         .requestedOptionCnt = 0,
+         .iaID = srv_data_ptr->IAID,
+         .timerT0 = srv_data_ptr->T0,
+         .timerT1 = srv_data_ptr->T1,
+         .requestedOptionList = NULL,
+     };
+
+     if (dhcp_client->renew_uses_solicit) {
+         packetReq.messageType = DHCPV6_SOLICATION_TYPE;
+     }
+
+     uint8_t *returned_ptr;
+
+     if (skip_address_info) {
+         packetReq.timerT0 = 0;
+         packetReq.timerT1 = 0;
+
+         // RFC 8415 States that DHCP Solicit messages explicitly CANNOT include the Server Identifier, so don't use it when making a Solicit message
+         if (dhcp_client->renew_uses_solicit)
+         {
+             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, NULL, NULL);
+         }
+         else
+         {
+             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, NULL, &srv_data_ptr->serverDUID);
+         }
+     } else {
+         // Set Address information
+         dhcpv6_ia_non_temporal_address_s nonTemporalAddress = {0};
+         nonTemporalAddress.requestedAddress = srv_data_ptr->iaNontemporalAddress.addressPrefix;
+         nonTemporalAddress.preferredLifeTime = srv_data_ptr->iaNontemporalAddress.preferredTime;
+         nonTemporalAddress.validLifeTime = srv_data_ptr->iaNontemporalAddress.validLifetime;
+
+         if (dhcp_client->renew_uses_solicit)
+         {
+             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, NULL);
+         }
+         else
+         {
+             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, &srv_data_ptr->serverDUID);
+         }
+     }
+
+     if (returned_ptr - payload_ptr + vendor_options_len > payload_len)
+     {
+         tr_error("Wrote too many bytes to the heap when trying to renew our DHCP address!");
+         ns_dyn_mem_free(payload_ptr);
+         return NULL;
+     }
+
+     // Add Vendor Class (16) and Vendor-specific Information (17) options
+     returned_ptr = dhcp_client_vendor_options_write(returned_ptr);
+
+     *msg_len = returned_ptr - payload_ptr;
+     if (packetReq.messageType == DHCPV6_SOLICATION_TYPE) {
+         *msg_len = dhcp_client_rapid_commit_apply(payload_ptr, *msg_len, dhcp_client->rapid_commit);
+     }
+     dhcp_client->msg_stats.renew.encode_count++;
+     return payload_ptr;
+ }
+
+ /* Build the renew template for a lease and locate the fields patched on every renew */
+ static int dhcp_client_template_build(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr)
+ {
+     uint16_t msg_len;
+
+     dhcp_client_template_free(dhcp_client);
+     uint8_t *msg_ptr = dhcp_client_renew_message_encode(dhcp_client, srv_data_ptr, &msg_len);
+     if (!msg_ptr) {
+         return -1;
+     }
+
+     dhcp_client->renew_template = msg_ptr;
+     dhcp_client->renew_template_len = msg_len;
+     dhcp_client->template_iaid = srv_data_ptr->IAID;
+
+     uint8_t *ia_ptr = dhcp_client_option_find(msg_ptr + DHCPV6_MSG_HEADER_LEN, msg_len - DHCPV6_MSG_HEADER_LEN, DHCPV6_IA_NA_OPTION_CODE);
+     if (!ia_ptr) {
+         return 0;
+     }
+     dhcp_client->template_ia_offset = ia_ptr - msg_ptr;
+
+     uint16_t ia_len = common_read_16_bit(ia_ptr + 2);
+     if (ia_len > DHCPV6_IA_NA_FIXED_LEN) {
+         uint8_t *iaaddr_ptr = dhcp_client_option_find(ia_ptr + DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_NA_FIXED_LEN, ia_len - DHCPV6_IA_NA_FIXED_LEN, DHCPV6_IAADDR_OPTION_CODE);
+         if (iaaddr_ptr) {
+             dhcp_client->template_iaaddr_offset = iaaddr_ptr - msg_ptr;
+         }
+     }
+     return 0;
+ }
+
+ /* The DHCP service frees each sent buffer when its exchange ends, so the buffer of the next renew
+  * is reserved as a copy of the template once the lease is set, and the renew only patches and hands it over */
+ static void dhcp_client_send_buf_reserve(dhcp_client_class_t *dhcp_client)
+ {
+     if (dhcp_client->renew_send_buf || !dhcp_client->renew_template) {
+         return;
+     }
+     dhcp_client->renew_send_buf = ns_dyn_mem_alloc(dhcp_client->renew_template_len);
+     if (dhcp_client->renew_send_buf) {
+         memcpy(dhcp_client->renew_send_buf, dhcp_client->renew_template, dhcp_client->renew_template_len);
+     }
+ }
+
+ /* Template is reusable while the IAID, leased address and server DUID are unchanged */
+ static bool dhcp_client_template_matches(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr)
+ {
+     uint8_t *msg_ptr = dhcp_client->renew_template;
+     if (!msg_ptr || dhcp_client->template_iaid != srv_data_ptr->IAID) {
+         return false;
+     }
+
+     if (dhcp_client->template_iaaddr_offset &&
+             memcmp(msg_ptr + dhcp_client->template_iaaddr_offset + DHCPV6_IAADDR_ADDRESS_OFFSET, srv_data_ptr->iaNontemporalAddress.addressPrefix, 16) != 0) {
+         return false;
+     }
+
+     if (dhcp_client->renew_uses_solicit) {
+         return true;
+     }
+
+     // Server Identifier option data is DUID type followed by the DUID
+     uint8_t *server_id = dhcp_client_option_find(msg_ptr + DHCPV6_MSG_HEADER_LEN, dhcp_client->renew_template_len - DHCPV6_MSG_HEADER_LEN, DHCPV6_SERVER_ID_OPTION_CODE);
+     if (!server_id || common_read_16_bit(server_id + 2) != srv_data_ptr->serverDUID.duid_length + 2) {
+         return false;
+     }
+     return memcmp(server_id + DHCPV6_OPTION_HEADER_LEN + 2, srv_data_ptr->serverDUID.duid, srv_data_ptr->serverDUID.duid_length) == 0;
+ }
+
+ /* Refresh the per renew fields of a copied template: transaction id and lifetimes */
+ static void dhcp_client_template_patch(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr, uint8_t *msg_ptr)
+ {
+     uint32_t txid = libdhcpv6_txid_get();
+     msg_ptr[1] = txid >> 16;
+     msg_ptr[2] = txid >> 8;
+     msg_ptr[3] = txid;
+
+     if (dhcp_client->no_address_hint) {
+         // T1/T2 are sent as zero without address information
+         return;
+     }
+
+     if (dhcp_client->template_ia_offset) {
+         common_write_32_bit(srv_data_ptr->T0, msg_ptr + dhcp_client->template_ia_offset + DHCPV6_IA_NA_T1_OFFSET);
+         common_write_32_bit(srv_data_ptr->T1, msg_ptr + dhcp_client->template_ia_offset + DHCPV6_IA_NA_T2_OFFSET);
+     }
+     if (dhcp_client->template_iaaddr_offset) {
+         common_write_32_bit(srv_data_ptr->iaNontemporalAddress.preferredTime, msg_ptr + dhcp_client->template_iaaddr_offset + DHCPV6_IAADDR_PREFERRED_OFFSET);
+         common_write_32_bit(srv_data_ptr->iaNontemporalAddress.validLifetime, msg_ptr + dhcp_client->template_iaaddr_offset + DHCPV6_IAADDR_VALID_OFFSET);
+     }
+ }
+
  /* solication responce received for either global address or routter id assignment */
  int dhcp_solicit_resp_cb(uint16_t instance_id, void *ptr, uint8_t msg_name,  uint8_t *msg_ptr, uint16_t msg_len)
  {
@@ -357,8 +913,8 @@
      //Clear Active Transaction state
      srv_data_ptr->transActionId = 0;
  
-     // Validate message
-     if (msg_name != DHCPV6_REPLY_TYPE) {
+     // Validate message, Advertise is only expected when the server does not do Rapid Commit
+     if (msg_name != DHCPV6_REPLY_TYPE && msg_name != DHCPV6_ADVERTISMENT_TYPE) {
          tr_error("invalid response");
          goto error_exit;
      }
@@ -384,25 +940,23 @@
          goto error_exit;
      }
  
-     //Allocate dynamically new Server DUID if needed
-     if (!srv_data_ptr->serverDynamic_DUID || serverId.duid_length > srv_data_ptr->dyn_server_duid_length) {
-         //Allocate dynamic new bigger
-         srv_data_ptr->dyn_server_duid_length = 0;
-         ns_dyn_mem_free(srv_data_ptr->serverDynamic_DUID);
-         srv_data_ptr->serverDynamic_DUID = ns_dyn_mem_alloc(serverId.duid_length);
-         if (!srv_data_ptr->serverDynamic_DUID) {
-             tr_error("Dynamic DUID alloc fail");
+     if (!dhcp_client_server_duid_store(srv_data_ptr, &serverId)) {
+         tr_error("Dynamic DUID alloc fail");
+         goto error_exit;
+     }
+
+     if (msg_name == DHCPV6_ADVERTISMENT_TYPE) {
+         // Server ignored Rapid Commit: stop asking for it and Request the advertised address
+         tr_info("DHCP Advertise received, Rapid Commit not in use");
+         dhcp_client->rapid_commit = false;
+         dhcp_client_template_free(dhcp_client);
+         if (dhcp_client_request_send(dhcp_client, srv_data_ptr, &dhcp_ia_non_temporal_params) != 0) {
+             tr_error("DHCP request send failed");
              goto error_exit;
          }
-         srv_data_ptr->dyn_server_duid_length = serverId.duid_length;
+         return RET_MSG_ACCEPTED;
      }
- 
-     //Copy Server DUID
-     srv_data_ptr->serverDUID.duid = srv_data_ptr->serverDynamic_DUID;
-     srv_data_ptr->serverDUID.type = serverId.type;
-     srv_data_ptr->serverDUID.duid_length = serverId.duid_length;
-     memcpy(srv_data_ptr->serverDUID.duid, serverId.duid, serverId.duid_length);
- 
+
      if (dhcp_client->one_instance_interface && memcmp(srv_data_ptr->iaNontemporalAddress.addressPrefix, dhcp_ia_non_temporal_params.nonTemporalAddress, 16)) {
  
          protocol_interface_info_entry_t *cur = protocol_stack_interface_info_get_by_id(dhcp_client->interface);
@@ -434,6 +988,106 @@
      return RET_MSG_ACCEPTED;
  }
  
+ /* Request the address offered in an Advertise, used when the server does not do Rapid Commit */
+ static int dhcp_client_request_send(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr, dhcp_ia_non_temporal_params_t *advertised)
+ {
+     uint16_t payload_len = libdhcpv6_address_request_message_len(srv_data_ptr->clientDUID.duid_length, srv_data_ptr->serverDUID.duid_length, 0, true)
+                            + dhcp_client_vendor_options_len();
+
+     uint8_t *payload_ptr = ns_dyn_mem_temporary_alloc(payload_len);
+     if (!payload_ptr) {
+         tr_error("OOM payload_ptr");
+         return -1;
+     }
+     dhcp_client->msg_stats.request.alloc_count++;
+     dhcp_client->msg_stats.request.encode_count++;
+
+     dhcpv6_solication_base_packet_s packetReq = {
+         .messageType = DHCPV6_REQUEST_TYPE,
+         .clientDUID = srv_data_ptr->clientDUID,
+         .requestedOptionCnt = 0,
+         .iaID = srv_data_ptr->IAID,
+         .timerT0 = advertised->T0,
+         .timerT1 = advertised->T1,
+         .requestedOptionList = NULL,
+     };
+
+     dhcpv6_ia_non_temporal_address_s nonTemporalAddress = {0};
+     nonTemporalAddress.requestedAddress = advertised->nonTemporalAddress;
+     nonTemporalAddress.preferredLifeTime = advertised->preferredValidLifeTime;
+     nonTemporalAddress.validLifeTime = advertised->validLifeTime;
+
+     uint8_t *ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, &srv_data_ptr->serverDUID);
+     ptr = dhcp_client_vendor_options_write(ptr);
+
+     srv_data_ptr->transActionId = dhcp_service_send_req(dhcp_client->service_instance, 0, srv_data_ptr, srv_data_ptr->server_address, payload_ptr, ptr - payload_ptr, dhcp_solicit_resp_cb);
+     if (srv_data_ptr->transActionId == 0) {
+         ns_dyn_mem_free(payload_ptr);
+         return -1;
+     }
+     return 0;
+ }
+
+ /* Rebind the address of a stored lease after reboot, the Reply is handled like a Solicit Reply */
+ static int dhcp_client_rebind_send(dhcp_client_class_t *dhcp_client, dhcpv6_client_server_data_t *srv_data_ptr, const dhcp_client_nv_lease_t *lease)
+ {
+     dhcp_duid_options_params_t serverId = {
+         .duid = (uint8_t *)lease->server_duid,
+         .type = lease->server_duid_type,
+         .duid_length = lease->server_duid_length,
+     };
+     if (!dhcp_client_server_duid_store(srv_data_ptr, &serverId)) {
+         return -1;
+     }
+
+     // Server binds the address to DUID and IAID, so keep the stored IAID
+     srv_data_ptr->IAID = lease->iaid;
+     srv_data_ptr->T0 = lease->t1;
+     srv_data_ptr->T1 = lease->t2;
+     memcpy(srv_data_ptr->iaNontemporalAddress.addressPrefix, lease->address, 16);
+     srv_data_ptr->iaNontemporalAddress.preferredTime = lease->preferred_lifetime;
+     srv_data_ptr->iaNontemporalAddress.validLifetime = lease->valid_lifetime;
+
+     // Rebind has the same options as a Solicit with an address hint, it must not carry a Server Identifier
+     uint16_t payload_len = libdhcpv6_solication_message_length(srv_data_ptr->clientDUID.duid_length, true, 0)
+                            + dhcp_client_vendor_options_len();
+     uint8_t *payload_ptr = ns_dyn_mem_temporary_alloc(payload_len);
+     if (!payload_ptr) {
+         return -1;
+     }
+
+     dhcpv6_solication_base_packet_s packetReq = {
+         .messageType = DHCPV6_REBIND_TYPE,
+         .clientDUID = srv_data_ptr->clientDUID,
+         .requestedOptionCnt = 0,
+         .iaID = srv_data_ptr->IAID,
+         .timerT0 = 0,
+         .timerT1 = 0,
+         .requestedOptionList = NULL,
+     };
+
+     dhcpv6_ia_non_temporal_address_s nonTemporalAddress = {0};
+     nonTemporalAddress.requestedAddress = srv_data_ptr->iaNontemporalAddress.addressPrefix;
+     nonTemporalAddress.preferredLifeTime = lease->preferred_lifetime;
+     nonTemporalAddress.validLifeTime = lease->valid_lifetime;
+
+     uint8_t *ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, NULL);
+     ptr = dhcp_client_vendor_options_write(ptr);
+
+     srv_data_ptr->transActionId = dhcp_service_send_req(dhcp_client->service_instance, 0, srv_data_ptr, srv_data_ptr->server_address, payload_ptr, ptr - payload_ptr, dhcp_solicit_resp_cb);
+     if (srv_data_ptr->transActionId == 0) {
+         ns_dyn_mem_free(payload_ptr);
+         return -1;
+     }
+     srv_data_ptr->iaNonTemporalStructValid = false;
+     dhcp_service_set_retry_timers(srv_data_ptr->transActionId, DHCPV6_REBIND_TIMEOUT, DHCPV6_REBIND_MAX_RT, DHCPV6_REBIND_MAX_RC);
+
+     // Web app already knows this node by the stored address
+     memcpy(dhcp_client->registered_address, lease->address, 16);
+     dhcp_client->address_registered = true;
+     return 0;
+ }
+
  int dhcp_client_get_global_address(int8_t interface, uint8_t dhcp_addr[static 16], uint8_t prefix[static 16], dhcp_client_global_adress_cb *error_cb)
  {
      dhcpv6_solication_base_packet_s solPacket = {0};
@@ -493,6 +1147,23 @@
      }
      //SET DUID
      srv_data_ptr->clientDUID = dhcp_client->duid;
+
+     // First address request after boot: try to keep the stored lease, a failed Rebind ends up here again and Solicits
+     if (!dhcp_client->nv_lease_checked) {
+         dhcp_client_nv_lease_t lease;
+         dhcp_client->nv_lease_checked = true;
+         if (dhcp_client_nv_lease_load(dhcp_client, &lease) && (!prefix || memcmp(lease.address, prefix, 8) == 0)) {
+             dhcp_client->global_address_cb = error_cb;
+             srv_data_ptr->GlobalAddress = true;
+             if (dhcp_client_rebind_send(dhcp_client, srv_data_ptr, &lease) == 0) {
+                 tr_info("DHCP Rebind stored lease");
+                 dhcp_client->msg_stats.rebind.alloc_count++;
+                 dhcp_client->msg_stats.rebind.encode_count++;
+                 return 0;
+             }
+             tr_warn("DHCP Rebind failed, Solicit");
+         }
+     }
  
  dhcp_address_get:
  
@@ -502,14 +1173,10 @@
          add_prefix = prefix != NULL;
      }
  
-     // Define vendor class data
-     const char *vendor_class_str = VENDOR_ID_CLASS;
-     uint16_t vendor_class_len = strlen(vendor_class_str);
-     uint16_t option16_total_len = 4 + 2 + vendor_class_len; // enterprise number(4) + data length(2) + data
- 
-     // Calculate payload length with vendor class option
-     payload_len = libdhcpv6_solication_message_length(srv_data_ptr->clientDUID.duid_length, add_prefix, 0) + option16_total_len;
- 
+     // Calculate payload length with vendor options and room for Rapid Commit
+     payload_len = libdhcpv6_solication_message_length(srv_data_ptr->clientDUID.duid_length, add_prefix, 0)
+                   + dhcp_client_vendor_options_len() + DHCPV6_OPTION_HEADER_LEN;
+
      payload_ptr = ns_dyn_mem_temporary_alloc(payload_len);
      if (!payload_ptr) {
          libdhcvp6_nontemporalAddress_server_data_free(srv_data_ptr);
@@ -517,6 +1184,8 @@
          return -1;
      }
  
+     dhcp_client->msg_stats.solicit.alloc_count++;
+     dhcp_client->msg_stats.solicit.encode_count++;
      dhcp_client->global_address_cb = error_cb;
      srv_data_ptr->GlobalAddress = true;
      // Build solicit
@@ -535,16 +1204,11 @@
          ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &solPacket, NULL, NULL);
      }
      
-     // Add Vendor Class Option (16)
-     ptr = common_write_16_bit(DHCPV6_OPTION_VENDOR_CLASS, ptr);
-     ptr = common_write_16_bit(option16_total_len, ptr); // Option length
-     ptr = common_write_32_bit(294, ptr); // Enterprise number
-     ptr = common_write_16_bit(vendor_class_len, ptr); // Vendor class data length
-     memcpy(ptr, vendor_class_str, vendor_class_len); // Vendor class data
-     ptr += vendor_class_len;
-     
-     uint16_t actual_length = ptr - payload_ptr;
- 
+     // Add Vendor Class (16) and Vendor-specific Information (17) options
+     ptr = dhcp_client_vendor_options_write(ptr);
+
+     uint16_t actual_length = dhcp_client_rapid_commit_apply(payload_ptr, ptr - payload_ptr, dhcp_client->rapid_commit);
+
      // send solicit
      srv_data_ptr->transActionId = dhcp_service_send_req(dhcp_client->service_instance, 0, srv_data_ptr, dhcp_addr, payload_ptr, actual_length, dhcp_solicit_resp_cb);
      if (srv_data_ptr->transActionId == 0) {
@@ -598,6 +1262,39 @@
      (void)interface;
      return;
  }
+
+ static uint8_t *dhcp_client_msg_counter_write(const dhcp_client_msg_counter_t *counter, uint8_t *ptr)
+ {
+     ptr = common_write_16_bit(counter->encode_count, ptr);
+     ptr = common_write_16_bit(counter->alloc_count, ptr);
+     return common_write_16_bit(counter->template_count, ptr);
+ }
+
+ /*
+  * Serialize renew timing and message counters for reading over CoAP, see dhcpv6_client_stats.h
+  */
+ uint16_t dhcp_client_stats_write(int8_t interface, uint8_t *buf, uint16_t buf_len)
+ {
+     dhcp_client_class_t *dhcp_client = dhcpv6_client_entry_discover(interface);
+     if (!dhcp_client || !buf || buf_len < DHCP_CLIENT_STATS_LEN) {
+         return 0;
+     }
+
+     const dhcp_client_renew_stats_t *stats = &dhcp_client->renew_stats;
+     uint8_t *ptr = buf;
+     ptr = common_write_16_bit(stats->renew_count, ptr);
+     ptr = common_write_16_bit(stats->renew_fail_count, ptr);
+     ptr = common_write_32_bit(stats->renew_ticks, ptr);
+     ptr = common_write_32_bit(stats->jitter_ticks, ptr);
+     ptr = common_write_32_bit(stats->last_interval_s, ptr);
+     ptr = common_write_32_bit(stats->min_interval_s, ptr);
+     ptr = common_write_32_bit(stats->max_interval_s, ptr);
+     ptr = dhcp_client_msg_counter_write(&dhcp_client->msg_stats.solicit, ptr);
+     ptr = dhcp_client_msg_counter_write(&dhcp_client->msg_stats.request, ptr);
+     ptr = dhcp_client_msg_counter_write(&dhcp_client->msg_stats.renew, ptr);
+     ptr = dhcp_client_msg_counter_write(&dhcp_client->msg_stats.rebind, ptr);
+     return ptr - buf;
+ }
  
  void dhcp_client_global_address_delete(int8_t interface, uint8_t *dhcp_addr, uint8_t prefix[static 16])
  {
@@ -628,7 +1325,6 @@
  {
  
      uint8_t *payload_ptr;
-     uint16_t payload_len;
      dhcp_client_class_t *dhcp_client = dhcpv6_client_entry_discover(interface->id);
      if (!dhcp_client) {
          return;
@@ -647,6 +1343,8 @@
      if (reason == ADDR_CALLBACK_INVALIDATED) {
          dhcp_service_req_remove_all(srv_data_ptr);// remove all pending retransmissions
          libdhcvp6_nontemporalAddress_server_data_free(srv_data_ptr);
+         dhcp_client_template_free(dhcp_client);
+         dhcp_client_nv_lease_delete(dhcp_client);
          tr_warn("Dhcp address lost");
          return;
      }
@@ -660,155 +1358,119 @@
          tr_warn("Do not trig new pending renew request");
          return;
      }
-     bool skip_address_info = dhcp_client->no_address_hint;
-
-     const char *vendor_class_str = VENDOR_ID_CLASS;
-     uint16_t vendor_class_len = strlen(vendor_class_str);
-     uint16_t option16_total_len = 4 + 2 + vendor_class_len; // enterprise number(4) + data length(2) + data
- 
-     // Allocate enough space for a Solicit message if enabled, otherwise allocate enough for a Renew message. It's okay to over-allocate if some options go unused.
-     if (dhcp_client->renew_uses_solicit)
-     {
-         payload_len = libdhcpv6_solication_message_length(srv_data_ptr->clientDUID.duid_length, skip_address_info, 0) + option16_total_len;
-     }
-     else
-     {
-         payload_len = libdhcpv6_address_request_message_len(srv_data_ptr->clientDUID.duid_length, srv_data_ptr->serverDUID.duid_length, 0, !skip_address_info) + option16_total_len;
-     }
- 
-     payload_ptr = ns_dyn_mem_temporary_alloc(payload_len);
-     if (payload_ptr == NULL) {
+     // Template is normally built when the lease is set, rebuild only if the lease changed under it
+     if (!dhcp_client_template_matches(dhcp_client, srv_data_ptr) && dhcp_client_template_build(dhcp_client, srv_data_ptr) != 0) {
          if (addr) {
              addr->state_timer = 200; //Retry after 20 seconds
          }
          tr_error("Out of memory");
          return ;
      }
-     dhcpv6_solication_base_packet_s packetReq = {
-         .messageType = DHCPV6_RENEW_TYPE,
-         .clientDUID = srv_data_ptr->clientDUID,
-         .requestedOptionCnt = 0,
-         .iaID = srv_data_ptr->IAID,
-         .timerT0 = srv_data_ptr->T0,
-         .timerT1 = srv_data_ptr->T1,
-         .requestedOptionList = NULL,
-     };
- 
-     if (dhcp_client->renew_uses_solicit) {
-         packetReq.messageType = DHCPV6_SOLICATION_TYPE;
-     }
- 
-     uint8_t* returned_ptr;
- 
-     if (skip_address_info) {
-         packetReq.timerT0 = 0;
-         packetReq.timerT1 = 0;
- 
-         // RFC 8415 States that DHCP Solicit messages explicitly CANNOT include the Server Identifier, so don't use it when making a Solicit message
-         if(dhcp_client->renew_uses_solicit)
-         {
-             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, NULL, NULL);
-         }
-         else
-         {
-             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, NULL, &srv_data_ptr->serverDUID);
-         }
-     } else {
-         // Set Address information
-         dhcpv6_ia_non_temporal_address_s nonTemporalAddress = {0};
-         nonTemporalAddress.requestedAddress = srv_data_ptr->iaNontemporalAddress.addressPrefix;
-         nonTemporalAddress.preferredLifeTime = srv_data_ptr->iaNontemporalAddress.preferredTime;
-         nonTemporalAddress.validLifeTime = srv_data_ptr->iaNontemporalAddress.validLifetime;
- 
-         if(dhcp_client->renew_uses_solicit)
-         {
-             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, NULL);
-         }
-         else
-         {
-             returned_ptr = libdhcpv6_generic_nontemporal_address_message_write(payload_ptr, &packetReq, &nonTemporalAddress, &srv_data_ptr->serverDUID);
+
+     // DHCP service owns and frees the sent buffer, so send the copy reserved when the lease was set
+     uint16_t actual_length = dhcp_client->renew_template_len;
+     payload_ptr = dhcp_client->renew_send_buf;
+     dhcp_client->renew_send_buf = NULL;
+     if (payload_ptr == NULL) {
+         // Nothing reserved after a failed exchange or a rebuilt template, copy it now
+         payload_ptr = ns_dyn_mem_temporary_alloc(actual_length);
+         if (payload_ptr == NULL) {
+             if (addr) {
+                 addr->state_timer = 200; //Retry after 20 seconds
+             }
+             tr_error("Out of memory");
+             return ;
          }
+         memcpy(payload_ptr, dhcp_client->renew_template, actual_length);
+         dhcp_client->msg_stats.renew.alloc_count++;
      }
- 
-     uint16_t payload_bytes_written = ((uint32_t) returned_ptr) - ((uint32_t) payload_ptr);
- 
-     if(payload_bytes_written > payload_len)
-     {
-         tr_error("Wrote too many bytes to the heap when trying to renew our DHCP address!");
-         return;
-     }
- 
+     dhcp_client_template_patch(dhcp_client, srv_data_ptr, payload_ptr);
+     dhcp_client->msg_stats.renew.template_count++;
+     uint8_t message_type = payload_ptr[0];
+
      // Get address
      uint8_t *server_address = dhcp_service_relay_global_addres_get(dhcp_client->relay_instance);
      if (!server_address) {
          server_address = srv_data_ptr->server_address;
      }
-
-     // Add Vendor Class Option (16)
-     returned_ptr = common_write_16_bit(DHCPV6_OPTION_VENDOR_CLASS, returned_ptr);
-     returned_ptr = common_write_16_bit(option16_total_len, returned_ptr); // Option length
-     returned_ptr = common_write_32_bit(294, returned_ptr); // Enterprise number
-     returned_ptr = common_write_16_bit(vendor_class_len, returned_ptr); // Vendor class data length
-     memcpy(returned_ptr, vendor_class_str, vendor_class_len); // Vendor class data
-     returned_ptr += vendor_class_len;
-     
-     uint16_t actual_length = returned_ptr - payload_ptr;
  
      // Send message
      srv_data_ptr->transActionId = dhcp_service_send_req(dhcp_client->service_instance, 0, srv_data_ptr, server_address, payload_ptr, actual_length, dhcp_solicit_resp_cb);
      if (srv_data_ptr->transActionId == 0) {
-         ns_dyn_mem_free(payload_ptr);
+         // Still ours, kept for the retry
+         dhcp_client->renew_send_buf = payload_ptr;
          if (addr) {
              addr->state_timer = 200; //Retry after 20 seconds
          }
          tr_error("DHCP renew send failed");
      }
-     if (packetReq.messageType == DHCPV6_SOLICATION_TYPE && dhcp_client->sol_timeout != 0) {
+     dhcp_client_renew_stats_update(dhcp_client, srv_data_ptr->transActionId != 0);
+     if (message_type == DHCPV6_SOLICATION_TYPE && dhcp_client->sol_timeout != 0) {
          // Default retry values are modified from specification update to message
          dhcp_service_set_retry_timers(srv_data_ptr->transActionId, dhcp_client->sol_timeout, dhcp_client->sol_max_rt, dhcp_client->sol_max_rc);
      }
      tr_info("DHCP renew send OK");
  }
  
- static bool dhcpv6_client_set_address(int8_t interface_id, dhcpv6_client_server_data_t *srv_data_ptr)
+ /* Pull a renew timer (100ms ticks) earlier by a per node fraction of the jitter window */
+ static uint32_t dhcp_client_renew_jitter_apply(protocol_interface_info_entry_t *cur, uint32_t renew_ticks)
  {
-     protocol_interface_info_entry_t *cur = NULL;
-     if_address_entry_t *address_entry = NULL;
-     uint32_t renewTimer;
-     cur = protocol_stack_interface_info_get_by_id(interface_id);
-     if (!cur) {
-         return false;
+     uint32_t window = (renew_ticks / 100) * DHCPV6_RENEW_JITTER_PERCENT;
+     if (!window || renew_ticks <= DHCPV6_RENEW_MIN_TICKS) {
+         return 0;
      }
-     renewTimer = libdhcpv6_renew_time_define(srv_data_ptr);
- 
-     srv_data_ptr->iaNonTemporalStructValid = true;
-     address_entry = addr_get_entry(cur, srv_data_ptr->iaNontemporalAddress.addressPrefix);
-     if (address_entry == NULL) {
-         // create new
-         address_entry = addr_add(cur, srv_data_ptr->iaNontemporalAddress.addressPrefix, 64, ADDR_SOURCE_DHCP, srv_data_ptr->iaNontemporalAddress.validLifetime, srv_data_ptr->iaNontemporalAddress.preferredTime, false);
-     } else {
-         addr_set_valid_lifetime(cur, address_entry, srv_data_ptr->iaNontemporalAddress.validLifetime);
-         addr_set_preferred_lifetime(cur, address_entry, srv_data_ptr->iaNontemporalAddress.preferredTime);
+
+     // Hashing the EUI-64 keeps nodes apart even if their random generators start alike after a reboot
+     uint32_t hash = dhcp_client_fnv1a(DHCP_CLIENT_FNV_OFFSET, cur->mac, 8);
+     uint16_t fraction = (uint16_t)(hash ^ (hash >> 16)) ^ randLIB_get_16bit();
+
+     uint32_t jitter = (uint32_t)(((uint64_t)window * fraction) >> 16);
+     if (renew_ticks - jitter < DHCPV6_RENEW_MIN_TICKS) {
+         jitter = renew_ticks - DHCPV6_RENEW_MIN_TICKS;
      }
- 
-     if (address_entry == NULL) {
-         tr_error("Address add failed");
-         srv_data_ptr->iaNonTemporalStructValid = false;
-         return false;
+     return jitter;
+ }
+
+ static void dhcp_client_renew_stats_update(dhcp_client_class_t *dhcp_client, bool sent)
+ {
+     dhcp_client_renew_stats_t *stats = &dhcp_client->renew_stats;
+     if (!sent) {
+         stats->renew_fail_count++;
+         return;
      }
- 
-     if (renewTimer) {
-         // translate seconds to 100ms ticks
-         if (renewTimer  <  0xffffffff / 10) {
-             renewTimer *= 10;
-         } else {
-             renewTimer = 0xfffffffe;
+
+     uint32_t now = eventOS_event_timer_ticks();
+     if (stats->renew_count) {
+         stats->last_interval_s = (now - stats->last_renew_tick) / EVENTOS_EVENT_TIMER_HZ;
+         if (!stats->min_interval_s || stats->last_interval_s < stats->min_interval_s) {
+             stats->min_interval_s = stats->last_interval_s;
+         }
+         if (stats->last_interval_s > stats->max_interval_s) {
+             stats->max_interval_s = stats->last_interval_s;
          }
      }
-     address_entry->state_timer = renewTimer;
-     address_entry->cb = dhcpv6_renew;
+     stats->last_renew_tick = now;
+     stats->renew_count++;
+ }
+
+#if (defined (FSR) || defined (LIGHT)) && DHCPV6_CLIENT_COAP_REGISTRATION
+ /* Registration was not acknowledged, announce the address again on the next lease update */
+ static int dhcp_client_web_app_register_cb(int8_t service_id, uint8_t source_address[static 16], uint16_t source_port, sn_coap_hdr_s *response_ptr)
+ {
+     (void)service_id;
+     (void)source_address;
+     (void)source_port;
+     if (!response_ptr) {
+         ns_list_foreach(dhcp_client_class_t, cur, &dhcp_client_list) {
+             cur->address_registered = false;
+         }
+     }
+     return 0;
+ }
 
-    #if defined (FSR) || defined (LIGHT)
+ /* Announce this node's vendor class and MAC to the web app */
+ static void dhcp_client_web_app_register(void)
+ {
     uint64_t macAddr;
     memcpy(&macAddr, (uint8_t *)(IEEE_MAC_ADDRESS_LOCATION),
            (APIMAC_SADDR_EXT_LEN));
@@ -842,10 +1504,80 @@
                         COAP_CONNECT_WEB_APP_URI,
                         COAP_CT_JSON, // Set content type to JSON
                         (uint8_t *) json_payload, strlen(json_payload), // Send JSON string
-                        NULL); // No specific callback needed for ACK/RST handling by the library
+                        dhcp_client_web_app_register_cb); // Library retransmits, callback only sees the final failure
+ }
+#endif
+
+ static bool dhcpv6_client_set_address(int8_t interface_id, dhcpv6_client_server_data_t *srv_data_ptr)
+ {
+     protocol_interface_info_entry_t *cur = NULL;
+     if_address_entry_t *address_entry = NULL;
+     uint32_t renewTimer;
+     cur = protocol_stack_interface_info_get_by_id(interface_id);
+     if (!cur) {
+         return false;
+     }
+     renewTimer = libdhcpv6_renew_time_define(srv_data_ptr);
+ 
+     srv_data_ptr->iaNonTemporalStructValid = true;
+     address_entry = addr_get_entry(cur, srv_data_ptr->iaNontemporalAddress.addressPrefix);
+     if (address_entry == NULL) {
+         // create new
+         address_entry = addr_add(cur, srv_data_ptr->iaNontemporalAddress.addressPrefix, 64, ADDR_SOURCE_DHCP, srv_data_ptr->iaNontemporalAddress.validLifetime, srv_data_ptr->iaNontemporalAddress.preferredTime, false);
+     } else {
+         addr_set_valid_lifetime(cur, address_entry, srv_data_ptr->iaNontemporalAddress.validLifetime);
+         addr_set_preferred_lifetime(cur, address_entry, srv_data_ptr->iaNontemporalAddress.preferredTime);
+     }
+ 
+     if (address_entry == NULL) {
+         tr_error("Address add failed");
+         srv_data_ptr->iaNonTemporalStructValid = false;
+         return false;
+     }
+ 
+     if (renewTimer) {
+         // translate seconds to 100ms ticks
+         if (renewTimer  <  0xffffffff / 10) {
+             renewTimer *= 10;
+         } else {
+             renewTimer = 0xfffffffe;
+         }
+     }
+
+     dhcp_client_class_t *dhcp_client = dhcpv6_client_entry_discover(interface_id);
+     if (dhcp_client && renewTimer && renewTimer != 0xfffffffe) {
+         uint32_t jitter = dhcp_client_renew_jitter_apply(cur, renewTimer);
+         dhcp_client->renew_stats.renew_ticks = renewTimer;
+         dhcp_client->renew_stats.jitter_ticks = jitter;
+         renewTimer -= jitter;
+         tr_debug("DHCP renew in %d ticks, jitter %d", (int)renewTimer, (int)jitter);
+     }
+     address_entry->state_timer = renewTimer;
+     address_entry->cb = dhcpv6_renew;
+
+     // Prepare the renew message once per lease, renews only patch it
+     if (dhcp_client && !dhcp_client_template_matches(dhcp_client, srv_data_ptr) && dhcp_client_template_build(dhcp_client, srv_data_ptr) != 0) {
+         tr_warn("Renew template build failed, retried at renew");
+     }
+     if (dhcp_client) {
+         dhcp_client_send_buf_reserve(dhcp_client);
+     }
+
+     if (dhcp_client) {
+         dhcp_client_nv_lease_store(dhcp_client, srv_data_ptr);
+     }
+
+    #if (defined (FSR) || defined (LIGHT)) && DHCPV6_CLIENT_COAP_REGISTRATION
+     // Renews and a Rebind of the stored lease keep the address, the web app only needs to hear about a new one
+     if (!dhcp_client) {
+         dhcp_client_web_app_register();
+     } else if (!dhcp_client->address_registered || memcmp(dhcp_client->registered_address, srv_data_ptr->iaNontemporalAddress.addressPrefix, 16) != 0) {
+         memcpy(dhcp_client->registered_address, srv_data_ptr->iaNontemporalAddress.addressPrefix, 16);
+         dhcp_client->address_registered = true;
+         dhcp_client_web_app_register();
+     }
     #endif
-    
-    
+
      return true;
  }
  
@@ -0,0 +1,22 @@
+/*
+ *  ======== dhcpv6_client_stats.h ========
+ *  Renew timing and message counters of the DHCPv6 client, see dhcpv6_client_service.c
+ */
+
+ #ifndef DHCPV6_CLIENT_STATS_H
+ #define DHCPV6_CLIENT_STATS_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP, big endian: renew_count(2) renew_fail_count(2) renew_ticks(4)
+  * jitter_ticks(4) last_interval_s(4) min_interval_s(4) max_interval_s(4), then the
+  * encode/alloc/template counts(2 each) for solicit, request, renew and rebind */
+ #define DHCP_CLIENT_STATS_LEN 48
+
+ /*!
+  * Serialize the renew timing and message counters of the client on the interface.
+  * Returns bytes written, 0 if the interface has no client or the buffer is too small.
+  */
+ uint16_t dhcp_client_stats_write(int8_t interface, uint8_t *buf, uint16_t buf_len);
+
+ #endif //DHCPV6_CLIENT_STATS_H
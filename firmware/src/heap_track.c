@@ -0,0 +1,254 @@
+/*
+ *  ======== heap_track.c ========
+ *  Allocation site and fragmentation tracking for the nanostack heap (HEAP_TRACK_ENABLE).
+ *  The ns_dyn_mem calls of the application and of the stack libraries are redirected here
+ *  at link time, with the GNU linker:
+ *      -Wl,--wrap=ns_dyn_mem_init,--wrap=ns_dyn_mem_alloc,--wrap=ns_dyn_mem_temporary_alloc,--wrap=ns_dyn_mem_free
+ *  and with the TI linker by the symbol maps of link_hooks.cmd, with --define=HEAP_TRACK_ENABLE.
+ *  Every block gets a small header naming its allocation site (the caller's return address),
+ *  so the bytes still held by each site can be read over CoAP and leaks show up as a site
+ *  that only grows. The free blocks are walked for the largest block and the block count.
+ */
+
+ #ifdef HEAP_TRACK_ENABLE
+
+ #include <stdint.h>
+ #include <string.h>
+ #include "nsdynmemLIB.h"
+ #include "platform/arm_hal_interrupt.h"
+ #include "common_functions.h"
+ #include "heap_track.h"
+
+ // Sites after the table is full are counted in entry 0, reported with address 0
+ #ifndef HEAP_TRACK_SITES
+ #define HEAP_TRACK_SITES            32
+ #endif
+
+ // Written in front of every tracked block, keeps the 4 byte alignment of the heap
+ #define HEAP_TRACK_MAGIC            0xA10C
+ typedef struct {
+     uint32_t size;
+     uint16_t site;
+     uint16_t check;                             // HEAP_TRACK_MAGIC ^ site
+ } heap_track_hdr_t;
+
+ typedef struct {
+     uintptr_t caller;
+     uint32_t live_bytes;
+     uint32_t peak_bytes;
+     uint32_t allocs;
+     uint16_t live_blocks;
+ } heap_track_site_t;
+
+ /* Heap block layout of nsdynmemLIB: the book keeping struct sits at the start of the heap
+  * and begins with pointers to the first and last word of the block area. Each block is
+  * enclosed by two words holding its size in words, negative while the block is free. */
+ typedef int heap_word_t;
+
+ extern void __real_ns_dyn_mem_init(void *heap, ns_mem_heap_size_t h_size,
+                                    void (*passed_fptr)(heap_fail_t), mem_stat_t *info_ptr);
+ extern void *__real_ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size);
+ extern void *__real_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size);
+ extern void __real_ns_dyn_mem_free(void *block);
+
+ static heap_track_site_t heap_track_sites[HEAP_TRACK_SITES];
+ static heap_word_t **heap_track_book = NULL;
+
+ /*!
+  * Site index of a caller, entry 0 when the table is full. Called in a critical section.
+  */
+ static uint16_t heap_track_site_get(uintptr_t caller)
+ {
+     uint16_t i;
+
+     for (i = 1; i < HEAP_TRACK_SITES; i++) {
+         if (heap_track_sites[i].caller == caller) {
+             return i;
+         }
+         if (heap_track_sites[i].caller == 0) {
+             heap_track_sites[i].caller = caller;
+             return i;
+         }
+     }
+     return 0;
+ }
+
+ /*!
+  * Put the header in front of a new block and account it to the caller
+  */
+ static void *heap_track_add(void *block, ns_mem_block_size_t alloc_size, uintptr_t caller)
+ {
+     heap_track_hdr_t *hdr = block;
+     heap_track_site_t *site;
+
+     if (!block) {
+         return NULL;
+     }
+
+     platform_enter_critical();
+     hdr->size = alloc_size;
+     hdr->site = heap_track_site_get(caller);
+     hdr->check = HEAP_TRACK_MAGIC ^ hdr->site;
+     site = &heap_track_sites[hdr->site];
+     site->live_bytes += alloc_size;
+     site->live_blocks++;
+     site->allocs++;
+     if (site->live_bytes > site->peak_bytes) {
+         site->peak_bytes = site->live_bytes;
+     }
+     platform_exit_critical();
+
+     return hdr + 1;
+ }
+
+ void __wrap_ns_dyn_mem_init(void *heap, ns_mem_heap_size_t h_size,
+                             void (*passed_fptr)(heap_fail_t), mem_stat_t *info_ptr)
+ {
+     uintptr_t misalign = (uintptr_t)heap % sizeof(heap_word_t);
+
+     __real_ns_dyn_mem_init(heap, h_size, passed_fptr, info_ptr);
+     // nsdynmemLIB aligns the heap start the same way before placing its book keeping there
+     heap_track_book = (heap_word_t **)((uint8_t *)heap + (misalign ? sizeof(heap_word_t) - misalign : 0));
+     memset(heap_track_sites, 0, sizeof(heap_track_sites));
+ }
+
+ void *__wrap_ns_dyn_mem_alloc(ns_mem_block_size_t alloc_size)
+ {
+     ns_mem_block_size_t size = alloc_size + sizeof(heap_track_hdr_t);
+
+     // Sizes the header would wrap around are left to fail in nsdynmemLIB
+     if (size < alloc_size) {
+         return __real_ns_dyn_mem_alloc(alloc_size);
+     }
+     return heap_track_add(__real_ns_dyn_mem_alloc(size), alloc_size,
+                           (uintptr_t)__builtin_return_address(0));
+ }
+
+ void *__wrap_ns_dyn_mem_temporary_alloc(ns_mem_block_size_t alloc_size)
+ {
+     ns_mem_block_size_t size = alloc_size + sizeof(heap_track_hdr_t);
+
+     if (size < alloc_size) {
+         return __real_ns_dyn_mem_temporary_alloc(alloc_size);
+     }
+     return heap_track_add(__real_ns_dyn_mem_temporary_alloc(size), alloc_size,
+                           (uintptr_t)__builtin_return_address(0));
+ }
+
+ void __wrap_ns_dyn_mem_free(void *block)
+ {
+     heap_track_hdr_t *hdr = (heap_track_hdr_t *)block - 1;
+     heap_track_site_t *site;
+
+     if (!block) {
+         return;
+     }
+     if (hdr->site >= HEAP_TRACK_SITES || hdr->check != (HEAP_TRACK_MAGIC ^ hdr->site)) {
+         // Not from the wrappers, let nsdynmemLIB report it
+         __real_ns_dyn_mem_free(block);
+         return;
+     }
+
+     platform_enter_critical();
+     site = &heap_track_sites[hdr->site];
+     site->live_bytes -= hdr->size;
+     site->live_blocks--;
+     hdr->check = 0;
+     platform_exit_critical();
+
+     __real_ns_dyn_mem_free(hdr);
+ }
+
+ /*!
+  * Count the free blocks and find the largest one, in bytes
+  */
+ static void heap_track_free_blocks(uint16_t *count, uint32_t *largest)
+ {
+     heap_word_t *ptr, *end;
+     heap_word_t size;
+
+     *count = 0;
+     *largest = 0;
+     if (!heap_track_book) {
+         return;
+     }
+
+     platform_enter_critical();
+     ptr = heap_track_book[0];
+     end = heap_track_book[1];
+     while (ptr < end) {
+         size = *ptr < 0 ? -*ptr : *ptr;
+         // A size that does not match the closing word means the walk is lost, stop there
+         if (size == 0 || ptr + size + 1 > end || ptr[size + 1] != *ptr) {
+             break;
+         }
+         if (*ptr < 0) {
+             (*count)++;
+             if ((uint32_t)size * sizeof(heap_word_t) > *largest) {
+                 *largest = size * sizeof(heap_word_t);
+             }
+         }
+         ptr += size + 2;
+     }
+     platform_exit_critical();
+ }
+
+ /*!
+  * Serialize the heap fragmentation and the sites with the most live bytes, see heap_track.h
+  */
+ uint16_t heap_track_write(uint8_t *buf, uint16_t buf_len)
+ {
+     static heap_track_site_t sites[HEAP_TRACK_SITES];
+     static uint8_t order[HEAP_TRACK_SITES];
+     const mem_stat_t *heap_stats = ns_dyn_mem_get_mem_stat();
+     uint16_t free_blocks;
+     uint32_t largest_free;
+     uint8_t used = 0, count = 0, i, j, tmp;
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < HEAP_TRACK_HEADER_LEN) {
+         return 0;
+     }
+
+     heap_track_free_blocks(&free_blocks, &largest_free);
+     platform_enter_critical();
+     memcpy(sites, heap_track_sites, sizeof(sites));
+     platform_exit_critical();
+
+     // Sort the sites that still hold memory by live bytes, the table is small
+     for (i = 0; i < HEAP_TRACK_SITES; i++) {
+         if (sites[i].live_blocks) {
+             order[used++] = i;
+         }
+     }
+     for (i = 1; i < used; i++) {
+         for (j = i; j > 0 && sites[order[j]].live_bytes > sites[order[j - 1]].live_bytes; j--) {
+             tmp = order[j];
+             order[j] = order[j - 1];
+             order[j - 1] = tmp;
+         }
+     }
+
+     *ptr++ = HEAP_TRACK_RECORD_VERSION;
+     ptr++;                                      // Site count, written last
+     ptr = common_write_16_bit(free_blocks, ptr);
+     ptr = common_write_32_bit(largest_free, ptr);
+     ptr = common_write_32_bit(heap_stats ? heap_stats->heap_sector_size : 0, ptr);
+     ptr = common_write_32_bit(heap_stats ? heap_stats->heap_sector_allocated_bytes : 0, ptr);
+     ptr = common_write_32_bit(heap_stats ? heap_stats->heap_sector_allocated_bytes_max : 0, ptr);
+     ptr = common_write_32_bit(heap_stats ? heap_stats->heap_alloc_fail_cnt : 0, ptr);
+
+     for (i = 0; i < used && ptr + HEAP_TRACK_ENTRY_LEN <= buf + buf_len; i++) {
+         const heap_track_site_t *site = &sites[order[i]];
+         ptr = common_write_32_bit((uint32_t)site->caller, ptr);
+         ptr = common_write_32_bit(site->live_bytes, ptr);
+         ptr = common_write_32_bit(site->peak_bytes, ptr);
+         ptr = common_write_32_bit(site->allocs, ptr);
+         ptr = common_write_16_bit(site->live_blocks, ptr);
+         count++;
+     }
+     buf[1] = count;
+     return ptr - buf;
+ }
+
+ #endif // HEAP_TRACK_ENABLE
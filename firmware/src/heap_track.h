@@ -0,0 +1,31 @@
+/*
+ *  ======== heap_track.h ========
+ *  Allocation sites and fragmentation of the nanostack heap, see heap_track.c
+ */
+
+ #ifndef HEAP_TRACK_H
+ #define HEAP_TRACK_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP, multi byte fields big endian:
+  * version(1) sites(1) free blocks(2) largest free block(4) heap size(4) allocated bytes(4)
+  * allocated bytes max(4) failed allocations(4), then per site, most live bytes first:
+  * caller address(4) live bytes(4) peak live bytes(4) allocations(4) live blocks(2) */
+ #define HEAP_TRACK_RECORD_VERSION   1
+ #define HEAP_TRACK_HEADER_LEN       24
+ #define HEAP_TRACK_ENTRY_LEN        18
+
+ // Sites in a record read over CoAP, the ones holding the most bytes
+ #ifndef HEAP_TRACK_RECORD_SITES
+ #define HEAP_TRACK_RECORD_SITES     16
+ #endif
+ #define HEAP_TRACK_RECORD_MAX_LEN   (HEAP_TRACK_HEADER_LEN + HEAP_TRACK_RECORD_SITES * HEAP_TRACK_ENTRY_LEN)
+
+ /*!
+  * Serialize the heap fragmentation and the sites with the most live bytes, as many as
+  * buf_len holds. Returns bytes written, 0 if the buffer cannot hold the header.
+  */
+ uint16_t heap_track_write(uint8_t *buf, uint16_t buf_len);
+
+ #endif //HEAP_TRACK_H
@@ -0,0 +1,64 @@
+/*
+ *  ======== link_hooks.cmd ========
+ *  Link time hooks of the optional modules for the TI linker (ticlang), in place of the GNU
+ *  linker's --wrap. The hooked functions are called inside the prebuilt stack libraries, so
+ *  the calls are redirected when linking. Each hook takes two symbol maps:
+ *      --symbol_map=name=__wrap_name       the library's calls of name link to the hook
+ *      --symbol_map=__real_name=name       the hook's call of __real_name links to the original
+ *  A symbol map resolves a reference with the definition of the other name. The original keeps
+ *  its name and its definition, so the second map reaches it and the two maps do not loop.
+ *
+ *  CCS hands every .cmd file of the project to the linker, this one sits next to the sources.
+ *  The linker runs the preprocessor on command files but does not get the compiler's defines,
+ *  so a module enabled with -DX_ENABLE in the compiler options also needs --define=X_ENABLE in
+ *  the linker options (Arm Linker > Basic Options, or -Wl,--define=X_ENABLE). Without it the
+ *  hooks are left out and the module sees no calls.
+ */
+
+#ifdef HEAP_TRACK_ENABLE
+/* heap_track.c */
+--symbol_map=ns_dyn_mem_init=__wrap_ns_dyn_mem_init
+--symbol_map=__real_ns_dyn_mem_init=ns_dyn_mem_init
+--symbol_map=ns_dyn_mem_alloc=__wrap_ns_dyn_mem_alloc
+--symbol_map=__real_ns_dyn_mem_alloc=ns_dyn_mem_alloc
+--symbol_map=ns_dyn_mem_temporary_alloc=__wrap_ns_dyn_mem_temporary_alloc
+--symbol_map=__real_ns_dyn_mem_temporary_alloc=ns_dyn_mem_temporary_alloc
+--symbol_map=ns_dyn_mem_free=__wrap_ns_dyn_mem_free
+--symbol_map=__real_ns_dyn_mem_free=ns_dyn_mem_free
+#endif
+
+#ifdef LINK_QUALITY_ENABLE
+/* link_quality.c */
+--symbol_map=ws_neighbor_class_rsl_in_calculate=__wrap_ws_neighbor_class_rsl_in_calculate
+--symbol_map=__real_ws_neighbor_class_rsl_in_calculate=ws_neighbor_class_rsl_in_calculate
+--symbol_map=ws_neighbor_class_rsl_out_calculate=__wrap_ws_neighbor_class_rsl_out_calculate
+--symbol_map=__real_ws_neighbor_class_rsl_out_calculate=ws_neighbor_class_rsl_out_calculate
+--symbol_map=etx_transm_attempts_update=__wrap_etx_transm_attempts_update
+--symbol_map=__real_etx_transm_attempts_update=etx_transm_attempts_update
+#endif
+
+#ifdef RPL_EVENTS_ENABLE
+/* rpl_events.c */
+--symbol_map=rpl_instance_consistent_rx=__wrap_rpl_instance_consistent_rx
+--symbol_map=__real_rpl_instance_consistent_rx=rpl_instance_consistent_rx
+--symbol_map=rpl_instance_inconsistent_rx=__wrap_rpl_instance_inconsistent_rx
+--symbol_map=__real_rpl_instance_inconsistent_rx=rpl_instance_inconsistent_rx
+--symbol_map=rpl_instance_dao_acked=__wrap_rpl_instance_dao_acked
+--symbol_map=__real_rpl_instance_dao_acked=rpl_instance_dao_acked
+#endif
+
+#ifdef CHANNEL_POLICY_ENABLE
+/* channel_policy.c */
+--symbol_map=macTxCompleteCallback=__wrap_macTxCompleteCallback
+--symbol_map=__real_macTxCompleteCallback=macTxCompleteCallback
+#endif
+
+#ifdef WISUN_NCP_ENABLE
+/* ncp_transport.c, UART byte counts and NCP_UART_BAUD_RATE */
+--symbol_map=otPlatUartReceived=__wrap_otPlatUartReceived
+--symbol_map=__real_otPlatUartReceived=otPlatUartReceived
+--symbol_map=otPlatUartSend=__wrap_otPlatUartSend
+--symbol_map=__real_otPlatUartSend=otPlatUartSend
+--symbol_map=UART2_open=__wrap_UART2_open
+--symbol_map=__real_UART2_open=UART2_open
+#endif
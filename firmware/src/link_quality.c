@@ -0,0 +1,251 @@
+/*
+ *  ======== link_quality.c ========
+ *  Link quality of each neighbor (LINK_QUALITY_ENABLE): an EWMA of the signal level heard
+ *  from it and reported by it, its last few samples, and the unicast results with an ETX
+ *  estimate. The entries are updated as the stack handles frames, the nanostack calls that
+ *  see them are redirected here at link time, with the GNU linker:
+ *      -Wl,--wrap=ws_neighbor_class_rsl_in_calculate,--wrap=ws_neighbor_class_rsl_out_calculate
+ *      -Wl,--wrap=etx_transm_attempts_update
+ *  and with the TI linker by the symbol maps of link_hooks.cmd, with --define=LINK_QUALITY_ENABLE.
+ *  Entries follow the slots of the MAC neighbor table, a slot taken over by another
+ *  neighbor starts over. A CoAP request only copies the table out.
+ */
+
+ #ifdef LINK_QUALITY_ENABLE
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdint.h>
+ #include <string.h>
+ #include "net_interface.h"
+ #include "NWK_INTERFACE/Include/protocol.h"
+ #include "6LoWPAN/ws/ws_common.h"
+ #include "6LoWPAN/ws/ws_neighbor_class.h"
+ #include "Service_Libs/mac_neighbor_table/mac_neighbor_table.h"
+ #include "platform/arm_hal_interrupt.h"
+ #include "common_functions.h"
+ #include "link_quality.h"
+
+ // Weight of a new sample in the EWMAs, 1 / 2^shift
+ #define LINK_QUALITY_EWMA_SHIFT     3
+ // Attempts a failed frame counts as in the ETX
+ #define LINK_QUALITY_ETX_FAIL       8
+ #define LINK_QUALITY_UNKNOWN        INT16_MIN
+
+ typedef struct {
+     uint8_t mac64[8];
+     bool in_use;
+     int16_t rssi_in;                            // 1/16 dBm
+     int16_t rssi_out;                           // 1/16 dBm
+     uint16_t etx;                               // 1/128
+     uint16_t tx_ok;
+     uint16_t tx_fail;
+     int8_t rssi_hist[LINK_QUALITY_SAMPLES];
+     uint8_t tx_hist[LINK_QUALITY_SAMPLES];
+     uint8_t rssi_head;                          // Next sample written, count saturates
+     uint8_t rssi_count;
+     uint8_t tx_head;
+     uint8_t tx_count;
+ } link_quality_entry_t;
+
+ extern void __real_ws_neighbor_class_rsl_in_calculate(ws_neighbor_class_entry_t *ws_neighbor, int8_t dbm_heard);
+ extern void __real_ws_neighbor_class_rsl_out_calculate(ws_neighbor_class_entry_t *ws_neighbor, uint8_t rsl_reported);
+ extern void __real_etx_transm_attempts_update(int8_t interface_id, uint8_t attempts, bool success,
+                                               uint8_t attribute_index, const uint8_t *mac64_addr_ptr);
+
+ static link_quality_entry_t link_quality_table[LINK_QUALITY_NEIGHBORS];
+
+ /*!
+  * MAC neighbor table of the Wi-SUN interface, NULL before the stack is up
+  */
+ static mac_neighbor_table_t *link_quality_mac_table(protocol_interface_info_entry_t *cur)
+ {
+     if (!cur || !cur->mac_parameters) {
+         return NULL;
+     }
+     return cur->mac_parameters->mac_neighbor_table;
+ }
+
+ /*!
+  * Entry of a neighbor table slot, reset when the slot holds another neighbor than last
+  * time. NULL for slots that are not tracked. Called in a critical section.
+  */
+ static link_quality_entry_t *link_quality_entry_get(uint8_t index, const uint8_t *mac64)
+ {
+     link_quality_entry_t *entry;
+
+     if (index >= LINK_QUALITY_NEIGHBORS || !mac64) {
+         return NULL;
+     }
+     entry = &link_quality_table[index];
+     if (!entry->in_use || memcmp(entry->mac64, mac64, sizeof(entry->mac64))) {
+         memset(entry, 0, sizeof(*entry));
+         memcpy(entry->mac64, mac64, sizeof(entry->mac64));
+         entry->in_use = true;
+         entry->rssi_in = LINK_QUALITY_UNKNOWN;
+         entry->rssi_out = LINK_QUALITY_UNKNOWN;
+     }
+     return entry;
+ }
+
+ /*!
+  * Entry of the neighbor a Wi-SUN neighbor info belongs to, the two tables share their slots
+  */
+ static link_quality_entry_t *link_quality_ws_entry_get(const ws_neighbor_class_entry_t *ws_neighbor)
+ {
+     protocol_interface_info_entry_t *cur = protocol_stack_interface_info_get(IF_6LoWPAN);
+     mac_neighbor_table_t *mac_table = link_quality_mac_table(cur);
+     ptrdiff_t index;
+
+     if (!mac_table || !cur->ws_info || !cur->ws_info->neighbor_storage.neigh_info_list) {
+         return NULL;
+     }
+     index = ws_neighbor - cur->ws_info->neighbor_storage.neigh_info_list;
+     if (index < 0 || index >= cur->ws_info->neighbor_storage.list_size || index >= mac_table->list_total_size) {
+         return NULL;
+     }
+     return link_quality_entry_get(index, mac_table->neighbor_entry_buffer[index].mac64);
+ }
+
+ static void link_quality_ewma_add(int16_t *ewma, int16_t sample)
+ {
+     if (*ewma == LINK_QUALITY_UNKNOWN) {
+         *ewma = sample;
+     } else {
+         *ewma += (sample - *ewma) / (1 << LINK_QUALITY_EWMA_SHIFT);
+     }
+ }
+
+ void __wrap_ws_neighbor_class_rsl_in_calculate(ws_neighbor_class_entry_t *ws_neighbor, int8_t dbm_heard)
+ {
+     link_quality_entry_t *entry;
+
+     __real_ws_neighbor_class_rsl_in_calculate(ws_neighbor, dbm_heard);
+
+     platform_enter_critical();
+     entry = link_quality_ws_entry_get(ws_neighbor);
+     if (entry) {
+         link_quality_ewma_add(&entry->rssi_in, dbm_heard * 16);
+         entry->rssi_hist[entry->rssi_head] = dbm_heard;
+         entry->rssi_head = (entry->rssi_head + 1) % LINK_QUALITY_SAMPLES;
+         if (entry->rssi_count < LINK_QUALITY_SAMPLES) {
+             entry->rssi_count++;
+         }
+     }
+     platform_exit_critical();
+ }
+
+ void __wrap_ws_neighbor_class_rsl_out_calculate(ws_neighbor_class_entry_t *ws_neighbor, uint8_t rsl_reported)
+ {
+     link_quality_entry_t *entry;
+
+     __real_ws_neighbor_class_rsl_out_calculate(ws_neighbor, rsl_reported);
+
+     platform_enter_critical();
+     entry = link_quality_ws_entry_get(ws_neighbor);
+     if (entry) {
+         // The RSL IE carries the level + 174 dBm
+         link_quality_ewma_add(&entry->rssi_out, ((int16_t)rsl_reported - 174) * 16);
+     }
+     platform_exit_critical();
+ }
+
+ void __wrap_etx_transm_attempts_update(int8_t interface_id, uint8_t attempts, bool success,
+                                        uint8_t attribute_index, const uint8_t *mac64_addr_ptr)
+ {
+     link_quality_entry_t *entry;
+     uint16_t sample;
+
+     __real_etx_transm_attempts_update(interface_id, attempts, success, attribute_index, mac64_addr_ptr);
+
+     platform_enter_critical();
+     entry = link_quality_entry_get(attribute_index, mac64_addr_ptr);
+     if (entry) {
+         if (success) {
+             sample = (attempts ? attempts : 1) * 128;
+             if (entry->tx_ok < UINT16_MAX) {
+                 entry->tx_ok++;
+             }
+         } else {
+             sample = (attempts > LINK_QUALITY_ETX_FAIL ? attempts : LINK_QUALITY_ETX_FAIL) * 128;
+             if (entry->tx_fail < UINT16_MAX) {
+                 entry->tx_fail++;
+             }
+         }
+         if (!entry->etx) {
+             entry->etx = sample;
+         } else {
+             entry->etx = entry->etx + ((int32_t)sample - entry->etx) / (1 << LINK_QUALITY_EWMA_SHIFT);
+         }
+         entry->tx_hist[entry->tx_head] = success ? attempts : 0;
+         entry->tx_head = (entry->tx_head + 1) % LINK_QUALITY_SAMPLES;
+         if (entry->tx_count < LINK_QUALITY_SAMPLES) {
+             entry->tx_count++;
+         }
+     }
+     platform_exit_critical();
+ }
+
+ /*!
+  * Write the last samples of a history ring, oldest first, behind their count
+  */
+ static uint8_t *link_quality_hist_write(const uint8_t *hist, uint8_t head, uint8_t count, uint8_t *ptr)
+ {
+     uint8_t i;
+
+     *ptr++ = count;
+     for (i = 0; i < LINK_QUALITY_SAMPLES; i++) {
+         *ptr++ = i < count ? hist[(head + LINK_QUALITY_SAMPLES - count + i) % LINK_QUALITY_SAMPLES] : 0;
+     }
+     return ptr;
+ }
+
+ /*!
+  * Serialize the neighbors still in the MAC neighbor table, see link_quality.h
+  */
+ uint16_t link_quality_write(uint8_t *buf, uint16_t buf_len)
+ {
+     static link_quality_entry_t table[LINK_QUALITY_NEIGHBORS];
+     mac_neighbor_table_t *mac_table = link_quality_mac_table(protocol_stack_interface_info_get(IF_6LoWPAN));
+     uint8_t count = 0, i;
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < LINK_QUALITY_HEADER_LEN) {
+         return 0;
+     }
+
+     platform_enter_critical();
+     memcpy(table, link_quality_table, sizeof(table));
+     platform_exit_critical();
+
+     *ptr++ = LINK_QUALITY_RECORD_VERSION;
+     ptr++;                                      // Neighbor count, written last
+     *ptr++ = LINK_QUALITY_SAMPLES;
+
+     for (i = 0; mac_table && i < LINK_QUALITY_NEIGHBORS && i < mac_table->list_total_size; i++) {
+         const link_quality_entry_t *entry = &table[i];
+         const mac_neighbor_table_entry_t *mac_entry = &mac_table->neighbor_entry_buffer[i];
+
+         // Neighbors removed since their last frame leave their entry behind
+         if (!entry->in_use || !mac_entry->in_use || memcmp(entry->mac64, mac_entry->mac64, sizeof(entry->mac64))) {
+             continue;
+         }
+         if (ptr + LINK_QUALITY_ENTRY_LEN > buf + buf_len) {
+             break;
+         }
+         memcpy(ptr, entry->mac64, sizeof(entry->mac64));
+         ptr += sizeof(entry->mac64);
+         ptr = common_write_16_bit((uint16_t)entry->rssi_in, ptr);
+         ptr = common_write_16_bit((uint16_t)entry->rssi_out, ptr);
+         ptr = common_write_16_bit(entry->etx, ptr);
+         ptr = common_write_16_bit(entry->tx_ok, ptr);
+         ptr = common_write_16_bit(entry->tx_fail, ptr);
+         ptr = link_quality_hist_write((const uint8_t *)entry->rssi_hist, entry->rssi_head, entry->rssi_count, ptr);
+         ptr = link_quality_hist_write(entry->tx_hist, entry->tx_head, entry->tx_count, ptr);
+         count++;
+     }
+     buf[1] = count;
+     return ptr - buf;
+ }
+
+ #endif // LINK_QUALITY_ENABLE
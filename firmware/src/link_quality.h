@@ -0,0 +1,38 @@
+/*
+ *  ======== link_quality.h ========
+ *  Link quality of each neighbor, see link_quality.c
+ */
+
+ #ifndef LINK_QUALITY_H
+ #define LINK_QUALITY_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP, multi byte fields big endian:
+  * version(1) neighbors(1) samples per history(1), then per neighbor:
+  * EUI-64(8) RSSI in EWMA(2) RSSI out EWMA(2) ETX(2) tx ok(2) tx failed(2)
+  * RSSI samples(1) RSSI history(samples per history, oldest first)
+  * tx samples(1) tx history(samples per history, oldest first)
+  * The EWMAs are signed 1/16 dBm, INT16_MIN until the first sample. The ETX is in 1/128,
+  * 0 until the first unicast. A tx sample is the attempts of a frame, 0 if it failed. */
+ #define LINK_QUALITY_RECORD_VERSION 1
+ #define LINK_QUALITY_HEADER_LEN     3
+ #define LINK_QUALITY_ENTRY_LEN      (20 + 2 * LINK_QUALITY_SAMPLES)
+
+ // Neighbor table slots tracked, neighbors in the slots above are not
+ #ifndef LINK_QUALITY_NEIGHBORS
+ #define LINK_QUALITY_NEIGHBORS      16
+ #endif
+ #ifndef LINK_QUALITY_SAMPLES
+ #define LINK_QUALITY_SAMPLES        8
+ #endif
+ #define LINK_QUALITY_RECORD_MAX_LEN (LINK_QUALITY_HEADER_LEN + \
+                                      LINK_QUALITY_NEIGHBORS * LINK_QUALITY_ENTRY_LEN)
+
+ /*!
+  * Serialize the neighbors still in the MAC neighbor table, see LINK_QUALITY_RECORD_VERSION
+  * for the layout. Returns bytes written, 0 if the buffer cannot hold the header.
+  */
+ uint16_t link_quality_write(uint8_t *buf, uint16_t buf_len);
+
+ #endif //LINK_QUALITY_H
@@ -0,0 +1,153 @@
+/*
+ *  ======== low_power.c ========
+ *  Standby accounting and trace power constraints for battery powered nodes (LOW_POWER_ENABLE).
+ *  The ITM trace output is garbled when the device powers down in idle, so standby is only
+ *  blocked while trace output is on. Time spent in standby is measured on the RTC from the
+ *  Power driver notifications, and turned into a duty cycle and charge estimate for CoAP.
+ */
+
+ #if defined(LOW_POWER_ENABLE) && !defined(WISUN_NCP_ENABLE)
+
+ #include <stdint.h>
+ #include <stdbool.h>
+ #include <ti/devices/DeviceFamily.h>
+ #include DeviceFamily_constructPath(driverlib/aon_rtc.h)
+ #include <ti/drivers/Power.h>
+ #include <ti/drivers/power/PowerCC26XX.h>
+ #include <ti/drivers/dpl/HwiP.h>
+ #include "ns_trace.h"
+ #include "trace_config.h"
+ #include "common_functions.h"
+ #include "low_power.h"
+
+ #define TRACE_GROUP "lpwr"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_LPWR
+
+ /* Current while awake. A Wi-SUN router keeps listening on its unicast schedule,
+  * so the CC1352 RX current dominates over the CPU */
+ #ifndef LOW_POWER_AWAKE_UA
+ #define LOW_POWER_AWAKE_UA          5800
+ #endif
+ /* Current in standby with the RTC running and RAM retained */
+ #ifndef LOW_POWER_STANDBY_NA
+ #define LOW_POWER_STANDBY_NA        850
+ #endif
+
+ typedef struct {
+     uint64_t start_us;
+     uint64_t standby_us;                        // Standby time of the completed intervals
+     uint64_t standby_entered_us;                // Start of the current standby, 0 when awake
+     uint32_t wakeups;
+     bool trace_on;
+     uint32_t trace_level;                       // Trace levels to restore when output is turned on
+ } low_power_state_t;
+
+ static low_power_state_t low_power = {0};
+ static Power_NotifyObj low_power_notify_obj;
+
+ /*!
+  * RTC time in us, the RTC keeps running in standby
+  */
+ static uint64_t low_power_rtc_us(void)
+ {
+     uint64_t rtc = AONRTCCurrent64BitValueGet();    // 32.32 fixed point seconds
+     return (rtc >> 32) * 1000000 + (((rtc & 0xFFFFFFFF) * 1000000) >> 32);
+ }
+
+ /*!
+  * Power driver notification, runs from the idle loop with interrupts disabled
+  */
+ static int low_power_notify(unsigned int eventType, uintptr_t eventArg, uintptr_t clientArg)
+ {
+     uint64_t now = low_power_rtc_us();
+
+     if (eventType == PowerCC26XX_ENTERING_STANDBY) {
+         low_power.standby_entered_us = now;
+     } else if (low_power.standby_entered_us) {
+         low_power.standby_us += now - low_power.standby_entered_us;
+         low_power.standby_entered_us = 0;
+         low_power.wakeups++;
+     }
+     return Power_NOTIFYDONE;
+ }
+
+ /*!
+  * Turn trace output on or off. While it is on the device stays out of idle power down
+  * and standby, to keep the ITM output intact.
+  */
+ void low_power_trace_set(bool enable)
+ {
+     if (enable == low_power.trace_on) {
+         return;
+     }
+     low_power.trace_on = enable;
+
+     if (enable) {
+         Power_setConstraint(PowerCC26XX_IDLE_PD_DISALLOW);
+         Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+         mbed_trace_config_set((mbed_trace_config_get() & ~TRACE_ACTIVE_LEVEL_ALL) | low_power.trace_level);
+         tr_info("Trace on, standby blocked");
+     } else {
+         tr_info("Trace off, standby allowed");
+         low_power.trace_level = mbed_trace_config_get() & TRACE_ACTIVE_LEVEL_ALL;
+         mbed_trace_config_set(mbed_trace_config_get() & ~TRACE_ACTIVE_LEVEL_ALL);
+         Power_releaseConstraint(PowerCC26XX_IDLE_PD_DISALLOW);
+         Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+     }
+ }
+
+ /*!
+  * Start standby accounting, call after the trace has been initialized
+  */
+ void low_power_init(bool trace_on)
+ {
+     low_power.start_us = low_power_rtc_us();
+     low_power.trace_level = mbed_trace_config_get() & TRACE_ACTIVE_LEVEL_ALL;
+     Power_registerNotify(&low_power_notify_obj, PowerCC26XX_ENTERING_STANDBY | PowerCC26XX_AWAKE_STANDBY,
+                          (Power_NotifyFxn)low_power_notify, 0);
+
+     // The trace is on after init, trace_set() only acts on a change
+     low_power.trace_on = !trace_on;
+     low_power_trace_set(trace_on);
+ }
+
+ /*!
+  * Serialize the duty cycle and charge estimate, see low_power.h
+  */
+ uint16_t low_power_stats_write(uint8_t *buf, uint16_t buf_len)
+ {
+     uint64_t now, uptime_us, standby_us, awake_us, charge_nc;
+     uint32_t wakeups;
+     uintptr_t key;
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < LOW_POWER_RECORD_LEN) {
+         return 0;
+     }
+
+     key = HwiP_disable();
+     now = low_power_rtc_us();
+     standby_us = low_power.standby_us;
+     wakeups = low_power.wakeups;
+     HwiP_restore(key);
+
+     uptime_us = now - low_power.start_us;
+     if (uptime_us == 0) {
+         uptime_us = 1;
+     }
+     awake_us = uptime_us - standby_us;
+     // us * uA is pC and us * nA is fC, sum them in nC
+     charge_nc = awake_us * LOW_POWER_AWAKE_UA / 1000 + standby_us * LOW_POWER_STANDBY_NA / 1000000;
+
+     *ptr++ = LOW_POWER_RECORD_VERSION;
+     *ptr++ = low_power.trace_on;
+     ptr = common_write_32_bit((uint32_t)(uptime_us / 1000000), ptr);
+     ptr = common_write_32_bit((uint32_t)(standby_us / 1000), ptr);
+     ptr = common_write_32_bit(wakeups, ptr);
+     ptr = common_write_16_bit((uint16_t)(awake_us * 10000 / uptime_us), ptr);
+     ptr = common_write_32_bit((uint32_t)(charge_nc * 1000 / uptime_us), ptr);
+     ptr = common_write_32_bit((uint32_t)(charge_nc / 3600000), ptr);    // 1 uAh is 3.6 mC
+     return ptr - buf;
+ }
+
+ #endif // LOW_POWER_ENABLE && !WISUN_NCP_ENABLE
@@ -0,0 +1,35 @@
+/*
+ *  ======== low_power.h ========
+ *  Standby accounting and trace power constraints, see low_power.c
+ */
+
+ #ifndef LOW_POWER_H
+ #define LOW_POWER_H
+
+ #include <stdint.h>
+ #include <stdbool.h>
+
+ /* Record read over CoAP, multi byte fields big endian:
+  * version(1) trace on(1) uptime s(4) standby ms(4) wakeups(4) duty cycle 0.01%(2)
+  * average current uA(4) charge uAh(4) */
+ #define LOW_POWER_RECORD_VERSION    1
+ #define LOW_POWER_RECORD_LEN        24
+
+ /*!
+  * Start standby accounting, call after the trace has been initialized
+  */
+ void low_power_init(bool trace_on);
+
+ /*!
+  * Turn trace output on or off. While it is on the device stays out of idle power down
+  * and standby, to keep the ITM output intact.
+  */
+ void low_power_trace_set(bool enable);
+
+ /*!
+  * Serialize the duty cycle and charge estimate, see LOW_POWER_RECORD_LEN for the layout.
+  * Returns bytes written, 0 if the buffer is too small.
+  */
+ uint16_t low_power_stats_write(uint8_t *buf, uint16_t buf_len);
+
+ #endif //LOW_POWER_H
@@ -73,6 +73,8 @@
 #include "ns_trace.h"
 #include "mesh_system.h"
 #include "mbedtls_wisun_config.h"
+#include "low_power.h"
+#include "tok_trace.h"
 
 #ifdef NV_RESTORE
 #include "macconfig.h"
@@ -200,7 +202,10 @@ void macHalAssertHandler(void)
  */
 int main(void)
 {
-#if !defined(WISUN_NCP_ENABLE) || !defined(EXCLUDE_TRACE) || defined(COAP_SERVICE_ENABLE)
+#if defined(LOW_POWER_ENABLE) && !defined(WISUN_NCP_ENABLE)
+    /* Low power nodes only disable power idle mode while trace
+       output is on, see low_power.c */
+#elif !defined(WISUN_NCP_ENABLE) || !defined(EXCLUDE_TRACE) || defined(COAP_SERVICE_ENABLE)
     /* Disable power idle mode to prevent known issue with ITM
        output garbage. */
     Power_setConstraint(PowerCC26XX_IDLE_PD_DISALLOW);
@@ -256,6 +261,18 @@ int main(void)
     }
     // Initalize trace
     ns_trace_init();
+#ifdef TOK_TRACE_ENABLE
+    tok_trace_init();
+#endif
+
+#ifdef LOW_POWER_ENABLE
+    // Standby is allowed whenever trace output is off
+#ifdef EXCLUDE_TRACE
+    low_power_init(false);
+#else
+    low_power_init(true);
+#endif
+#endif
 
     // Initialize mesh system and start the event loop thread
     mesh_system_init();
@@ -271,6 +288,9 @@ int main(void)
 
     // Initialize trace
     ns_trace_init();
+#ifdef TOK_TRACE_ENABLE
+    tok_trace_init();
+#endif
 
     // Initialize mesh system and start the ns event loop thread
     mesh_system_init();
@@ -0,0 +1,175 @@
+/*
+ *  ======== metrics_tlv.c ========
+ *  Encoder of the metrics payloads. Fields carry an ID and a length instead of sitting at
+ *  a struct offset, so the payloads do not depend on compiler padding or byte order and the
+ *  server decodes fields it knows by ID, whatever else a newer node sends.
+ *  See metrics_tlv.h for the layout and the field IDs.
+ */
+
+ #include <string.h>
+ #include "metrics_tlv.h"
+
+ static uint8_t *metrics_tlv_write_varint(uint8_t *ptr, uint16_t value)
+ {
+     while (value >= 0x80) {
+         *ptr++ = (uint8_t)value | 0x80;
+         value >>= 7;
+     }
+     *ptr++ = (uint8_t)value;
+     return ptr;
+ }
+
+ /*!
+  * Reserve room for a field of len bytes and write its ID and length,
+  * returns where the value goes or NULL if the field does not fit
+  */
+ static uint8_t *metrics_tlv_field(metrics_tlv_t *tlv, uint8_t id, uint16_t len)
+ {
+     uint16_t header_len = len < 0x80 ? 2 : (len < 0x4000 ? 3 : 4);
+
+     if (tlv->overflow || tlv->end - tlv->ptr < header_len + len) {
+         tlv->overflow = true;
+         return NULL;
+     }
+     *tlv->ptr++ = id;
+     tlv->ptr = metrics_tlv_write_varint(tlv->ptr, len);
+     return tlv->ptr;
+ }
+
+ void metrics_tlv_start(metrics_tlv_t *tlv, uint8_t *buf, uint16_t buf_len)
+ {
+     tlv->start = buf;
+     tlv->ptr = buf;
+     tlv->end = buf + buf_len;
+     tlv->overflow = !buf || buf_len < 1;
+     if (!tlv->overflow) {
+         *tlv->ptr++ = METRICS_TLV_SCHEMA_VERSION;
+     }
+ }
+
+ void metrics_tlv_uint(metrics_tlv_t *tlv, uint8_t id, uint32_t value)
+ {
+     uint8_t len = 4;
+     uint8_t *ptr;
+
+     if (value == 0) {
+         return;
+     }
+     while (!(value >> (8 * (len - 1)))) {
+         len--;
+     }
+     ptr = metrics_tlv_field(tlv, id, len);
+     if (!ptr) {
+         return;
+     }
+     while (len--) {
+         *ptr++ = (uint8_t)(value >> (8 * len));
+     }
+     tlv->ptr = ptr;
+ }
+
+ const metrics_tlv_member_t metrics_tlv_join_time[METRICS_TLV_JOIN_TIME_COUNT] = {
+     {METRICS_TLV_JOIN_TIME,             0,  4, false},
+     {METRICS_TLV_JOIN_TIME + 1,         4,  4, false},
+     {METRICS_TLV_JOIN_TIME + 2,         8,  4, false},
+     {METRICS_TLV_JOIN_TIME + 3,         12, 4, false},
+     {METRICS_TLV_JOIN_TIME + 4,         16, 4, false},
+ };
+
+ const metrics_tlv_member_t metrics_tlv_mac_debug[METRICS_TLV_MAC_DEBUG_COUNT] = {
+     {METRICS_TLV_BR_DISCONNECTS,        0,  4, true},
+     {METRICS_TLV_DEV_TABLE_SIZE,        4,  2, false},
+     {METRICS_TLV_FH_NT_NUM_NODES,       6,  2, false},
+ };
+
+ const metrics_tlv_member_t metrics_tlv_mac_perf[METRICS_TLV_MAC_PERF_COUNT] = {
+     {METRICS_TLV_MAC_ASYNC_REQ,         0,  4, true},
+     {METRICS_TLV_MAC_ASYNC_REQ + 1,     4,  4, true},
+     {METRICS_TLV_MAC_ASYNC_REQ + 2,     8,  4, true},
+     {METRICS_TLV_MAC_ASYNC_REQ + 3,     12, 4, true},
+     {METRICS_TLV_MAC_TX_BROADCAST,      16, 4, true},
+     {METRICS_TLV_MAC_TX_UNICAST,        20, 4, true},
+     {METRICS_TLV_MAC_TX_CONF_OK,        24, 4, true},
+     {METRICS_TLV_MAC_TX_CONF_NO_ACK,    28, 4, true},
+     {METRICS_TLV_MAC_TX_CONF_NO_ENTRY,  32, 4, true},
+     {METRICS_TLV_MAC_TX_CONF_CH_BUSY,   36, 4, true},
+     {METRICS_TLV_MAC_TX_CONF_OTHER,     40, 4, true},
+     {METRICS_TLV_MAC_RX_ASYNC_IND,      44, 4, true},
+     {METRICS_TLV_MAC_RX_ASYNC_IND + 1,  48, 4, true},
+     {METRICS_TLV_MAC_RX_ASYNC_IND + 2,  52, 4, true},
+     {METRICS_TLV_MAC_RX_ASYNC_IND + 3,  56, 4, true},
+     {METRICS_TLV_MAC_RX_IND,            60, 4, true},
+ };
+
+ uint32_t metrics_tlv_member_get(const metrics_tlv_member_t *member, const void *data, uint16_t size)
+ {
+     const uint8_t *ptr = (const uint8_t *)data + member->offset;
+     uint16_t half;
+     uint32_t word;
+
+     if (member->offset + member->size > size) {
+         return 0;
+     }
+     if (member->size == 2) {
+         memcpy(&half, ptr, sizeof(half));
+         return half;
+     }
+     memcpy(&word, ptr, sizeof(word));
+     return word;
+ }
+
+ void metrics_tlv_members(metrics_tlv_t *tlv, const metrics_tlv_member_t *members, uint8_t count,
+                          const void *data, uint16_t size)
+ {
+     uint8_t i;
+
+     for (i = 0; i < count; i++) {
+         metrics_tlv_uint(tlv, members[i].id, metrics_tlv_member_get(&members[i], data, size));
+     }
+ }
+
+ void metrics_tlv_bytes(metrics_tlv_t *tlv, uint8_t id, const uint8_t *data, uint16_t len)
+ {
+     uint8_t *ptr;
+
+     if (len == 0) {
+         return;
+     }
+     ptr = metrics_tlv_field(tlv, id, len);
+     if (!ptr) {
+         return;
+     }
+     memcpy(ptr, data, len);
+     tlv->ptr = ptr + len;
+ }
+
+ uint8_t *metrics_tlv_open(metrics_tlv_t *tlv, uint8_t id)
+ {
+     uint8_t *mark = tlv->ptr;
+
+     // The length is patched by metrics_tlv_close(), one byte is kept for it
+     if (!metrics_tlv_field(tlv, id, 0)) {
+         return NULL;
+     }
+     return mark;
+ }
+
+ void metrics_tlv_close(metrics_tlv_t *tlv, uint8_t *mark)
+ {
+     uint16_t len;
+
+     if (!mark || tlv->overflow) {
+         return;
+     }
+     len = tlv->ptr - (mark + 2);
+     if (len >= 0x80) {
+         tlv->overflow = true;
+         return;
+     }
+     mark[1] = (uint8_t)len;
+ }
+
+ uint16_t metrics_tlv_end(const metrics_tlv_t *tlv)
+ {
+     return tlv->overflow ? 0 : tlv->ptr - tlv->start;
+ }
@@ -0,0 +1,124 @@
+/*
+ *  ======== metrics_tlv.h ========
+ *  Self describing encoding of the metrics, see metrics_tlv.c
+ */
+
+ #ifndef METRICS_TLV_H
+ #define METRICS_TLV_H
+
+ #include <stdint.h>
+ #include <stdbool.h>
+
+ /* A payload is the schema version(1) followed by fields of
+  * ID(1) length(varint) value(length). Integers are big endian in as few bytes as hold them,
+  * fields with the value 0 are left out. A reader skips the IDs it does not know, so fields
+  * can be added without a new schema version, a new version is only needed when the meaning
+  * of an ID changes. Varints are 7 bits a byte, low bits first, 0x80 set on all but the last.
+  * The server decodes with the table in ti-wisun-webapp/server/src/parsing.js, keep both in step. */
+ #define METRICS_TLV_SCHEMA_VERSION      2
+
+ // Field IDs of the metrics and telemetry payloads
+ #define METRICS_TLV_REVISION            0x01    // test_metrics_s revision
+ #define METRICS_TLV_HEAP_SIZE           0x02
+ #define METRICS_TLV_HEAP_ALLOCATED      0x03
+ #define METRICS_TLV_HEAP_ALLOCATED_MAX  0x04
+ #define METRICS_TLV_RANK                0x05
+ #define METRICS_TLV_UDP_RECEIVED        0x06
+ #define METRICS_TLV_UPTIME_S            0x07
+ #define METRICS_TLV_TELEMETRY_SEQ       0x08
+ #define METRICS_TLV_TELEMETRY_FLAGS     0x09
+ #define METRICS_TLV_TELEMETRY_INTERVAL  0x0A
+ #define METRICS_TLV_JOIN_TIME           0x10    // 0x10-0x14, the join times of JOIN_TIME_s, 10 us ticks
+ #define METRICS_TLV_JOIN_TIME_COUNT     5
+ // MAC debug counts of timac_getMACDebugCounts()
+ #define METRICS_TLV_BR_DISCONNECTS      0x20
+ #define METRICS_TLV_DEV_TABLE_SIZE      0x21
+ #define METRICS_TLV_FH_NT_NUM_NODES     0x22
+ #define METRICS_TLV_MAC_DEBUG_COUNT     3
+ // MAC perf data of timac_getMACPerfData()
+ #define METRICS_TLV_MAC_ASYNC_REQ       0x40    // 0x40-0x43, per async frame type
+ #define METRICS_TLV_MAC_TX_BROADCAST    0x44
+ #define METRICS_TLV_MAC_TX_UNICAST      0x45
+ #define METRICS_TLV_MAC_TX_CONF_OK      0x46
+ #define METRICS_TLV_MAC_TX_CONF_NO_ACK  0x47
+ #define METRICS_TLV_MAC_TX_CONF_NO_ENTRY 0x48
+ #define METRICS_TLV_MAC_TX_CONF_CH_BUSY 0x49
+ #define METRICS_TLV_MAC_TX_CONF_OTHER   0x4A
+ #define METRICS_TLV_MAC_RX_ASYNC_IND    0x4B    // 0x4B-0x4E, per async frame type
+ #define METRICS_TLV_MAC_RX_IND          0x4F
+ #define METRICS_TLV_MAC_PERF_COUNT      16
+ #define METRICS_TLV_MPL_LATENCY         0x60    // MPL latency record, see MPL_LAT_RECORD_VERSION
+ #define METRICS_TLV_TASK_STATS          0x61    // Task record, see TASK_STATS_RECORD_VERSION
+ #define METRICS_TLV_NEIGHBOR            0x70    // Nested, one per neighbor, IDs below
+
+ // Field IDs inside METRICS_TLV_NEIGHBOR
+ #define METRICS_TLV_NEIGHBOR_MAC        0x01
+ #define METRICS_TLV_NEIGHBOR_RSSI_IN    0x02
+ #define METRICS_TLV_NEIGHBOR_RSSI_OUT   0x03
+
+ // Bytes a field of a 32-bit value takes at most
+ #define METRICS_TLV_UINT_MAX_LEN        6
+
+ /* A field of an SDK struct, encoded by value with its own ID. The structs are declared in the
+  * SDK headers, the offsets follow their layout (the fixed offsets spinel-cli.py read before). */
+ typedef struct {
+     uint8_t id;
+     uint8_t offset;     // Bytes from the start of the struct
+     uint8_t size;       // 2 or 4, in the byte order of the node
+     bool counter;       // Counts up, telemetry sends its changes
+ } metrics_tlv_member_t;
+
+ extern const metrics_tlv_member_t metrics_tlv_join_time[METRICS_TLV_JOIN_TIME_COUNT];
+ extern const metrics_tlv_member_t metrics_tlv_mac_debug[METRICS_TLV_MAC_DEBUG_COUNT];
+ extern const metrics_tlv_member_t metrics_tlv_mac_perf[METRICS_TLV_MAC_PERF_COUNT];
+
+ typedef struct {
+     uint8_t *start;
+     uint8_t *ptr;
+     uint8_t *end;
+     bool overflow;      // A field did not fit, the payload is not usable
+ } metrics_tlv_t;
+
+ /*!
+  * Start a payload in buf, with the schema version
+  */
+ void metrics_tlv_start(metrics_tlv_t *tlv, uint8_t *buf, uint16_t buf_len);
+
+ /*!
+  * Add an integer field, left out when value is 0
+  */
+ void metrics_tlv_uint(metrics_tlv_t *tlv, uint8_t id, uint32_t value);
+
+ /*!
+  * Value of a member in data, 0 if it lies past size bytes
+  */
+ uint32_t metrics_tlv_member_get(const metrics_tlv_member_t *member, const void *data, uint16_t size);
+
+ /*!
+  * Add the count members of the struct at data, of size bytes, as integer fields
+  */
+ void metrics_tlv_members(metrics_tlv_t *tlv, const metrics_tlv_member_t *members, uint8_t count,
+                          const void *data, uint16_t size);
+
+ /*!
+  * Add a field holding len bytes of data, left out when len is 0
+  */
+ void metrics_tlv_bytes(metrics_tlv_t *tlv, uint8_t id, const uint8_t *data, uint16_t len);
+
+ /*!
+  * Start a field holding other fields, returns the mark to pass to metrics_tlv_close()
+  */
+ uint8_t *metrics_tlv_open(metrics_tlv_t *tlv, uint8_t id);
+
+ /*!
+  * Close the field started at mark, its length is filled in. Nested fields must
+  * stay below 128 bytes.
+  */
+ void metrics_tlv_close(metrics_tlv_t *tlv, uint8_t *mark);
+
+ /*!
+  * Returns the payload length, 0 if something did not fit
+  */
+ uint16_t metrics_tlv_end(const metrics_tlv_t *tlv);
+
+ #endif //METRICS_TLV_H
@@ -0,0 +1,350 @@
+/*
+ *  ======== ncp_transport.c ========
+ *  NCP side of the host link: UART and Spinel send signals from the platform
+ *  layer, and the NCP tasklet events that process them. Kept apart from
+ *  application.c so it also builds on Linux, see firmware/tools/ncp_linkbench.
+ */
+
+ #ifdef WISUN_NCP_ENABLE
+
+ #include <stdint.h>
+ #include <stdbool.h>
+ #include <ti/drivers/UART2.h>
+ #include <ti/drivers/dpl/HwiP.h>
+ #include "ti_drivers_config.h"
+ #include "eventOS_event.h"
+ #include "eventOS_event_timer.h"
+ #include "platform/system.h"
+ #include "application.h"
+ #include "ncp_transport.h"
+
+ /* The counters of ncp_uart_stats are traced this often, 0 leaves them to a debugger or a
+  * host build that reads them directly (tools/ncp_linkbench) */
+ #ifndef NCP_UART_STATS_INTERVAL_S
+ #define NCP_UART_STATS_INTERVAL_S   60
+ #endif
+
+ #if NCP_UART_STATS_INTERVAL_S > 0
+ #include "ns_trace.h"
+ #include "trace_config.h"
+
+ #define TRACE_GROUP "ncpt"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_NCPT
+ #endif
+
+ /* Hooks on the calls between the prebuilt NCP libraries and the drivers, redirected at link
+  * time, with the GNU linker:
+  *     -Wl,--wrap=otPlatUartReceived,--wrap=otPlatUartSend,--wrap=UART2_open
+  * and with the TI linker by the symbol maps of link_hooks.cmd, with --define=WISUN_NCP_ENABLE.
+  * The OpenThread UART calls are counted in bytes, and UART2_open sets the NCP link rate.
+  * The host builds of tools/ncp_linkbench count their bytes in the emulated platform instead. */
+ #ifndef NCP_UART_HOOKS
+ #define NCP_UART_HOOKS              1
+ #endif
+
+ /* Baud rate of the NCP UART (CONFIG_UART2_0). The platform layer opens it at the SDK's
+  * 115200, the UART2_open hook replaces the rate. The webapp finds a faster rate when it
+  * is among its -b/--baud-rates. */
+ #ifndef NCP_UART_BAUD_RATE
+ #define NCP_UART_BAUD_RATE          115200
+ #endif
+
+ #if NCP_UART_HOOKS
+ #include "openthread/platform/uart.h"
+ #endif
+
+ extern int8_t ncp_tasklet_id;
+
+ /* Async Spinel notifications signalled within this many ms are sent in one tasklet turn,
+  * 0 sends them on the next turn of the event loop */
+ #ifndef NCP_ASYNC_MAX_LATENCY_MS
+ #define NCP_ASYNC_MAX_LATENCY_MS    0
+ #endif
+ #define NCP_ASYNC_TIMER_ID          0
+ // Posts an NCP_UART_EVENT, told apart from the UART signals by its event id
+ #define NCP_UART_STATS_TIMER_ID     1
+
+ ncp_uart_stats_t ncp_uart_stats = {0};
+ static uintptr_t ncp_uart_pending = 0;      // PLATFORM_UART_EVENT_* flags not yet processed
+ static uint32_t ncp_uart_batch = 0;
+ static bool ncp_uart_event_queued = false;
+ static uint32_t ncp_async_pending = 0;      // Async frames signalled but not yet handed to the NCP
+ static bool ncp_async_event_queued = false;
+
+ #if NCP_UART_HOOKS
+ extern UART2_Handle __real_UART2_open(uint_least8_t index, UART2_Params *params);
+ extern void __real_otPlatUartReceived(const uint8_t *aBuf, uint16_t aBufLength);
+ extern otError __real_otPlatUartSend(const uint8_t *aBuf, uint16_t aBufLength);
+
+ void __wrap_otPlatUartReceived(const uint8_t *aBuf, uint16_t aBufLength)
+ {
+     ncp_uart_stats.rx_bytes += aBufLength;
+     __real_otPlatUartReceived(aBuf, aBufLength);
+ }
+
+ otError __wrap_otPlatUartSend(const uint8_t *aBuf, uint16_t aBufLength)
+ {
+     otError error = __real_otPlatUartSend(aBuf, aBufLength);
+
+     if (error == OT_ERROR_NONE) {
+         ncp_uart_stats.tx_bytes += aBufLength;
+     }
+     return error;
+ }
+
+ UART2_Handle __wrap_UART2_open(uint_least8_t index, UART2_Params *params)
+ {
+     UART2_Params ncp_params;
+
+     if (index != CONFIG_UART2_0) {
+         return __real_UART2_open(index, params);
+     }
+     // The driver copies the parameters when opening, a local copy is enough
+     if (params) {
+         ncp_params = *params;
+     } else {
+         UART2_Params_init(&ncp_params);
+     }
+     ncp_params.baudRate = NCP_UART_BAUD_RATE;
+     return __real_UART2_open(index, &ncp_params);
+ }
+ #endif
+
+ /*!
+  * Signal NCP tasklet with the event NCP_SEND_RESPONSE_EVENT,
+  * so that NCP_tasklet can process the sending of a response
+  * back to the host, when the host sends a command.
+  * e.g. Response to a command from host to set/get configuration.
+  */
+ void platformNcpSendRspSignal()
+ {
+     //post an event to ncp_tasklet
+     arm_event_s event = {
+            .sender = 0,
+            .receiver = ncp_tasklet_id,
+            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
+            .event_type = NCP_SEND_RESPONSE_EVENT,
+            .event_id = 0,
+            .event_data = 0
+        };
+ 
+    ncp_uart_stats.rsp_frames++;
+    eventOS_event_send(&event);
+ }
+ 
+ /*!
+  * Signal NCP tasklet with the event NCP_SEND_ASYNC_RSPONSE_EVENT
+  * so that NCP tasket can process the sending of an async response
+  * back to the host - e.g. reception of a packet by the NWP
+  */
+ void platformNcpSendAsyncRspSignal()
+ {
+     uintptr_t key;
+     bool post;
+     int8_t ret;
+
+     key = HwiP_disable();
+     ncp_async_pending++;
+     ncp_uart_stats.async_frames++;
+     post = !ncp_async_event_queued;
+     if (post) {
+         ncp_async_event_queued = true;
+     } else {
+         ncp_uart_stats.async_coalesced++;
+     }
+     HwiP_restore(key);
+
+     if (!post) {
+         return;
+     }
+
+ #if NCP_ASYNC_MAX_LATENCY_MS > 0
+     // Give the frames that follow a burst's first one time to join it
+     ret = eventOS_event_timer_request(NCP_ASYNC_TIMER_ID, NCP_SEND_ASYNC_RSPONSE_EVENT,
+                                       ncp_tasklet_id, NCP_ASYNC_MAX_LATENCY_MS);
+ #else
+     //post an event to ncp_tasklet
+     arm_event_s event = {
+            .sender = 0,
+            .receiver = ncp_tasklet_id,
+            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
+            .event_type = NCP_SEND_ASYNC_RSPONSE_EVENT,
+            .event_id = 0,
+            .event_data = 0
+        };
+
+     ret = eventOS_event_send(&event);
+ #endif
+     if (ret != 0) {
+         // Keep the frames counted, the next signal schedules them again
+         key = HwiP_disable();
+         ncp_async_event_queued = false;
+         ncp_uart_stats.async_dropped++;
+         HwiP_restore(key);
+     } else {
+         ncp_uart_stats.async_events++;
+     }
+ }
+
+ /*!
+  * Hand every async frame signalled since the event was scheduled to the NCP
+  * back to back, so they reach the UART TX ring as one write burst
+  */
+ static void ncp_async_process(void)
+ {
+     uintptr_t key;
+     uint32_t count;
+
+     key = HwiP_disable();
+     count = ncp_async_pending;
+     ncp_async_pending = 0;
+     ncp_async_event_queued = false;
+     HwiP_restore(key);
+
+     if (count > ncp_uart_stats.async_max_batch) {
+         ncp_uart_stats.async_max_batch = count;
+     }
+     while (count--) {
+         platformNcpSendAsyncProcess();
+     }
+ }
+ 
+ /*!
+  * Callback from the UART module indicating need for processing, arg carries
+  * PLATFORM_UART_EVENT_* flags. Runs in driver callback context, so only one
+  * NCP_UART_EVENT is kept queued and later flags are or'ed into it.
+  */
+ void platformUartSignal(uintptr_t arg)
+ {
+     uintptr_t key;
+     bool post;
+
+     key = HwiP_disable();
+     ncp_uart_pending |= arg;
+     ncp_uart_batch++;
+     ncp_uart_stats.signals++;
+     post = !ncp_uart_event_queued;
+     if (post) {
+         ncp_uart_event_queued = true;
+     } else {
+         ncp_uart_stats.coalesced++;
+     }
+     HwiP_restore(key);
+
+     if (!post) {
+         return;
+     }
+
+     //post an event to ncp_tasklet, the flags are picked up when it runs
+     arm_event_s event = {
+            .sender = 0,
+            .receiver = ncp_tasklet_id,
+            .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
+            .event_type = NCP_UART_EVENT,
+            .event_id = 0,
+            .event_data = 0
+        };
+
+     if (eventOS_event_send(&event) != 0) {
+         // Leave the flags pending, the next signal tries again
+         key = HwiP_disable();
+         ncp_uart_event_queued = false;
+         ncp_uart_stats.post_failures++;
+         HwiP_restore(key);
+     } else {
+         ncp_uart_stats.events++;
+     }
+ }
+
+ /*!
+  * Take the UART flags gathered since the NCP_UART_EVENT was posted and process them at once
+  */
+ static void ncp_uart_process(void)
+ {
+     uintptr_t key;
+     uintptr_t flags;
+     uint32_t batch;
+
+     key = HwiP_disable();
+     flags = ncp_uart_pending;
+     batch = ncp_uart_batch;
+     ncp_uart_pending = 0;
+     ncp_uart_batch = 0;
+     ncp_uart_event_queued = false;
+     HwiP_restore(key);
+
+     if (batch > ncp_uart_stats.max_batch) {
+         ncp_uart_stats.max_batch = batch;
+     }
+     if (flags) {
+         platformUartProcess(flags);
+     }
+     // The NCP UART is opened by the platform layer, the driver hands out its config entry as the handle
+     ncp_uart_stats.rx_overruns = UART2_getOverrunCount((UART2_Handle)&UART2_config[CONFIG_UART2_0]);
+ }
+
+ #if NCP_UART_STATS_INTERVAL_S > 0
+ /*!
+  * Trace the transport counters so the host sees them with the rest of the NCP trace,
+  * and schedule the next time
+  */
+ static void ncp_uart_stats_trace(void)
+ {
+     tr_info("uart rx_bytes:%lu tx_bytes:%lu overruns:%lu",
+             (unsigned long)ncp_uart_stats.rx_bytes, (unsigned long)ncp_uart_stats.tx_bytes,
+             (unsigned long)ncp_uart_stats.rx_overruns);
+     tr_info("uart signals:%lu events:%lu coalesced:%lu post_failures:%lu max_batch:%lu",
+             (unsigned long)ncp_uart_stats.signals, (unsigned long)ncp_uart_stats.events,
+             (unsigned long)ncp_uart_stats.coalesced, (unsigned long)ncp_uart_stats.post_failures,
+             (unsigned long)ncp_uart_stats.max_batch);
+     tr_info("spinel rsp:%lu async:%lu async_events:%lu async_coalesced:%lu async_dropped:%lu async_max_batch:%lu",
+             (unsigned long)ncp_uart_stats.rsp_frames, (unsigned long)ncp_uart_stats.async_frames,
+             (unsigned long)ncp_uart_stats.async_events, (unsigned long)ncp_uart_stats.async_coalesced,
+             (unsigned long)ncp_uart_stats.async_dropped, (unsigned long)ncp_uart_stats.async_max_batch);
+     eventOS_event_timer_request(NCP_UART_STATS_TIMER_ID, NCP_UART_EVENT, ncp_tasklet_id,
+                                 NCP_UART_STATS_INTERVAL_S * 1000);
+ }
+ #endif
+
+ /*!
+  * Start the periodic trace of the transport counters, called once the NCP tasklet has its id
+  */
+ void ncp_transport_init(void)
+ {
+ #if NCP_UART_STATS_INTERVAL_S > 0
+     eventOS_event_timer_request(NCP_UART_STATS_TIMER_ID, NCP_UART_EVENT, ncp_tasklet_id,
+                                 NCP_UART_STATS_INTERVAL_S * 1000);
+ #endif
+ }
+
+ /*!
+  * Handle the UART and Spinel send events of the NCP tasklet
+  */
+ void ncp_transport_event(uint8_t event_type, uint8_t event_id)
+ {
+     switch (event_type)
+     {
+         case NCP_UART_EVENT:
+ #if NCP_UART_STATS_INTERVAL_S > 0
+             if (event_id == NCP_UART_STATS_TIMER_ID) {
+                 ncp_uart_stats_trace();
+                 break;
+             }
+ #endif
+             ncp_uart_process();
+             break;
+
+         case NCP_SEND_RESPONSE_EVENT:
+             platformNcpSendProcess();
+             break;
+
+         case NCP_SEND_ASYNC_RSPONSE_EVENT:
+             ncp_async_process();
+             break;
+
+         default:
+             break;
+     }
+ }
+
+ #endif //WISUN_NCP_ENABLE
@@ -0,0 +1,44 @@
+/*
+ *  ======== ncp_transport.h ========
+ *  NCP host link transport, see ncp_transport.c
+ */
+
+ #ifndef NCP_TRANSPORT_H
+ #define NCP_TRANSPORT_H
+
+ #include <stdint.h>
+
+ /* NCP UART transport counters. UART signals raised while an NCP_UART_EVENT is
+  * still queued are merged into it, so a burst of chunks is handled in one pass.
+  * Traced by the "ncpt" group every NCP_UART_STATS_INTERVAL_S. The byte counts come from the
+  * OpenThread UART calls, hooked with link_hooks.cmd (--define=WISUN_NCP_ENABLE) or GNU --wrap */
+ typedef struct {
+     uint32_t signals;           // platformUartSignal() calls
+     uint32_t events;            // NCP_UART_EVENTs posted
+     uint32_t coalesced;         // Signals merged into an already queued event
+     uint32_t post_failures;     // NCP_UART_EVENTs that could not be queued
+     uint32_t max_batch;         // Most signals handled by one event
+     uint32_t rsp_frames;        // Spinel responses signalled for sending
+     uint32_t async_frames;      // Async Spinel frames signalled for sending
+     uint32_t async_events;      // NCP_SEND_ASYNC_RSPONSE_EVENTs scheduled
+     uint32_t async_coalesced;   // Async frames joining an already scheduled event
+     uint32_t async_dropped;     // Async events that could not be scheduled, frames wait for the next signal
+     uint32_t async_max_batch;   // Most async frames sent in one tasklet turn
+     uint32_t rx_overruns;       // Receive overruns counted by the UART2 driver
+     uint32_t rx_bytes;          // Bytes handed to the NCP by the platform layer
+     uint32_t tx_bytes;          // Bytes the NCP had the platform layer send
+ } ncp_uart_stats_t;
+
+ extern ncp_uart_stats_t ncp_uart_stats;
+
+ /*!
+  * Start the periodic trace of ncp_uart_stats (NCP_UART_STATS_INTERVAL_S)
+  */
+ void ncp_transport_init(void);
+
+ /*!
+  * Handle the UART and Spinel send events of the NCP tasklet
+  */
+ void ncp_transport_event(uint8_t event_type, uint8_t event_id);
+
+ #endif //NCP_TRANSPORT_H
@@ -0,0 +1,28 @@
+/*
+ *  ======== node_state.h ========
+ *  State of the node kept by application.c and the Wi-SUN tasklet, for the modules that
+ *  send to the border router on their own
+ */
+
+ #ifndef NODE_STATE_H
+ #define NODE_STATE_H
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #ifdef WISUN_TEST_METRICS
+ #include "application.h"
+ #endif
+
+ // Set once the DAO was sent, the border router has a route to the node from then on
+ extern bool sent_dao;
+ // Address of the border router, the root of the DODAG
+ extern uint8_t root_unicast_addr[16];
+
+ #ifdef WISUN_TEST_METRICS
+ /*!
+  * Sample the test metrics of the stack and the MAC, see application.c
+  */
+ void get_test_metrics(test_metrics_s *test_metrics);
+ #endif
+
+ #endif //NODE_STATE_H
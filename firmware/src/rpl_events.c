@@ -0,0 +1,231 @@
+/*
+ *  ======== rpl_events.c ========
+ *  RPL topology change log (RPL_EVENTS_ENABLE). The instance is sampled every
+ *  RPL_EVENTS_POLL_MS, a change of preferred parent, rank or DODAG version is stored in a
+ *  ring of RPL_EVENTS_SLOTS events with a sequence number, a timestamp and the DIO/DAO
+ *  counters of the moment. A reader passes the last sequence number it has and gets the
+ *  newer events, so the ring can be followed without reading it whole.
+ *  The DIO and DAO-ACK counters come from the nanostack calls handling them, redirected
+ *  here at link time, with the GNU linker:
+ *      -Wl,--wrap=rpl_instance_consistent_rx,--wrap=rpl_instance_inconsistent_rx,--wrap=rpl_instance_dao_acked
+ *  and with the TI linker by the symbol maps of link_hooks.cmd, with --define=RPL_EVENTS_ENABLE.
+ *  The DAOs sent are counted from the advance of the DAO sequence number.
+ */
+
+ #ifdef RPL_EVENTS_ENABLE
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <string.h>
+ #include "eventOS_event.h"
+ #include "eventOS_event_timer.h"
+ #include "NWK_INTERFACE/Include/protocol.h"
+ #include "RPL/rpl_protocol.h"
+ #include "RPL/rpl_upward.h"
+ #include "RPL/rpl_downward.h"
+ #include "RPL/rpl_structures.h"
+ #include "common_functions.h"
+ #include "uptime.h"
+ #include "rpl_events.h"
+
+ #ifndef RPL_EVENTS_SLOTS
+ #define RPL_EVENTS_SLOTS            32
+ #endif
+ #ifndef RPL_EVENTS_POLL_MS
+ #define RPL_EVENTS_POLL_MS          500
+ #endif
+ #define RPL_EVENTS_POLL_EVT         1
+ #define RPL_EVENTS_TIMER_ID         0
+
+ typedef struct {
+     uint32_t dio_rx;
+     uint32_t dio_inconsistent;
+     uint32_t dao_tx;
+     uint32_t dao_ack;
+ } rpl_events_counters_t;
+
+ typedef struct {
+     uint32_t seq;
+     uint32_t time_ms;
+     uint8_t changes;
+     uint8_t version;
+     uint16_t rank;
+     uint8_t parent[8];
+     rpl_events_counters_t counters;
+ } rpl_event_t;
+
+ // Last sampled state
+ typedef struct {
+     bool instance;
+     bool attached;
+     uint8_t version;
+     uint16_t rank;
+     uint8_t parent[8];
+     uint8_t dao_sequence;
+ } rpl_events_state_t;
+
+ extern void __real_rpl_instance_consistent_rx(rpl_instance_t *instance);
+ extern void __real_rpl_instance_inconsistent_rx(rpl_instance_t *instance);
+ extern void __real_rpl_instance_dao_acked(rpl_instance_t *instance, const uint8_t src[16], int8_t interface_id,
+                                           uint8_t dao_sequence, uint8_t status);
+ extern rpl_instance_t *get_rpl_instance();
+
+ static rpl_event_t rpl_events[RPL_EVENTS_SLOTS];
+ static uint32_t rpl_events_next_seq = 1;
+ static rpl_events_counters_t rpl_events_counters;
+ static rpl_events_state_t rpl_events_state;
+ static int8_t rpl_events_tasklet_id = -1;
+
+ void __wrap_rpl_instance_consistent_rx(rpl_instance_t *instance)
+ {
+     rpl_events_counters.dio_rx++;
+     __real_rpl_instance_consistent_rx(instance);
+ }
+
+ void __wrap_rpl_instance_inconsistent_rx(rpl_instance_t *instance)
+ {
+     rpl_events_counters.dio_rx++;
+     rpl_events_counters.dio_inconsistent++;
+     __real_rpl_instance_inconsistent_rx(instance);
+ }
+
+ void __wrap_rpl_instance_dao_acked(rpl_instance_t *instance, const uint8_t src[16], int8_t interface_id,
+                                    uint8_t dao_sequence, uint8_t status)
+ {
+     rpl_events_counters.dao_ack++;
+     __real_rpl_instance_dao_acked(instance, src, interface_id, dao_sequence, status);
+ }
+
+ // Wraps at 2^32 ms like the fields it goes in, a reader takes the differences modulo 2^32
+ static uint32_t rpl_events_time_ms(void)
+ {
+     return (uint32_t)uptime_ms();
+ }
+
+ /*!
+  * Sample the instance and log what changed since the last sample
+  */
+ static void rpl_events_sample(void)
+ {
+     rpl_instance_t *instance = get_rpl_instance();
+     rpl_neighbour_t *parent = instance ? rpl_instance_preferred_parent(instance) : NULL;
+     rpl_events_state_t now = {0};
+     rpl_event_t *event;
+     uint8_t changes = 0;
+
+     if (instance && parent) {
+         now.attached = true;
+         now.version = instance->current_dodag_version ? instance->current_dodag_version->number : 0;
+         now.rank = instance->current_rank;
+         memcpy(now.parent, parent->ll_address + 8, sizeof(now.parent));
+     }
+     if (instance) {
+         // The sequence advances by one per DAO, a uint8_t difference survives its wrap
+         now.instance = true;
+         now.dao_sequence = instance->dao_sequence;
+         if (rpl_events_state.instance) {
+             rpl_events_counters.dao_tx += (uint8_t)(now.dao_sequence - rpl_events_state.dao_sequence);
+         }
+     }
+
+     if (now.attached) {
+         if (!rpl_events_state.attached || memcmp(now.parent, rpl_events_state.parent, sizeof(now.parent))) {
+             changes |= RPL_EVENT_PARENT;
+         }
+         if (!rpl_events_state.attached || now.rank != rpl_events_state.rank) {
+             changes |= RPL_EVENT_RANK;
+         }
+         if (!rpl_events_state.attached || now.version != rpl_events_state.version) {
+             changes |= RPL_EVENT_VERSION;
+         }
+     } else if (rpl_events_state.attached) {
+         changes = RPL_EVENT_DETACHED;
+     }
+     rpl_events_state = now;
+     if (!changes) {
+         return;
+     }
+
+     event = &rpl_events[rpl_events_next_seq % RPL_EVENTS_SLOTS];
+     event->seq = rpl_events_next_seq++;
+     event->time_ms = rpl_events_time_ms();
+     event->changes = changes;
+     event->version = now.version;
+     event->rank = now.rank;
+     memcpy(event->parent, now.parent, sizeof(event->parent));
+     event->counters = rpl_events_counters;
+ }
+
+ static void rpl_events_tasklet(arm_event_s *event)
+ {
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             rpl_events_tasklet_id = event->receiver;
+             break;
+         case RPL_EVENTS_POLL_EVT:
+             rpl_events_sample();
+             break;
+         default:
+             return;
+     }
+     eventOS_event_timer_request(RPL_EVENTS_TIMER_ID, RPL_EVENTS_POLL_EVT, rpl_events_tasklet_id, RPL_EVENTS_POLL_MS);
+ }
+
+ /*!
+  * Start sampling the RPL instance
+  */
+ void rpl_events_init(void)
+ {
+     if (rpl_events_tasklet_id < 0) {
+         eventOS_event_handler_create(&rpl_events_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+     }
+ }
+
+ /*!
+  * Serialize the events after sequence number since, see rpl_events.h
+  */
+ uint16_t rpl_events_write(uint32_t since, uint8_t *buf, uint16_t buf_len)
+ {
+     uint32_t oldest = rpl_events_next_seq > RPL_EVENTS_SLOTS ? rpl_events_next_seq - RPL_EVENTS_SLOTS : 1;
+     uint32_t seq;
+     uint8_t count = 0;
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < RPL_EVENTS_HEADER_LEN) {
+         return 0;
+     }
+
+     *ptr++ = RPL_EVENTS_RECORD_VERSION;
+     ptr++;                                      // Event count, written last
+     ptr = common_write_32_bit(rpl_events_time_ms(), ptr);
+     ptr = common_write_32_bit(rpl_events_next_seq, ptr);
+     ptr = common_write_32_bit(oldest, ptr);
+     ptr = common_write_32_bit(rpl_events_counters.dio_rx, ptr);
+     ptr = common_write_32_bit(rpl_events_counters.dio_inconsistent, ptr);
+     ptr = common_write_32_bit(rpl_events_counters.dao_tx, ptr);
+     ptr = common_write_32_bit(rpl_events_counters.dao_ack, ptr);
+
+     // A cursor ahead of the log, from before a reboot, reads it from the start
+     if (since >= rpl_events_next_seq) {
+         since = 0;
+     }
+     for (seq = since + 1 > oldest ? since + 1 : oldest;
+          seq < rpl_events_next_seq && ptr + RPL_EVENTS_ENTRY_LEN <= buf + buf_len; seq++) {
+         const rpl_event_t *event = &rpl_events[seq % RPL_EVENTS_SLOTS];
+         ptr = common_write_32_bit(event->seq, ptr);
+         ptr = common_write_32_bit(event->time_ms, ptr);
+         *ptr++ = event->changes;
+         *ptr++ = event->version;
+         ptr = common_write_16_bit(event->rank, ptr);
+         memcpy(ptr, event->parent, sizeof(event->parent));
+         ptr += sizeof(event->parent);
+         ptr = common_write_32_bit(event->counters.dio_rx, ptr);
+         ptr = common_write_32_bit(event->counters.dio_inconsistent, ptr);
+         ptr = common_write_32_bit(event->counters.dao_tx, ptr);
+         count++;
+     }
+     buf[1] = count;
+     return ptr - buf;
+ }
+
+ #endif // RPL_EVENTS_ENABLE
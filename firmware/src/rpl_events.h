@@ -0,0 +1,46 @@
+/*
+ *  ======== rpl_events.h ========
+ *  RPL topology change log, see rpl_events.c
+ */
+
+ #ifndef RPL_EVENTS_H
+ #define RPL_EVENTS_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP, multi byte fields big endian:
+  * version(1) events(1) time ms(4) next sequence(4) oldest sequence(4)
+  * DIOs received(4) inconsistent DIOs(4) DAOs sent(4) DAO-ACKs received(4),
+  * then per event, oldest first:
+  * sequence(4) time ms(4) changes(1) DODAG version(1) rank(2) parent interface ID(8)
+  * DIOs received(4) inconsistent DIOs(4) DAOs sent(4)
+  * Events older than the oldest sequence were overwritten before they were read.
+  * The times are milliseconds since boot modulo 2^32, the header one is the time of the read. */
+ #define RPL_EVENTS_RECORD_VERSION   1
+ #define RPL_EVENTS_HEADER_LEN       30
+ #define RPL_EVENTS_ENTRY_LEN        32
+
+ // Changes of an event, RPL_EVENT_DETACHED with no instance or parent left
+ #define RPL_EVENT_PARENT            0x01
+ #define RPL_EVENT_RANK              0x02
+ #define RPL_EVENT_VERSION           0x04
+ #define RPL_EVENT_DETACHED          0x08
+
+ // Events in a record read over CoAP, the reader asks again from the last one it got
+ #ifndef RPL_EVENTS_RECORD_EVENTS
+ #define RPL_EVENTS_RECORD_EVENTS    16
+ #endif
+ #define RPL_EVENTS_RECORD_MAX_LEN   (RPL_EVENTS_HEADER_LEN + RPL_EVENTS_RECORD_EVENTS * RPL_EVENTS_ENTRY_LEN)
+
+ /*!
+  * Start sampling the RPL instance
+  */
+ void rpl_events_init(void);
+
+ /*!
+  * Serialize the events after sequence number since, as many as fit. Since 0 reads from
+  * the oldest event kept. Returns bytes written, 0 if the buffer cannot hold the header.
+  */
+ uint16_t rpl_events_write(uint32_t since, uint8_t *buf, uint16_t buf_len);
+
+ #endif //RPL_EVENTS_H
@@ -0,0 +1,128 @@
+/*
+ *  ======== task_stats.c ========
+ *  Stack high water marks and CPU load of every task, for sizing the thread stacks.
+ *  Stacks are filled with a known pattern when the task is created (Task.initStackFlag)
+ *  and the untouched part is measured by Task_stat(). The CPU time of each task is
+ *  accumulated by the Task hooks of the Load module (Load.taskEnabled).
+ */
+
+ #ifndef FREERTOS_SUPPORT
+
+ #include <stdint.h>
+ #include <stdbool.h>
+ #include <ti/sysbios/knl/Task.h>
+ #include <ti/sysbios/utils/Load.h>
+ #include "ns_trace.h"
+ #include "trace_config.h"
+ #include "common_functions.h"
+ #include "task_stats.h"
+
+ #define TRACE_GROUP "task"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_TASK
+
+ // A stack that gets this close to full is traced when the record is read
+ #define TASK_STATS_STACK_LOW_BYTES  64
+
+ /*!
+  * CPU load of a task over the last Load window in 0.01%
+  */
+ static uint16_t task_stats_load(Task_Handle task)
+ {
+     Load_Stat load;
+
+     if (!Load_getTaskLoad(task, &load) || load.totalTime == 0) {
+         return 0;
+     }
+     return (uint16_t)(((uint64_t)load.threadTime * 10000) / load.totalTime);
+ }
+
+ /*!
+  * Serialize the stack and CPU usage of all tasks, see task_stats.h
+  */
+ uint16_t task_stats_write(uint8_t *buf, uint16_t buf_len)
+ {
+     Task_Handle task;
+     Task_Stat stat;
+     uintptr_t key;
+     uint8_t count = 0;
+     uint8_t *ptr = buf + TASK_STATS_HEADER_LEN;
+
+     if (!buf || buf_len < TASK_STATS_HEADER_LEN) {
+         return 0;
+     }
+
+     // Keep the task list from changing while it is walked
+     key = Task_disable();
+     for (task = Task_Object_first(); task != NULL && count < TASK_STATS_MAX; task = Task_Object_next(task)) {
+         if (ptr + TASK_STATS_ENTRY_LEN > buf + buf_len) {
+             break;
+         }
+         Task_stat(task, &stat);
+         *ptr++ = (uint8_t)stat.priority;
+         ptr = common_write_16_bit((uint16_t)stat.stackSize, ptr);
+         ptr = common_write_16_bit((uint16_t)(stat.stackSize - stat.used), ptr);
+         ptr = common_write_16_bit(task_stats_load(task), ptr);
+         count++;
+     }
+     Task_restore(key);
+
+     // Traced once the scheduler runs again, the trace output may block
+     for (uint8_t i = 0; i < count; i++) {
+         const uint8_t *entry = buf + TASK_STATS_HEADER_LEN + i * TASK_STATS_ENTRY_LEN;
+         uint16_t stack_free = common_read_16_bit(entry + 3);
+         if (stack_free < TASK_STATS_STACK_LOW_BYTES) {
+             tr_warn("Task priority %d: %u of %u stack bytes free", entry[0], stack_free,
+                     common_read_16_bit(entry + 1));
+         }
+     }
+
+     buf[0] = TASK_STATS_RECORD_VERSION;
+     buf[1] = count;
+     common_write_16_bit((uint16_t)(Load_getCPULoad() * 100), buf + 2);
+     return ptr - buf;
+ }
+
+ #else // FREERTOS_SUPPORT
+
+ #include <stdint.h>
+ #include <FreeRTOS.h>
+ #include <task.h>
+ #include "common_functions.h"
+ #include "task_stats.h"
+
+ /*!
+  * Same record as the TI-RTOS build. FreeRTOS does not keep the stack size, it is written as 0.
+  * CPU load needs configGENERATE_RUN_TIME_STATS and is over the whole uptime.
+  */
+ uint16_t task_stats_write(uint8_t *buf, uint16_t buf_len)
+ {
+     TaskStatus_t status[TASK_STATS_MAX];
+     uint32_t total_time = 0;
+     UBaseType_t count, i;
+     uint16_t idle_load = 0;
+     uint8_t *ptr = buf + TASK_STATS_HEADER_LEN;
+
+     if (!buf || buf_len < TASK_STATS_HEADER_LEN) {
+         return 0;
+     }
+
+     count = uxTaskGetSystemState(status, TASK_STATS_MAX, &total_time);
+     for (i = 0; i < count && ptr + TASK_STATS_ENTRY_LEN <= buf + buf_len; i++) {
+         uint16_t load = total_time ? (uint16_t)(((uint64_t)status[i].ulRunTimeCounter * 10000) / total_time) : 0;
+         // Time at idle priority is what the CPU had to spare
+         if (status[i].uxCurrentPriority == tskIDLE_PRIORITY) {
+             idle_load += load;
+         }
+         *ptr++ = (uint8_t)status[i].uxCurrentPriority;
+         ptr = common_write_16_bit(0, ptr);
+         ptr = common_write_16_bit((uint16_t)(status[i].usStackHighWaterMark * sizeof(StackType_t)), ptr);
+         ptr = common_write_16_bit(load, ptr);
+     }
+
+     buf[0] = TASK_STATS_RECORD_VERSION;
+     buf[1] = (uint8_t)((ptr - buf - TASK_STATS_HEADER_LEN) / TASK_STATS_ENTRY_LEN);
+     common_write_16_bit(idle_load < 10000 ? 10000 - idle_load : 0, buf + 2);
+     return ptr - buf;
+ }
+
+ #endif // FREERTOS_SUPPORT
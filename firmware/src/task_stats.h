@@ -0,0 +1,26 @@
+/*
+ *  ======== task_stats.h ========
+ *  Stack high water marks and CPU load of every task, see task_stats.c
+ */
+
+ #ifndef TASK_STATS_H
+ #define TASK_STATS_H
+
+ #include <stdint.h>
+
+ /* Record read over CoAP and carried in the test metrics, multi byte fields big endian:
+  * version(1) tasks(1) cpu load 0.01%(2), then per task:
+  * priority(1) stack size(2) stack free at the high water mark(2) cpu load 0.01%(2) */
+ #define TASK_STATS_RECORD_VERSION   1
+ #define TASK_STATS_HEADER_LEN       4
+ #define TASK_STATS_ENTRY_LEN        7
+ #define TASK_STATS_MAX              16
+ #define TASK_STATS_RECORD_MAX_LEN   (TASK_STATS_HEADER_LEN + TASK_STATS_MAX * TASK_STATS_ENTRY_LEN)
+
+ /*!
+  * Serialize the stack and CPU usage of all tasks, see TASK_STATS_RECORD_MAX_LEN for the layout.
+  * Returns bytes written, 0 if the buffer cannot hold the header.
+  */
+ uint16_t task_stats_write(uint8_t *buf, uint16_t buf_len);
+
+ #endif //TASK_STATS_H
@@ -0,0 +1,240 @@
+/*
+ *  ======== telemetry.c ========
+ *  Metrics pushed to a collector (TELEMETRY_ENABLE, needs WISUN_TEST_METRICS). Every
+ *  TELEMETRY_INTERVAL_S the test metrics are sampled and sent in one UDP datagram to the
+ *  collector, by default the border router, where the webapp receives them. The counters
+ *  stay monotonic on the node and are sent as the change since the previous record, every
+ *  TELEMETRY_KEYFRAME_EVERY records and after a restart their full values are sent instead
+ *  so a collector that lost records is back in step. Nothing is reset by reading.
+ *  The datagram uses the fields of metrics_tlv.h, counters that did not change are left out.
+ *  The collector address, port and interval can be changed over CoAP, see telemetry_set().
+ */
+
+ #ifdef TELEMETRY_ENABLE
+
+ #ifndef WISUN_TEST_METRICS
+ #error "TELEMETRY_ENABLE needs WISUN_TEST_METRICS"
+ #endif
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <string.h>
+ #include "eventOS_event.h"
+ #include "eventOS_event_timer.h"
+ #include "socket_api.h"
+ #include "ns_address.h"
+ #include "ns_trace.h"
+ #include "trace_config.h"
+ #include "common_functions.h"
+ #include "application.h"
+ #include "uptime.h"
+ #include "metrics_tlv.h"
+ #include "node_state.h"
+ #include "telemetry.h"
+
+ #define TRACE_GROUP "telm"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_TELM
+
+ /* Datagram sent to the collector, fields of metrics_tlv.h:
+  * METRICS_TLV_TELEMETRY_SEQ, _FLAGS, _INTERVAL, METRICS_TLV_UPTIME_S, the heap and the rank,
+  * then METRICS_TLV_UDP_RECEIVED and the fields of the MAC debug counts and perf data.
+  * In a keyframe the counters hold their values, otherwise the zigzag encoded difference to
+  * the previous record, so a counter that did not change is left out. The other fields
+  * (metrics_tlv_member_t counter false) always hold their values. */
+ #define TELEMETRY_FLAG_KEYFRAME     0x01
+
+ #define TELEMETRY_FIELDS            (1 + METRICS_TLV_MAC_DEBUG_COUNT + METRICS_TLV_MAC_PERF_COUNT)
+ #define TELEMETRY_RECORD_MAX_LEN    (1 + (8 + TELEMETRY_FIELDS) * METRICS_TLV_UINT_MAX_LEN)
+
+ #ifndef TELEMETRY_INTERVAL_S
+ #define TELEMETRY_INTERVAL_S        60
+ #endif
+ #ifndef TELEMETRY_KEYFRAME_EVERY
+ #define TELEMETRY_KEYFRAME_EVERY    10
+ #endif
+ // 0xF0B0-0xF0BF, the 6LoWPAN header compression sends these in 4 bits
+ #ifndef TELEMETRY_PORT
+ #define TELEMETRY_PORT              0xF0B1
+ #endif
+ #define TELEMETRY_SEND_EVT          1
+ #define TELEMETRY_TIMER_ID          0
+
+ static int8_t telemetry_tasklet_id = -1;
+ static int8_t telemetry_socket_id = -1;
+ static ns_address_t telemetry_collector;
+ static bool telemetry_collector_set;
+ static uint16_t telemetry_interval_s = TELEMETRY_INTERVAL_S;
+ static uint16_t telemetry_seq;
+ static uint16_t telemetry_since_keyframe;
+ static uint32_t telemetry_last[TELEMETRY_FIELDS];
+ static test_metrics_s telemetry_metrics;
+
+ /*!
+  * Add a field, a counter as its value in a keyframe and as the change since the
+  * previous record otherwise. index is the field's slot in telemetry_last.
+  */
+ static void telemetry_field(metrics_tlv_t *tlv, uint8_t index, uint8_t id, uint32_t value,
+                             bool counter, bool keyframe)
+ {
+     if (keyframe || !counter) {
+         metrics_tlv_uint(tlv, id, value);
+     } else {
+         // Counters that went down (perf data gauges) stay short too
+         int32_t delta = (int32_t)(value - telemetry_last[index]);
+         metrics_tlv_uint(tlv, id, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+     }
+     telemetry_last[index] = value;
+ }
+
+ /*!
+  * Add the members of one of the SDK metric structs, from telemetry_last slot first on
+  */
+ static void telemetry_members(metrics_tlv_t *tlv, uint8_t first, const metrics_tlv_member_t *members,
+                               uint8_t count, const void *data, uint16_t size, bool keyframe)
+ {
+     uint8_t i;
+
+     for (i = 0; i < count; i++) {
+         telemetry_field(tlv, first + i, members[i].id, metrics_tlv_member_get(&members[i], data, size),
+                         members[i].counter, keyframe);
+     }
+ }
+
+ /*!
+  * Sample the metrics and build the record, see TELEMETRY_RECORD_MAX_LEN for the layout
+  */
+ static uint16_t telemetry_build(uint8_t *buf, uint16_t buf_len)
+ {
+     bool keyframe = telemetry_since_keyframe == 0;
+     metrics_tlv_t tlv;
+
+     get_test_metrics(&telemetry_metrics);
+     metrics_tlv_start(&tlv, buf, buf_len);
+     metrics_tlv_uint(&tlv, METRICS_TLV_TELEMETRY_SEQ, telemetry_seq++);
+     metrics_tlv_uint(&tlv, METRICS_TLV_TELEMETRY_FLAGS, keyframe ? TELEMETRY_FLAG_KEYFRAME : 0);
+     metrics_tlv_uint(&tlv, METRICS_TLV_TELEMETRY_INTERVAL, telemetry_interval_s);
+     metrics_tlv_uint(&tlv, METRICS_TLV_UPTIME_S, (uint32_t)(uptime_ms() / 1000));
+     metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_SIZE, telemetry_metrics.heap_debug.heap_sector_size);
+     metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_ALLOCATED, telemetry_metrics.heap_debug.heap_sector_allocated_bytes);
+     metrics_tlv_uint(&tlv, METRICS_TLV_HEAP_ALLOCATED_MAX, telemetry_metrics.heap_debug.heap_sector_allocated_bytes_max);
+     metrics_tlv_uint(&tlv, METRICS_TLV_RANK, telemetry_metrics.current_rank);
+     telemetry_field(&tlv, 0, METRICS_TLV_UDP_RECEIVED, telemetry_metrics.udpPktCnt, true, keyframe);
+     telemetry_members(&tlv, 1, metrics_tlv_mac_debug, METRICS_TLV_MAC_DEBUG_COUNT,
+                       &telemetry_metrics.mac_debug, sizeof(telemetry_metrics.mac_debug), keyframe);
+     telemetry_members(&tlv, 1 + METRICS_TLV_MAC_DEBUG_COUNT, metrics_tlv_mac_perf, METRICS_TLV_MAC_PERF_COUNT,
+                       &telemetry_metrics.mac_perf_data, sizeof(telemetry_metrics.mac_perf_data), keyframe);
+     if (++telemetry_since_keyframe >= TELEMETRY_KEYFRAME_EVERY) {
+         telemetry_since_keyframe = 0;
+     }
+     return metrics_tlv_end(&tlv);
+ }
+
+ // Nothing is received on the socket and send failures are seen in the sendto return
+ static void telemetry_socket_callback(void *cb)
+ {
+     (void)cb;
+ }
+
+ static void telemetry_send(void)
+ {
+     static uint8_t telemetry_buf[TELEMETRY_RECORD_MAX_LEN];
+     uint16_t len;
+     int16_t ret;
+
+     // Nothing to send to before the DAO made the node reachable
+     if (!telemetry_collector_set) {
+         if (!sent_dao) {
+             return;
+         }
+         memcpy(telemetry_collector.address, root_unicast_addr, 16);
+     }
+     if (telemetry_socket_id < 0) {
+         telemetry_socket_id = socket_open(SOCKET_UDP, 0, telemetry_socket_callback);
+         if (telemetry_socket_id < 0) {
+             tr_warn("socket open failed with error %d", telemetry_socket_id);
+             return;
+         }
+     }
+     len = telemetry_build(telemetry_buf, sizeof(telemetry_buf));
+     ret = socket_sendto(telemetry_socket_id, &telemetry_collector, telemetry_buf, len);
+     if (ret < 0) {
+         // The counters moved on, the next record has to carry their values
+         telemetry_since_keyframe = 0;
+         tr_debug("send failed with error %d", ret);
+     }
+ }
+
+ static void telemetry_tasklet(arm_event_s *event)
+ {
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             telemetry_tasklet_id = event->receiver;
+             break;
+         case TELEMETRY_SEND_EVT:
+             telemetry_send();
+             break;
+         default:
+             return;
+     }
+     if (telemetry_interval_s) {
+         eventOS_event_timer_request(TELEMETRY_TIMER_ID, TELEMETRY_SEND_EVT, telemetry_tasklet_id,
+                                     (uint32_t)telemetry_interval_s * 1000);
+     }
+ }
+
+ /*!
+  * Start pushing metrics to the border router every TELEMETRY_INTERVAL_S
+  */
+ void telemetry_init(void)
+ {
+     telemetry_collector.type = ADDRESS_IPV6;
+     telemetry_collector.identifier = TELEMETRY_PORT;
+     if (telemetry_tasklet_id < 0) {
+         eventOS_event_handler_create(&telemetry_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+     }
+ }
+
+ /*!
+  * Change the interval, 0 stops the records, and the collector. A NULL address
+  * sends to the border router again. The next record is a keyframe.
+  */
+ void telemetry_set(uint16_t interval_s, const uint8_t *address, uint16_t port)
+ {
+     telemetry_collector_set = address != NULL;
+     if (address) {
+         memcpy(telemetry_collector.address, address, 16);
+     }
+     telemetry_collector.identifier = port ? port : TELEMETRY_PORT;
+     telemetry_interval_s = interval_s;
+     telemetry_since_keyframe = 0;
+     if (telemetry_tasklet_id >= 0) {
+         eventOS_event_timer_cancel(TELEMETRY_TIMER_ID, telemetry_tasklet_id);
+         if (interval_s) {
+             eventOS_event_timer_request(TELEMETRY_TIMER_ID, TELEMETRY_SEND_EVT, telemetry_tasklet_id,
+                                         (uint32_t)interval_s * 1000);
+         }
+     }
+ }
+
+ /*!
+  * Serialize the settings, see telemetry.h
+  */
+ uint16_t telemetry_write_config(uint8_t *buf, uint16_t buf_len)
+ {
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < TELEMETRY_CONFIG_LEN) {
+         return 0;
+     }
+     ptr = common_write_16_bit(telemetry_interval_s, ptr);
+     ptr = common_write_16_bit(telemetry_collector.identifier, ptr);
+     ptr = common_write_16_bit(telemetry_seq, ptr);
+     if (telemetry_collector_set) {
+         memcpy(ptr, telemetry_collector.address, 16);
+     } else {
+         memset(ptr, 0, 16);
+     }
+     return ptr + 16 - buf;
+ }
+
+ #endif // TELEMETRY_ENABLE
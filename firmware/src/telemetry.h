@@ -0,0 +1,32 @@
+/*
+ *  ======== telemetry.h ========
+ *  Metrics pushed to a collector, see telemetry.c
+ */
+
+ #ifndef TELEMETRY_H
+ #define TELEMETRY_H
+
+ #include <stdint.h>
+
+ /* Settings read over CoAP, big endian: interval s(2) port(2) sequence of the next record(2)
+  * collector address(16), all zero when sending to the border router */
+ #define TELEMETRY_CONFIG_LEN        22
+
+ /*!
+  * Start pushing metrics to the border router every TELEMETRY_INTERVAL_S
+  */
+ void telemetry_init(void);
+
+ /*!
+  * Change the interval, 0 stops the records, and the collector. A NULL address
+  * sends to the border router again. The next record is a keyframe.
+  */
+ void telemetry_set(uint16_t interval_s, const uint8_t *address, uint16_t port);
+
+ /*!
+  * Serialize the settings, see TELEMETRY_CONFIG_LEN.
+  * Returns bytes written, 0 if the buffer is too small.
+  */
+ uint16_t telemetry_write_config(uint8_t *buf, uint16_t buf_len);
+
+ #endif //TELEMETRY_H
@@ -0,0 +1,340 @@
+/*
+ *  ======== time_sync.c ========
+ *  Network time for event timestamps (TIME_SYNC_ENABLE). Every TIME_SYNC_INTERVAL_S the node
+ *  asks the time server, by default the border router where the webapp answers, for its time
+ *  with a four timestamp exchange: the node's send time t1 goes out, the server returns it with
+ *  its receive time t2 and send time t3, and the node notes the arrival t4. The round trip less
+ *  the server's hold time is (t4 - t1) - (t3 - t2), half of it is taken as the way back, so the
+ *  server's time at t4 is t3 + rtt / 2. The error of that is at most rtt / 2 and comes from
+ *  the two ways taking different times, so of the last TIME_SYNC_FILTER_LEN answers only the
+ *  one with the shortest round trip is used. Between samples the local clock is carried forward
+ *  with the drift, measured from how the offset to the server moved over a long span.
+ *  time_sync_now_ms() returns the server's time in ms since the Unix epoch, 0 until synced.
+ *
+ *  A reference multicast by the server was not used, in a multi hop mesh its delay changes
+ *  with the hop count and the MPL repeats by far more than a millisecond and the node cannot
+ *  measure it. The broadcast schedule BFIO only orders frames within one broadcast interval.
+ */
+
+ #ifdef TIME_SYNC_ENABLE
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <string.h>
+ #include "eventOS_event.h"
+ #include "eventOS_event_timer.h"
+ #include "socket_api.h"
+ #include "ns_address.h"
+ #include "ns_trace.h"
+ #include "trace_config.h"
+ #include "common_functions.h"
+ #include "randLIB.h"
+ #include "uptime.h"
+ #include "node_state.h"
+ #include "time_sync.h"
+
+ #define TRACE_GROUP "tsyn"
+ #define TRACE_GROUP_LEVEL TRACE_CONFIG_TSYN
+
+ /* Request, node to server: version(1) type(1) seq(2) t1(8)
+  * Response, server to node: version(1) type(1) seq(2) t1(8) t2(8) t3(8)
+  * Big endian, t1 is in the node's clock and is only echoed, t2 and t3 are the server's
+  * ms since the Unix epoch. The server side is ti-wisun-webapp/server/src/TimeSyncServer.js. */
+ #define TIME_SYNC_VERSION           1
+ #define TIME_SYNC_TYPE_REQUEST      1
+ #define TIME_SYNC_TYPE_RESPONSE     2
+ #define TIME_SYNC_REQUEST_LEN       12
+ #define TIME_SYNC_RESPONSE_LEN      28
+
+ #ifndef TIME_SYNC_INTERVAL_S
+ #define TIME_SYNC_INTERVAL_S        60
+ #endif
+ // Polled this often until the first answer
+ #define TIME_SYNC_RETRY_S           10
+ // Longest interval, the drift only follows the crystal's temperature when sampled often enough
+ #define TIME_SYNC_MAX_INTERVAL_S    3600
+ // 0xF0B0-0xF0BF, the 6LoWPAN header compression sends these in 4 bits
+ #ifndef TIME_SYNC_PORT
+ #define TIME_SYNC_PORT              0xF0B2
+ #endif
+ // Answers slower than this are queued somewhere and say little about the way back
+ #define TIME_SYNC_MAX_RTT_MS        3000
+ // A sample this far off the prediction is a step of the server clock, the drift is dropped
+ #define TIME_SYNC_STEP_MS           2000
+ // Answers the shortest round trip is picked from
+ #define TIME_SYNC_FILTER_LEN        4
+ // The drift is measured once the span makes the round trips of its two ends this small in it
+ #define TIME_SYNC_DRIFT_ERROR_PPB   10000
+ // Well beyond the crystal tolerance
+ #define TIME_SYNC_MAX_DRIFT_PPB     500000
+ #define TIME_SYNC_POLL_EVT          1
+ #define TIME_SYNC_TIMER_ID          0
+
+ static int8_t time_sync_tasklet_id = -1;
+ static int8_t time_sync_socket_id = -1;
+ static ns_address_t time_sync_server;
+ static bool time_sync_server_set;
+ static uint16_t time_sync_interval_s = TIME_SYNC_INTERVAL_S;
+ static uint16_t time_sync_seq;
+ static uint64_t time_sync_t1;          // Send time of the outstanding request, 0 for none
+ static bool time_sync_synced;
+ static uint64_t time_sync_local_at;    // Local time of the last sample
+ static uint64_t time_sync_server_at;   // Server time at time_sync_local_at
+ static int32_t time_sync_drift_ppb;    // Server clock rate over the local one, less 1
+ static uint16_t time_sync_rtt_ms;
+ static uint64_t time_sync_anchor_local; // Sample the drift is measured from
+ static int64_t time_sync_anchor_offset;
+ static uint16_t time_sync_anchor_rtt_ms;
+
+ typedef struct {
+     uint64_t local_ms;
+     uint64_t server_ms;
+     uint16_t rtt_ms;
+ } time_sync_answer_t;
+
+ static time_sync_answer_t time_sync_filter[TIME_SYNC_FILTER_LEN];
+ static uint8_t time_sync_filter_next;
+
+ /*!
+  * Server time at the local time, carried forward from the last sample
+  */
+ static uint64_t time_sync_predict(uint64_t local_ms)
+ {
+     int64_t elapsed = (int64_t)(local_ms - time_sync_local_at);
+
+     return time_sync_server_at + elapsed + elapsed * time_sync_drift_ppb / 1000000000;
+ }
+
+ /*!
+  * Take the server time at the local time as the new reference, the drift moves
+  * half way to what the offset did since the anchor
+  */
+ static void time_sync_sample(uint64_t local_ms, uint64_t server_ms, uint16_t rtt_ms)
+ {
+     int64_t offset = (int64_t)(server_ms - local_ms);
+     int64_t span = (int64_t)(local_ms - time_sync_anchor_local);
+     int64_t error;
+     int64_t drift;
+
+     if (!time_sync_synced) {
+         tr_info("Synchronized, round trip %d ms", rtt_ms);
+         time_sync_anchor_local = local_ms;
+         time_sync_anchor_offset = offset;
+         time_sync_anchor_rtt_ms = rtt_ms;
+     } else {
+         error = (int64_t)(server_ms - time_sync_predict(local_ms));
+         tr_debug("Off by %d ms, drift %d ppb", (int)error, (int)time_sync_drift_ppb);
+         if (error > TIME_SYNC_STEP_MS || error < -TIME_SYNC_STEP_MS) {
+             tr_info("Server time stepped by %d ms", (int)error);
+             time_sync_drift_ppb = 0;
+             time_sync_anchor_local = local_ms;
+             time_sync_anchor_offset = offset;
+             time_sync_anchor_rtt_ms = rtt_ms;
+         } else if ((int64_t)(time_sync_anchor_rtt_ms + rtt_ms) * (1000000000 / 2) <=
+                    span * TIME_SYNC_DRIFT_ERROR_PPB) {
+             // Each offset is off by at most half its round trip
+             drift = (offset - time_sync_anchor_offset) * 1000000000 / span;
+             drift = time_sync_drift_ppb + (drift - time_sync_drift_ppb) / 2;
+             if (drift > TIME_SYNC_MAX_DRIFT_PPB) {
+                 drift = TIME_SYNC_MAX_DRIFT_PPB;
+             } else if (drift < -TIME_SYNC_MAX_DRIFT_PPB) {
+                 drift = -TIME_SYNC_MAX_DRIFT_PPB;
+             }
+             time_sync_drift_ppb = (int32_t)drift;
+             time_sync_anchor_local = local_ms;
+             time_sync_anchor_offset = offset;
+             time_sync_anchor_rtt_ms = rtt_ms;
+         }
+     }
+     time_sync_local_at = local_ms;
+     time_sync_server_at = server_ms;
+     time_sync_synced = true;
+ }
+
+ /*!
+  * Add an answer to the filter and take the one with the shortest round trip
+  * as the sample, unless it is older than the current reference
+  */
+ static void time_sync_answer(uint64_t local_ms, uint64_t server_ms, uint16_t rtt_ms)
+ {
+     time_sync_answer_t *best = NULL;
+     uint8_t i;
+
+     time_sync_filter[time_sync_filter_next].local_ms = local_ms;
+     time_sync_filter[time_sync_filter_next].server_ms = server_ms;
+     time_sync_filter[time_sync_filter_next].rtt_ms = rtt_ms;
+     time_sync_filter_next = (time_sync_filter_next + 1) % TIME_SYNC_FILTER_LEN;
+     for (i = 0; i < TIME_SYNC_FILTER_LEN; i++) {
+         // local_ms 0 marks an empty slot
+         if (time_sync_filter[i].local_ms && (!best || time_sync_filter[i].rtt_ms < best->rtt_ms)) {
+             best = &time_sync_filter[i];
+         }
+     }
+     time_sync_rtt_ms = rtt_ms;
+     if (!time_sync_synced || best->local_ms > time_sync_local_at) {
+         time_sync_sample(best->local_ms, best->server_ms, best->rtt_ms);
+     }
+ }
+
+ static void time_sync_socket_callback(void *cb)
+ {
+     socket_callback_t *sock_cb = (socket_callback_t *)cb;
+     uint8_t buf[TIME_SYNC_RESPONSE_LEN];
+     ns_address_t source;
+     uint64_t t1, t2, t3, t4;
+     int64_t rtt;
+     int16_t len;
+
+     if ((sock_cb->event_type & SOCKET_EVENT_MASK) != SOCKET_DATA) {
+         return;
+     }
+     t4 = uptime_ms();
+     len = socket_recvfrom(time_sync_socket_id, buf, sizeof(buf), 0, &source);
+     // Longer answers are accepted so later versions can append fields
+     if (len < TIME_SYNC_RESPONSE_LEN ||
+         buf[0] != TIME_SYNC_VERSION ||
+         buf[1] != TIME_SYNC_TYPE_RESPONSE) {
+         return;
+     }
+     // Only the answer to the outstanding request, a late one would be measured from the wrong t1
+     t1 = common_read_64_bit(buf + 4);
+     if (!time_sync_t1 || t1 != time_sync_t1 ||
+         common_read_16_bit(buf + 2) != (uint16_t)(time_sync_seq - 1)) {
+         return;
+     }
+     time_sync_t1 = 0;
+     t2 = common_read_64_bit(buf + 12);
+     t3 = common_read_64_bit(buf + 20);
+     rtt = (int64_t)(t4 - t1) - (int64_t)(t3 - t2);
+     if (rtt < 0 || rtt > TIME_SYNC_MAX_RTT_MS) {
+         tr_debug("Answer dropped, round trip %d ms", (int)rtt);
+         return;
+     }
+     time_sync_answer(t4, t3 + rtt / 2, (uint16_t)rtt);
+ }
+
+ static void time_sync_poll(void)
+ {
+     uint8_t buf[TIME_SYNC_REQUEST_LEN];
+     int16_t ret;
+
+     // Nothing to ask before the DAO made the node reachable
+     if (!time_sync_server_set) {
+         if (!sent_dao) {
+             return;
+         }
+         memcpy(time_sync_server.address, root_unicast_addr, 16);
+     }
+     if (time_sync_socket_id < 0) {
+         time_sync_socket_id = socket_open(SOCKET_UDP, 0, time_sync_socket_callback);
+         if (time_sync_socket_id < 0) {
+             tr_warn("socket open failed with error %d", time_sync_socket_id);
+             return;
+         }
+     }
+     // Never 0, that marks no request outstanding
+     time_sync_t1 = uptime_ms() | 1;
+     buf[0] = TIME_SYNC_VERSION;
+     buf[1] = TIME_SYNC_TYPE_REQUEST;
+     common_write_16_bit(time_sync_seq++, buf + 2);
+     common_write_64_bit(time_sync_t1, buf + 4);
+     ret = socket_sendto(time_sync_socket_id, &time_sync_server, buf, sizeof(buf));
+     if (ret < 0) {
+         time_sync_t1 = 0;
+         tr_debug("send failed with error %d", ret);
+     }
+ }
+
+ static void time_sync_tasklet(arm_event_s *event)
+ {
+     uint32_t delay_ms;
+
+     switch (event->event_type) {
+         case ARM_LIB_TASKLET_INIT_EVENT:
+             time_sync_tasklet_id = event->receiver;
+             break;
+         case TIME_SYNC_POLL_EVT:
+             time_sync_poll();
+             break;
+         default:
+             return;
+     }
+     if (time_sync_interval_s) {
+         // Up to a second of jitter so nodes booted together do not ask together
+         delay_ms = (uint32_t)(time_sync_synced ? time_sync_interval_s : TIME_SYNC_RETRY_S) * 1000 +
+                    randLIB_get_random_in_range(0, 1000);
+         eventOS_event_timer_request(TIME_SYNC_TIMER_ID, TIME_SYNC_POLL_EVT, time_sync_tasklet_id, delay_ms);
+     }
+ }
+
+ /*!
+  * Start synchronizing to the border router every TIME_SYNC_INTERVAL_S
+  */
+ void time_sync_init(void)
+ {
+     time_sync_server.type = ADDRESS_IPV6;
+     time_sync_server.identifier = TIME_SYNC_PORT;
+     if (time_sync_tasklet_id < 0) {
+         eventOS_event_handler_create(&time_sync_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+     }
+ }
+
+ /*!
+  * Change the interval, up to TIME_SYNC_MAX_INTERVAL_S, and the server. An interval of 0
+  * stops the exchanges and drops the time, a NULL address asks the border router again.
+  */
+ void time_sync_set(uint16_t interval_s, const uint8_t *address)
+ {
+     time_sync_server_set = address != NULL;
+     // The old server's time does not predict the new one's
+     if (address || !interval_s) {
+         time_sync_synced = false;
+         time_sync_drift_ppb = 0;
+         memset(time_sync_filter, 0, sizeof(time_sync_filter));
+     }
+     if (address) {
+         memcpy(time_sync_server.address, address, 16);
+     }
+     time_sync_interval_s = interval_s < TIME_SYNC_MAX_INTERVAL_S ? interval_s : TIME_SYNC_MAX_INTERVAL_S;
+     time_sync_t1 = 0;
+     if (time_sync_tasklet_id >= 0) {
+         eventOS_event_timer_cancel(TIME_SYNC_TIMER_ID, time_sync_tasklet_id);
+         if (interval_s) {
+             eventOS_event_timer_request(TIME_SYNC_TIMER_ID, TIME_SYNC_POLL_EVT, time_sync_tasklet_id, 0);
+         }
+     }
+ }
+
+ /*!
+  * Server time in ms since the Unix epoch, 0 before the first exchange
+  */
+ uint64_t time_sync_now_ms(void)
+ {
+     if (!time_sync_synced) {
+         return 0;
+     }
+     return time_sync_predict(uptime_ms());
+ }
+
+ /*!
+  * Serialize the state, see time_sync.h
+  */
+ uint16_t time_sync_write_status(uint8_t *buf, uint16_t buf_len)
+ {
+     uint64_t local_ms = uptime_ms();
+     uint8_t *ptr = buf;
+
+     if (!buf || buf_len < TIME_SYNC_STATUS_LEN) {
+         return 0;
+     }
+     *ptr++ = time_sync_synced ? TIME_SYNC_FLAG_SYNCED : 0;
+     *ptr++ = 0;
+     ptr = common_write_16_bit(time_sync_interval_s, ptr);
+     ptr = common_write_16_bit(time_sync_rtt_ms, ptr);
+     ptr = common_write_32_bit((uint32_t)time_sync_drift_ppb, ptr);
+     ptr = common_write_32_bit(time_sync_synced ? (uint32_t)((local_ms - time_sync_local_at) / 1000) : 0, ptr);
+     ptr = common_write_64_bit(time_sync_synced ? time_sync_predict(local_ms) : 0, ptr);
+     return ptr - buf;
+ }
+
+ #endif // TIME_SYNC_ENABLE
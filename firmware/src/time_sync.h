@@ -0,0 +1,38 @@
+/*
+ *  ======== time_sync.h ========
+ *  Network time for event timestamps, see time_sync.c
+ */
+
+ #ifndef TIME_SYNC_H
+ #define TIME_SYNC_H
+
+ #include <stdint.h>
+
+ /* State read over CoAP, big endian: flags(1) reserved(1) interval s(2) last round trip ms(2)
+  * drift ppb(4, signed) s since the last sample(4) time_sync_now_ms()(8) */
+ #define TIME_SYNC_STATUS_LEN        22
+ #define TIME_SYNC_FLAG_SYNCED       0x01
+
+ /*!
+  * Start synchronizing to the border router every TIME_SYNC_INTERVAL_S
+  */
+ void time_sync_init(void);
+
+ /*!
+  * Change the interval, up to TIME_SYNC_MAX_INTERVAL_S, and the server. An interval of 0
+  * stops the exchanges and drops the time, a NULL address asks the border router again.
+  */
+ void time_sync_set(uint16_t interval_s, const uint8_t *address);
+
+ /*!
+  * Server time in ms since the Unix epoch, 0 before the first exchange
+  */
+ uint64_t time_sync_now_ms(void);
+
+ /*!
+  * Serialize the state, see TIME_SYNC_STATUS_LEN.
+  * Returns bytes written, 0 if the buffer is too small.
+  */
+ uint16_t time_sync_write_status(uint8_t *buf, uint16_t buf_len);
+
+ #endif //TIME_SYNC_H
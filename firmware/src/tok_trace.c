@@ -0,0 +1,290 @@
+/*
+ *  ======== tok_trace.c ========
+ *  Tokenized trace backend (TOK_TRACE_ENABLE). A log site does not format its text: it
+ *  copies the address of its format string and its raw arguments into a RAM ring, and a
+ *  low priority task sends the records to an ITM stimulus port. The host rebuilds the
+ *  text from the strings in the ELF image, see firmware/tools/tok_trace.
+ *  Log sites never wait, a record that finds the ring full is counted as dropped.
+ */
+
+ #ifdef TOK_TRACE_ENABLE
+
+ #include <stdint.h>
+ #include <stdbool.h>
+ #include <stdarg.h>
+ #include <stddef.h>
+ #include <string.h>
+ #include <stdatomic.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <ti/drivers/ITM.h>
+ #include <ti/drivers/dpl/ClockP.h>
+ #include "ns_trace.h"
+ #include "tok_trace.h"
+
+ // Records the ring holds, a power of two
+ #ifndef TOK_TRACE_SLOTS
+ #define TOK_TRACE_SLOTS             32
+ #endif
+ // Argument bytes of a record, enough for an IPv6 address printed byte by byte
+ #ifndef TOK_TRACE_ARGS_LEN
+ #define TOK_TRACE_ARGS_LEN          72
+ #endif
+ // Stimulus port of the records, the text trace keeps port 0
+ #ifndef TOK_TRACE_ITM_PORT
+ #define TOK_TRACE_ITM_PORT          1
+ #endif
+ #ifndef TOK_TRACE_PRIORITY
+ #define TOK_TRACE_PRIORITY          1
+ #endif
+ #ifndef TOK_TRACE_STACK_SIZE
+ #define TOK_TRACE_STACK_SIZE        1024
+ #endif
+
+ // %s arguments are cut to this many bytes
+ #define TOK_TRACE_STR_MAX           32
+
+ /* Record on the stimulus port, sent as 32 bit words, little endian:
+  * magic(1) level(1) argument bytes(1) records dropped before this one(1) time ms(4)
+  * format string address(4) group string address(4) arguments padded to 4 bytes.
+  * Arguments in the order of the format: 4 bytes for each integer, character and pointer,
+  * 8 for long long and double, a length byte and the bytes for a string. */
+ #define TOK_TRACE_MAGIC             0xA5
+ #define TOK_TRACE_HEADER_LEN        16
+
+ typedef struct {
+     atomic_uint seq;                            // Position the slot is ready for, see tok_trace_write()
+     uint32_t ticks;
+     const char *fmt;
+     const char *group;
+     uint8_t level;
+     uint8_t args_len;
+     uint8_t args[TOK_TRACE_ARGS_LEN];
+ } tok_trace_slot_t;
+
+ static tok_trace_slot_t tok_trace_ring[TOK_TRACE_SLOTS];
+ static atomic_uint tok_trace_tail;              // Next position to reserve
+ static unsigned int tok_trace_head;             // Next position to send, drain task only
+ static atomic_uint tok_trace_dropped;
+ static sem_t tok_trace_sem;
+ static bool tok_trace_started = false;
+
+ /*!
+  * Copy n argument bytes, false when they do not fit
+  */
+ static bool tok_trace_put(uint8_t **ptr, const uint8_t *end, const void *data, size_t n)
+ {
+     if (*ptr + n > end) {
+         return false;
+     }
+     if (n) {
+         memcpy(*ptr, data, n);
+     }
+     *ptr += n;
+     return true;
+ }
+
+ /*!
+  * Copy the arguments of the format, see TOK_TRACE_MAGIC for the encoding.
+  * Stops at the first argument that does not fit, the host shows the rest as missing.
+  */
+ static uint8_t tok_trace_pack(uint8_t *buf, const char *fmt, va_list ap)
+ {
+     uint8_t *ptr = buf;
+     const uint8_t *end = buf + TOK_TRACE_ARGS_LEN;
+     bool fits = true;
+
+     while (fits && (fmt = strchr(fmt, '%')) != NULL) {
+         uint8_t longs = 0;
+         bool size = false, long_double = false;
+         uint32_t word;
+
+         fmt++;
+         if (*fmt == '%') {
+             fmt++;
+             continue;
+         }
+         // Flags, width and precision, a * takes an int argument
+         while (*fmt && strchr("-+ #0123456789.*", *fmt)) {
+             if (*fmt == '*') {
+                 word = va_arg(ap, int);
+                 fits = tok_trace_put(&ptr, end, &word, sizeof(word));
+             }
+             fmt++;
+         }
+         while (*fmt && strchr("hlLjzt", *fmt)) {
+             if (*fmt == 'l') {
+                 longs++;
+             } else if (*fmt == 'j') {
+                 longs = 2;
+             } else if (*fmt == 'L') {
+                 long_double = true;
+             } else if (*fmt == 'z' || *fmt == 't') {
+                 size = true;
+             }
+             fmt++;
+         }
+
+         switch (*fmt) {
+             case '\0':
+                 return ptr - buf;
+             case 's': {
+                 const char *str = va_arg(ap, const char *);
+                 uint8_t len = 0;
+                 while (str && len < TOK_TRACE_STR_MAX && str[len]) {
+                     len++;
+                 }
+                 fits = tok_trace_put(&ptr, end, &len, 1) && tok_trace_put(&ptr, end, str, len);
+                 break;
+             }
+             case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                 double value = long_double ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                 fits = tok_trace_put(&ptr, end, &value, sizeof(value));
+                 break;
+             }
+             case 'p':
+                 word = (uint32_t)(uintptr_t)va_arg(ap, void *);
+                 fits = tok_trace_put(&ptr, end, &word, sizeof(word));
+                 break;
+             default:
+                 if (longs >= 2) {
+                     unsigned long long value = va_arg(ap, unsigned long long);
+                     fits = tok_trace_put(&ptr, end, &value, sizeof(value));
+                     break;
+                 }
+                 if (longs) {
+                     word = va_arg(ap, unsigned long);
+                 } else if (size) {
+                     word = va_arg(ap, size_t);
+                 } else {
+                     word = va_arg(ap, unsigned int);
+                 }
+                 fits = tok_trace_put(&ptr, end, &word, sizeof(word));
+                 break;
+         }
+         fmt++;
+     }
+     return ptr - buf;
+ }
+
+ void tok_trace_write(uint8_t level, const char *group, const char *fmt, ...)
+ {
+     tok_trace_slot_t *slot;
+     unsigned int pos;
+     int diff;
+     va_list ap;
+
+     if (!tok_trace_started || !(mbed_trace_config_get() & level)) {
+         return;
+     }
+
+     /* Reserve a slot, any number of tasks may log at once. A slot is free
+      * for position pos when its seq equals pos and holds a record when seq is pos + 1. */
+     pos = atomic_load_explicit(&tok_trace_tail, memory_order_relaxed);
+     for (;;) {
+         slot = &tok_trace_ring[pos & (TOK_TRACE_SLOTS - 1)];
+         diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+         if (diff == 0) {
+             if (atomic_compare_exchange_weak_explicit(&tok_trace_tail, &pos, pos + 1,
+                                                       memory_order_relaxed, memory_order_relaxed)) {
+                 break;
+             }
+         } else if (diff < 0) {
+             // The drain task has not freed this slot yet
+             atomic_fetch_add_explicit(&tok_trace_dropped, 1, memory_order_relaxed);
+             return;
+         } else {
+             pos = atomic_load_explicit(&tok_trace_tail, memory_order_relaxed);
+         }
+     }
+
+     slot->ticks = ClockP_getSystemTicks();
+     slot->fmt = fmt;
+     slot->group = group;
+     slot->level = level;
+     va_start(ap, fmt);
+     slot->args_len = tok_trace_pack(slot->args, fmt, ap);
+     va_end(ap);
+     atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+     sem_post(&tok_trace_sem);
+ }
+
+ /*!
+  * Send the oldest record, false when the ring is empty
+  */
+ static bool tok_trace_send(void)
+ {
+     uint32_t words[(TOK_TRACE_HEADER_LEN + TOK_TRACE_ARGS_LEN + 3) / 4] = {0};
+     tok_trace_slot_t *slot = &tok_trace_ring[tok_trace_head & (TOK_TRACE_SLOTS - 1)];
+     unsigned int dropped, i, len;
+
+     if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tok_trace_head + 1) {
+         return false;
+     }
+
+     dropped = atomic_load_explicit(&tok_trace_dropped, memory_order_relaxed);
+     if (dropped > UINT8_MAX) {
+         dropped = UINT8_MAX;
+     }
+     atomic_fetch_sub_explicit(&tok_trace_dropped, dropped, memory_order_relaxed);
+
+     words[0] = TOK_TRACE_MAGIC | (slot->level << 8) | (slot->args_len << 16) | (dropped << 24);
+     words[1] = (uint32_t)(((uint64_t)slot->ticks * ClockP_getSystemTickPeriod()) / 1000);
+     words[2] = (uint32_t)(uintptr_t)slot->fmt;
+     words[3] = (uint32_t)(uintptr_t)slot->group;
+     memcpy(&words[TOK_TRACE_HEADER_LEN / 4], slot->args, slot->args_len);
+     len = (TOK_TRACE_HEADER_LEN + slot->args_len + 3) / 4;
+
+     // Hand the slot back before the slow part
+     atomic_store_explicit(&slot->seq, tok_trace_head + TOK_TRACE_SLOTS, memory_order_release);
+     tok_trace_head++;
+
+     for (i = 0; i < len; i++) {
+         ITM_send32Atomic(TOK_TRACE_ITM_PORT, words[i]);
+     }
+     return true;
+ }
+
+ /*!
+  * Drain task, sends records as they are queued
+  */
+ static void *tok_trace_task(void *arg)
+ {
+     for (;;) {
+         sem_wait(&tok_trace_sem);
+         while (tok_trace_send()) {
+         }
+     }
+     return NULL;
+ }
+
+ void tok_trace_init(void)
+ {
+     pthread_t           thread;
+     pthread_attr_t      attrs;
+     struct sched_param  priParam;
+     int                 retc;
+     unsigned int        i;
+
+     for (i = 0; i < TOK_TRACE_SLOTS; i++) {
+         atomic_init(&tok_trace_ring[i].seq, i);
+     }
+     atomic_init(&tok_trace_tail, 0);
+     atomic_init(&tok_trace_dropped, 0);
+     tok_trace_head = 0;
+     sem_init(&tok_trace_sem, 0, 0);
+     ITM_open();
+
+     pthread_attr_init(&attrs);
+     priParam.sched_priority = TOK_TRACE_PRIORITY;
+     retc = pthread_attr_setschedparam(&attrs, &priParam);
+     retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+     retc |= pthread_attr_setstacksize(&attrs, TOK_TRACE_STACK_SIZE);
+     // Without the task nothing would free the slots, the log sites stay quiet then
+     if (retc == 0 && pthread_create(&thread, &attrs, tok_trace_task, NULL) == 0) {
+         tok_trace_started = true;
+     }
+ }
+
+ #endif // TOK_TRACE_ENABLE
@@ -0,0 +1,27 @@
+/*
+ *  ======== tok_trace.h ========
+ *  Tokenized trace backend, see tok_trace.c. With TOK_TRACE_ENABLE the tr_* calls
+ *  of the files that include trace_config.h log through it.
+ */
+
+ #ifndef TOK_TRACE_H
+ #define TOK_TRACE_H
+
+ #ifdef TOK_TRACE_ENABLE
+
+ #include <stdint.h>
+ #include "ns_trace.h"
+
+ /*!
+  * Start the drain task, call after the trace has been initialized
+  */
+ void tok_trace_init(void);
+
+ /*!
+  * Queue a trace record of the format and its raw arguments, formatted on the host
+  */
+ void tok_trace_write(uint8_t level, const char *group, const char *fmt, ...);
+
+ #endif // TOK_TRACE_ENABLE
+
+ #endif //TOK_TRACE_H
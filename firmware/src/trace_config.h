@@ -0,0 +1,129 @@
+/*
+ *  ======== trace_config.h ========
+ *  Compile time trace levels of the application trace groups. A tr_* call below the level
+ *  of its group is removed by the preprocessor, with its arguments and format string.
+ *  Calls that remain still pass the runtime check of mbed_trace_config_set().
+ *
+ *  A file sets TRACE_GROUP_LEVEL to the level of its group next to TRACE_GROUP, and
+ *  includes this header after ns_trace.h. Levels are set per build, for example
+ *      -DTRACE_CONFIG_DEFAULT=TRACE_CONFIG_WARN -DTRACE_CONFIG_DHP=TRACE_CONFIG_INFO
+ *  keeps warnings and errors everywhere and the info trace of the DHCPv6 client.
+ *  The header may also be included before ns_trace.h, then only the levels are defined.
+ */
+
+ #ifndef TRACE_CONFIG_H
+ #define TRACE_CONFIG_H
+
+ // Levels, plain digits since they are pasted into macro names
+ #define TRACE_CONFIG_NONE           0
+ #define TRACE_CONFIG_ERROR          1
+ #define TRACE_CONFIG_WARN           2
+ #define TRACE_CONFIG_INFO           3
+ #define TRACE_CONFIG_DEBUG          4
+
+ // Level of the groups not set below, builds without trace keep none
+ #ifndef TRACE_CONFIG_DEFAULT
+ #ifdef EXCLUDE_TRACE
+ #define TRACE_CONFIG_DEFAULT        TRACE_CONFIG_NONE
+ #else
+ #define TRACE_CONFIG_DEFAULT        TRACE_CONFIG_DEBUG
+ #endif
+ #endif
+
+ // application.c, non-NCP builds keep it when the stack is built without trace
+ #ifndef TRACE_CONFIG_MAIN
+ #ifndef WISUN_NCP_ENABLE
+ #define TRACE_CONFIG_MAIN           TRACE_CONFIG_DEBUG
+ #else
+ #define TRACE_CONFIG_MAIN           TRACE_CONFIG_DEFAULT
+ #endif
+ #endif
+ // dhcpv6_client_service.c
+ #ifndef TRACE_CONFIG_DHP
+ #define TRACE_CONFIG_DHP            TRACE_CONFIG_DEFAULT
+ #endif
+ // low_power.c
+ #ifndef TRACE_CONFIG_LPWR
+ #define TRACE_CONFIG_LPWR           TRACE_CONFIG_DEFAULT
+ #endif
+ // task_stats.c
+ #ifndef TRACE_CONFIG_TASK
+ #define TRACE_CONFIG_TASK           TRACE_CONFIG_DEFAULT
+ #endif
+ // channel_policy.c
+ #ifndef TRACE_CONFIG_CHPO
+ #define TRACE_CONFIG_CHPO           TRACE_CONFIG_DEFAULT
+ #endif
+ // telemetry.c
+ #ifndef TRACE_CONFIG_TELM
+ #define TRACE_CONFIG_TELM           TRACE_CONFIG_DEFAULT
+ #endif
+ // time_sync.c
+ #ifndef TRACE_CONFIG_TSYN
+ #define TRACE_CONFIG_TSYN           TRACE_CONFIG_DEFAULT
+ #endif
+ // ncp_transport.c, the host reads the UART counters from it so it stays in builds without trace
+ #ifndef TRACE_CONFIG_NCPT
+ #define TRACE_CONFIG_NCPT           TRACE_CONFIG_INFO
+ #endif
+
+ #endif //TRACE_CONFIG_H
+
+ #if defined(TRACE_LEVEL_DEBUG) && !defined(TRACE_CONFIG_GATES)
+ #define TRACE_CONFIG_GATES
+
+ #ifdef TOK_TRACE_ENABLE
+ #include "tok_trace.h"
+ #endif
+
+ // Where the calls that are compiled in go, host builds may set their own
+ #ifndef TRACE_CONFIG_EMIT
+ #ifdef TOK_TRACE_ENABLE
+ #define TRACE_CONFIG_EMIT(level, ...)   tok_trace_write(level, TRACE_GROUP, __VA_ARGS__)
+ #else
+ #define TRACE_CONFIG_EMIT(level, ...)   mbed_tracef(level, TRACE_GROUP, __VA_ARGS__)
+ #endif
+ #endif
+
+ #define TRACE_CONFIG_DROP(level, ...)   ((void)0)
+
+ // TRACE_CONFIG_KEEP_<group level>_<call level>
+ #define TRACE_CONFIG_KEEP_0_1           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_0_2           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_0_3           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_0_4           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_1_1           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_1_2           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_1_3           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_1_4           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_2_1           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_2_2           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_2_3           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_2_4           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_3_1           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_3_2           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_3_3           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_3_4           TRACE_CONFIG_DROP
+ #define TRACE_CONFIG_KEEP_4_1           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_4_2           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_4_3           TRACE_CONFIG_EMIT
+ #define TRACE_CONFIG_KEEP_4_4           TRACE_CONFIG_EMIT
+
+ // The extra level expands TRACE_GROUP_LEVEL to its digit before pasting
+ #define TRACE_CONFIG_GATE(group_level, call_level)     TRACE_CONFIG_GATE_(group_level, call_level)
+ #define TRACE_CONFIG_GATE_(group_level, call_level)    TRACE_CONFIG_KEEP_##group_level##_##call_level
+
+ #undef tr_debug
+ #undef tr_info
+ #undef tr_warn
+ #undef tr_warning
+ #undef tr_error
+ #undef tr_err
+ #define tr_debug(...)       TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 4)(TRACE_LEVEL_DEBUG, __VA_ARGS__)
+ #define tr_info(...)        TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 3)(TRACE_LEVEL_INFO, __VA_ARGS__)
+ #define tr_warn(...)        TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 2)(TRACE_LEVEL_WARN, __VA_ARGS__)
+ #define tr_warning(...)     TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 2)(TRACE_LEVEL_WARN, __VA_ARGS__)
+ #define tr_error(...)       TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 1)(TRACE_LEVEL_ERROR, __VA_ARGS__)
+ #define tr_err(...)         TRACE_CONFIG_GATE(TRACE_GROUP_LEVEL, 1)(TRACE_LEVEL_ERROR, __VA_ARGS__)
+
+ #endif // TRACE_LEVEL_DEBUG && !TRACE_CONFIG_GATES
@@ -0,0 +1,59 @@
+/*
+ *  ======== uptime.c ========
+ *  Time since boot for the timestamps of the optional modules. ClockP_getSystemTicks() is
+ *  32 bits, at the 10 us tick of the syscfgs it wraps every 11.9 hours. Each read carries
+ *  the wraps seen so far, and a ClockP callback reads it every UPTIME_KEEPALIVE_S so a wrap
+ *  is never missed when the modules read it less often than that.
+ */
+
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <ti/drivers/dpl/ClockP.h>
+ #include <ti/drivers/dpl/HwiP.h>
+ #include "uptime.h"
+
+ // Well within the shortest wrap, 2^32 ticks of 10 us
+ #define UPTIME_KEEPALIVE_S      3600
+
+ static uint32_t uptime_last_ticks;
+ static uint64_t uptime_wraps;
+ static ClockP_Struct uptime_clock;
+ static bool uptime_clock_started;
+
+ static uint64_t uptime_ticks(void)
+ {
+     uintptr_t key;
+     uint32_t ticks;
+     uint64_t total;
+
+     key = HwiP_disable();
+     ticks = ClockP_getSystemTicks();
+     if (ticks < uptime_last_ticks) {
+         uptime_wraps += 1ULL << 32;
+     }
+     uptime_last_ticks = ticks;
+     total = uptime_wraps + ticks;
+     HwiP_restore(key);
+     return total;
+ }
+
+ static void uptime_keepalive(uintptr_t arg)
+ {
+     (void)arg;
+     uptime_ticks();
+ }
+
+ uint64_t uptime_ms(void)
+ {
+     if (!uptime_clock_started) {
+         ClockP_Params params;
+         uint32_t period = (uint32_t)((uint64_t)UPTIME_KEEPALIVE_S * 1000000 / ClockP_getSystemTickPeriod());
+
+         uptime_clock_started = true;
+         ClockP_Params_init(&params);
+         params.period = period;
+         params.startFlag = true;
+         ClockP_construct(&uptime_clock, uptime_keepalive, period, &params);
+     }
+     return (uptime_ticks() * ClockP_getSystemTickPeriod()) / 1000;
+ }
@@ -0,0 +1,16 @@
+/*
+ *  ======== uptime.h ========
+ *  Time since boot that does not wrap, see uptime.c
+ */
+
+ #ifndef UPTIME_H
+ #define UPTIME_H
+
+ #include <stdint.h>
+
+ /*!
+  * Milliseconds since boot, the 32-bit system ticks extended past their wrap
+  */
+ uint64_t uptime_ms(void);
+
+ #endif //UPTIME_H
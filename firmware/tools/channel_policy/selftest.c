@@ -0,0 +1,151 @@
+/*
+ * Self test of the channel exclusion policy: feeds MAC completions with a constant failure
+ * ratio to ../../src/channel_policy.c period after period and checks the EWMA and the
+ * excluded channels in its CoAP record.
+ *   chpo_selftest [-v]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "eventOS_event.h"
+#include "common_functions.h"
+#include "channel_policy.h"
+
+// Defaults of channel_policy.c, the build does not override them
+#define EXCLUDE_PCT         40
+#define HOLD_PERIODS        10
+#define PERIOD_EVT          1
+#define MAC_NO_ACK          0xE9
+
+// Channels 0-15 configured, twice CHANNEL_POLICY_MIN_CHANNELS so one can be excluded
+#define CONFIGURED          16
+#define TEST_CHANNEL        3
+
+void __wrap_macTxCompleteCallback(uint8_t status);
+
+int chpo_selftest_verbose;
+uint8_t macPhyChannel;
+static void (*tasklet)(arm_event_s *);
+static int failures;
+
+void __real_macTxCompleteCallback(uint8_t status)
+{
+}
+
+int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uint8_t init_event_type)
+{
+    arm_event_s event = {.receiver = 1, .event_type = init_event_type};
+
+    tasklet = handler_func_ptr;
+    tasklet(&event);
+    return 1;
+}
+
+// The test posts the period events itself
+int8_t eventOS_event_timer_request(uint8_t event_id, uint8_t event_type, int8_t tasklet_id, uint32_t time)
+{
+    return 0;
+}
+
+int ws_management_channel_mask_set(int8_t interface_id, uint32_t channel_mask[8])
+{
+    return 0;
+}
+
+/*
+ * One policy period with frames sent on the test channel, failed of them without an ACK
+ */
+static void period(uint16_t frames, uint16_t failed)
+{
+    arm_event_s event = {.receiver = 1, .event_type = PERIOD_EVT};
+    uint16_t i;
+
+    macPhyChannel = TEST_CHANNEL;
+    for (i = 0; i < frames; i++) {
+        __wrap_macTxCompleteCallback(i < failed ? MAC_NO_ACK : 0);
+    }
+    tasklet(&event);
+}
+
+/*
+ * Failure ratio EWMA and exclusion of the test channel, from the CoAP record
+ */
+static void state(uint8_t *ratio, bool *excluded)
+{
+    uint8_t buf[CHANNEL_POLICY_HEADER_LEN + 129 * CHANNEL_POLICY_ENTRY_LEN];
+    uint16_t len = channel_policy_write(buf, sizeof(buf));
+    const uint8_t *entry;
+
+    *ratio = 0;
+    *excluded = buf[8 + TEST_CHANNEL / 8] & (1 << (TEST_CHANNEL % 8));
+    for (entry = buf + CHANNEL_POLICY_HEADER_LEN; entry + CHANNEL_POLICY_ENTRY_LEN <= buf + len;
+         entry += CHANNEL_POLICY_ENTRY_LEN) {
+        if (entry[0] == TEST_CHANNEL) {
+            *ratio = entry[1];
+        }
+    }
+}
+
+static void check(const char *name, bool ok, uint8_t ratio, bool excluded)
+{
+    printf("%-48s %s (ratio %u%%, %s)\n", name, ok ? "ok" : "FAILED", ratio,
+           excluded ? "excluded" : "allowed");
+    if (!ok) {
+        failures++;
+    }
+}
+
+/*
+ * A constant failure ratio, periods long enough for the EWMA to settle
+ */
+static void constant(const char *name, uint8_t pct, bool exclude)
+{
+    uint8_t ratio;
+    bool excluded;
+    int i;
+
+    channel_policy_reset();
+    for (i = 0; i < 30; i++) {
+        period(100, pct);
+    }
+    state(&ratio, &excluded);
+    // An excluded channel is held with the ratio it had when it was excluded
+    check(name, excluded == exclude && (exclude ? ratio >= EXCLUDE_PCT : ratio == pct), ratio, excluded);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t mask[CHANNEL_POLICY_MASK_LEN] = {0};
+    uint8_t ratio;
+    bool excluded;
+    int i;
+
+    chpo_selftest_verbose = argc > 1 && !strcmp(argv[1], "-v");
+    memset(mask, 0xff, CONFIGURED / 8);
+    channel_policy_init(0, mask, sizeof(mask));
+
+    constant("constant 39% stays allowed at 39%", 39, false);
+    constant("constant 40% (the threshold) is excluded", 40, true);
+    constant("constant 42% is excluded", 42, true);
+
+    // Recovery: held out, allowed again just under the threshold, then clean periods
+    for (i = 0; i < HOLD_PERIODS; i++) {
+        period(0, 0);
+    }
+    state(&ratio, &excluded);
+    check("allowed again after the hold periods", !excluded && ratio == EXCLUDE_PCT - 1, ratio, excluded);
+    for (i = 0; i < 30; i++) {
+        period(100, 0);
+    }
+    state(&ratio, &excluded);
+    check("clean periods decay the ratio to 0%", !excluded && ratio == 0, ratio, excluded);
+
+    if (failures) {
+        printf("channel_policy: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("channel_policy: all checks passed\n");
+    return 0;
+}
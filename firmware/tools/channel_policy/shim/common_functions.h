@@ -0,0 +1,23 @@
+#ifndef CHPO_SELFTEST_COMMON_FUNCTIONS_H
+#define CHPO_SELFTEST_COMMON_FUNCTIONS_H
+
+#include <stdint.h>
+
+static inline uint8_t *common_write_16_bit(uint16_t value, uint8_t ptr[static 2])
+{
+    *ptr++ = value >> 8;
+    *ptr++ = value;
+    return ptr;
+}
+
+static inline uint16_t common_read_16_bit(const uint8_t data_buf[static 2])
+{
+    return (uint16_t)data_buf[0] << 8 | data_buf[1];
+}
+
+static inline uint32_t common_read_32_bit_inverse(const uint8_t data_buf[static 4])
+{
+    return (uint32_t)data_buf[3] << 24 | (uint32_t)data_buf[2] << 16 | (uint32_t)data_buf[1] << 8 | data_buf[0];
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CHPO_SELFTEST_NS_TRACE_H
+#define CHPO_SELFTEST_NS_TRACE_H
+
+#include <stdio.h>
+
+// The policy's trace is printed with -v
+extern int chpo_selftest_verbose;
+
+#define tr_trace_(...) do { \
+        if (chpo_selftest_verbose) { \
+            fprintf(stderr, "[" TRACE_GROUP "] " __VA_ARGS__); \
+            fputc('\n', stderr); \
+        } \
+    } while (0)
+
+#define tr_error(...) tr_trace_(__VA_ARGS__)
+#define tr_warn(...)  tr_trace_(__VA_ARGS__)
+#define tr_info(...)  tr_trace_(__VA_ARGS__)
+#define tr_debug(...) tr_trace_(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef CHPO_SELFTEST_WS_MANAGEMENT_API_H
+#define CHPO_SELFTEST_WS_MANAGEMENT_API_H
+
+#include <stdint.h>
+
+int ws_management_channel_mask_set(int8_t interface_id, uint32_t channel_mask[8]);
+
+#endif
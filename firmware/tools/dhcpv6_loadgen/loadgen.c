@@ -0,0 +1,624 @@
+/*
+ * DHCPv6 client load generator.
+ *
+ * Runs the node DHCPv6 client (firmware/src/dhcpv6_client_service.c) on the host for many simulated
+ * nodes at once, each with its own EUI-64 DUID and IAID, against a Kea server. Nodes are configured
+ * like the Wi-SUN stack does (one client per interface, no address hint) and relayed to Kea, then
+ * keep renewing until the run ends. Reports latency percentiles per message exchange, time to
+ * acquire an address and throughput.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include "ns_types.h"
+#include "randLIB.h"
+#include "dhcpv6_client_api.h"
+#include "libDHCPv6/libDHCPv6.h"
+#include "loadgen.h"
+
+#define TRACE_GROUP "lgen"
+#include "ns_trace.h"
+
+#ifndef LOADGEN_VENDOR_CLASS
+#define LOADGEN_VENDOR_CLASS "fsr"
+#endif
+
+#define LOADGEN_TICK_US             100000      // Address timers run on 100ms ticks like nanostack
+#define LOADGEN_RETRY_BASE_US       2000000
+#define LOADGEN_SAMPLES_MAX         (1u << 20)  // Per worker and exchange, counts keep going past it
+
+int loadgen_verbose = 0;
+
+typedef enum {
+    LAT_SOLICIT_REPLY,
+    LAT_SOLICIT_ADVERTISE,
+    LAT_REQUEST,
+    LAT_RENEW,
+    LAT_RENEW_SOLICIT,
+    LAT_REBIND,
+    LAT_ACQUIRE,
+    LAT_COUNT
+} loadgen_latency_t;
+
+static const char *const latency_names[LAT_COUNT] = {
+    "solicit/reply",
+    "solicit/advertise",
+    "request/reply",
+    "renew/reply",
+    "renew solicit/reply",
+    "rebind/reply",
+    "address acquired",
+};
+
+typedef enum {
+    CNT_EXCHANGES,
+    CNT_RETRANSMITS,
+    CNT_TIMEOUTS,
+    CNT_ACQUIRED,
+    CNT_ACQUIRE_FAILED,
+    CNT_ADVERTISE,
+    CNT_RENEW_OK,
+    CNT_RENEW_FAILED,
+    CNT_EXPIRED,
+    CNT_BOUND_AT_END,
+    CNT_COUNT
+} loadgen_counter_t;
+
+typedef struct {
+    uint32_t *samples;                          /*!< Latency in microseconds */
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t dropped;
+} loadgen_samples_t;
+
+/* Sent from every worker to the parent, followed by the samples of each exchange */
+typedef struct {
+    uint32_t counters[CNT_COUNT];
+    uint32_t sample_count[LAT_COUNT];
+    uint32_t dropped[LAT_COUNT];
+    uint64_t first_acquire_us;
+    uint64_t last_acquire_us;
+} loadgen_report_t;
+
+typedef enum {
+    NODE_IDLE,
+    NODE_SOLICIT,
+    NODE_BOUND,
+    NODE_RETRY,
+} loadgen_node_state_t;
+
+typedef struct {
+    loadgen_node_state_t state;
+    uint64_t start_us;                          /*!< Scheduled start, or retry time in NODE_RETRY */
+    uint64_t acquire_start_us;
+} loadgen_node_t;
+
+typedef struct {
+    uint32_t clients;
+    uint32_t worker_clients;
+    uint32_t rate;                              /*!< Nodes started per second over all workers */
+    uint32_t duration_s;
+    bool renew_uses_solicit;
+    uint16_t sol_timeout;
+    uint16_t sol_max_rt;
+    uint8_t sol_max_rc;
+    uint8_t mac_seed;
+    loadgen_relay_config_t relay;
+} loadgen_config_t;
+
+static loadgen_config_t config = {
+    .clients = 100,
+    .worker_clients = 100,
+    .rate = 50,
+    .duration_s = 180,
+    .sol_timeout = 1,
+    .sol_max_rt = 16,
+    .sol_max_rc = 4,
+};
+
+static loadgen_node_t nodes[LOADGEN_WORKER_CLIENTS_MAX + 1];
+static loadgen_samples_t samples[LAT_COUNT];
+static loadgen_report_t report;
+static uint8_t prefix[16];
+
+uint64_t loadgen_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void loadgen_sample_add(loadgen_latency_t type, uint64_t latency_us)
+{
+    loadgen_samples_t *set = &samples[type];
+    if (set->count == set->capacity) {
+        uint32_t capacity = set->capacity ? set->capacity * 2 : 1024;
+        uint32_t *grown = capacity <= LOADGEN_SAMPLES_MAX ? realloc(set->samples, capacity * sizeof(uint32_t)) : NULL;
+        if (!grown) {
+            set->dropped++;
+            return;
+        }
+        set->samples = grown;
+        set->capacity = capacity;
+    }
+    set->samples[set->count++] = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us;
+}
+
+static void loadgen_retry_schedule(loadgen_node_t *node, uint64_t now)
+{
+    // Spread retries so failed nodes do not come back as one burst
+    node->state = NODE_RETRY;
+    node->start_us = now + LOADGEN_RETRY_BASE_US + randLIB_get_32bit() % LOADGEN_RETRY_BASE_US;
+}
+
+static void loadgen_global_address_cb(int8_t interface, uint8_t dhcp_addr[static 16], uint8_t address[static 16], bool register_status)
+{
+    loadgen_node_t *node = &nodes[interface];
+    uint64_t now = loadgen_now_us();
+    (void)dhcp_addr;
+
+    if (node->state == NODE_BOUND) {
+        report.counters[register_status ? CNT_RENEW_OK : CNT_RENEW_FAILED]++;
+        // A failed renew keeps the address until its valid lifetime runs out
+        return;
+    }
+
+    if (!register_status) {
+        tr_warn("node %d: address request failed", interface);
+        report.counters[CNT_ACQUIRE_FAILED]++;
+        loadgen_retry_schedule(node, now);
+        return;
+    }
+
+    char addr_str[INET6_ADDRSTRLEN];
+    tr_info("node %d: %s", interface, inet_ntop(AF_INET6, address, addr_str, sizeof(addr_str)));
+    loadgen_sample_add(LAT_ACQUIRE, now - node->acquire_start_us);
+    report.counters[CNT_ACQUIRED]++;
+    if (!report.first_acquire_us) {
+        report.first_acquire_us = now;
+    }
+    report.last_acquire_us = now;
+    node->state = NODE_BOUND;
+}
+
+void loadgen_exchange_done(int8_t interface, uint8_t sent_type, uint8_t reply_type, uint64_t latency_us, uint8_t retransmissions)
+{
+    loadgen_latency_t type;
+    (void)retransmissions;
+
+    switch (sent_type) {
+        case DHCPV6_SOLICATION_TYPE:
+            if (nodes[interface].state == NODE_BOUND) {
+                type = LAT_RENEW_SOLICIT;
+            } else if (reply_type == DHCPV6_ADVERTISMENT_TYPE) {
+                type = LAT_SOLICIT_ADVERTISE;
+            } else {
+                type = LAT_SOLICIT_REPLY;
+            }
+            if (reply_type == DHCPV6_ADVERTISMENT_TYPE) {
+                report.counters[CNT_ADVERTISE]++;
+            }
+            break;
+        case DHCPV6_REQUEST_TYPE:
+            type = LAT_REQUEST;
+            break;
+        case DHCPV6_RENEW_TYPE:
+            type = LAT_RENEW;
+            break;
+        case DHCPV6_REBIND_TYPE:
+            type = LAT_REBIND;
+            break;
+        default:
+            return;
+    }
+    report.counters[CNT_EXCHANGES]++;
+    loadgen_sample_add(type, latency_us);
+}
+
+void loadgen_exchange_timeout(int8_t interface, uint8_t sent_type)
+{
+    tr_warn("node %d: message %d timed out", interface, sent_type);
+    report.counters[CNT_TIMEOUTS]++;
+}
+
+void loadgen_retransmit(int8_t interface, uint8_t sent_type)
+{
+    (void)interface;
+    (void)sent_type;
+    report.counters[CNT_RETRANSMITS]++;
+}
+
+void loadgen_address_lost(int8_t interface)
+{
+    tr_warn("node %d: address expired", interface);
+    report.counters[CNT_EXPIRED]++;
+    nodes[interface].state = NODE_RETRY;
+    nodes[interface].start_us = loadgen_now_us();
+}
+
+static void loadgen_node_start(int8_t interface, uint64_t now)
+{
+    loadgen_node_t *node = &nodes[interface];
+    uint8_t *server = config.relay.server.sin6_addr.s6_addr;
+
+    // Drop what a failed attempt left behind, a one client interface would otherwise wait for it
+    dhcp_client_global_address_delete(interface, NULL, prefix);
+
+    node->state = NODE_SOLICIT;
+    node->acquire_start_us = now;
+    if (dhcp_client_get_global_address(interface, server, prefix, loadgen_global_address_cb) != 0) {
+        report.counters[CNT_ACQUIRE_FAILED]++;
+        loadgen_retry_schedule(node, now);
+    }
+}
+
+static int loadgen_write_all(int fd, const void *data, size_t len)
+{
+    const uint8_t *ptr = data;
+    while (len) {
+        ssize_t written = write(fd, ptr, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        ptr += written;
+        len -= written;
+    }
+    return 0;
+}
+
+static int loadgen_read_all(int fd, void *data, size_t len)
+{
+    uint8_t *ptr = data;
+    while (len) {
+        ssize_t got = read(fd, ptr, len);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return -1;
+        }
+        ptr += got;
+        len -= got;
+    }
+    return 0;
+}
+
+static int loadgen_worker_run(uint32_t worker, uint32_t workers, uint32_t count, uint64_t t0, int report_fd)
+{
+    randLIB_seed(((uint64_t)getpid() << 32) ^ t0 ^ worker);
+
+    if (dhcp_service_shim_open(&config.relay) != 0) {
+        fprintf(stderr, "worker %u: socket setup failed: %s\n", worker, strerror(errno));
+        return -1;
+    }
+
+    for (uint32_t i = 1; i <= count; i++) {
+        int8_t interface = (int8_t)i;
+        uint8_t mac[8] = {0x00, 0x12, 0x4b, config.mac_seed, (uint8_t)(worker >> 8), (uint8_t)worker, 0x00, (uint8_t)i};
+        if (!protocol_shim_interface_create(interface, mac)) {
+            fprintf(stderr, "worker %u: interface %u setup failed\n", worker, i);
+            return -1;
+        }
+        dhcp_client_init(interface, DHCPV6_DUID_HARDWARE_EUI64_TYPE);
+        // Same client setup as the Wi-SUN bootstrap, renew_uses_solicit is the option under test
+        dhcp_client_configure(interface, config.renew_uses_solicit, true, true);
+        dhcp_client_solicit_timeout_set(interface, config.sol_timeout, config.sol_max_rt, config.sol_max_rc);
+
+        // Interleave the workers so the ramp is even over all nodes
+        uint64_t global_index = (uint64_t)(i - 1) * workers + worker;
+        nodes[i].state = NODE_IDLE;
+        nodes[i].start_us = t0 + global_index * 1000000 / config.rate;
+    }
+
+    uint64_t end = t0 + (uint64_t)config.duration_s * 1000000;
+    uint64_t next_tick = t0 + LOADGEN_TICK_US;
+    uint64_t now;
+
+    while ((now = loadgen_now_us()) < end) {
+        uint64_t next_event = end;
+
+        for (uint32_t i = 1; i <= count; i++) {
+            if (nodes[i].state != NODE_IDLE && nodes[i].state != NODE_RETRY) {
+                continue;
+            }
+            if (nodes[i].start_us <= now) {
+                loadgen_node_start((int8_t)i, now);
+            } else if (nodes[i].start_us < next_event) {
+                next_event = nodes[i].start_us;
+            }
+        }
+
+        while (next_tick <= now) {
+            protocol_shim_timer_tick();
+            next_tick += LOADGEN_TICK_US;
+        }
+        if (next_tick < next_event) {
+            next_event = next_tick;
+        }
+
+        int wait_ms = (int)((next_event - now + 999) / 1000);
+        int tr_ms = dhcp_service_shim_timer_run();
+        if (tr_ms >= 0 && tr_ms < wait_ms) {
+            wait_ms = tr_ms;
+        }
+        dhcp_service_shim_poll(wait_ms);
+    }
+
+    for (uint32_t i = 1; i <= count; i++) {
+        if (nodes[i].state == NODE_BOUND) {
+            report.counters[CNT_BOUND_AT_END]++;
+        }
+        dhcp_client_delete((int8_t)i);
+        protocol_shim_interface_free((int8_t)i);
+    }
+    dhcp_service_shim_close();
+
+    for (int type = 0; type < LAT_COUNT; type++) {
+        report.sample_count[type] = samples[type].count;
+        report.dropped[type] = samples[type].dropped;
+    }
+    if (loadgen_write_all(report_fd, &report, sizeof(report)) != 0) {
+        return -1;
+    }
+    for (int type = 0; type < LAT_COUNT; type++) {
+        if (loadgen_write_all(report_fd, samples[type].samples, samples[type].count * sizeof(uint32_t)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Merge a worker report into the totals, the worker samples are appended to samples[] */
+static int loadgen_report_read(int fd, loadgen_report_t *total)
+{
+    loadgen_report_t worker_report;
+    if (loadgen_read_all(fd, &worker_report, sizeof(worker_report)) != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < CNT_COUNT; i++) {
+        total->counters[i] += worker_report.counters[i];
+    }
+    if (worker_report.first_acquire_us && (!total->first_acquire_us || worker_report.first_acquire_us < total->first_acquire_us)) {
+        total->first_acquire_us = worker_report.first_acquire_us;
+    }
+    if (worker_report.last_acquire_us > total->last_acquire_us) {
+        total->last_acquire_us = worker_report.last_acquire_us;
+    }
+
+    for (int type = 0; type < LAT_COUNT; type++) {
+        loadgen_samples_t *set = &samples[type];
+        uint32_t count = worker_report.sample_count[type];
+        total->dropped[type] += worker_report.dropped[type];
+        if (!count) {
+            continue;
+        }
+        uint32_t *grown = realloc(set->samples, (size_t)(set->count + count) * sizeof(uint32_t));
+        if (!grown) {
+            return -1;
+        }
+        set->samples = grown;
+        if (loadgen_read_all(fd, set->samples + set->count, count * sizeof(uint32_t)) != 0) {
+            return -1;
+        }
+        set->count += count;
+    }
+    return 0;
+}
+
+static int loadgen_sample_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest rank percentile of sorted samples, in milliseconds
+static double loadgen_percentile(const loadgen_samples_t *set, uint32_t percent)
+{
+    uint64_t rank = ((uint64_t)set->count * percent + 99) / 100;
+    return set->samples[rank ? rank - 1 : 0] / 1000.0;
+}
+
+static void loadgen_results_print(const loadgen_report_t *total, uint32_t workers, double elapsed_s)
+{
+    printf("clients %u (%u workers), class %s, duration %u s, renew uses solicit: %s\n",
+           config.clients, workers, LOADGEN_VENDOR_CLASS, config.duration_s, config.renew_uses_solicit ? "yes" : "no");
+    printf("%-20s %8s %9s %9s %9s %9s\n", "exchange", "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    for (int type = 0; type < LAT_COUNT; type++) {
+        loadgen_samples_t *set = &samples[type];
+        if (!set->count) {
+            continue;
+        }
+        qsort(set->samples, set->count, sizeof(uint32_t), loadgen_sample_compare);
+        printf("%-20s %8u %9.2f %9.2f %9.2f %9.2f\n", latency_names[type], set->count,
+               loadgen_percentile(set, 50), loadgen_percentile(set, 90), loadgen_percentile(set, 99),
+               set->samples[set->count - 1] / 1000.0);
+        if (total->dropped[type]) {
+            printf("%-20s %8u samples not kept\n", "", total->dropped[type]);
+        }
+    }
+
+    const uint32_t *cnt = total->counters;
+    printf("acquired %u, failed %u, bound at end %u/%u, expired %u\n",
+           cnt[CNT_ACQUIRED], cnt[CNT_ACQUIRE_FAILED], cnt[CNT_BOUND_AT_END], config.clients, cnt[CNT_EXPIRED]);
+    printf("renews ok %u, failed %u, advertise fallbacks %u, retransmissions %u, timeouts %u\n",
+           cnt[CNT_RENEW_OK], cnt[CNT_RENEW_FAILED], cnt[CNT_ADVERTISE], cnt[CNT_RETRANSMITS], cnt[CNT_TIMEOUTS]);
+    printf("throughput %.1f exchanges/s", cnt[CNT_EXCHANGES] / elapsed_s);
+    if (cnt[CNT_ACQUIRED] > 1 && total->last_acquire_us > total->first_acquire_us) {
+        double span_s = (total->last_acquire_us - total->first_acquire_us) / 1e6;
+        printf(", addresses %.1f/s over %.1f s", (cnt[CNT_ACQUIRED] - 1) / span_s, span_s);
+    }
+    printf("\n");
+}
+
+static void loadgen_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n, --clients N         simulated nodes (default %u)\n"
+            "  -s, --server ADDR       Kea address (default ::1)\n"
+            "  -p, --port PORT         Kea port (default %d)\n"
+            "  -l, --link-address ADDR relay link-address selecting the subnet (default 2020:abcd::1)\n"
+            "  -r, --rate N            nodes started per second (default %u)\n"
+            "  -d, --duration S        run time in seconds, renews continue until then (default %u)\n"
+            "  -S, --renew-solicit     renew with Solicit instead of Renew (renew_uses_solicit)\n"
+            "  -t, --solicit-timers I,M,C  Solicit timeout, max timeout (s) and retries (default %u,%u,%u)\n"
+            "  -w, --worker-clients N  nodes per worker process, at most %d (default %u)\n"
+            "  -m, --mac-seed N        byte placed in every EUI-64, use a new one for fresh leases\n"
+            "  -v, --verbose           client traces, repeat for more\n",
+            name, config.clients, DHCPV6_SERVER_PORT, config.rate, config.duration_s,
+            config.sol_timeout, config.sol_max_rt, config.sol_max_rc, LOADGEN_WORKER_CLIENTS_MAX, config.worker_clients);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"clients", required_argument, NULL, 'n'},
+        {"server", required_argument, NULL, 's'},
+        {"port", required_argument, NULL, 'p'},
+        {"link-address", required_argument, NULL, 'l'},
+        {"rate", required_argument, NULL, 'r'},
+        {"duration", required_argument, NULL, 'd'},
+        {"renew-solicit", no_argument, NULL, 'S'},
+        {"solicit-timers", required_argument, NULL, 't'},
+        {"worker-clients", required_argument, NULL, 'w'},
+        {"mac-seed", required_argument, NULL, 'm'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    const char *server = "::1";
+    const char *link_address = "2020:abcd::1";
+    unsigned port = DHCPV6_SERVER_PORT;
+    unsigned sol_timeout, sol_max_rt, sol_max_rc;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:s:p:l:r:d:St:w:m:vh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                config.clients = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                server = optarg;
+                break;
+            case 'p':
+                port = strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                link_address = optarg;
+                break;
+            case 'r':
+                config.rate = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                config.duration_s = strtoul(optarg, NULL, 0);
+                break;
+            case 'S':
+                config.renew_uses_solicit = true;
+                break;
+            case 't':
+                if (sscanf(optarg, "%u,%u,%u", &sol_timeout, &sol_max_rt, &sol_max_rc) != 3 || !sol_timeout || sol_max_rc > 0xff) {
+                    fprintf(stderr, "invalid solicit timers: %s\n", optarg);
+                    return 2;
+                }
+                config.sol_timeout = sol_timeout;
+                config.sol_max_rt = sol_max_rt;
+                config.sol_max_rc = sol_max_rc;
+                break;
+            case 'w':
+                config.worker_clients = strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                config.mac_seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                loadgen_verbose++;
+                break;
+            default:
+                loadgen_usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (!config.clients || !config.rate || !config.duration_s ||
+            !config.worker_clients || config.worker_clients > LOADGEN_WORKER_CLIENTS_MAX || !port || port > 0xffff) {
+        loadgen_usage(argv[0]);
+        return 2;
+    }
+
+    config.relay.server.sin6_family = AF_INET6;
+    config.relay.server.sin6_port = htons(port);
+    if (inet_pton(AF_INET6, server, &config.relay.server.sin6_addr) != 1 ||
+            inet_pton(AF_INET6, link_address, config.relay.link_address) != 1) {
+        fprintf(stderr, "invalid IPv6 address\n");
+        return 2;
+    }
+    // Nodes ask for an address in the /64 of the relay link
+    memcpy(prefix, config.relay.link_address, 8);
+
+    uint32_t workers = (config.clients + config.worker_clients - 1) / config.worker_clients;
+    int *report_fds = calloc(workers, sizeof(int));
+    pid_t *pids = calloc(workers, sizeof(pid_t));
+    if (!report_fds || !pids) {
+        return 1;
+    }
+
+    // Workers share the start time so the ramp and the run end line up
+    uint64_t t0 = loadgen_now_us() + 100000;
+    fflush(NULL);
+
+    for (uint32_t worker = 0; worker < workers; worker++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        // Nodes are dealt out round robin so every worker has an even share of the ramp
+        uint32_t count = config.clients / workers + (worker < config.clients % workers);
+
+        pids[worker] = fork();
+        if (pids[worker] < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pids[worker] == 0) {
+            close(fds[0]);
+            int ret = loadgen_worker_run(worker, workers, count, t0, fds[1]);
+            _exit(ret == 0 ? 0 : 1);
+        }
+        close(fds[1]);
+        report_fds[worker] = fds[0];
+    }
+
+    loadgen_report_t total = {0};
+    int status = 0;
+    for (uint32_t worker = 0; worker < workers; worker++) {
+        if (loadgen_report_read(report_fds[worker], &total) != 0) {
+            fprintf(stderr, "worker %u: no report\n", worker);
+            status = 1;
+        }
+        close(report_fds[worker]);
+    }
+    for (uint32_t worker = 0; worker < workers; worker++) {
+        int worker_status;
+        waitpid(pids[worker], &worker_status, 0);
+        if (!WIFEXITED(worker_status) || WEXITSTATUS(worker_status) != 0) {
+            status = 1;
+        }
+    }
+
+    loadgen_results_print(&total, workers, (loadgen_now_us() - t0) / 1e6);
+    return status;
+}
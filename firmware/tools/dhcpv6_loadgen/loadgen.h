@@ -0,0 +1,41 @@
+/*
+ * DHCPv6 client load generator, shared between the driver and the nanostack shims.
+ */
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include "ns_types.h"
+#include <netinet/in.h>
+#include "NWK_INTERFACE/Include/protocol.h"
+
+// Interface ids are int8_t in the client, one worker process simulates at most this many nodes
+#define LOADGEN_WORKER_CLIENTS_MAX  120
+
+/* Clock used for all latency measurements, microseconds */
+uint64_t loadgen_now_us(void);
+
+/* Relay-Forward settings of the dhcp_service shim */
+typedef struct {
+    struct sockaddr_in6 server;                 /*!< Kea address and port */
+    uint8_t link_address[16];                   /*!< Relay link-address, selects the Kea subnet */
+} loadgen_relay_config_t;
+
+int dhcp_service_shim_open(const loadgen_relay_config_t *config);
+void dhcp_service_shim_close(void);
+/* Wait up to timeout_ms for replies and dispatch them to the client */
+void dhcp_service_shim_poll(int timeout_ms);
+/* Retransmit or time out due transactions, returns ms until the next one is due (-1 if none) */
+int dhcp_service_shim_timer_run(void);
+
+protocol_interface_info_entry_t *protocol_shim_interface_create(int8_t id, const uint8_t mac[static 8]);
+void protocol_shim_interface_free(int8_t id);
+/* Advance address state timers and lifetimes by one 100ms tick */
+void protocol_shim_timer_tick(void);
+
+/* Hooks the shims call back into the driver */
+void loadgen_exchange_done(int8_t interface, uint8_t sent_type, uint8_t reply_type, uint64_t latency_us, uint8_t retransmissions);
+void loadgen_exchange_timeout(int8_t interface, uint8_t sent_type);
+void loadgen_retransmit(int8_t interface, uint8_t sent_type);
+void loadgen_address_lost(int8_t interface);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef LOADGEN_PROTOCOL_H
+#define LOADGEN_PROTOCOL_H
+
+#include "ns_types.h"
+
+typedef enum {
+    ADDR_CALLBACK_DAD_COMPLETE,
+    ADDR_CALLBACK_TIMER,
+    ADDR_CALLBACK_DEPRECATED,
+    ADDR_CALLBACK_INVALIDATED,
+    ADDR_CALLBACK_DELETED,
+} if_address_callback_t;
+
+typedef enum {
+    ADDR_SOURCE_UNKNOWN,
+    ADDR_SOURCE_SLAAC,
+    ADDR_SOURCE_DHCP,
+    ADDR_SOURCE_STATIC,
+} if_address_source_t;
+
+struct protocol_interface_info_entry;
+struct if_address_entry;
+
+typedef void if_address_callback_fn(struct protocol_interface_info_entry *interface, struct if_address_entry *addr, if_address_callback_t reason);
+
+typedef struct if_address_entry {
+    uint8_t address[16];
+    uint8_t prefix_len;
+    uint32_t valid_lifetime;
+    uint32_t preferred_lifetime;
+    uint32_t state_timer;                       // 100ms ticks, cb is called with ADDR_CALLBACK_TIMER at zero
+    uint32_t valid_ticks;                       // 100ms ticks left of the valid lifetime, 0xffffffff is infinite
+    if_address_source_t source;
+    if_address_callback_fn *cb;
+    bool in_use;
+} if_address_entry_t;
+
+#define LOADGEN_IF_ADDRESS_MAX 2
+
+/* One simulated node */
+typedef struct protocol_interface_info_entry {
+    int8_t id;
+    uint8_t mac[8];
+    if_address_entry_t addresses[LOADGEN_IF_ADDRESS_MAX];
+} protocol_interface_info_entry_t;
+
+protocol_interface_info_entry_t *protocol_stack_interface_info_get_by_id(int8_t nwk_id);
+if_address_entry_t *addr_get_entry(const protocol_interface_info_entry_t *interface, const uint8_t addr[static 16]);
+if_address_entry_t *addr_add(protocol_interface_info_entry_t *cur, const uint8_t address[static 16], uint_fast8_t prefix_len, if_address_source_t source, uint32_t valid_lifetime, uint32_t preferred_lifetime, bool skip_dad);
+int_fast8_t addr_delete(protocol_interface_info_entry_t *cur, const uint8_t address[static 16]);
+void addr_deprecate(protocol_interface_info_entry_t *cur, const uint8_t address[static 16]);
+void addr_set_valid_lifetime(protocol_interface_info_entry_t *interface, if_address_entry_t *entry, uint32_t valid_lifetime);
+void addr_set_preferred_lifetime(protocol_interface_info_entry_t *interface, if_address_entry_t *entry, uint32_t preferred_lifetime);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef LOADGEN_COAP_SERVICE_API_H
+#define LOADGEN_COAP_SERVICE_API_H
+
+/* Included by the FSR/LIGHT builds of the client, registration is compiled out for the load generator */
+#include "ns_types.h"
+
+typedef struct sn_coap_hdr_ sn_coap_hdr_s;
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef LOADGEN_COMMON_FUNCTIONS_H
+#define LOADGEN_COMMON_FUNCTIONS_H
+
+#include <stdint.h>
+
+static inline uint8_t *common_write_16_bit(uint16_t value, uint8_t ptr[static 2])
+{
+    *ptr++ = value >> 8;
+    *ptr++ = value;
+    return ptr;
+}
+
+static inline uint8_t *common_write_24_bit(uint32_t value, uint8_t ptr[static 3])
+{
+    *ptr++ = value >> 16;
+    *ptr++ = value >> 8;
+    *ptr++ = value;
+    return ptr;
+}
+
+static inline uint8_t *common_write_32_bit(uint32_t value, uint8_t ptr[static 4])
+{
+    *ptr++ = value >> 24;
+    *ptr++ = value >> 16;
+    *ptr++ = value >> 8;
+    *ptr++ = value;
+    return ptr;
+}
+
+static inline uint16_t common_read_16_bit(const uint8_t data_buf[static 2])
+{
+    return (uint16_t)data_buf[0] << 8 | data_buf[1];
+}
+
+static inline uint32_t common_read_24_bit(const uint8_t data_buf[static 3])
+{
+    return (uint32_t)data_buf[0] << 16 | (uint32_t)data_buf[1] << 8 | data_buf[2];
+}
+
+static inline uint32_t common_read_32_bit(const uint8_t data_buf[static 4])
+{
+    return (uint32_t)data_buf[0] << 24 | (uint32_t)data_buf[1] << 16 | (uint32_t)data_buf[2] << 8 | data_buf[3];
+}
+
+#endif
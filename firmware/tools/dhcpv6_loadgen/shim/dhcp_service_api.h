@@ -0,0 +1,26 @@
+#ifndef LOADGEN_DHCP_SERVICE_API_H
+#define LOADGEN_DHCP_SERVICE_API_H
+
+#include "ns_types.h"
+
+#define DHCP_INSTANCE_CLIENT        1
+#define DHCP_INSTANCE_SERVER        2
+#define DHCP_INTANCE_RELAY_AGENT    3
+
+#define RET_MSG_ACCEPTED    0
+#define RET_MSG_NOT_MINE    1
+
+/* msg_name 0 with a NULL message reports that all retransmissions timed out */
+typedef int (dhcp_service_receive_resp_cb)(uint16_t instance_id, void *ptr, uint8_t msg_name, uint8_t *msg_ptr, uint16_t msg_len);
+
+uint16_t dhcp_service_init(int8_t interface_id, int instance_type, void *receive_req_cb);
+void dhcp_service_delete(uint16_t instance);
+uint32_t dhcp_service_send_req(uint16_t instance_id, uint8_t options, void *ptr, const uint8_t addr[static 16], uint8_t *msg_ptr, uint16_t msg_len, dhcp_service_receive_resp_cb *receive_resp_cb);
+void dhcp_service_set_retry_timers(uint32_t msg_tr_id, uint16_t timeout_init, uint16_t timeout_max, uint8_t retrans_max);
+void dhcp_service_update_server_address(uint32_t msg_tr_id, uint8_t *server_address);
+void dhcp_service_req_remove_all(void *msg_class_ptr);
+void dhcp_service_relay_instance_enable(uint16_t instance, uint8_t *server_address);
+void dhcp_service_relay_interface_id_option_enable(uint16_t instance, bool enable);
+uint8_t *dhcp_service_relay_global_addres_get(uint16_t instance);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef LOADGEN_DHCPV6_CLIENT_API_H
+#define LOADGEN_DHCPV6_CLIENT_API_H
+
+#include "ns_types.h"
+
+typedef void (dhcp_client_global_adress_cb)(int8_t interface, uint8_t dhcp_addr[static 16], uint8_t prefix[static 16], bool register_status);
+
+typedef struct dhcp_server_notify_info {
+    uint32_t life_time;
+    uint8_t *duid;
+    uint16_t duid_type;
+    uint16_t duid_length;
+} dhcp_server_notify_info_t;
+
+typedef struct dhcp_option_notify {
+    uint16_t option_type;
+    union {
+        struct {
+            uint32_t enterprise_number;
+            uint8_t *data;
+            uint16_t data_length;
+        } vendor_spesific;
+        struct {
+            uint8_t *data;
+            uint16_t data_length;
+        } generic;
+    } option;
+} dhcp_option_notify_t;
+
+typedef void (dhcp_client_options_notify_cb)(int8_t interface, dhcp_option_notify_t *option_notify, dhcp_server_notify_info_t *server_info);
+
+void dhcp_client_init(int8_t interface, uint16_t link_type);
+void dhcp_client_configure(int8_t interface, bool renew_uses_solicit, bool one_client_for_this_interface, bool no_address_hint);
+void dhcp_client_solicit_timeout_set(int8_t interface, uint16_t timeout, uint16_t max_rt, uint8_t max_rc);
+int dhcp_client_get_global_address(int8_t interface, uint8_t dhcp_addr[static 16], uint8_t prefix[static 16], dhcp_client_global_adress_cb *error_cb);
+int dhcp_client_server_address_update(int8_t interface, uint8_t *prefix, uint8_t server_address[static 16]);
+void dhcp_client_global_address_delete(int8_t interface, uint8_t *dhcp_addr, uint8_t prefix[static 16]);
+void dhcp_client_delete(int8_t interface);
+
+#endif
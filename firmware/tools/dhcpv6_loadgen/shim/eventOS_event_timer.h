@@ -0,0 +1,10 @@
+#ifndef LOADGEN_EVENTOS_EVENT_TIMER_H
+#define LOADGEN_EVENTOS_EVENT_TIMER_H
+
+#include <stdint.h>
+
+#define EVENTOS_EVENT_TIMER_HZ 100
+
+uint32_t eventOS_event_timer_ticks(void);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef LOADGEN_IP6STRING_H
+#define LOADGEN_IP6STRING_H
+
+#include "ns_types.h"
+
+#endif
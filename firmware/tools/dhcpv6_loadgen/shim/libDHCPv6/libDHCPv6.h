@@ -0,0 +1,111 @@
+#ifndef LOADGEN_LIBDHCPV6_H
+#define LOADGEN_LIBDHCPV6_H
+
+#include "ns_types.h"
+
+#define DHCPV6_SOLICATION_TYPE          1
+#define DHCPV6_ADVERTISMENT_TYPE        2
+#define DHCPV6_REQUEST_TYPE             3
+#define DHCPV6_CONFIRM_TYPE             4
+#define DHCPV6_RENEW_TYPE               5
+#define DHCPV6_REBIND_TYPE              6
+#define DHCPV6_REPLY_TYPE               7
+#define DHCPV6_RELEASE_TYPE             8
+#define DHCPV6_RELAY_FORWARD            12
+#define DHCPV6_RELAY_REPLY              13
+
+#define DHCPV6_CLIENT_ID_OPTION         1
+#define DHCPV6_SERVER_ID_OPTION         2
+#define DHCPV6_IDENTITY_ASSOCIATION_OPTION 3
+#define DHCPV6_IA_ADDRESS_OPTION        5
+#define DHCPV6_OPTION_REQUEST_OPTION    6
+#define DHCPV6_ELAPSED_TIME_OPTION      8
+#define DHCPV6_RELAY_MESSAGE_OPTION     9
+#define DHCPV6_STATUS_CODE_OPTION       13
+#define DHCPV6_OPTION_RAPID_COMMIT      14
+#define DHCPV6_OPTION_VENDOR_CLASS      16
+#define DHCPV6_OPTION_VENDOR_SPECIFIC_INFO 17
+#define DHCPV6_OPTION_DNS_SERVERS       23
+#define DHCPV6_OPTION_DOMAIN_LIST       24
+#define DHCPV6_RELAY_SOURCE_PORT_OPTION 135
+
+#define DHCPV6_DUID_LINK_LAYER_TYPE     3
+#define DHCPV6_DUID_HARDWARE_EUI64_TYPE 27
+#define DHCPV6_DUID_HARDWARE_EUI48_TYPE 1
+
+#define DHCPV6_SERVER_PORT  547
+#define DHCPV6_CLIENT_PORT  546
+
+typedef struct dhcp_duid_options_params {
+    uint16_t type;
+    uint8_t duid_length;
+    uint8_t *duid;
+} dhcp_duid_options_params_t;
+
+typedef struct dhcp_ia_non_temporal_params {
+    uint32_t iaId;
+    uint32_t T0;
+    uint32_t T1;
+    uint8_t *nonTemporalAddress;
+    uint32_t preferredValidLifeTime;
+    uint32_t validLifeTime;
+} dhcp_ia_non_temporal_params_t;
+
+typedef struct dhcpv6_ia_non_temporal_address_entry {
+    uint8_t addressPrefix[16];
+    uint32_t preferredTime;
+    uint32_t validLifetime;
+} dhcpv6_ia_non_temporal_address_entry_t;
+
+typedef struct dhcpv6_solication_base_packet {
+    uint8_t messageType;
+    uint32_t transActionId;
+    dhcp_duid_options_params_t clientDUID;
+    uint32_t iaID;
+    uint32_t timerT0;
+    uint32_t timerT1;
+    uint8_t requestedOptionCnt;
+    uint16_t *requestedOptionList;
+} dhcpv6_solication_base_packet_s;
+
+typedef struct dhcpv6_ia_non_temporal_address {
+    uint8_t *requestedAddress;
+    uint32_t preferredLifeTime;
+    uint32_t validLifeTime;
+} dhcpv6_ia_non_temporal_address_s;
+
+typedef struct dhcpv6_client_server_entry {
+    int8_t interfaceId;
+    uint8_t instanceId;
+    uint32_t transActionId;
+    uint32_t IAID;
+    uint32_t T0;
+    uint32_t T1;
+    uint8_t server_address[16];
+    bool GlobalAddress;
+    bool iaNonTemporalStructValid;
+    dhcp_duid_options_params_t clientDUID;
+    dhcp_duid_options_params_t serverDUID;
+    uint8_t *serverDynamic_DUID;
+    uint8_t dyn_server_duid_length;
+    dhcpv6_ia_non_temporal_address_entry_t iaNontemporalAddress;
+    struct dhcpv6_client_server_entry *next;
+} dhcpv6_client_server_data_t;
+
+uint8_t libdhcpv6_nonTemporal_entry_get_unique_instance_id(void);
+uint8_t libdhcpv6_duid_linktype_size(uint16_t linkType);
+dhcpv6_client_server_data_t *libdhcvp6_nontemporalAddress_server_data_allocate(int8_t interfaceId, uint8_t instanceId, uint8_t *nonTemporalPrefix, uint8_t serverIPv6[static 16]);
+void libdhcvp6_nontemporalAddress_server_data_free(dhcpv6_client_server_data_t *removedEntry);
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_instance(uint8_t instanceId);
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_prefix(int8_t interfaceId, uint8_t *prefix);
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_iaid(uint32_t iaId);
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_validate_class_pointer(void *class_ptr);
+uint32_t libdhcpv6_txid_get(void);
+uint32_t libdhcpv6_renew_time_define(dhcpv6_client_server_data_t *addresInfo);
+uint16_t libdhcpv6_solication_message_length(uint16_t clientDUIDLength, bool addressDefined, uint8_t requestOptionCount);
+uint16_t libdhcpv6_address_request_message_len(uint16_t clientDUIDLength, uint16_t serverDUIDLength, uint8_t requstOptionCnt, bool add_address);
+uint8_t *libdhcpv6_generic_nontemporal_address_message_write(uint8_t *ptr, dhcpv6_solication_base_packet_s *packet, dhcpv6_ia_non_temporal_address_s *nonTemporalAddress, dhcp_duid_options_params_t *serverLink);
+int libdhcpv6_reply_message_option_validate(dhcp_duid_options_params_t *clientId, dhcp_duid_options_params_t *serverId, dhcp_ia_non_temporal_params_t *dhcp_ia_non_temporal_params, uint8_t *ptr, uint16_t data_length);
+int libdhcpv6_compare_DUID(dhcp_duid_options_params_t *targetId, dhcp_duid_options_params_t *parsedId);
+
+#endif
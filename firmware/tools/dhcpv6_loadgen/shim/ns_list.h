@@ -0,0 +1,59 @@
+#ifndef LOADGEN_NS_LIST_H
+#define LOADGEN_NS_LIST_H
+
+#include <stddef.h>
+
+/* Minimal intrusive list with the nanostack macro names, links point at entries */
+typedef struct ns_list_link {
+    void *next;
+    void *prev;
+} ns_list_link_t;
+
+typedef struct ns_list {
+    void *first;
+    void *last;
+    size_t offset;
+} ns_list_t;
+
+#define NS_LIST_DEFINE(name, type, field) ns_list_t name = { NULL, NULL, offsetof(type, field) }
+#define NS_LIST_LINK_(list, e) ((ns_list_link_t *)((char *)(e) + (list)->offset))
+
+#define ns_list_foreach(type, e, list) \
+    for (type *e = (type *)(list)->first; e; e = (type *)NS_LIST_LINK_(list, e)->next)
+
+#define ns_list_foreach_safe(type, e, list) \
+    for (type *e = (type *)(list)->first, *e##_next_ = e ? (type *)NS_LIST_LINK_(list, e)->next : NULL; \
+         e; e = e##_next_, e##_next_ = e ? (type *)NS_LIST_LINK_(list, e)->next : NULL)
+
+#define ns_list_get_first(list) ((list)->first)
+#define ns_list_is_empty(list) ((list)->first == NULL)
+
+static inline void ns_list_add_to_end(ns_list_t *list, void *entry)
+{
+    ns_list_link_t *link = NS_LIST_LINK_(list, entry);
+    link->next = NULL;
+    link->prev = list->last;
+    if (list->last) {
+        NS_LIST_LINK_(list, list->last)->next = entry;
+    } else {
+        list->first = entry;
+    }
+    list->last = entry;
+}
+
+static inline void ns_list_remove(ns_list_t *list, void *entry)
+{
+    ns_list_link_t *link = NS_LIST_LINK_(list, entry);
+    if (link->prev) {
+        NS_LIST_LINK_(list, link->prev)->next = link->next;
+    } else {
+        list->first = link->next;
+    }
+    if (link->next) {
+        NS_LIST_LINK_(list, link->next)->prev = link->prev;
+    } else {
+        list->last = link->prev;
+    }
+}
+
+#endif
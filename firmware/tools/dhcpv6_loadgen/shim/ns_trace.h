@@ -0,0 +1,21 @@
+#ifndef LOADGEN_NS_TRACE_H
+#define LOADGEN_NS_TRACE_H
+
+#include <stdio.h>
+
+// Client traces are only printed with -v, load runs would drown in them otherwise
+extern int loadgen_verbose;
+
+#define tr_trace_(level, ...) do { \
+        if (loadgen_verbose >= (level)) { \
+            fprintf(stderr, "[" TRACE_GROUP "] " __VA_ARGS__); \
+            fputc('\n', stderr); \
+        } \
+    } while (0)
+
+#define tr_error(...) tr_trace_(1, __VA_ARGS__)
+#define tr_warn(...)  tr_trace_(1, __VA_ARGS__)
+#define tr_info(...)  tr_trace_(2, __VA_ARGS__)
+#define tr_debug(...) tr_trace_(3, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LOADGEN_NS_TYPES_H
+#define LOADGEN_NS_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#define NS_LARGE
+
+#endif
@@ -0,0 +1,10 @@
+/*
+ * Host shim for the nanostack headers used by dhcpv6_client_service.c.
+ * Only what the DHCPv6 client needs is declared, see shim_*.c for the implementations.
+ */
+#ifndef LOADGEN_NSCONFIG_H
+#define LOADGEN_NSCONFIG_H
+
+#define HAVE_DHCPV6
+
+#endif
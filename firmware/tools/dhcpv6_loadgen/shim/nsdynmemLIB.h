@@ -0,0 +1,11 @@
+#ifndef LOADGEN_NSDYNMEMLIB_H
+#define LOADGEN_NSDYNMEMLIB_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define ns_dyn_mem_alloc(size)              malloc(size)
+#define ns_dyn_mem_temporary_alloc(size)    malloc(size)
+#define ns_dyn_mem_free(ptr)                free(ptr)
+
+#endif
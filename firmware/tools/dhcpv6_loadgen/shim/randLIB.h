@@ -0,0 +1,12 @@
+#ifndef LOADGEN_RANDLIB_H
+#define LOADGEN_RANDLIB_H
+
+#include <stdint.h>
+
+uint16_t randLIB_get_16bit(void);
+uint32_t randLIB_get_32bit(void);
+
+// Host only, see shim_platform.c
+void randLIB_seed(uint64_t seed);
+
+#endif
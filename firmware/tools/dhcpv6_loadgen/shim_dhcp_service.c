@@ -0,0 +1,404 @@
+/*
+ * Host dhcp_service: every simulated node sends through one UDP socket as its own Relay-Forward,
+ * so Kea accepts the messages over unicast and the replies come back to an unprivileged port.
+ * Transactions, retransmissions and the callback contract follow nanostack dhcp_service_server.c.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "ns_types.h"
+#include "ns_list.h"
+#include "nsdynmemLIB.h"
+#include "common_functions.h"
+#include "randLIB.h"
+#include "dhcp_service_api.h"
+#include "libDHCPv6/libDHCPv6.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "loadgen.h"
+
+#define TRACE_GROUP "dhcs"
+#include "ns_trace.h"
+
+#define DHCP_SERVICE_INSTANCE_MAX   (2 * LOADGEN_WORKER_CLIENTS_MAX)
+#define DHCP_RELAY_HEADER_LEN       34          // msg-type, hop-count, link-address, peer-address
+#define DHCP_MSG_MAX                1500
+
+typedef struct {
+    int8_t interface_id;
+    int instance_type;
+    bool in_use;
+} dhcp_service_instance_t;
+
+typedef struct {
+    uint32_t msg_tr_id;
+    uint16_t instance_id;
+    int8_t interface_id;
+    void *client_obj_ptr;
+    uint8_t *msg_ptr;
+    uint16_t msg_len;
+    dhcp_service_receive_resp_cb *recv_resp_cb;
+    uint32_t timeout_init;                      /*!< ms */
+    uint32_t timeout_max;                       /*!< ms, 0 is no limit */
+    uint8_t retrans_max;                        /*!< 0 is no limit */
+    uint8_t retrans;
+    uint32_t timeout;                           /*!< Current retransmission timeout, ms */
+    uint64_t first_tx_us;
+    uint64_t next_tx_us;
+    ns_list_link_t link;
+} msg_tr_t;
+
+static NS_LIST_DEFINE(msg_tr_list, msg_tr_t, link);
+static dhcp_service_instance_t instances[DHCP_SERVICE_INSTANCE_MAX];
+static loadgen_relay_config_t relay_config;
+static int relay_socket = -1;
+static uint32_t msg_tr_id_next;
+
+/* RFC 8415 section 7.6 timers, Renew and Rebind are bounded by a retry count instead of T2 and the valid lifetime */
+static void dhcp_tr_default_timers(msg_tr_t *msg_tr_ptr, uint8_t msg_type)
+{
+    switch (msg_type) {
+        case DHCPV6_SOLICATION_TYPE:
+            msg_tr_ptr->timeout_init = 1000;
+            msg_tr_ptr->timeout_max = 3600000;
+            msg_tr_ptr->retrans_max = 0;
+            break;
+        case DHCPV6_REQUEST_TYPE:
+            msg_tr_ptr->timeout_init = 1000;
+            msg_tr_ptr->timeout_max = 30000;
+            msg_tr_ptr->retrans_max = 10;
+            break;
+        default:
+            msg_tr_ptr->timeout_init = 10000;
+            msg_tr_ptr->timeout_max = 600000;
+            msg_tr_ptr->retrans_max = 4;
+            break;
+    }
+}
+
+// RT +- 10%
+static uint32_t dhcp_tr_randomise(uint32_t timeout)
+{
+    uint32_t range = timeout / 5;
+    if (!range) {
+        return timeout;
+    }
+    return timeout - timeout / 10 + randLIB_get_32bit() % range;
+}
+
+static msg_tr_t *dhcp_tr_find(uint32_t msg_tr_id)
+{
+    ns_list_foreach(msg_tr_t, cur, &msg_tr_list) {
+        if (cur->msg_tr_id == msg_tr_id) {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+static void dhcp_tr_delete(msg_tr_t *msg_tr_ptr)
+{
+    ns_list_remove(&msg_tr_list, msg_tr_ptr);
+    ns_dyn_mem_free(msg_tr_ptr->msg_ptr);
+    ns_dyn_mem_free(msg_tr_ptr);
+}
+
+static int dhcp_tr_send(msg_tr_t *msg_tr_ptr)
+{
+    static uint8_t relay_msg[DHCP_RELAY_HEADER_LEN + DHCP_MSG_MAX + 16];
+    protocol_interface_info_entry_t *cur = protocol_stack_interface_info_get_by_id(msg_tr_ptr->interface_id);
+    if (!cur || msg_tr_ptr->msg_len > DHCP_MSG_MAX) {
+        return -1;
+    }
+
+    uint8_t *ptr = relay_msg;
+    *ptr++ = DHCPV6_RELAY_FORWARD;
+    *ptr++ = 0;                                 // hop-count
+    memcpy(ptr, relay_config.link_address, 16);
+    ptr += 16;
+    // peer-address is the node's EUI-64 link-local address
+    memset(ptr, 0, 16);
+    ptr[0] = 0xfe;
+    ptr[1] = 0x80;
+    memcpy(ptr + 8, cur->mac, 8);
+    ptr[8] ^= 0x02;
+    ptr += 16;
+
+    ptr = common_write_16_bit(DHCPV6_RELAY_MESSAGE_OPTION, ptr);
+    ptr = common_write_16_bit(msg_tr_ptr->msg_len, ptr);
+    memcpy(ptr, msg_tr_ptr->msg_ptr, msg_tr_ptr->msg_len);
+    ptr += msg_tr_ptr->msg_len;
+
+    // RFC 8357 Relay Source Port: Kea answers to our source port instead of 547
+    ptr = common_write_16_bit(DHCPV6_RELAY_SOURCE_PORT_OPTION, ptr);
+    ptr = common_write_16_bit(2, ptr);
+    ptr = common_write_16_bit(0, ptr);
+
+    if (sendto(relay_socket, relay_msg, ptr - relay_msg, 0, (const struct sockaddr *)&relay_config.server, sizeof(relay_config.server)) < 0) {
+        tr_warn("sendto failed %d", errno);
+        return -1;
+    }
+    return 0;
+}
+
+int dhcp_service_shim_open(const loadgen_relay_config_t *config)
+{
+    relay_config = *config;
+    relay_socket = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (relay_socket < 0) {
+        return -1;
+    }
+    struct sockaddr_in6 local = {0};
+    local.sin6_family = AF_INET6;
+    local.sin6_addr = in6addr_any;
+    if (bind(relay_socket, (struct sockaddr *)&local, sizeof(local)) != 0) {
+        close(relay_socket);
+        relay_socket = -1;
+        return -1;
+    }
+    fcntl(relay_socket, F_SETFL, fcntl(relay_socket, F_GETFL) | O_NONBLOCK);
+    msg_tr_id_next = randLIB_get_32bit() & 0x00ffffff;
+    return 0;
+}
+
+void dhcp_service_shim_close(void)
+{
+    ns_list_foreach_safe(msg_tr_t, cur, &msg_tr_list) {
+        dhcp_tr_delete(cur);
+    }
+    if (relay_socket >= 0) {
+        close(relay_socket);
+        relay_socket = -1;
+    }
+}
+
+static void dhcp_service_receive(uint8_t *msg_ptr, uint16_t msg_len)
+{
+    if (msg_len < DHCP_RELAY_HEADER_LEN || msg_ptr[0] != DHCPV6_RELAY_REPLY) {
+        return;
+    }
+
+    // Unwrap the Relay Message option
+    uint8_t *ptr = msg_ptr + DHCP_RELAY_HEADER_LEN;
+    uint16_t data_len = msg_len - DHCP_RELAY_HEADER_LEN;
+    uint8_t *inner = NULL;
+    uint16_t inner_len = 0;
+    while (data_len >= 4) {
+        uint16_t type = common_read_16_bit(ptr);
+        uint16_t length = common_read_16_bit(ptr + 2);
+        if (data_len - 4 < length) {
+            return;
+        }
+        if (type == DHCPV6_RELAY_MESSAGE_OPTION) {
+            inner = ptr + 4;
+            inner_len = length;
+            break;
+        }
+        ptr += 4 + length;
+        data_len -= 4 + length;
+    }
+    if (!inner || inner_len < 4) {
+        return;
+    }
+
+    msg_tr_t *msg_tr_ptr = dhcp_tr_find(common_read_24_bit(inner + 1));
+    if (!msg_tr_ptr) {
+        tr_debug("No transaction for reply");
+        return;
+    }
+
+    // Transaction is gone before the callback, the client may start the next one from it
+    uint16_t instance_id = msg_tr_ptr->instance_id;
+    void *client_obj_ptr = msg_tr_ptr->client_obj_ptr;
+    dhcp_service_receive_resp_cb *recv_resp_cb = msg_tr_ptr->recv_resp_cb;
+    loadgen_exchange_done(msg_tr_ptr->interface_id, msg_tr_ptr->msg_ptr[0], inner[0], loadgen_now_us() - msg_tr_ptr->first_tx_us, msg_tr_ptr->retrans);
+    dhcp_tr_delete(msg_tr_ptr);
+
+    recv_resp_cb(instance_id, client_obj_ptr, inner[0], inner + 4, inner_len - 4);
+}
+
+void dhcp_service_shim_poll(int timeout_ms)
+{
+    static uint8_t msg[DHCP_RELAY_HEADER_LEN + DHCP_MSG_MAX + 64];
+    struct pollfd pfd = { .fd = relay_socket, .events = POLLIN };
+
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+    for (;;) {
+        ssize_t len = recv(relay_socket, msg, sizeof(msg), 0);
+        if (len < 0) {
+            return;
+        }
+        dhcp_service_receive(msg, (uint16_t)len);
+    }
+}
+
+int dhcp_service_shim_timer_run(void)
+{
+    uint64_t now = loadgen_now_us();
+
+    // The callback may add or remove transactions, so look up one due transaction at a time
+    for (;;) {
+        msg_tr_t *due = NULL;
+        ns_list_foreach(msg_tr_t, cur, &msg_tr_list) {
+            if (cur->next_tx_us <= now) {
+                due = cur;
+                break;
+            }
+        }
+        if (!due) {
+            break;
+        }
+
+        if (due->retrans_max && due->retrans >= due->retrans_max) {
+            uint16_t instance_id = due->instance_id;
+            void *client_obj_ptr = due->client_obj_ptr;
+            dhcp_service_receive_resp_cb *recv_resp_cb = due->recv_resp_cb;
+            loadgen_exchange_timeout(due->interface_id, due->msg_ptr[0]);
+            dhcp_tr_delete(due);
+            recv_resp_cb(instance_id, client_obj_ptr, 0, NULL, 0);
+            continue;
+        }
+
+        due->retrans++;
+        due->timeout *= 2;
+        if (due->timeout_max && due->timeout > due->timeout_max) {
+            due->timeout = due->timeout_max;
+        }
+        due->timeout = dhcp_tr_randomise(due->timeout);
+        due->next_tx_us = now + (uint64_t)due->timeout * 1000;
+        loadgen_retransmit(due->interface_id, due->msg_ptr[0]);
+        dhcp_tr_send(due);
+    }
+
+    int next_ms = -1;
+    ns_list_foreach(msg_tr_t, cur, &msg_tr_list) {
+        int due_ms = cur->next_tx_us > now ? (int)((cur->next_tx_us - now + 999) / 1000) : 0;
+        if (next_ms < 0 || due_ms < next_ms) {
+            next_ms = due_ms;
+        }
+    }
+    return next_ms;
+}
+
+uint16_t dhcp_service_init(int8_t interface_id, int instance_type, void *receive_req_cb)
+{
+    (void)receive_req_cb;
+    for (uint16_t i = 0; i < DHCP_SERVICE_INSTANCE_MAX; i++) {
+        if (instances[i].in_use && instances[i].interface_id == interface_id && instances[i].instance_type == instance_type) {
+            return i + 1;
+        }
+    }
+    for (uint16_t i = 0; i < DHCP_SERVICE_INSTANCE_MAX; i++) {
+        if (!instances[i].in_use) {
+            instances[i].in_use = true;
+            instances[i].interface_id = interface_id;
+            instances[i].instance_type = instance_type;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void dhcp_service_delete(uint16_t instance)
+{
+    if (!instance || instance > DHCP_SERVICE_INSTANCE_MAX) {
+        return;
+    }
+    ns_list_foreach_safe(msg_tr_t, cur, &msg_tr_list) {
+        if (cur->instance_id == instance) {
+            dhcp_tr_delete(cur);
+        }
+    }
+    instances[instance - 1].in_use = false;
+}
+
+uint32_t dhcp_service_send_req(uint16_t instance_id, uint8_t options, void *ptr, const uint8_t addr[static 16], uint8_t *msg_ptr, uint16_t msg_len, dhcp_service_receive_resp_cb *receive_resp_cb)
+{
+    (void)options;
+    (void)addr;                                 // Always relayed to the configured server
+    if (!instance_id || instance_id > DHCP_SERVICE_INSTANCE_MAX || !instances[instance_id - 1].in_use || msg_len < 4) {
+        return 0;
+    }
+
+    msg_tr_t *msg_tr_ptr = ns_dyn_mem_alloc(sizeof(msg_tr_t));
+    if (!msg_tr_ptr) {
+        return 0;
+    }
+    memset(msg_tr_ptr, 0, sizeof(msg_tr_t));
+
+    do {
+        msg_tr_id_next = (msg_tr_id_next + 1) & 0x00ffffff;
+    } while (!msg_tr_id_next || dhcp_tr_find(msg_tr_id_next));
+
+    msg_tr_ptr->msg_tr_id = msg_tr_id_next;
+    msg_tr_ptr->instance_id = instance_id;
+    msg_tr_ptr->interface_id = instances[instance_id - 1].interface_id;
+    msg_tr_ptr->client_obj_ptr = ptr;
+    msg_tr_ptr->msg_ptr = msg_ptr;
+    msg_tr_ptr->msg_len = msg_len;
+    msg_tr_ptr->recv_resp_cb = receive_resp_cb;
+    dhcp_tr_default_timers(msg_tr_ptr, msg_ptr[0]);
+    msg_tr_ptr->timeout = dhcp_tr_randomise(msg_tr_ptr->timeout_init);
+    common_write_24_bit(msg_tr_ptr->msg_tr_id, &msg_ptr[1]);
+
+    if (dhcp_tr_send(msg_tr_ptr) != 0) {
+        // Caller still owns the buffer on failure
+        ns_dyn_mem_free(msg_tr_ptr);
+        return 0;
+    }
+    msg_tr_ptr->first_tx_us = loadgen_now_us();
+    msg_tr_ptr->next_tx_us = msg_tr_ptr->first_tx_us + (uint64_t)msg_tr_ptr->timeout * 1000;
+    ns_list_add_to_end(&msg_tr_list, msg_tr_ptr);
+    return msg_tr_ptr->msg_tr_id;
+}
+
+void dhcp_service_set_retry_timers(uint32_t msg_tr_id, uint16_t timeout_init, uint16_t timeout_max, uint8_t retrans_max)
+{
+    msg_tr_t *msg_tr_ptr = dhcp_tr_find(msg_tr_id);
+    if (!msg_tr_ptr) {
+        return;
+    }
+    msg_tr_ptr->timeout_init = timeout_init * 1000;
+    msg_tr_ptr->timeout_max = timeout_max * 1000;
+    msg_tr_ptr->retrans_max = retrans_max;
+    msg_tr_ptr->timeout = dhcp_tr_randomise(msg_tr_ptr->timeout_init);
+    msg_tr_ptr->next_tx_us = msg_tr_ptr->first_tx_us + (uint64_t)msg_tr_ptr->timeout * 1000;
+}
+
+void dhcp_service_update_server_address(uint32_t msg_tr_id, uint8_t *server_address)
+{
+    (void)msg_tr_id;
+    (void)server_address;
+}
+
+void dhcp_service_req_remove_all(void *msg_class_ptr)
+{
+    ns_list_foreach_safe(msg_tr_t, cur, &msg_tr_list) {
+        if (cur->client_obj_ptr == msg_class_ptr) {
+            dhcp_tr_delete(cur);
+        }
+    }
+}
+
+void dhcp_service_relay_instance_enable(uint16_t instance, uint8_t *server_address)
+{
+    (void)instance;
+    (void)server_address;
+}
+
+void dhcp_service_relay_interface_id_option_enable(uint16_t instance, bool enable)
+{
+    (void)instance;
+    (void)enable;
+}
+
+uint8_t *dhcp_service_relay_global_addres_get(uint16_t instance)
+{
+    (void)instance;
+    return NULL;
+}
@@ -0,0 +1,300 @@
+/*
+ * Host implementation of the libDHCPv6 calls used by dhcpv6_client_service.c.
+ * Message layout follows nanostack libDHCPv6.c so the client encodes the same bytes it sends on a node.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "common_functions.h"
+#include "randLIB.h"
+#include "libDHCPv6/libDHCPv6.h"
+
+#define DHCPV6_OPTION_HEADER_LEN        4
+#define DHCPV6_IA_NA_FIXED_LEN          12
+#define DHCPV6_IA_ADDRESS_OPTION_LEN    24
+#define DHCPV6_ELAPSED_TIME_OPTION_LEN  2
+
+static dhcpv6_client_server_data_t *nontemporal_list = NULL;
+static uint8_t instance_id_next = 1;
+
+static uint8_t *option_find(uint8_t *ptr, uint16_t data_len, uint16_t option_type, uint16_t *option_len)
+{
+    while (data_len >= DHCPV6_OPTION_HEADER_LEN) {
+        uint16_t type = common_read_16_bit(ptr);
+        uint16_t length = common_read_16_bit(ptr + 2);
+        if (data_len - DHCPV6_OPTION_HEADER_LEN < length) {
+            return NULL;
+        }
+        if (type == option_type) {
+            *option_len = length;
+            return ptr + DHCPV6_OPTION_HEADER_LEN;
+        }
+        ptr += DHCPV6_OPTION_HEADER_LEN + length;
+        data_len -= DHCPV6_OPTION_HEADER_LEN + length;
+    }
+    return NULL;
+}
+
+static int duid_option_get(uint8_t *ptr, uint16_t data_len, uint16_t option_type, dhcp_duid_options_params_t *params)
+{
+    uint16_t length;
+    uint8_t *data = option_find(ptr, data_len, option_type, &length);
+    // DUID type and at least two bytes of DUID
+    if (!data || length < 4 || length - 2 > 0xff) {
+        return -1;
+    }
+    params->type = common_read_16_bit(data);
+    params->duid = data + 2;
+    params->duid_length = length - 2;
+    return 0;
+}
+
+static uint8_t *duid_option_write(uint8_t *ptr, uint16_t option_type, const dhcp_duid_options_params_t *duid)
+{
+    ptr = common_write_16_bit(option_type, ptr);
+    ptr = common_write_16_bit(duid->duid_length + 2, ptr);
+    ptr = common_write_16_bit(duid->type, ptr);
+    memcpy(ptr, duid->duid, duid->duid_length);
+    return ptr + duid->duid_length;
+}
+
+uint8_t libdhcpv6_duid_linktype_size(uint16_t linkType)
+{
+    if (linkType == DHCPV6_DUID_HARDWARE_EUI48_TYPE) {
+        return 6;
+    }
+    return 8;
+}
+
+uint8_t libdhcpv6_nonTemporal_entry_get_unique_instance_id(void)
+{
+    for (;;) {
+        uint8_t id = instance_id_next++;
+        if (id == 0) {
+            continue;
+        }
+        if (!libdhcpv6_nonTemporal_entry_get_by_instance(id)) {
+            return id;
+        }
+    }
+}
+
+dhcpv6_client_server_data_t *libdhcvp6_nontemporalAddress_server_data_allocate(int8_t interfaceId, uint8_t instanceId, uint8_t *nonTemporalPrefix, uint8_t serverIPv6[static 16])
+{
+    dhcpv6_client_server_data_t *entry = ns_dyn_mem_alloc(sizeof(dhcpv6_client_server_data_t));
+    if (!entry) {
+        return NULL;
+    }
+    memset(entry, 0, sizeof(dhcpv6_client_server_data_t));
+
+    uint32_t iaid;
+    do {
+        iaid = randLIB_get_32bit();
+    } while (!iaid || libdhcpv6_nonTemporal_entry_get_by_iaid(iaid));
+
+    entry->interfaceId = interfaceId;
+    entry->instanceId = instanceId;
+    entry->IAID = iaid;
+    if (nonTemporalPrefix) {
+        memcpy(entry->iaNontemporalAddress.addressPrefix, nonTemporalPrefix, 8);
+    }
+    memcpy(entry->server_address, serverIPv6, 16);
+    entry->next = nontemporal_list;
+    nontemporal_list = entry;
+    return entry;
+}
+
+void libdhcvp6_nontemporalAddress_server_data_free(dhcpv6_client_server_data_t *removedEntry)
+{
+    for (dhcpv6_client_server_data_t **cur = &nontemporal_list; *cur; cur = &(*cur)->next) {
+        if (*cur == removedEntry) {
+            *cur = removedEntry->next;
+            ns_dyn_mem_free(removedEntry->serverDynamic_DUID);
+            ns_dyn_mem_free(removedEntry);
+            return;
+        }
+    }
+}
+
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_instance(uint8_t instanceId)
+{
+    for (dhcpv6_client_server_data_t *cur = nontemporal_list; cur; cur = cur->next) {
+        if (cur->instanceId == instanceId) {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_prefix(int8_t interfaceId, uint8_t *prefix)
+{
+    for (dhcpv6_client_server_data_t *cur = nontemporal_list; cur; cur = cur->next) {
+        if (cur->interfaceId == interfaceId && memcmp(cur->iaNontemporalAddress.addressPrefix, prefix, 8) == 0) {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_entry_get_by_iaid(uint32_t iaId)
+{
+    for (dhcpv6_client_server_data_t *cur = nontemporal_list; cur; cur = cur->next) {
+        if (cur->IAID == iaId) {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+dhcpv6_client_server_data_t *libdhcpv6_nonTemporal_validate_class_pointer(void *class_ptr)
+{
+    for (dhcpv6_client_server_data_t *cur = nontemporal_list; cur; cur = cur->next) {
+        if (cur == class_ptr) {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+uint32_t libdhcpv6_txid_get(void)
+{
+    uint32_t txid;
+    do {
+        txid = randLIB_get_32bit() & 0x00ffffff;
+    } while (!txid);
+    return txid;
+}
+
+uint32_t libdhcpv6_renew_time_define(dhcpv6_client_server_data_t *addresInfo)
+{
+    uint32_t renew_time = addresInfo->T0;
+
+    if (!renew_time) {
+        // Server left T1 to the client, RFC 8415 suggests half of the preferred lifetime
+        renew_time = addresInfo->iaNontemporalAddress.preferredTime / 2;
+    }
+    if (renew_time == 0xffffffff) {
+        return 0;
+    }
+    return renew_time;
+}
+
+uint16_t libdhcpv6_solication_message_length(uint16_t clientDUIDLength, bool addressDefined, uint8_t requestOptionCount)
+{
+    uint16_t length = 4;                                                    // Header
+    length += DHCPV6_OPTION_HEADER_LEN + 2 + clientDUIDLength;              // Client Identifier
+    length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_ELAPSED_TIME_OPTION_LEN;    // Elapsed Time
+    length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_NA_FIXED_LEN;            // IA_NA
+    length += DHCPV6_OPTION_HEADER_LEN;                                     // Rapid Commit
+    if (addressDefined) {
+        length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_ADDRESS_OPTION_LEN;
+    }
+    if (requestOptionCount) {
+        length += DHCPV6_OPTION_HEADER_LEN + 2 * requestOptionCount;
+    }
+    return length;
+}
+
+uint16_t libdhcpv6_address_request_message_len(uint16_t clientDUIDLength, uint16_t serverDUIDLength, uint8_t requstOptionCnt, bool add_address)
+{
+    uint16_t length = 4;
+    length += DHCPV6_OPTION_HEADER_LEN + 2 + clientDUIDLength;
+    length += DHCPV6_OPTION_HEADER_LEN + 2 + serverDUIDLength;
+    length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_ELAPSED_TIME_OPTION_LEN;
+    length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_NA_FIXED_LEN;
+    if (add_address) {
+        length += DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_ADDRESS_OPTION_LEN;
+    }
+    if (requstOptionCnt) {
+        length += DHCPV6_OPTION_HEADER_LEN + 2 * requstOptionCnt;
+    }
+    return length;
+}
+
+uint8_t *libdhcpv6_generic_nontemporal_address_message_write(uint8_t *ptr, dhcpv6_solication_base_packet_s *packet, dhcpv6_ia_non_temporal_address_s *nonTemporalAddress, dhcp_duid_options_params_t *serverLink)
+{
+    uint16_t ia_len = DHCPV6_IA_NA_FIXED_LEN;
+    if (nonTemporalAddress) {
+        ia_len += DHCPV6_OPTION_HEADER_LEN + DHCPV6_IA_ADDRESS_OPTION_LEN;
+    }
+
+    *ptr++ = packet->messageType;
+    ptr = common_write_24_bit(packet->transActionId, ptr);
+    ptr = duid_option_write(ptr, DHCPV6_CLIENT_ID_OPTION, &packet->clientDUID);
+    if (serverLink) {
+        ptr = duid_option_write(ptr, DHCPV6_SERVER_ID_OPTION, serverLink);
+    }
+
+    ptr = common_write_16_bit(DHCPV6_ELAPSED_TIME_OPTION, ptr);
+    ptr = common_write_16_bit(DHCPV6_ELAPSED_TIME_OPTION_LEN, ptr);
+    ptr = common_write_16_bit(0, ptr);
+
+    ptr = common_write_16_bit(DHCPV6_IDENTITY_ASSOCIATION_OPTION, ptr);
+    ptr = common_write_16_bit(ia_len, ptr);
+    ptr = common_write_32_bit(packet->iaID, ptr);
+    ptr = common_write_32_bit(packet->timerT0, ptr);
+    ptr = common_write_32_bit(packet->timerT1, ptr);
+    if (nonTemporalAddress) {
+        ptr = common_write_16_bit(DHCPV6_IA_ADDRESS_OPTION, ptr);
+        ptr = common_write_16_bit(DHCPV6_IA_ADDRESS_OPTION_LEN, ptr);
+        memcpy(ptr, nonTemporalAddress->requestedAddress, 16);
+        ptr += 16;
+        ptr = common_write_32_bit(nonTemporalAddress->preferredLifeTime, ptr);
+        ptr = common_write_32_bit(nonTemporalAddress->validLifeTime, ptr);
+    }
+
+    if (packet->requestedOptionCnt) {
+        ptr = common_write_16_bit(DHCPV6_OPTION_REQUEST_OPTION, ptr);
+        ptr = common_write_16_bit(2 * packet->requestedOptionCnt, ptr);
+        for (uint8_t i = 0; i < packet->requestedOptionCnt; i++) {
+            ptr = common_write_16_bit(packet->requestedOptionList[i], ptr);
+        }
+    }
+
+    // nanostack always offers Rapid Commit in a Solicit, the client strips it when disabled
+    if (packet->messageType == DHCPV6_SOLICATION_TYPE) {
+        ptr = common_write_16_bit(DHCPV6_OPTION_RAPID_COMMIT, ptr);
+        ptr = common_write_16_bit(0, ptr);
+    }
+    return ptr;
+}
+
+int libdhcpv6_reply_message_option_validate(dhcp_duid_options_params_t *clientId, dhcp_duid_options_params_t *serverId, dhcp_ia_non_temporal_params_t *dhcp_ia_non_temporal_params, uint8_t *ptr, uint16_t data_length)
+{
+    if (!ptr) {
+        return -1;
+    }
+    if (duid_option_get(ptr, data_length, DHCPV6_CLIENT_ID_OPTION, clientId) != 0 ||
+            duid_option_get(ptr, data_length, DHCPV6_SERVER_ID_OPTION, serverId) != 0) {
+        return -1;
+    }
+
+    uint16_t ia_len;
+    uint8_t *ia = option_find(ptr, data_length, DHCPV6_IDENTITY_ASSOCIATION_OPTION, &ia_len);
+    if (!ia || ia_len < DHCPV6_IA_NA_FIXED_LEN) {
+        return -1;
+    }
+    dhcp_ia_non_temporal_params->iaId = common_read_32_bit(ia);
+    dhcp_ia_non_temporal_params->T0 = common_read_32_bit(ia + 4);
+    dhcp_ia_non_temporal_params->T1 = common_read_32_bit(ia + 8);
+
+    // IA without an address (NoAddrsAvail status) is not a usable reply
+    uint16_t addr_len;
+    uint8_t *addr = option_find(ia + DHCPV6_IA_NA_FIXED_LEN, ia_len - DHCPV6_IA_NA_FIXED_LEN, DHCPV6_IA_ADDRESS_OPTION, &addr_len);
+    if (!addr || addr_len < DHCPV6_IA_ADDRESS_OPTION_LEN) {
+        return -1;
+    }
+    dhcp_ia_non_temporal_params->nonTemporalAddress = addr;
+    dhcp_ia_non_temporal_params->preferredValidLifeTime = common_read_32_bit(addr + 16);
+    dhcp_ia_non_temporal_params->validLifeTime = common_read_32_bit(addr + 20);
+    return 0;
+}
+
+int libdhcpv6_compare_DUID(dhcp_duid_options_params_t *targetId, dhcp_duid_options_params_t *parsedId)
+{
+    if (targetId->type != parsedId->type || targetId->duid_length != parsedId->duid_length) {
+        return -1;
+    }
+    return memcmp(targetId->duid, parsedId->duid, targetId->duid_length) == 0 ? 0 : -1;
+}
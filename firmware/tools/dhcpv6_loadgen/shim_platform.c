@@ -0,0 +1,35 @@
+/*
+ * Host eventOS tick and randLIB. The generator seeds each worker differently so IAIDs,
+ * transaction ids and renew jitter do not repeat across worker processes.
+ */
+
+#include "ns_types.h"
+#include "eventOS_event_timer.h"
+#include "randLIB.h"
+#include "loadgen.h"
+
+static uint64_t rand_state = 0x9e3779b97f4a7c15ull;
+
+void randLIB_seed(uint64_t seed)
+{
+    rand_state = seed ? seed : 0x9e3779b97f4a7c15ull;
+}
+
+// xorshift64*
+uint32_t randLIB_get_32bit(void)
+{
+    rand_state ^= rand_state >> 12;
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    return (uint32_t)((rand_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+uint16_t randLIB_get_16bit(void)
+{
+    return (uint16_t)randLIB_get_32bit();
+}
+
+uint32_t eventOS_event_timer_ticks(void)
+{
+    return (uint32_t)(loadgen_now_us() / (1000000 / EVENTOS_EVENT_TIMER_HZ));
+}
@@ -0,0 +1,158 @@
+/*
+ * Host interface and address table: one interface per simulated node, with the state timer and
+ * lifetime handling the DHCPv6 client relies on to renew and to notice an expired lease.
+ */
+
+#include <string.h>
+#include "ns_types.h"
+#include "nsdynmemLIB.h"
+#include "NWK_INTERFACE/Include/protocol.h"
+#include "loadgen.h"
+
+#define ADDR_LIFETIME_INFINITE  0xffffffff
+
+static protocol_interface_info_entry_t *interfaces[LOADGEN_WORKER_CLIENTS_MAX + 1];
+
+// Lifetimes are seconds, the table counts 100ms ticks
+static uint32_t addr_lifetime_ticks(uint32_t lifetime)
+{
+    if (lifetime == ADDR_LIFETIME_INFINITE || lifetime >= ADDR_LIFETIME_INFINITE / 10) {
+        return ADDR_LIFETIME_INFINITE;
+    }
+    return lifetime * 10;
+}
+
+protocol_interface_info_entry_t *protocol_shim_interface_create(int8_t id, const uint8_t mac[static 8])
+{
+    if (id <= 0 || id > LOADGEN_WORKER_CLIENTS_MAX || interfaces[id]) {
+        return NULL;
+    }
+    protocol_interface_info_entry_t *cur = ns_dyn_mem_alloc(sizeof(protocol_interface_info_entry_t));
+    if (!cur) {
+        return NULL;
+    }
+    memset(cur, 0, sizeof(protocol_interface_info_entry_t));
+    cur->id = id;
+    memcpy(cur->mac, mac, 8);
+    interfaces[id] = cur;
+    return cur;
+}
+
+void protocol_shim_interface_free(int8_t id)
+{
+    if (id <= 0 || id > LOADGEN_WORKER_CLIENTS_MAX) {
+        return;
+    }
+    ns_dyn_mem_free(interfaces[id]);
+    interfaces[id] = NULL;
+}
+
+void protocol_shim_timer_tick(void)
+{
+    for (int id = 1; id <= LOADGEN_WORKER_CLIENTS_MAX; id++) {
+        protocol_interface_info_entry_t *cur = interfaces[id];
+        if (!cur) {
+            continue;
+        }
+        for (int i = 0; i < LOADGEN_IF_ADDRESS_MAX; i++) {
+            if_address_entry_t *addr = &cur->addresses[i];
+            if (!addr->in_use) {
+                continue;
+            }
+
+            if (addr->valid_ticks != ADDR_LIFETIME_INFINITE && --addr->valid_ticks == 0) {
+                if (addr->cb) {
+                    addr->cb(cur, addr, ADDR_CALLBACK_INVALIDATED);
+                }
+                addr->in_use = false;
+                loadgen_address_lost(cur->id);
+                continue;
+            }
+
+            if (addr->state_timer && --addr->state_timer == 0 && addr->cb) {
+                addr->cb(cur, addr, ADDR_CALLBACK_TIMER);
+            }
+        }
+    }
+}
+
+protocol_interface_info_entry_t *protocol_stack_interface_info_get_by_id(int8_t nwk_id)
+{
+    if (nwk_id <= 0 || nwk_id > LOADGEN_WORKER_CLIENTS_MAX) {
+        return NULL;
+    }
+    return interfaces[nwk_id];
+}
+
+if_address_entry_t *addr_get_entry(const protocol_interface_info_entry_t *interface, const uint8_t addr[static 16])
+{
+    for (int i = 0; i < LOADGEN_IF_ADDRESS_MAX; i++) {
+        const if_address_entry_t *entry = &interface->addresses[i];
+        if (entry->in_use && memcmp(entry->address, addr, 16) == 0) {
+            return (if_address_entry_t *)entry;
+        }
+    }
+    return NULL;
+}
+
+if_address_entry_t *addr_add(protocol_interface_info_entry_t *cur, const uint8_t address[static 16], uint_fast8_t prefix_len, if_address_source_t source, uint32_t valid_lifetime, uint32_t preferred_lifetime, bool skip_dad)
+{
+    (void)skip_dad;
+    if (addr_get_entry(cur, address)) {
+        return NULL;
+    }
+    for (int i = 0; i < LOADGEN_IF_ADDRESS_MAX; i++) {
+        if_address_entry_t *entry = &cur->addresses[i];
+        if (entry->in_use) {
+            continue;
+        }
+        memset(entry, 0, sizeof(if_address_entry_t));
+        memcpy(entry->address, address, 16);
+        entry->prefix_len = prefix_len;
+        entry->source = source;
+        entry->valid_lifetime = valid_lifetime;
+        entry->preferred_lifetime = preferred_lifetime;
+        entry->valid_ticks = addr_lifetime_ticks(valid_lifetime);
+        entry->in_use = true;
+        return entry;
+    }
+    return NULL;
+}
+
+int_fast8_t addr_delete(protocol_interface_info_entry_t *cur, const uint8_t address[static 16])
+{
+    if_address_entry_t *entry = addr_get_entry(cur, address);
+    if (!entry) {
+        return -1;
+    }
+    if (entry->cb) {
+        entry->cb(cur, entry, ADDR_CALLBACK_DELETED);
+    }
+    entry->in_use = false;
+    return 0;
+}
+
+void addr_deprecate(protocol_interface_info_entry_t *cur, const uint8_t address[static 16])
+{
+    if_address_entry_t *entry = addr_get_entry(cur, address);
+    if (!entry) {
+        return;
+    }
+    entry->preferred_lifetime = 0;
+    if (entry->cb) {
+        entry->cb(cur, entry, ADDR_CALLBACK_DEPRECATED);
+    }
+}
+
+void addr_set_valid_lifetime(protocol_interface_info_entry_t *interface, if_address_entry_t *entry, uint32_t valid_lifetime)
+{
+    (void)interface;
+    entry->valid_lifetime = valid_lifetime;
+    entry->valid_ticks = addr_lifetime_ticks(valid_lifetime);
+}
+
+void addr_set_preferred_lifetime(protocol_interface_info_entry_t *interface, if_address_entry_t *entry, uint32_t preferred_lifetime)
+{
+    (void)interface;
+    entry->preferred_lifetime = preferred_lifetime;
+}
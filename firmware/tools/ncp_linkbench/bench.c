@@ -0,0 +1,444 @@
+/*
+ * NCP link benchmark. Forks the NCP transport (../../src/ncp_transport.c with the emulated
+ * platform of shim_platform.c) onto the slave side of a pty and drives it from the master side
+ * the way wfantund would: pipelined property gets and IPv6 frames in PROP_STREAM_NET, while the
+ * NCP sends unsolicited STREAM_NET frames. Reports frames/s, latency percentiles per frame class
+ * and NCP CPU time per frame, plus the transport counters (ncp_uart_stats).
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "linkbench.h"
+
+// Spinel transaction ids are four bits and 0 is for unsolicited frames
+#define BENCH_WINDOW_MAX        15
+#define BENCH_SAMPLES_MAX       (1u << 24)
+#define BENCH_DRAIN_US          2000000
+#define BENCH_TX_BUFFER         (4 * HDLC_ENCODED_MAX(LINKBENCH_FRAME_MAX))
+
+typedef enum {
+    LAT_PROP_GET,
+    LAT_STREAM_NET,
+    LAT_ASYNC,
+    LAT_COUNT,
+} bench_latency_t;
+
+static const char *latency_names[LAT_COUNT] = {
+    [LAT_PROP_GET] = "prop get",
+    [LAT_STREAM_NET] = "stream net",
+    [LAT_ASYNC] = "async stream net",
+};
+
+typedef struct {
+    uint32_t *samples;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t dropped;
+} bench_samples_t;
+
+typedef struct {
+    bool active;
+    bench_latency_t type;
+    uint8_t prop;
+    uint64_t sent_us;
+} bench_transaction_t;
+
+typedef struct {
+    uint32_t duration_s;
+    uint32_t window;
+    uint32_t get_percent;
+    uint16_t net_min;
+    uint16_t net_max;
+    ncp_platform_config_t ncp;
+} bench_config_t;
+
+static bench_config_t config = {
+    .duration_s = 10,
+    .window = 8,
+    .get_percent = 50,
+    .net_min = 80,
+    .net_max = 1280,
+    .ncp = {
+        .baud = 0,
+        .rx_ring = 1024,
+        .tx_ring = 2048,
+        .rx_chunk = 64,
+        .async_rate = 100,
+        .async_size = 200,
+    },
+};
+
+static bench_samples_t samples[LAT_COUNT];
+static bench_transaction_t transactions[BENCH_WINDOW_MAX + 1];
+static uint32_t outstanding;
+static uint8_t next_tid = 1;
+static uint32_t frames_sent;
+static uint32_t frames_received;
+static uint32_t bad_responses;
+static uint64_t rand_state = 0x9e3779b97f4a7c15ull;
+
+uint64_t linkbench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// xorshift64*
+static uint32_t bench_rand(void)
+{
+    rand_state ^= rand_state >> 12;
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    return (uint32_t)((rand_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static void bench_sample_add(bench_latency_t type, uint64_t latency_us)
+{
+    bench_samples_t *set = &samples[type];
+    if (set->count == set->capacity) {
+        uint32_t capacity = set->capacity ? set->capacity * 2 : 1024;
+        uint32_t *grown = capacity <= BENCH_SAMPLES_MAX ? realloc(set->samples, capacity * sizeof(uint32_t)) : NULL;
+        if (!grown) {
+            set->dropped++;
+            return;
+        }
+        set->samples = grown;
+        set->capacity = capacity;
+    }
+    set->samples[set->count++] = latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us;
+}
+
+// Build the next request into frame, returns its length
+static size_t bench_request_build(uint8_t *frame, uint8_t tid, bench_transaction_t *transaction)
+{
+    static const uint8_t get_props[] = {SPINEL_PROP_PROTOCOL_VERSION, SPINEL_PROP_NCP_VERSION, SPINEL_PROP_HWADDR};
+
+    frame[0] = SPINEL_HEADER_FLAG | tid;
+    if (bench_rand() % 100 < config.get_percent) {
+        transaction->type = LAT_PROP_GET;
+        transaction->prop = get_props[bench_rand() % sizeof(get_props)];
+        frame[1] = SPINEL_CMD_PROP_VALUE_GET;
+        frame[2] = transaction->prop;
+        return 3;
+    }
+
+    // IPv6 packet of a random size, the payload is a pattern the NCP does not look at
+    uint16_t length = config.net_min + bench_rand() % (config.net_max - config.net_min + 1);
+    transaction->type = LAT_STREAM_NET;
+    transaction->prop = SPINEL_PROP_LAST_STATUS;
+    frame[1] = SPINEL_CMD_PROP_VALUE_SET;
+    frame[2] = SPINEL_PROP_STREAM_NET;
+    frame[3] = length & 0xff;
+    frame[4] = length >> 8;
+    frame[5] = 0x60;
+    for (uint16_t i = 1; i < length; i++) {
+        frame[5 + i] = (uint8_t)(i * 7);
+    }
+    return 5 + length;
+}
+
+static void bench_frame_handle(const uint8_t *frame, size_t length, uint64_t now)
+{
+    uint8_t tid = frame[0] & SPINEL_TID_MASK;
+
+    frames_received++;
+    if (length < 3 || frame[1] != SPINEL_CMD_PROP_VALUE_IS) {
+        bad_responses++;
+        return;
+    }
+    if (tid == 0) {
+        uint64_t stamp;
+        if (frame[2] != SPINEL_PROP_STREAM_NET || length < 5 + sizeof(stamp)) {
+            bad_responses++;
+            return;
+        }
+        memcpy(&stamp, &frame[5], sizeof(stamp));
+        bench_sample_add(LAT_ASYNC, now - stamp);
+        return;
+    }
+
+    bench_transaction_t *transaction = &transactions[tid];
+    if (!transaction->active) {
+        bad_responses++;
+        return;
+    }
+    transaction->active = false;
+    outstanding--;
+    if (frame[2] != transaction->prop || (transaction->prop == SPINEL_PROP_LAST_STATUS && frame[3] != 0)) {
+        bad_responses++;
+        return;
+    }
+    bench_sample_add(transaction->type, now - transaction->sent_us);
+}
+
+static void bench_run(int fd)
+{
+    static uint8_t tx_buffer[BENCH_TX_BUFFER];
+    static uint8_t frame[LINKBENCH_FRAME_MAX];
+    static hdlc_decoder_t decoder;
+    size_t tx_length = 0;
+    uint64_t now = linkbench_now_us();
+    uint64_t end = now + (uint64_t)config.duration_s * 1000000;
+
+    while (now < end || (outstanding && now < end + BENCH_DRAIN_US)) {
+        // Keep the window full, a frame is timed from when it is queued for the pty
+        while (now < end && outstanding < config.window &&
+                tx_length + HDLC_ENCODED_MAX(LINKBENCH_FRAME_MAX) <= sizeof(tx_buffer)) {
+            while (transactions[next_tid].active) {
+                next_tid = next_tid % BENCH_WINDOW_MAX + 1;
+            }
+            bench_transaction_t *transaction = &transactions[next_tid];
+            size_t length = bench_request_build(frame, next_tid, transaction);
+            tx_length += hdlc_encode(frame, length, &tx_buffer[tx_length]);
+            transaction->active = true;
+            transaction->sent_us = now;
+            outstanding++;
+            frames_sent++;
+            next_tid = next_tid % BENCH_WINDOW_MAX + 1;
+        }
+
+        struct pollfd pfd = {.fd = fd, .events = POLLIN | (tx_length ? POLLOUT : 0)};
+        if (poll(&pfd, 1, 10) < 0 && errno != EINTR) {
+            perror("poll");
+            return;
+        }
+        if (pfd.revents & POLLOUT) {
+            ssize_t sent = write(fd, tx_buffer, tx_length);
+            if (sent > 0) {
+                memmove(tx_buffer, &tx_buffer[sent], tx_length - sent);
+                tx_length -= sent;
+            }
+        }
+        now = linkbench_now_us();
+        if (pfd.revents & POLLIN) {
+            uint8_t chunk[4096];
+            ssize_t got = read(fd, chunk, sizeof(chunk));
+            for (ssize_t i = 0; i < got; i++) {
+                size_t length = hdlc_decode_byte(&decoder, chunk[i]);
+                if (length) {
+                    bench_frame_handle(decoder.frame, length, now);
+                }
+            }
+        }
+    }
+    if (decoder.fcs_errors) {
+        printf("host: %u frames with a bad FCS\n", decoder.fcs_errors);
+    }
+}
+
+static int bench_sample_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest rank percentile of sorted samples, in milliseconds
+static double bench_percentile(const bench_samples_t *set, uint32_t percent)
+{
+    uint64_t rank = ((uint64_t)set->count * percent + 99) / 100;
+    return set->samples[rank ? rank - 1 : 0] / 1000.0;
+}
+
+static double timeval_us(struct timeval tv)
+{
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void bench_results_print(const linkbench_ncp_report_t *ncp, double elapsed_s)
+{
+    const ncp_uart_stats_t *uart = &ncp->uart;
+    const ncp_platform_stats_t *platform = &ncp->platform;
+    char baud[16] = "unlimited";
+
+    if (config.ncp.baud) {
+        snprintf(baud, sizeof(baud), "%u", config.ncp.baud);
+    }
+    printf("baud %s, window %u, %u s, %u%% gets, IPv6 frames %u-%u B, async %u/s of %u B, rings rx %u tx %u\n",
+           baud, config.window, config.duration_s, config.get_percent, config.net_min, config.net_max,
+           config.ncp.async_rate, config.ncp.async_size, config.ncp.rx_ring, config.ncp.tx_ring);
+    printf("%-20s %8s %9s %9s %9s %9s\n", "frames", "count", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    for (int type = 0; type < LAT_COUNT; type++) {
+        bench_samples_t *set = &samples[type];
+        if (!set->count) {
+            continue;
+        }
+        qsort(set->samples, set->count, sizeof(uint32_t), bench_sample_compare);
+        printf("%-20s %8u %9.3f %9.3f %9.3f %9.3f\n", latency_names[type], set->count,
+               bench_percentile(set, 50), bench_percentile(set, 90), bench_percentile(set, 99),
+               set->samples[set->count - 1] / 1000.0);
+        if (set->dropped) {
+            printf("%-20s %8u samples not kept\n", "", set->dropped);
+        }
+    }
+
+    uint32_t ncp_frames = platform->rx_frames + platform->tx_frames;
+    double cpu_us = timeval_us(ncp->cpu_user) + timeval_us(ncp->cpu_system);
+    printf("throughput host->ncp %.1f frames/s, ncp->host %.1f frames/s, %.1f kB/s from the ncp\n",
+           frames_sent / elapsed_s, frames_received / elapsed_s, platform->tx_bytes / elapsed_s / 1000);
+    printf("ncp cpu %.1f ms (user %.1f, system %.1f), %.2f us/frame over %u frames\n",
+           cpu_us / 1000, timeval_us(ncp->cpu_user) / 1000, timeval_us(ncp->cpu_system) / 1000,
+           ncp_frames ? cpu_us / ncp_frames : 0, ncp_frames);
+    printf("uart signals %u, events %u, coalesced %u, post failures %u, max batch %u, rx overruns %u\n",
+           uart->signals, uart->events, uart->coalesced, uart->post_failures, uart->max_batch, uart->rx_overruns);
+    printf("responses %u, async frames %u, events %u, coalesced %u, dropped %u, max batch %u\n",
+           uart->rsp_frames, uart->async_frames, uart->async_events, uart->async_coalesced,
+           uart->async_dropped, uart->async_max_batch);
+    printf("lost %u, bad responses %u, ncp fcs errors %u, response queue full %u, async queue full %u, eventOS queue full %u\n",
+           outstanding, bad_responses, platform->rx_fcs_errors, platform->rsp_queue_full,
+           platform->async_queue_full, ncp->eventos_queue_full);
+}
+
+static void bench_usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -d, --duration S        run time in seconds (default %u)\n"
+            "  -w, --window N          requests in flight, 1-%d (default %u)\n"
+            "  -g, --get-percent P     share of property gets, the rest are IPv6 frames (default %u)\n"
+            "  -s, --net-size MIN,MAX  IPv6 frame sizes in bytes, at most 1280 (default %u,%u)\n"
+            "  -a, --async-rate N      unsolicited frames per second from the NCP, 0 for none (default %u)\n"
+            "  -A, --async-size N      size of those frames (default %u)\n"
+            "  -b, --baud N            emulated UART bit rate, 0 for as fast as the pty goes (default 0)\n"
+            "  -r, --rings RX,TX       UART ring sizes (default %u,%u)\n"
+            "  -c, --rx-chunk N        bytes per RX driver callback (default %u)\n",
+            name, config.duration_s, BENCH_WINDOW_MAX, config.window, config.get_percent, config.net_min,
+            config.net_max, config.ncp.async_rate, config.ncp.async_size, config.ncp.rx_ring,
+            config.ncp.tx_ring, config.ncp.rx_chunk);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"duration", required_argument, NULL, 'd'},
+        {"window", required_argument, NULL, 'w'},
+        {"get-percent", required_argument, NULL, 'g'},
+        {"net-size", required_argument, NULL, 's'},
+        {"async-rate", required_argument, NULL, 'a'},
+        {"async-size", required_argument, NULL, 'A'},
+        {"baud", required_argument, NULL, 'b'},
+        {"rings", required_argument, NULL, 'r'},
+        {"rx-chunk", required_argument, NULL, 'c'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    unsigned first, second;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "d:w:g:s:a:A:b:r:c:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'd':
+                config.duration_s = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                config.window = strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                config.get_percent = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                if (sscanf(optarg, "%u,%u", &first, &second) != 2 || !first || first > second || second > 1280) {
+                    fprintf(stderr, "invalid frame sizes: %s\n", optarg);
+                    return 2;
+                }
+                config.net_min = first;
+                config.net_max = second;
+                break;
+            case 'a':
+                config.ncp.async_rate = strtoul(optarg, NULL, 0);
+                break;
+            case 'A':
+                config.ncp.async_size = strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                config.ncp.baud = strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                if (sscanf(optarg, "%u,%u", &first, &second) != 2 || first < 64 ||
+                        second < HDLC_ENCODED_MAX(LINKBENCH_FRAME_MAX)) {
+                    fprintf(stderr, "invalid ring sizes: %s, TX must hold an escaped %d byte frame\n",
+                            optarg, LINKBENCH_FRAME_MAX);
+                    return 2;
+                }
+                config.ncp.rx_ring = first;
+                config.ncp.tx_ring = second;
+                break;
+            case 'c':
+                config.ncp.rx_chunk = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                bench_usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (!config.duration_s || !config.window || config.window > BENCH_WINDOW_MAX || config.get_percent > 100 ||
+            !config.ncp.rx_chunk || config.ncp.async_rate > 1000000 || config.ncp.async_size < 8 ||
+            config.ncp.async_size > 1280) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    // Raw 8-bit link, both ends non-blocking
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 || grantpt(master) || unlockpt(master)) {
+        perror("pty");
+        return 1;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    struct termios tio;
+    if (slave < 0 || tcgetattr(slave, &tio)) {
+        perror("pty slave");
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    int report_pipe[2];
+    if (pipe(report_pipe)) {
+        perror("pipe");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        close(master);
+        close(report_pipe[0]);
+        _exit(ncp_main(slave, &config.ncp, report_pipe[1]));
+    }
+    close(slave);
+    close(report_pipe[1]);
+
+    uint64_t start = linkbench_now_us();
+    bench_run(master);
+    double elapsed_s = (linkbench_now_us() - start) / 1e6;
+    close(master);
+
+    linkbench_ncp_report_t report;
+    ssize_t got = read(report_pipe[0], &report, sizeof(report));
+    int status;
+    waitpid(pid, &status, 0);
+    if (got != sizeof(report)) {
+        fprintf(stderr, "no report from the ncp process\n");
+        return 1;
+    }
+    bench_results_print(&report, elapsed_s);
+    return 0;
+}
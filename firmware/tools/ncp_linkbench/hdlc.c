@@ -0,0 +1,86 @@
+/*
+ * HDLC-lite framing used by Spinel on the NCP UART, shared by the host and NCP sides.
+ */
+
+#include "linkbench.h"
+
+#define HDLC_FLAG       0x7e
+#define HDLC_ESCAPE     0x7d
+#define HDLC_ESCAPE_XOR 0x20
+
+// CRC-16/X.25, the HDLC FCS
+static uint16_t hdlc_fcs_byte(uint16_t fcs, uint8_t byte)
+{
+    fcs ^= byte;
+    for (int bit = 0; bit < 8; bit++) {
+        fcs = (fcs & 1) ? (fcs >> 1) ^ 0x8408 : fcs >> 1;
+    }
+    return fcs;
+}
+
+static size_t hdlc_put(uint8_t *out, size_t pos, uint8_t byte)
+{
+    if (byte == HDLC_FLAG || byte == HDLC_ESCAPE) {
+        out[pos++] = HDLC_ESCAPE;
+        byte ^= HDLC_ESCAPE_XOR;
+    }
+    out[pos++] = byte;
+    return pos;
+}
+
+size_t hdlc_encode(const uint8_t *payload, size_t length, uint8_t *out)
+{
+    uint16_t fcs = 0xffff;
+    size_t pos = 0;
+
+    out[pos++] = HDLC_FLAG;
+    for (size_t i = 0; i < length; i++) {
+        fcs = hdlc_fcs_byte(fcs, payload[i]);
+        pos = hdlc_put(out, pos, payload[i]);
+    }
+    fcs ^= 0xffff;
+    pos = hdlc_put(out, pos, fcs & 0xff);
+    pos = hdlc_put(out, pos, fcs >> 8);
+    out[pos++] = HDLC_FLAG;
+    return pos;
+}
+
+size_t hdlc_decode_byte(hdlc_decoder_t *decoder, uint8_t byte)
+{
+    if (byte == HDLC_FLAG) {
+        size_t length = decoder->length;
+        bool overflow = decoder->overflow;
+        decoder->length = 0;
+        decoder->escape = false;
+        decoder->overflow = false;
+        if (length < 3 || overflow) {
+            // Back to back flags delimit nothing, oversized frames are dropped
+            decoder->fcs_errors += overflow;
+            return 0;
+        }
+        uint16_t fcs = 0xffff;
+        for (size_t i = 0; i < length - 2; i++) {
+            fcs = hdlc_fcs_byte(fcs, decoder->frame[i]);
+        }
+        fcs ^= 0xffff;
+        if (decoder->frame[length - 2] != (fcs & 0xff) || decoder->frame[length - 1] != (fcs >> 8)) {
+            decoder->fcs_errors++;
+            return 0;
+        }
+        return length - 2;
+    }
+    if (byte == HDLC_ESCAPE) {
+        decoder->escape = true;
+        return 0;
+    }
+    if (decoder->escape) {
+        byte ^= HDLC_ESCAPE_XOR;
+        decoder->escape = false;
+    }
+    if (decoder->length < sizeof(decoder->frame)) {
+        decoder->frame[decoder->length++] = byte;
+    } else {
+        decoder->overflow = true;
+    }
+    return 0;
+}
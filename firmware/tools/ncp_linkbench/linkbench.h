@@ -0,0 +1,95 @@
+/*
+ * NCP link benchmark, shared between the host driver, the emulated NCP platform and the shims.
+ */
+#ifndef LINKBENCH_H
+#define LINKBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include "ncp_transport.h"
+
+// Largest Spinel frame: a 1280 byte IPv6 packet in PROP_STREAM_NET plus the Spinel headers
+#define LINKBENCH_FRAME_MAX         1300
+
+/* Spinel subset driven by the benchmark */
+#define SPINEL_HEADER_FLAG          0x80
+#define SPINEL_TID_MASK             0x0f
+#define SPINEL_CMD_PROP_VALUE_GET   0x02
+#define SPINEL_CMD_PROP_VALUE_SET   0x03
+#define SPINEL_CMD_PROP_VALUE_IS    0x06
+#define SPINEL_PROP_LAST_STATUS     0x00
+#define SPINEL_PROP_PROTOCOL_VERSION 0x01
+#define SPINEL_PROP_NCP_VERSION     0x02
+#define SPINEL_PROP_HWADDR          0x08
+#define SPINEL_PROP_STREAM_NET      0x72
+
+/* Clock used for all latency measurements, microseconds. CLOCK_MONOTONIC is shared by both
+ * processes, so the NCP can stamp async frames with it */
+uint64_t linkbench_now_us(void);
+
+/* HDLC-lite framing of the NCP UART */
+typedef struct {
+    uint8_t frame[LINKBENCH_FRAME_MAX + 2];
+    size_t length;
+    bool escape;
+    bool overflow;
+    uint32_t fcs_errors;
+} hdlc_decoder_t;
+
+// Worst case encoded size of a payload
+#define HDLC_ENCODED_MAX(len)       (2 * ((len) + 2) + 2)
+
+size_t hdlc_encode(const uint8_t *payload, size_t length, uint8_t *out);
+/* Feed one received byte, returns the payload length when it closes a frame with a good
+ * FCS (payload in decoder->frame), 0 otherwise */
+size_t hdlc_decode_byte(hdlc_decoder_t *decoder, uint8_t byte);
+
+/* Emulated NCP side: UART driver and the SDK platform/Spinel layer above it */
+typedef struct {
+    uint32_t baud;                              /*!< UART bit rate, 0 for as fast as the pty goes */
+    uint32_t rx_ring;                           /*!< UART2 RX ring size, as in border_router.syscfg */
+    uint32_t tx_ring;                           /*!< UART2 TX ring size */
+    uint32_t rx_chunk;                          /*!< Bytes per RX driver callback */
+    uint32_t async_rate;                        /*!< Unsolicited STREAM_NET frames per second */
+    uint16_t async_size;                        /*!< IPv6 packet size of those frames */
+} ncp_platform_config_t;
+
+typedef struct {
+    uint32_t rx_frames;
+    uint32_t rx_fcs_errors;
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t async_generated;
+    uint32_t async_queue_full;                  /*!< Async frames not generated, the queue was full */
+    uint32_t rsp_queue_full;                    /*!< Requests dropped, no room for the response */
+} ncp_platform_stats_t;
+
+void ncp_platform_init(int fd, const ncp_platform_config_t *config);
+/* Poll events the emulated UART waits for */
+short ncp_platform_poll_events(void);
+/* Run the emulated UART driver and async source, returns ms until it needs to run again (-1 none) */
+int ncp_platform_run(short revents);
+const ncp_platform_stats_t *ncp_platform_stats(void);
+
+/* What the NCP process hands back when the host closes the link */
+typedef struct {
+    ncp_uart_stats_t uart;
+    ncp_platform_stats_t platform;
+    uint32_t eventos_queue_full;
+    struct timeval cpu_user;
+    struct timeval cpu_system;
+} linkbench_ncp_report_t;
+
+/* Run the NCP tasklet on the pty slave until the host hangs up, then write the report */
+int ncp_main(int fd, const ncp_platform_config_t *config, int report_fd);
+
+/* eventOS shim */
+// Dispatch queued events until the queue is empty
+void eventos_shim_run(void);
+// Post due timer events, returns ms until the next one (-1 none)
+int eventos_shim_timers_run(void);
+uint32_t eventos_shim_queue_full(void);
+
+#endif
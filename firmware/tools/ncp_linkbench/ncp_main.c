@@ -0,0 +1,62 @@
+/*
+ * NCP side of the benchmark: the NCP tasklet of application.c, reduced to the transport events
+ * of ../../src/ncp_transport.c, run by a poll loop that stands in for the eventOS scheduler and
+ * the UART interrupts.
+ */
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "eventOS_event.h"
+#include "linkbench.h"
+
+int8_t ncp_tasklet_id = -1;
+
+static void ncp_tasklet(arm_event_s *event)
+{
+    if (event->event_type == ARM_LIB_TASKLET_INIT_EVENT) {
+        ncp_tasklet_id = event->receiver;
+        return;
+    }
+    ncp_transport_event(event->event_type, event->event_id);
+}
+
+int ncp_main(int fd, const ncp_platform_config_t *config, int report_fd)
+{
+    struct pollfd pfd = {.fd = fd};
+    linkbench_ncp_report_t report = {0};
+    struct rusage usage;
+    int platform_timeout;
+
+    ncp_platform_init(fd, config);
+    eventOS_event_handler_create(&ncp_tasklet, ARM_LIB_TASKLET_INIT_EVENT);
+    platform_timeout = ncp_platform_run(0);
+
+    for (;;) {
+        eventos_shim_run();
+        int timeout = eventos_shim_timers_run();
+        if (timeout == 0) {
+            continue;
+        }
+        if (platform_timeout >= 0 && (timeout < 0 || platform_timeout < timeout)) {
+            timeout = platform_timeout;
+        }
+        pfd.events = ncp_platform_poll_events();
+        if (poll(&pfd, 1, timeout) < 0) {
+            break;
+        }
+        if (pfd.revents & (POLLHUP | POLLERR)) {
+            // Host closed the link, whatever it left in flight no longer matters
+            break;
+        }
+        platform_timeout = ncp_platform_run(pfd.revents);
+    }
+
+    getrusage(RUSAGE_SELF, &usage);
+    report.uart = ncp_uart_stats;
+    report.platform = *ncp_platform_stats();
+    report.eventos_queue_full = eventos_shim_queue_full();
+    report.cpu_user = usage.ru_utime;
+    report.cpu_system = usage.ru_stime;
+    return write(report_fd, &report, sizeof(report)) == sizeof(report) ? 0 : 1;
+}
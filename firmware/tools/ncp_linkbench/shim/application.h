@@ -0,0 +1,12 @@
+#ifndef LINKBENCH_APPLICATION_H
+#define LINKBENCH_APPLICATION_H
+
+// NCP tasklet events, numbered after the eventOS library events
+typedef enum {
+    NCP_UART_EVENT = 1,
+    NCP_SEND_RESPONSE_EVENT,
+    NCP_SEND_ASYNC_RSPONSE_EVENT,
+    NCP_AUTO_START_EVENT,
+} ncp_event_type_e;
+
+#endif
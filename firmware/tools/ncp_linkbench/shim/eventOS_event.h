@@ -0,0 +1,30 @@
+#ifndef LINKBENCH_EVENTOS_EVENT_H
+#define LINKBENCH_EVENTOS_EVENT_H
+
+#include <stdint.h>
+
+typedef enum {
+    ARM_LIB_HIGH_PRIORITY_EVENT = 0,
+    ARM_LIB_MED_PRIORITY_EVENT = 1,
+    ARM_LIB_LOW_PRIORITY_EVENT = 2,
+} arm_library_event_priority_e;
+
+typedef enum {
+    ARM_LIB_TASKLET_INIT_EVENT = 0,
+} arm_library_event_type_e;
+
+typedef struct arm_event_s {
+    int8_t receiver;
+    int8_t sender;
+    uint8_t event_type;
+    uint8_t event_id;
+    void *data_ptr;
+    arm_library_event_priority_e priority;
+    uintptr_t event_data;
+} arm_event_s;
+
+int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uint8_t init_event_type);
+// Returns -1 when the queue is full, like nanostack when it cannot allocate the event
+int8_t eventOS_event_send(const arm_event_s *event);
+
+#endif
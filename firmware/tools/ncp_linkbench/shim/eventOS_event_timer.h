@@ -0,0 +1,8 @@
+#ifndef LINKBENCH_EVENTOS_EVENT_TIMER_H
+#define LINKBENCH_EVENTOS_EVENT_TIMER_H
+
+#include <stdint.h>
+
+int8_t eventOS_event_timer_request(uint8_t event_id, uint8_t event_type, int8_t tasklet_id, uint32_t time);
+
+#endif
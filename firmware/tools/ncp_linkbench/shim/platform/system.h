@@ -0,0 +1,20 @@
+#ifndef LINKBENCH_PLATFORM_SYSTEM_H
+#define LINKBENCH_PLATFORM_SYSTEM_H
+
+#include <stdint.h>
+
+// Flags the UART driver callbacks pass to platformUartSignal()
+#define PLATFORM_UART_EVENT_TX  (1 << 0)
+#define PLATFORM_UART_EVENT_RX  (1 << 1)
+
+/* Implemented by the application (ncp_transport.c) */
+void platformUartSignal(uintptr_t arg);
+void platformNcpSendRspSignal(void);
+void platformNcpSendAsyncRspSignal(void);
+
+/* Implemented by the platform layer (shim_platform.c here) */
+void platformUartProcess(uintptr_t arg);
+void platformNcpSendProcess(void);
+void platformNcpSendAsyncProcess(void);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef LINKBENCH_UART2_H
+#define LINKBENCH_UART2_H
+
+#include <stdint.h>
+
+typedef struct {
+    int fd;                                     /*!< pty slave standing in for the UART */
+} UART2_Config;
+
+typedef UART2_Config *UART2_Handle;
+
+extern UART2_Config UART2_config[];
+
+// Bytes dropped by the emulated driver because the RX ring was full
+uint32_t UART2_getOverrunCount(UART2_Handle handle);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef LINKBENCH_HWIP_H
+#define LINKBENCH_HWIP_H
+
+#include <stdint.h>
+
+// The emulated UART "interrupts" run from the same poll loop as the tasklets, nothing to mask
+static inline uintptr_t HwiP_disable(void)
+{
+    return 0;
+}
+
+static inline void HwiP_restore(uintptr_t key)
+{
+    (void)key;
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef LINKBENCH_TI_DRIVERS_CONFIG_H
+#define LINKBENCH_TI_DRIVERS_CONFIG_H
+
+#define CONFIG_UART2_0  0
+
+#endif
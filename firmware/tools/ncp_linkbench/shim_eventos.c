@@ -0,0 +1,110 @@
+/*
+ * Host eventOS: one FIFO for all priorities and a small timer table, enough for the NCP tasklet.
+ */
+
+#include <string.h>
+#include "eventOS_event.h"
+#include "eventOS_event_timer.h"
+#include "linkbench.h"
+
+#define EVENTOS_QUEUE_SIZE      32
+#define EVENTOS_TASKLETS_MAX    4
+#define EVENTOS_TIMERS_MAX      8
+
+typedef struct {
+    bool active;
+    uint64_t due_us;
+    arm_event_s event;
+} eventos_timer_t;
+
+static void (*tasklets[EVENTOS_TASKLETS_MAX])(arm_event_s *);
+static int8_t tasklet_count;
+static arm_event_s queue[EVENTOS_QUEUE_SIZE];
+static uint32_t queue_head;
+static uint32_t queue_count;
+static uint32_t queue_full;
+static eventos_timer_t timers[EVENTOS_TIMERS_MAX];
+
+int8_t eventOS_event_send(const arm_event_s *event)
+{
+    if (queue_count == EVENTOS_QUEUE_SIZE || event->receiver < 0 || event->receiver >= tasklet_count) {
+        queue_full++;
+        return -1;
+    }
+    queue[(queue_head + queue_count++) % EVENTOS_QUEUE_SIZE] = *event;
+    return 0;
+}
+
+int8_t eventOS_event_handler_create(void (*handler_func_ptr)(arm_event_s *), uint8_t init_event_type)
+{
+    if (tasklet_count == EVENTOS_TASKLETS_MAX) {
+        return -1;
+    }
+    int8_t id = tasklet_count++;
+    tasklets[id] = handler_func_ptr;
+    arm_event_s event = {
+        .receiver = id,
+        .sender = id,
+        .event_type = init_event_type,
+        .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
+    };
+    eventOS_event_send(&event);
+    return id;
+}
+
+int8_t eventOS_event_timer_request(uint8_t event_id, uint8_t event_type, int8_t tasklet_id, uint32_t time)
+{
+    for (int i = 0; i < EVENTOS_TIMERS_MAX; i++) {
+        if (!timers[i].active) {
+            timers[i].active = true;
+            timers[i].due_us = linkbench_now_us() + (uint64_t)time * 1000;
+            timers[i].event = (arm_event_s) {
+                .receiver = tasklet_id,
+                .sender = tasklet_id,
+                .event_type = event_type,
+                .event_id = event_id,
+                .priority = ARM_LIB_HIGH_PRIORITY_EVENT,
+            };
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void eventos_shim_run(void)
+{
+    while (queue_count) {
+        arm_event_s event = queue[queue_head];
+        queue_head = (queue_head + 1) % EVENTOS_QUEUE_SIZE;
+        queue_count--;
+        tasklets[event.receiver](&event);
+    }
+}
+
+int eventos_shim_timers_run(void)
+{
+    uint64_t now = linkbench_now_us();
+    int next = -1;
+
+    for (int i = 0; i < EVENTOS_TIMERS_MAX; i++) {
+        if (!timers[i].active) {
+            continue;
+        }
+        if (timers[i].due_us <= now) {
+            timers[i].active = false;
+            eventOS_event_send(&timers[i].event);
+            next = 0;
+            continue;
+        }
+        int ms = (int)((timers[i].due_us - now + 999) / 1000);
+        if (next < 0 || ms < next) {
+            next = ms;
+        }
+    }
+    return next;
+}
+
+uint32_t eventos_shim_queue_full(void)
+{
+    return queue_full;
+}
@@ -0,0 +1,344 @@
+/*
+ * Emulated NCP platform: the UART2 driver on a pty and the SDK layer above it that frames Spinel
+ * with HDLC and answers the host. Only the part the benchmark drives is modelled:
+ * - RX bytes land in a ring in rx_chunk sized driver callbacks that raise PLATFORM_UART_EVENT_RX
+ * - property gets are answered with PROP_VALUE_IS, STREAM_NET sets with LAST_STATUS
+ * - unsolicited STREAM_NET frames carrying a send timestamp are queued at async_rate
+ * - responses go through platformNcpSendRspSignal()/platformNcpSendProcess() one frame each,
+ *   async frames through platformNcpSendAsyncRspSignal()/platformNcpSendAsyncProcess()
+ * - the TX ring drains at the configured baud rate, each write raises PLATFORM_UART_EVENT_TX
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ti/drivers/UART2.h>
+#include "platform/system.h"
+#include "linkbench.h"
+
+#define NCP_QUEUE_SIZE          16
+#define SPINEL_STATUS_OK        0
+#define SPINEL_STATUS_INVALID_COMMAND 3
+#define SPINEL_STATUS_PROP_NOT_FOUND  13
+
+typedef struct {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t head;
+    uint32_t count;
+} ncp_ring_t;
+
+typedef struct {
+    uint16_t length;
+    uint8_t data[LINKBENCH_FRAME_MAX];
+} ncp_frame_t;
+
+typedef struct {
+    ncp_frame_t frames[NCP_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    uint32_t deferred;                          /*!< Sends signalled while the TX ring was full */
+} ncp_queue_t;
+
+UART2_Config UART2_config[1] = {{.fd = -1}};
+
+static ncp_platform_config_t config;
+static ncp_platform_stats_t stats;
+static uint32_t rx_overruns;
+static ncp_ring_t rx_ring;
+static ncp_ring_t tx_ring;
+static hdlc_decoder_t decoder;
+static ncp_queue_t rsp_queue;
+static ncp_queue_t async_queue;
+static double rx_credit;
+static double tx_credit;
+static uint64_t credit_us;
+static uint64_t next_async_us;
+
+uint32_t UART2_getOverrunCount(UART2_Handle handle)
+{
+    (void)handle;
+    return rx_overruns;
+}
+
+static uint32_t ring_free(const ncp_ring_t *ring)
+{
+    return ring->size - ring->count;
+}
+
+static void ring_write(ncp_ring_t *ring, const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        ring->data[(ring->head + ring->count++) % ring->size] = data[i];
+    }
+}
+
+static ncp_frame_t *queue_tail(ncp_queue_t *queue)
+{
+    return queue->count < NCP_QUEUE_SIZE ? &queue->frames[(queue->head + queue->count) % NCP_QUEUE_SIZE] : NULL;
+}
+
+static void response_queue(uint8_t header, uint8_t prop, const uint8_t *value, uint16_t length)
+{
+    ncp_frame_t *frame = queue_tail(&rsp_queue);
+    if (!frame) {
+        stats.rsp_queue_full++;
+        return;
+    }
+    frame->data[0] = header;
+    frame->data[1] = SPINEL_CMD_PROP_VALUE_IS;
+    frame->data[2] = prop;
+    memcpy(&frame->data[3], value, length);
+    frame->length = 3 + length;
+    rsp_queue.count++;
+    platformNcpSendRspSignal();
+}
+
+static void response_status(uint8_t header, uint8_t status)
+{
+    response_queue(header, SPINEL_PROP_LAST_STATUS, &status, 1);
+}
+
+static void spinel_handle(const uint8_t *frame, size_t length)
+{
+    static const uint8_t protocol_version[] = {4, 3};
+    static const char ncp_version[] = "TIWISUNFAN/1.0.0; LINKBENCH";
+    static const uint8_t hwaddr[] = {0x00, 0x12, 0x4b, 0x00, 0x14, 0xf7, 0xd2, 0x8c};
+
+    if (length < 3 || !(frame[0] & SPINEL_HEADER_FLAG)) {
+        return;
+    }
+    stats.rx_frames++;
+    if (frame[1] == SPINEL_CMD_PROP_VALUE_GET) {
+        switch (frame[2]) {
+            case SPINEL_PROP_PROTOCOL_VERSION:
+                response_queue(frame[0], frame[2], protocol_version, sizeof(protocol_version));
+                break;
+            case SPINEL_PROP_NCP_VERSION:
+                response_queue(frame[0], frame[2], (const uint8_t *)ncp_version, sizeof(ncp_version));
+                break;
+            case SPINEL_PROP_HWADDR:
+                response_queue(frame[0], frame[2], hwaddr, sizeof(hwaddr));
+                break;
+            default:
+                response_status(frame[0], SPINEL_STATUS_PROP_NOT_FOUND);
+                break;
+        }
+    } else if (frame[1] == SPINEL_CMD_PROP_VALUE_SET && frame[2] == SPINEL_PROP_STREAM_NET) {
+        // The packet would go to the mesh here, the host only waits for the status
+        response_status(frame[0], SPINEL_STATUS_OK);
+    } else {
+        response_status(frame[0], SPINEL_STATUS_INVALID_COMMAND);
+    }
+}
+
+// Move the head of the queue to the TX ring, false if the ring has no room for it yet
+static bool queue_send(ncp_queue_t *queue)
+{
+    static uint8_t encoded[HDLC_ENCODED_MAX(LINKBENCH_FRAME_MAX)];
+    ncp_frame_t *frame = &queue->frames[queue->head];
+    size_t length = hdlc_encode(frame->data, frame->length, encoded);
+
+    if (length > ring_free(&tx_ring)) {
+        return false;
+    }
+    ring_write(&tx_ring, encoded, length);
+    queue->head = (queue->head + 1) % NCP_QUEUE_SIZE;
+    queue->count--;
+    stats.tx_frames++;
+    return true;
+}
+
+static void queue_process(ncp_queue_t *queue)
+{
+    if (!queue->count) {
+        return;
+    }
+    if (queue->deferred || !queue_send(queue)) {
+        queue->deferred++;
+    }
+}
+
+// Sends that found the TX ring full go out as it drains, responses first
+static void queue_resume(ncp_queue_t *queue)
+{
+    while (queue->deferred && queue->count && queue_send(queue)) {
+        queue->deferred--;
+    }
+    if (!queue->count) {
+        queue->deferred = 0;
+    }
+}
+
+void platformUartProcess(uintptr_t arg)
+{
+    if (arg & PLATFORM_UART_EVENT_RX) {
+        while (rx_ring.count) {
+            uint8_t byte = rx_ring.data[rx_ring.head];
+            rx_ring.head = (rx_ring.head + 1) % rx_ring.size;
+            rx_ring.count--;
+            size_t length = hdlc_decode_byte(&decoder, byte);
+            if (length) {
+                spinel_handle(decoder.frame, length);
+            }
+        }
+        stats.rx_fcs_errors = decoder.fcs_errors;
+    }
+    if (arg & PLATFORM_UART_EVENT_TX) {
+        queue_resume(&rsp_queue);
+        queue_resume(&async_queue);
+    }
+}
+
+void platformNcpSendProcess(void)
+{
+    queue_process(&rsp_queue);
+}
+
+void platformNcpSendAsyncProcess(void)
+{
+    queue_process(&async_queue);
+}
+
+static void async_generate(uint64_t now)
+{
+    uint32_t interval_us = 1000000 / config.async_rate;
+
+    while (next_async_us <= now) {
+        next_async_us += interval_us;
+        ncp_frame_t *frame = queue_tail(&async_queue);
+        if (!frame) {
+            stats.async_queue_full++;
+            continue;
+        }
+        // PROP_VALUE_IS STREAM_NET with tid 0, the packet starts with the send time
+        frame->data[0] = SPINEL_HEADER_FLAG;
+        frame->data[1] = SPINEL_CMD_PROP_VALUE_IS;
+        frame->data[2] = SPINEL_PROP_STREAM_NET;
+        frame->data[3] = config.async_size & 0xff;
+        frame->data[4] = config.async_size >> 8;
+        memset(&frame->data[5], 0x60, config.async_size);
+        memcpy(&frame->data[5], &now, sizeof(now));
+        frame->length = 5 + config.async_size;
+        async_queue.count++;
+        stats.async_generated++;
+        platformNcpSendAsyncRspSignal();
+    }
+}
+
+static void credit_update(uint64_t now)
+{
+    if (!config.baud) {
+        return;
+    }
+    // 8N1, ten bit times per byte
+    double earned = (now - credit_us) * (config.baud / 10.0) / 1e6;
+    credit_us = now;
+    // A few chunks of slack, so poll wakeups that come late do not cost line time
+    rx_credit = rx_credit + earned > 4 * config.rx_chunk ? 4 * config.rx_chunk : rx_credit + earned;
+    tx_credit = tx_credit + earned > tx_ring.size ? tx_ring.size : tx_credit + earned;
+}
+
+static uint32_t credit_limit(double credit, uint32_t length)
+{
+    return !config.baud || credit >= length ? length : (uint32_t)credit;
+}
+
+// One driver callback per rx_chunk, as many as the line has delivered since the last run
+static void uart_rx(void)
+{
+    uint8_t chunk[LINKBENCH_FRAME_MAX];
+
+    while (!config.baud || rx_credit >= 1) {
+        uint32_t length = credit_limit(rx_credit, config.rx_chunk);
+        ssize_t got = read(UART2_config[0].fd, chunk, length);
+        if (got <= 0) {
+            return;
+        }
+        rx_credit -= config.baud ? got : 0;
+        // At a real bit rate the bytes arrive whether there is room or not
+        uint32_t kept = (uint32_t)got < ring_free(&rx_ring) ? (uint32_t)got : ring_free(&rx_ring);
+        rx_overruns += got - kept;
+        ring_write(&rx_ring, chunk, kept);
+        platformUartSignal(PLATFORM_UART_EVENT_RX);
+        if (!config.baud) {
+            return;
+        }
+    }
+}
+
+static void uart_tx(void)
+{
+    uint32_t length = tx_ring.count;
+    if (tx_ring.head + length > tx_ring.size) {
+        length = tx_ring.size - tx_ring.head;
+    }
+    length = credit_limit(tx_credit, length);
+    ssize_t sent = write(UART2_config[0].fd, &tx_ring.data[tx_ring.head], length);
+
+    if (sent <= 0) {
+        return;
+    }
+    tx_credit -= config.baud ? sent : 0;
+    tx_ring.head = (tx_ring.head + sent) % tx_ring.size;
+    tx_ring.count -= sent;
+    stats.tx_bytes += sent;
+    platformUartSignal(PLATFORM_UART_EVENT_TX);
+}
+
+void ncp_platform_init(int fd, const ncp_platform_config_t *platform_config)
+{
+    config = *platform_config;
+    config.rx_chunk = config.rx_chunk > LINKBENCH_FRAME_MAX ? LINKBENCH_FRAME_MAX : config.rx_chunk;
+    UART2_config[0].fd = fd;
+    rx_ring.data = malloc(config.rx_ring);
+    rx_ring.size = config.rx_ring;
+    tx_ring.data = malloc(config.tx_ring);
+    tx_ring.size = config.tx_ring;
+    credit_us = linkbench_now_us();
+    next_async_us = credit_us + (config.async_rate ? 1000000 / config.async_rate : 0);
+}
+
+short ncp_platform_poll_events(void)
+{
+    short events = 0;
+    if (!config.baud || rx_credit >= 1) {
+        // Without a bit rate a full ring leaves the bytes in the pty, like flow control would
+        events |= (config.baud || ring_free(&rx_ring)) ? POLLIN : 0;
+    }
+    if (tx_ring.count && (!config.baud || tx_credit >= 1)) {
+        events |= POLLOUT;
+    }
+    return events;
+}
+
+int ncp_platform_run(short revents)
+{
+    uint64_t now = linkbench_now_us();
+    int timeout = -1;
+
+    credit_update(now);
+    if (revents & POLLIN) {
+        uart_rx();
+    }
+    if (revents & POLLOUT) {
+        uart_tx();
+    }
+    if (config.async_rate) {
+        async_generate(now);
+        timeout = (int)((next_async_us - now + 999) / 1000);
+    }
+    if (config.baud && (rx_credit < 1 || (tx_ring.count && tx_credit < 1))) {
+        // Wake up once the line has moved a chunk
+        int wait = (int)(config.rx_chunk * 10000ull / config.baud) + 1;
+        timeout = timeout < 0 || wait < timeout ? wait : timeout;
+    }
+    return timeout;
+}
+
+const ncp_platform_stats_t *ncp_platform_stats(void)
+{
+    return &stats;
+}
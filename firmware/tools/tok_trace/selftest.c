@@ -0,0 +1,127 @@
+/*
+ * Self test of the tokenized trace: logs through ../../src/tok_trace.c into an ITM capture
+ * and writes the text the decoder has to rebuild from it. make check compares the two.
+ *   tok_selftest <capture> <expected text>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "ns_trace.h"
+#include "trace_config.h"
+#include "shim_platform.h"
+
+#define TRACE_GROUP "test"
+#define TRACE_GROUP_LEVEL TRACE_CONFIG_DEBUG
+
+// Ring size of tok_trace.c, set for both by the Makefile
+#ifndef TOK_TRACE_SLOTS
+#define TOK_TRACE_SLOTS 32
+#endif
+
+static FILE *expected;
+static int evaluated;
+
+static int count_evaluation(void)
+{
+    return ++evaluated;
+}
+
+// Log through the backend and write what printf makes of the same call
+#define CHECK(tr, name, fmt, ...)                                              \
+    do {                                                                       \
+        tr(fmt, ##__VA_ARGS__);                                                \
+        fprintf(expected, "[" name "][test]: " fmt "\n", ##__VA_ARGS__);       \
+    } while (0)
+
+/*
+ * Wait until the drain task has sent everything queued
+ */
+static void drain(void)
+{
+    unsigned long words;
+
+    do {
+        words = shim_itm_word_count();
+        usleep(50000);
+    } while (words != shim_itm_word_count());
+}
+
+int main(int argc, char **argv)
+{
+    const uint8_t ip[16] = {0x20, 0x20, 0xab, 0xcd, 0, 0, 0, 0, 0x02, 0x12, 0x4b, 0, 0x14, 0xf8, 0x2a, 0xf0};
+    const char *library = "Oct 19 2026";
+    char long_str[64];
+    int i;
+
+    if (argc != 3 || !(shim_itm_capture = fopen(argv[1], "wb")) || !(expected = fopen(argv[2], "w"))) {
+        fprintf(stderr, "usage: %s <capture> <expected text>\n", argv[0]);
+        return 2;
+    }
+    tok_trace_init();
+
+    CHECK(tr_info, "INFO", "nanostackNetworkHandler: CON_STATUS_DISCONNECTED");
+    CHECK(tr_info, "INFO",
+          "nanostackNetworkHandler: CON_STATUS_GLOBAL_UP, IP "
+          "%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x",
+          ip[0], ip[1], ip[2], ip[3], ip[4], ip[5], ip[6], ip[7],
+          ip[8], ip[9], ip[10], ip[11], ip[12], ip[13], ip[14], ip[15]);
+    CHECK(tr_debug, "DBG ", "socket_callback() sock=%d, event=0x%x, interface=%d, data len=%d",
+          3, 0x15, -1, 42);
+    CHECK(tr_warn, "WARN", "Task priority %d: %u of %u stack bytes free", 5, 40u, 1024u);
+    CHECK(tr_error, "ERR ", "Library info | Date: %s, Version: %-8s|", library, "2.1");
+    CHECK(tr_info, "INFO", "%c%c %5.2f %e %lld %llx %%", 'o', 'k', 3.14159, -2.5e-7, -12345678901LL,
+          0x123456789abcULL);
+    CHECK(tr_info, "INFO", "[%*d] [%-*d] [%.*s]", 6, 42, 4, 7, 3, "abcdef");
+    CHECK(tr_info, "INFO", "%u %d %x", 4294967295u, -2147483647 - 1, 0xdeadbeefu);
+
+    // Strings are cut to TOK_TRACE_STR_MAX
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    tr_info("%s!", long_str);
+    fprintf(expected, "[INFO][test]: %.32s!\n", long_str);
+
+    // Arguments beyond TOK_TRACE_ARGS_LEN are shown as missing
+    tr_info("%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d", 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+            10, 11, 12, 13, 14, 15, 16, 17, 18);
+    fprintf(expected, "[INFO][test]: 0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 <?>\n");
+
+    // Levels turned off in the trace configuration are not queued
+    shim_trace_config = TRACE_ACTIVE_LEVEL_ALL & ~TRACE_LEVEL_DEBUG;
+    tr_debug("not sent");
+    shim_trace_config = TRACE_ACTIVE_LEVEL_ALL;
+
+    // Calls below the level of the group are not compiled, their arguments are not evaluated
+#undef TRACE_GROUP_LEVEL
+#define TRACE_GROUP_LEVEL TRACE_CONFIG_WARN
+    tr_info("not compiled %d", count_evaluation());
+    tr_debug("not compiled %d", count_evaluation());
+    tr_warn("compiled %d", count_evaluation());
+    fprintf(expected, "[WARN][test]: compiled 1\n");
+#undef TRACE_GROUP_LEVEL
+#define TRACE_GROUP_LEVEL TRACE_CONFIG_DEBUG
+    if (evaluated != 1) {
+        fprintf(stderr, "%d arguments of dropped calls evaluated\n", evaluated - 1);
+        return 1;
+    }
+    drain();
+
+    // Hold the drain task on its next record and overfill the ring
+    shim_itm_stall(true);
+    CHECK(tr_info, "INFO", "held");
+    shim_itm_wait_stalled();
+    // The drop count goes out with the first record sent after it
+    fprintf(expected, "-- 8 records dropped --\n");
+    for (i = 0; i < TOK_TRACE_SLOTS + 8; i++) {
+        tr_info("burst %d", i);
+        if (i < TOK_TRACE_SLOTS) {
+            fprintf(expected, "[INFO][test]: burst %d\n", i);
+        }
+    }
+    shim_itm_stall(false);
+    drain();
+
+    fclose(shim_itm_capture);
+    fclose(expected);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef TOK_SELFTEST_NS_TRACE_H
+#define TOK_SELFTEST_NS_TRACE_H
+
+#include <stdint.h>
+
+// Levels and macros as in mbed_trace.h, the text backend is not part of the host build
+#define TRACE_LEVEL_DEBUG 0x10
+#define TRACE_LEVEL_INFO 0x08
+#define TRACE_LEVEL_WARN 0x04
+#define TRACE_LEVEL_ERROR 0x02
+#define TRACE_LEVEL_CMD 0x01
+#define TRACE_ACTIVE_LEVEL_ALL 0x1f
+
+uint8_t mbed_trace_config_get(void);
+void mbed_tracef(uint8_t dlevel, const char *grp, const char *fmt, ...);
+
+#define tr_debug(...) mbed_tracef(TRACE_LEVEL_DEBUG, TRACE_GROUP, __VA_ARGS__)
+#define tr_info(...) mbed_tracef(TRACE_LEVEL_INFO, TRACE_GROUP, __VA_ARGS__)
+#define tr_warn(...) mbed_tracef(TRACE_LEVEL_WARN, TRACE_GROUP, __VA_ARGS__)
+#define tr_warning(...) mbed_tracef(TRACE_LEVEL_WARN, TRACE_GROUP, __VA_ARGS__)
+#define tr_error(...) mbed_tracef(TRACE_LEVEL_ERROR, TRACE_GROUP, __VA_ARGS__)
+#define tr_err(...) mbed_tracef(TRACE_LEVEL_ERROR, TRACE_GROUP, __VA_ARGS__)
+
+#endif
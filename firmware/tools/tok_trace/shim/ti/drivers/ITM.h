@@ -0,0 +1,11 @@
+#ifndef TOK_SELFTEST_ITM_H
+#define TOK_SELFTEST_ITM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Writes the stimulus port packets to the capture file of the self test, see shim_itm.c
+bool ITM_open(void);
+void ITM_send32Atomic(uint8_t port, uint32_t value);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef TOK_SELFTEST_CLOCKP_H
+#define TOK_SELFTEST_CLOCKP_H
+
+#include <stdint.h>
+
+uint32_t ClockP_getSystemTicks(void);
+uint32_t ClockP_getSystemTickPeriod(void);
+
+#endif
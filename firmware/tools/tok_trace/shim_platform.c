@@ -0,0 +1,95 @@
+/*
+ * Host stand-ins for the ITM driver, ClockP and the mbed trace configuration used by tok_trace.c.
+ * The stimulus port writes are framed as ITM software source packets, as a SWO capture holds them.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <ti/drivers/ITM.h>
+#include <ti/drivers/dpl/ClockP.h>
+#include "ns_trace.h"
+#include "shim_platform.h"
+
+FILE *shim_itm_capture;
+uint8_t shim_trace_config = TRACE_ACTIVE_LEVEL_ALL;
+
+static pthread_mutex_t shim_itm_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t shim_itm_cond = PTHREAD_COND_INITIALIZER;
+static bool shim_itm_stalled;
+static bool shim_itm_waiting;
+static unsigned long shim_itm_words;
+
+bool ITM_open(void)
+{
+    // A synchronization packet, as the capture of a running trace starts with
+    static const uint8_t sync[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x80};
+    fwrite(sync, 1, sizeof(sync), shim_itm_capture);
+    return true;
+}
+
+void ITM_send32Atomic(uint8_t port, uint32_t value)
+{
+    uint8_t packet[5] = {(uint8_t)(port << 3) | 0x03, value, value >> 8, value >> 16, value >> 24};
+
+    pthread_mutex_lock(&shim_itm_lock);
+    while (shim_itm_stalled) {
+        shim_itm_waiting = true;
+        pthread_cond_broadcast(&shim_itm_cond);
+        pthread_cond_wait(&shim_itm_cond, &shim_itm_lock);
+    }
+    shim_itm_waiting = false;
+    fwrite(packet, 1, sizeof(packet), shim_itm_capture);
+    // Timestamp packets in between, the decoder skips them
+    if (++shim_itm_words % 7 == 0) {
+        static const uint8_t timestamp[] = {0xC0, 0x81, 0x01};
+        fwrite(timestamp, 1, sizeof(timestamp), shim_itm_capture);
+    }
+    pthread_mutex_unlock(&shim_itm_lock);
+}
+
+void shim_itm_stall(bool stall)
+{
+    pthread_mutex_lock(&shim_itm_lock);
+    shim_itm_stalled = stall;
+    pthread_cond_broadcast(&shim_itm_cond);
+    pthread_mutex_unlock(&shim_itm_lock);
+}
+
+void shim_itm_wait_stalled(void)
+{
+    pthread_mutex_lock(&shim_itm_lock);
+    while (!shim_itm_waiting) {
+        pthread_cond_wait(&shim_itm_cond, &shim_itm_lock);
+    }
+    pthread_mutex_unlock(&shim_itm_lock);
+}
+
+unsigned long shim_itm_word_count(void)
+{
+    unsigned long words;
+
+    pthread_mutex_lock(&shim_itm_lock);
+    words = shim_itm_words;
+    pthread_mutex_unlock(&shim_itm_lock);
+    return words;
+}
+
+uint32_t ClockP_getSystemTicks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 100000 + ts.tv_nsec / 10000);
+}
+
+uint32_t ClockP_getSystemTickPeriod(void)
+{
+    return 10;
+}
+
+uint8_t mbed_trace_config_get(void)
+{
+    return shim_trace_config;
+}
@@ -0,0 +1,19 @@
+#ifndef TOK_SELFTEST_SHIM_PLATFORM_H
+#define TOK_SELFTEST_SHIM_PLATFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Capture file the ITM packets are written to
+extern FILE *shim_itm_capture;
+// Value of mbed_trace_config_get()
+extern uint8_t shim_trace_config;
+
+// Hold the drain task in its next ITM write, to fill the ring
+void shim_itm_stall(bool stall);
+// Wait until the drain task is held
+void shim_itm_wait_stalled(void);
+unsigned long shim_itm_word_count(void);
+
+#endif
@@ -0,0 +1,499 @@
+/*
+ * Decoder for the tokenized trace of firmware/src/tok_trace.c.
+ * Reads a SWO capture of the ITM stream (or the bytes of the stimulus port with -r),
+ * looks up the format and group strings of each record in the ELF image the node runs,
+ * and prints the trace as text.
+ */
+
+#include <elf.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Record layout, see TOK_TRACE_MAGIC in tok_trace.c
+#define TOK_MAGIC 0xA5
+#define TOK_HEADER_LEN 16
+#define TOK_ARGS_MAX 255
+
+#define TRACE_LEVEL_DEBUG 0x10
+#define TRACE_LEVEL_INFO 0x08
+#define TRACE_LEVEL_WARN 0x04
+#define TRACE_LEVEL_ERROR 0x02
+#define TRACE_LEVEL_CMD 0x01
+
+typedef struct {
+    uint64_t addr;
+    uint64_t size;
+    const uint8_t *data;
+} image_section_t;
+
+typedef struct {
+    uint8_t *file;
+    image_section_t *sections;
+    size_t count;
+} image_t;
+
+typedef struct {
+    const char *elf_path;
+    const char *capture_path;
+    int port;
+    bool raw;
+    bool no_time;
+} options_t;
+
+static uint64_t records;
+static uint64_t dropped;
+static uint64_t unresolved;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] <elf> [capture]\n"
+            "  -p <port>  ITM stimulus port of the records (default 1, TOK_TRACE_ITM_PORT)\n"
+            "  -r         the capture holds the port bytes only, not ITM packets\n"
+            "  -q         leave out the timestamps\n"
+            "The capture is read from stdin when no file is given.\n",
+            prog);
+}
+
+static uint8_t *read_file(FILE *f, size_t *len)
+{
+    size_t cap = 1 << 16;
+    uint8_t *buf = malloc(cap);
+    size_t n;
+
+    *len = 0;
+    while (buf && (n = fread(buf + *len, 1, cap - *len, f)) > 0) {
+        *len += n;
+        if (*len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    return buf;
+}
+
+#define READ_CHUNK 4096
+
+/*
+ * Load the allocated sections with contents, 32 and 64 bit little endian ELF.
+ * The 64 bit case covers the host build of make check.
+ */
+static bool image_load(image_t *img, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    size_t len, i, shnum, shoff, shentsize;
+
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+    img->file = read_file(f, &len);
+    fclose(f);
+    if (!img->file || len < EI_NIDENT || memcmp(img->file, ELFMAG, SELFMAG) != 0 ||
+        img->file[EI_DATA] != ELFDATA2LSB) {
+        fprintf(stderr, "%s: not a little endian ELF file\n", path);
+        return false;
+    }
+
+    bool is64 = img->file[EI_CLASS] == ELFCLASS64;
+    if (is64) {
+        const Elf64_Ehdr *eh = (const Elf64_Ehdr *)img->file;
+        shnum = eh->e_shnum;
+        shoff = eh->e_shoff;
+        shentsize = eh->e_shentsize;
+    } else {
+        const Elf32_Ehdr *eh = (const Elf32_Ehdr *)img->file;
+        shnum = eh->e_shnum;
+        shoff = eh->e_shoff;
+        shentsize = eh->e_shentsize;
+    }
+    if (shoff + shnum * shentsize > len) {
+        fprintf(stderr, "%s: truncated section table\n", path);
+        return false;
+    }
+
+    img->sections = calloc(shnum, sizeof(*img->sections));
+    img->count = 0;
+    for (i = 0; i < shnum; i++) {
+        const uint8_t *sh = img->file + shoff + i * shentsize;
+        uint64_t flags, addr, offset, size;
+        uint32_t type;
+        if (is64) {
+            const Elf64_Shdr *s = (const Elf64_Shdr *)sh;
+            type = s->sh_type, flags = s->sh_flags, addr = s->sh_addr;
+            offset = s->sh_offset, size = s->sh_size;
+        } else {
+            const Elf32_Shdr *s = (const Elf32_Shdr *)sh;
+            type = s->sh_type, flags = s->sh_flags, addr = s->sh_addr;
+            offset = s->sh_offset, size = s->sh_size;
+        }
+        if (!(flags & SHF_ALLOC) || type == SHT_NOBITS || size == 0 || offset + size > len) {
+            continue;
+        }
+        img->sections[img->count++] = (image_section_t){addr, size, img->file + offset};
+    }
+    return true;
+}
+
+/*
+ * String at a target address, NULL when no section holds it
+ */
+static const char *image_string(const image_t *img, uint32_t addr)
+{
+    size_t i;
+
+    for (i = 0; i < img->count; i++) {
+        const image_section_t *s = &img->sections[i];
+        if (addr >= s->addr && addr < s->addr + s->size) {
+            const char *str = (const char *)s->data + (addr - s->addr);
+            // The string has to end inside the section
+            if (memchr(str, '\0', s->size - (addr - s->addr))) {
+                return str;
+            }
+        }
+    }
+    return NULL;
+}
+
+static const char *level_name(uint8_t level)
+{
+    switch (level) {
+        case TRACE_LEVEL_DEBUG:
+            return "DBG ";
+        case TRACE_LEVEL_INFO:
+            return "INFO";
+        case TRACE_LEVEL_WARN:
+            return "WARN";
+        case TRACE_LEVEL_ERROR:
+            return "ERR ";
+        case TRACE_LEVEL_CMD:
+            return "CMD ";
+    }
+    return NULL;
+}
+
+typedef struct {
+    const uint8_t *ptr;
+    const uint8_t *end;
+} args_t;
+
+static bool args_get(args_t *args, void *out, size_t n)
+{
+    if (args->ptr + n > args->end) {
+        return false;
+    }
+    memcpy(out, args->ptr, n);
+    args->ptr += n;
+    return true;
+}
+
+/*
+ * Rebuild the text from the format and the packed arguments, see tok_trace_pack()
+ */
+static void format_record(const char *fmt, const uint8_t *data, size_t len, char *out, size_t out_len)
+{
+    args_t args = {data, data + len};
+    size_t pos = 0;
+
+#define APPEND(...)                                                                    \
+    do {                                                                               \
+        int n_ = snprintf(out + pos, out_len - pos, __VA_ARGS__);                      \
+        pos = (n_ < 0 || (size_t)n_ >= out_len - pos) ? out_len - 1 : pos + (size_t)n_; \
+    } while (0)
+
+    out[0] = '\0';
+    while (*fmt && pos < out_len - 1) {
+        char spec[32];
+        size_t spec_len = 0;
+        int longs = 0;
+        bool missing = false;
+
+        if (*fmt != '%') {
+            out[pos++] = *fmt++;
+            out[pos] = '\0';
+            continue;
+        }
+        if (fmt[1] == '%') {
+            APPEND("%%");
+            fmt += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision, * is replaced by its argument
+        spec[spec_len++] = *fmt++;
+        while (*fmt && strchr("-+ #0123456789.*", *fmt) && spec_len < sizeof(spec) - 24) {
+            if (*fmt == '*') {
+                int32_t width;
+                if (!args_get(&args, &width, sizeof(width))) {
+                    missing = true;
+                    width = 0;
+                }
+                spec_len += sprintf(spec + spec_len, "%d", width);
+            } else {
+                spec[spec_len++] = *fmt;
+            }
+            fmt++;
+        }
+        // Length modifiers are replaced by the host type of the packed value
+        while (*fmt && strchr("hlLjzt", *fmt)) {
+            if (*fmt == 'l') {
+                longs++;
+            } else if (*fmt == 'j') {
+                longs = 2;
+            }
+            fmt++;
+        }
+        if (!*fmt) {
+            break;
+        }
+        char conv = *fmt++;
+
+        if (missing) {
+            APPEND("<?>");
+            continue;
+        }
+        switch (conv) {
+            case 's': {
+                uint8_t n;
+                char str[TOK_ARGS_MAX + 1];
+                if (!args_get(&args, &n, 1) || !args_get(&args, str, n)) {
+                    APPEND("<?>");
+                    break;
+                }
+                str[n] = '\0';
+                spec[spec_len++] = 's';
+                spec[spec_len] = '\0';
+                APPEND(spec, str);
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                double value;
+                if (!args_get(&args, &value, sizeof(value))) {
+                    APPEND("<?>");
+                    break;
+                }
+                spec[spec_len++] = conv;
+                spec[spec_len] = '\0';
+                APPEND(spec, value);
+                break;
+            }
+            case 'p': {
+                uint32_t value;
+                if (!args_get(&args, &value, sizeof(value))) {
+                    APPEND("<?>");
+                    break;
+                }
+                APPEND("0x%08x", value);
+                break;
+            }
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c': {
+                long long value;
+                if (longs >= 2) {
+                    uint64_t v;
+                    if (!args_get(&args, &v, sizeof(v))) {
+                        APPEND("<?>");
+                        break;
+                    }
+                    value = (long long)v;
+                } else {
+                    uint32_t v;
+                    if (!args_get(&args, &v, sizeof(v))) {
+                        APPEND("<?>");
+                        break;
+                    }
+                    // Signed conversions of 32 bit values need the sign extended
+                    value = (conv == 'd' || conv == 'i') ? (long long)(int32_t)v : (long long)v;
+                    if (conv != 'd' && conv != 'i' && conv != 'c') {
+                        value &= 0xFFFFFFFFLL;
+                    }
+                }
+                if (conv == 'c') {
+                    spec[spec_len++] = 'c';
+                    spec[spec_len] = '\0';
+                    APPEND(spec, (int)value);
+                } else {
+                    spec[spec_len++] = 'l';
+                    spec[spec_len++] = 'l';
+                    spec[spec_len++] = conv;
+                    spec[spec_len] = '\0';
+                    APPEND(spec, value);
+                }
+                break;
+            }
+            default:
+                // Unknown conversion, shown as written
+                spec[spec_len++] = conv;
+                spec[spec_len] = '\0';
+                APPEND("%s", spec);
+                break;
+        }
+    }
+#undef APPEND
+}
+
+/*
+ * Decode the records in the port bytes, returns the bytes consumed
+ */
+static size_t decode_records(const image_t *img, const options_t *opt, const uint8_t *buf, size_t len)
+{
+    size_t pos = 0;
+    char text[1024];
+
+    while (len - pos >= TOK_HEADER_LEN) {
+        const uint8_t *rec = buf + pos;
+        uint8_t level = rec[1], args_len = rec[2], drops = rec[3];
+        uint32_t time_ms, fmt_addr, group_addr;
+        const char *fmt, *group, *name = level_name(level);
+        size_t rec_len = TOK_HEADER_LEN + ((args_len + 3u) & ~3u);
+
+        // Records are word aligned, skip words until a header is found again
+        if (rec[0] != TOK_MAGIC || !name) {
+            pos += 4;
+            continue;
+        }
+        if (len - pos < rec_len) {
+            break;
+        }
+        memcpy(&time_ms, rec + 4, 4);
+        memcpy(&fmt_addr, rec + 8, 4);
+        memcpy(&group_addr, rec + 12, 4);
+        pos += rec_len;
+
+        if (drops) {
+            dropped += drops;
+            printf("-- %u records dropped --\n", drops);
+        }
+        records++;
+        fmt = image_string(img, fmt_addr);
+        group = image_string(img, group_addr);
+        if (!fmt) {
+            unresolved++;
+            snprintf(text, sizeof(text), "<format 0x%08x not in the image>", fmt_addr);
+        } else {
+            format_record(fmt, rec + TOK_HEADER_LEN, args_len, text, sizeof(text));
+        }
+        if (!opt->no_time) {
+            printf("%6u.%03u ", time_ms / 1000, time_ms % 1000);
+        }
+        printf("[%s][%-4s]: %s\n", name, group ? group : "?", text);
+    }
+    return pos;
+}
+
+/*
+ * Append the payload of the software source packets of one port in an ITM stream to out.
+ * Returns the input bytes consumed, a packet cut off at the end is left for the next read.
+ */
+static size_t itm_demux(const uint8_t *in, size_t len, int port, uint8_t *out, size_t *out_len)
+{
+    static const size_t sizes[4] = {0, 1, 2, 4};
+    size_t i = 0, start;
+
+    while (i < len) {
+        uint8_t hdr = in[i];
+        start = i++;
+        if (hdr == 0x00 || hdr == 0x80 || hdr == 0x70) {
+            // Synchronization and overflow
+            continue;
+        }
+        if ((hdr & 0x03) != 0) {
+            // Source packet, bit 2 marks the hardware sources
+            size_t size = sizes[hdr & 0x03];
+            if (i + size > len) {
+                return start;
+            }
+            if (!(hdr & 0x04) && (hdr >> 3) == port) {
+                memcpy(out + *out_len, in + i, size);
+                *out_len += size;
+            }
+            i += size;
+            continue;
+        }
+        // Timestamp and extension packets, continued while bit 7 is set
+        if (hdr & 0x80) {
+            while (i < len && (in[i] & 0x80)) {
+                i++;
+            }
+            if (i == len) {
+                return start;
+            }
+            i++;
+        }
+    }
+    return i;
+}
+
+int main(int argc, char **argv)
+{
+    options_t opt = {.port = 1};
+    image_t img;
+    // Input and port bytes left over from the last read, a record is at most 16 + 255 bytes
+    static uint8_t in[READ_CHUNK + 8];
+    static uint8_t port_bytes[2 * READ_CHUNK + TOK_HEADER_LEN + TOK_ARGS_MAX];
+    size_t in_len = 0, port_len = 0, used;
+    ssize_t r;
+    FILE *f = stdin;
+    int c;
+
+    while ((c = getopt(argc, argv, "p:rqh")) != -1) {
+        switch (c) {
+            case 'p':
+                opt.port = atoi(optarg);
+                break;
+            case 'r':
+                opt.raw = true;
+                break;
+            case 'q':
+                opt.no_time = true;
+                break;
+            default:
+                usage(argv[0]);
+                return c == 'h' ? 0 : 2;
+        }
+    }
+    if (optind >= argc || opt.port < 0 || opt.port > 31) {
+        usage(argv[0]);
+        return 2;
+    }
+    opt.elf_path = argv[optind];
+    opt.capture_path = optind + 1 < argc ? argv[optind + 1] : NULL;
+
+    if (!image_load(&img, opt.elf_path)) {
+        return 1;
+    }
+    if (opt.capture_path && !(f = fopen(opt.capture_path, "rb"))) {
+        fprintf(stderr, "%s: %s\n", opt.capture_path, strerror(errno));
+        return 1;
+    }
+    // Decoded as it arrives, so a live SWO stream can be piped in
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    while ((r = read(fileno(f), in + in_len, READ_CHUNK)) > 0) {
+        in_len += (size_t)r;
+        if (opt.raw) {
+            memcpy(port_bytes + port_len, in, in_len);
+            port_len += in_len;
+            in_len = 0;
+        } else {
+            used = itm_demux(in, in_len, opt.port, port_bytes, &port_len);
+            memmove(in, in + used, in_len - used);
+            in_len -= used;
+        }
+        used = decode_records(&img, &opt, port_bytes, port_len);
+        memmove(port_bytes, port_bytes + used, port_len - used);
+        port_len -= used;
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+
+    fprintf(stderr, "%llu records, %llu dropped on the node, %llu formats not found in %s\n",
+            (unsigned long long)records, (unsigned long long)dropped, (unsigned long long)unresolved,
+            opt.elf_path);
+    return 0;
+}
@@ -11,9 +11,15 @@ const CONSTANTS = {
   PING_RESULTS_FILE_NAME: 'PingResults.csv',
   WFANTUND_PATH: '/usr/local/sbin/wfantund',
   BR_FILE_PATH: '/dev/ttyACM0',
+  NCP_DEFAULT_BAUD_RATE: 115200,
+  NCP_BAUD_RATES: [115200],
   PROPERTY_UPDATE_INTERVAL: 9998000, // in ms
   TOPOLOGY_UPDATE_INTERVAL: 9999999, // in ms
   MANUAL_DEV_MODE: false,
+  KEA_LEGAL_LOG_DIR: '/var/lib/kea',
+  TELEMETRY_PORT: 0xf0b1,
+  TELEMETRY_RETENTION_DAYS: 7,
+  TIME_SYNC_PORT: 0xf0b2,
   PORT: 80,
   HOST: '0.0.0.0',
 };
@@ -27,6 +33,11 @@ function setAppConstants() {
     'File path to watch for border router',
     CONSTANTS.BR_FILE_PATH
   );
+  program.option(
+    '-b, --baud-rates <rates>',
+    'Comma separated NCP UART rates to try, the fastest one the NCP answers on is used',
+    CONSTANTS.NCP_BAUD_RATES.join(',')
+  );
   program.option('-p, --port <port>', 'Port to open http server on', CONSTANTS.PORT);
   program.option('-h, --host <hostname>', 'Host to open http server on', CONSTANTS.HOST);
   program.option(
@@ -49,15 +60,43 @@ function setAppConstants() {
     'Dev mode allows user to start wfantund manually',
     CONSTANTS.MANUAL_DEV_MODE
   );
+  program.option(
+    '-k, --kea-log-dir <dir-path>',
+    'Directory of the Kea forensic log used to register devices (empty to disable)',
+    CONSTANTS.KEA_LEGAL_LOG_DIR
+  );
+  program.option(
+    '-m, --telemetry-port <port>',
+    'UDP port the nodes push telemetry to (0 to disable)',
+    CONSTANTS.TELEMETRY_PORT
+  );
+  program.option(
+    '-r, --telemetry-retention <days>',
+    'Days of telemetry to keep',
+    CONSTANTS.TELEMETRY_RETENTION_DAYS
+  );
+  program.option(
+    '-c, --time-sync-port <port>',
+    'UDP port the nodes ask for the time on (0 to disable)',
+    CONSTANTS.TIME_SYNC_PORT
+  );
   program.parse(process.argv);
   const options = program.opts();
   CONSTANTS.BR_FILE_PATH = options.serialPort;
+  CONSTANTS.NCP_BAUD_RATES = String(options.baudRates)
+    .split(',')
+    .map(rate => parseInt(rate, 10))
+    .filter(rate => rate > 0);
   CONSTANTS.PORT = options.port;
   CONSTANTS.WFANTUND_PATH = options.wfantundPath;
   CONSTANTS.TOPOLOGY_UPDATE_INTERVAL = options.topologyInterval;
   CONSTANTS.PROPERTY_UPDATE_INTERVAL = options.propertyInterval;
   CONSTANTS.MANUAL_DEV_MODE = options.devMode;
   CONSTANTS.HOST = options.host;
+  CONSTANTS.KEA_LEGAL_LOG_DIR = options.keaLogDir;
+  CONSTANTS.TELEMETRY_PORT = parseInt(options.telemetryPort, 10);
+  CONSTANTS.TELEMETRY_RETENTION_DAYS = parseFloat(options.telemetryRetention);
+  CONSTANTS.TIME_SYNC_PORT = parseInt(options.timeSyncPort, 10);
 }
 
 /**
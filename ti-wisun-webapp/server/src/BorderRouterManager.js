@@ -5,6 +5,73 @@ const {borderRouterLogger} = require('./logger');
 const {WfantundManager} = require('./WfantundManager');
 const {CONSTANTS} = require('./AppConstants');
 const {getLatestTopology} = require('./topology');
+const {SPINEL, hdlcEncode, hdlcDecode} = require('./hdlc');
+
+/**
+ * Time to wait for the NCP to answer a probe at one baud rate
+ */
+const NCP_PROBE_TIMEOUT = 500; // in ms
+
+/**
+ * This function opens the NCP serial port at the given rate and
+ * sends a Spinel get of the protocol version. At a rate the NCP is
+ * not running, the request arrives as garbage that the NCP drops,
+ * and its answer (if any) fails the FCS check here.
+ * @param {string} path
+ * @param {number} baudRate
+ * @returns {Promise<boolean>} whether the NCP answered
+ */
+function probeNCP(path, baudRate) {
+  return new Promise(resolve => {
+    const header = SPINEL.HEADER_FLAG | 1;
+    const port = new SerialPort({path, baudRate, autoOpen: false});
+    let rest = Buffer.alloc(0);
+    let timer = null;
+    let done = false;
+
+    const finish = answered => {
+      if (done) {
+        return;
+      }
+      done = true;
+      clearTimeout(timer);
+      port.removeAllListeners('data');
+      if (port.isOpen) {
+        port.close(() => resolve(answered));
+      } else {
+        resolve(answered);
+      }
+    };
+
+    port.on('error', () => finish(false));
+    port.open(err => {
+      if (err) {
+        finish(false);
+        return;
+      }
+      port.on('data', chunk => {
+        const decoded = hdlcDecode(Buffer.concat([rest, chunk]));
+        rest = decoded.rest;
+        const answered = decoded.frames.some(
+          frame =>
+            frame.length >= 3 &&
+            frame[0] === header &&
+            frame[1] === SPINEL.CMD_PROP_VALUE_IS &&
+            frame[2] === SPINEL.PROP_PROTOCOL_VERSION
+        );
+        if (answered) {
+          finish(true);
+        }
+      });
+      timer = setTimeout(() => finish(false), NCP_PROBE_TIMEOUT);
+      port.write(
+        hdlcEncode(
+          Buffer.from([header, SPINEL.CMD_PROP_VALUE_GET, SPINEL.PROP_PROTOCOL_VERSION])
+        )
+      );
+    });
+  });
+}
 
 /**
  *
@@ -29,6 +96,7 @@ class BorderRouterManager {
       ignorePermissionErrors: true,
     });
     this.wfantundManager = new WfantundManager();
+    this.linkRate = CONSTANTS.NCP_DEFAULT_BAUD_RATE;
     this.ncpPropertyUpdateIntervalID;
     this.watcher
       .on('add', this.deviceAdded)
@@ -60,10 +128,13 @@ class BorderRouterManager {
    * update all the properties at times specified by the
    * APP_CONSTANTS.
    */
-  deviceAdded = () => {
+  deviceAdded = async () => {
     borderRouterLogger.info('Border router connected');
+    this.linkRate = await this.negotiateLinkRate();
+    ClientState.linkRate = this.linkRate;
+    borderRouterLogger.info(`NCP link rate ${this.linkRate} baud`);
     //TODO determine beahvior in the event that wfantund errors out (crashes)
-    this.wfantundManager.start();
+    this.wfantundManager.start(this.linkRate);
     this.connected = true;
     this.updateNCPProperties();
     this.updateTopology();
@@ -88,6 +159,35 @@ class BorderRouterManager {
     clearInterval(this.topologyUpdateIntervalID);
     borderRouterLogger.info('Border router disconnected');
     this.connected = false;
+    ClientState.linkRate = null;
+  };
+
+  /**
+   * Find the fastest rate the NCP answers on. The configured rates are
+   * probed from the highest down, and the first one that gets a valid
+   * Spinel reply becomes the link rate. If none answers, or only the
+   * default rate is configured, the default rate is used as before.
+   * In dev mode wfantund owns the port, so nothing is probed.
+   * @returns {Promise<number>}
+   */
+  negotiateLinkRate = async () => {
+    const rates = [...new Set(CONSTANTS.NCP_BAUD_RATES)].sort((a, b) => b - a);
+    const onlyDefault = rates.length === 1 && rates[0] === CONSTANTS.NCP_DEFAULT_BAUD_RATE;
+    if (CONSTANTS.MANUAL_DEV_MODE || onlyDefault) {
+      return CONSTANTS.NCP_DEFAULT_BAUD_RATE;
+    }
+    for (const rate of rates) {
+      if (await probeNCP(CONSTANTS.BR_FILE_PATH, rate)) {
+        return rate;
+      }
+      borderRouterLogger.debug(`NCP did not answer at ${rate} baud`);
+    }
+    borderRouterLogger.warning(
+      `NCP did not answer at any of ${rates.join(', ')} baud, using ${
+        CONSTANTS.NCP_DEFAULT_BAUD_RATE
+      }`
+    );
+    return CONSTANTS.NCP_DEFAULT_BAUD_RATE;
   };
 
   /**
@@ -152,7 +252,7 @@ class BorderRouterManager {
           reject(e);
         }
       }
-      const port = new SerialPort({baudRate: 115200, path: CONSTANTS.BR_FILE_PATH}, err => {
+      const port = new SerialPort({baudRate: this.linkRate, path: CONSTANTS.BR_FILE_PATH}, err => {
         if (err) {
           borderRouterLogger.error(`Serial Port Error ${err}`);
           return;
@@ -166,7 +266,7 @@ class BorderRouterManager {
               borderRouterLogger.error(`Serial Port Error ${err}`);
               reject('Failed to close Serial Port');
             }
-            this.wfantundManager.start();
+            this.wfantundManager.start(this.linkRate);
             resolve();
           });
         });
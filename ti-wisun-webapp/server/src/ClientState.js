@@ -83,6 +83,8 @@ const ClientState = {
   connected: false,
   // NCP Properties (from DBus API)
   ncpProperties: defaultNCPProperties(),
+  // Baud rate of the NCP UART link, null while the BR is disconnected
+  linkRate: null,
   // Auto ping settings
   autoPing: defaultAutoPing(),
 };
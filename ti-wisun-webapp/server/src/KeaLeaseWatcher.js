@@ -0,0 +1,182 @@
+const chokidar = require('chokidar');
+const fs = require('fs');
+const path = require('path');
+const {keaLogger} = require('./logger');
+const {CONSTANTS} = require('./AppConstants');
+const {deviceOperations} = require('./database');
+const {parseKeaLegalLine, macFromDuid} = require('./parsing');
+
+/**
+ * Kea names forensic log files <base-name>.<CCYYMMDD>.txt
+ */
+const KEA_LEGAL_LOG_GLOB = 'kea-legal.*.txt';
+
+/**
+ * Upper bound on remembered DUIDs, oldest entries are dropped first
+ */
+const MAX_TRACKED_CLIENTS = 1024;
+
+/**
+ *
+ * Register devices from DHCPv6 lease events instead of the
+ * connect_web_app CoAP request. Kea's forensic logging hook
+ * (see bp-files/kea-dhcp6.conf) writes a line with the vendor
+ * options of every request and a line with the leased address of
+ * every Reply. Both carry the client DUID, which holds the MAC.
+ *
+ */
+class KeaLeaseWatcher {
+  /**
+   * On creation, the log directory is watched for forensic log
+   * files. Files present at startup are read from the start, new
+   * data is read as Kea appends it.
+   * @param {SocketIOServer} io used to tell clients the device list changed
+   */
+  constructor(io) {
+    this.io = io;
+    this.fileOffsets = new Map();
+    this.partialLines = new Map();
+    this.pendingReads = new Map();
+    this.vendorOptionsByDuid = new Map();
+    this.registeredAddressByDuid = new Map();
+    this.watcher = chokidar.watch(path.join(CONSTANTS.KEA_LEGAL_LOG_DIR, KEA_LEGAL_LOG_GLOB), {
+      persistent: true,
+      ignorePermissionErrors: true,
+    });
+    this.watcher
+      .on('add', this.readNewData)
+      .on('change', this.readNewData)
+      .on('unlink', this.fileRemoved)
+      .on('error', function (error) {
+        keaLogger.error(error);
+      });
+  }
+
+  /**
+   * Queue a read of the data appended to filePath since the last
+   * read, so reads of one file never overlap.
+   * @param {string} filePath
+   */
+  readNewData = filePath => {
+    const previousRead = this.pendingReads.get(filePath) || Promise.resolve();
+    const read = previousRead
+      .then(() => this.readFile(filePath))
+      .catch(error => keaLogger.error(`Failed to read ${filePath}: ${error.message}`));
+    this.pendingReads.set(filePath, read);
+  };
+
+  /**
+   * Forget the read position of a removed (rotated) file
+   * @param {string} filePath
+   */
+  fileRemoved = filePath => {
+    this.fileOffsets.delete(filePath);
+    this.partialLines.delete(filePath);
+    this.pendingReads.delete(filePath);
+  };
+
+  /**
+   * Read and process the complete lines appended to filePath
+   * @param {string} filePath
+   */
+  async readFile(filePath) {
+    const {size} = await fs.promises.stat(filePath);
+    let offset = this.fileOffsets.get(filePath) || 0;
+    if (size < offset) {
+      // Truncated, start over
+      offset = 0;
+      this.partialLines.delete(filePath);
+    }
+    if (size === offset) {
+      return;
+    }
+
+    const fileHandle = await fs.promises.open(filePath, 'r');
+    const buffer = Buffer.alloc(size - offset);
+    try {
+      await fileHandle.read(buffer, 0, buffer.length, offset);
+    } finally {
+      await fileHandle.close();
+    }
+    this.fileOffsets.set(filePath, size);
+
+    const text = (this.partialLines.get(filePath) || '') + buffer.toString('utf8');
+    const lines = text.split('\n');
+    this.partialLines.set(filePath, lines.pop());
+    for (const line of lines) {
+      const record = parseKeaLegalLine(line);
+      if (record) {
+        await this.handleRecord(record);
+      }
+    }
+  }
+
+  /**
+   * Remember vendor options per DUID and register the device when
+   * it gets a new address
+   * @param {Object} record from parseKeaLegalLine
+   */
+  async handleRecord(record) {
+    if (record.type === 'vendor') {
+      this.rememberClient(this.vendorOptionsByDuid, record.duid, record.vendorOptions);
+      return;
+    }
+
+    const vendorOptions = this.vendorOptionsByDuid.get(record.duid);
+    // Only nodes sending our vendor options are registered, zero lifetime is a release
+    if (!vendorOptions || !vendorOptions.deviceClass || record.valid === 0) {
+      return;
+    }
+    // Renews keep the address, nothing to update
+    if (this.registeredAddressByDuid.get(record.duid) === record.address) {
+      return;
+    }
+    const mac = macFromDuid(record.duid);
+    if (!mac) {
+      keaLogger.warning(`No MAC address in DUID ${record.duid}`);
+      return;
+    }
+
+    keaLogger.info(
+      `Lease ${record.address} for ${mac}, class ${vendorOptions.deviceClass}, firmware ${vendorOptions.firmwareVersion}`
+    );
+    try {
+      await deviceOperations.ensureDeviceExists(
+        mac,
+        record.address,
+        'NEW DEVICE',
+        vendorOptions.deviceClass,
+        vendorOptions.deviceClass
+      );
+      this.rememberClient(this.registeredAddressByDuid, record.duid, record.address);
+      this.io.emit('devices_updated');
+    } catch (error) {
+      keaLogger.error(`Device registration failed for ${mac}: ${error.message}`);
+    }
+  }
+
+  /**
+   * Set map[duid] = value, dropping the oldest entry when full
+   * @param {Map} map
+   * @param {string} duid
+   * @param {*} value
+   */
+  rememberClient(map, duid, value) {
+    map.delete(duid);
+    if (map.size >= MAX_TRACKED_CLIENTS) {
+      map.delete(map.keys().next().value);
+    }
+    map.set(duid, value);
+  }
+
+  /**
+   * Stop watching the log directory
+   */
+  async exit() {
+    await this.watcher.close();
+  }
+}
+
+module.exports = {
+  KeaLeaseWatcher,
+};
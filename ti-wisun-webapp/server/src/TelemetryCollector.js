@@ -0,0 +1,159 @@
+const dgram = require('dgram');
+const {telemetryLogger} = require('./logger');
+const {CONSTANTS} = require('./AppConstants');
+const {telemetryOperations} = require('./database');
+const {parseTelemetry} = require('./parsing');
+
+/**
+ * Old samples are deleted this often
+ */
+const PRUNE_INTERVAL_MS = 60 * 60 * 1000;
+
+/**
+ * Upper bound on nodes followed, the longest silent is dropped first
+ */
+const MAX_TRACKED_NODES = 1024;
+
+/**
+ * This function applies a telemetry record to the state kept for
+ * its node and returns the samples to store. Gauges are stored as
+ * they are, counters as their increase since the previous record.
+ * The counter values are followed through the changes, when a
+ * record is lost or the node restarted they are only known again
+ * from the next keyframe.
+ * @param {Object} node state of the node, updated
+ * @param {Object} record from parseTelemetry
+ * @returns {Object[]|null} [{metric, value}], null for a duplicate
+ */
+function applyTelemetryRecord(node, record) {
+  if (node.seq === record.seq && node.uptimeSeconds === record.uptimeSeconds) {
+    return null;
+  }
+  const samples = [
+    {metric: 'heapSize', value: record.heapSize},
+    {metric: 'heapAllocated', value: record.heapAllocated},
+    {metric: 'heapAllocatedMax', value: record.heapAllocatedMax},
+    {metric: 'rank', value: record.rank},
+    {metric: 'devTableSize', value: record.devTableSize},
+    {metric: 'fhNtNumNodes', value: record.fhNtNumNodes},
+  ];
+  const restarted = node.uptimeSeconds !== undefined && record.uptimeSeconds < node.uptimeSeconds;
+  const inOrder = node.seq !== undefined && record.seq === ((node.seq + 1) & 0xffff);
+  const totals = restarted ? null : node.totals;
+
+  // Counters the node left out are 0 in a keyframe and unchanged otherwise
+  if (record.keyframe) {
+    if (totals) {
+      for (const metric of new Set([...Object.keys(totals), ...Object.keys(record.counters)])) {
+        const value = record.counters[metric] || 0;
+        samples.push({metric, value: (value - (totals[metric] || 0)) | 0});
+      }
+    }
+    node.totals = {...record.counters};
+  } else if (totals && inOrder) {
+    for (const [metric, delta] of Object.entries(record.counters)) {
+      samples.push({metric, value: delta});
+      totals[metric] = ((totals[metric] || 0) + delta) >>> 0;
+    }
+  } else {
+    node.totals = null;
+  }
+  node.seq = record.seq;
+  node.uptimeSeconds = record.uptimeSeconds;
+  return samples;
+}
+
+/**
+ *
+ * Receive the metrics pushed by TELEMETRY_ENABLE nodes and store
+ * them as time series, so the fleet can be graphed without polling
+ * every node's metrics resource.
+ *
+ */
+class TelemetryCollector {
+  /**
+   * On creation, the telemetry port is bound on all addresses
+   * and from then on old samples are pruned every PRUNE_INTERVAL_MS.
+   * @param {SocketIOServer} io used to tell clients new samples arrived
+   */
+  constructor(io) {
+    this.io = io;
+    this.nodes = new Map();
+    this.socket = dgram.createSocket({type: 'udp6', reuseAddr: true});
+    this.socket
+      .on('message', this.handleMessage)
+      .on('listening', () =>
+        telemetryLogger.info(`Listening on UDP port ${CONSTANTS.TELEMETRY_PORT}`)
+      )
+      .on('error', error => telemetryLogger.error(error));
+    this.socket.bind(CONSTANTS.TELEMETRY_PORT);
+    this.pruneTimer = setInterval(this.prune, PRUNE_INTERVAL_MS);
+  }
+
+  /**
+   * Decode a datagram and store its samples
+   * @param {Buffer} payload
+   * @param {Object} rinfo sender
+   */
+  handleMessage = async (payload, rinfo) => {
+    const ip = rinfo.address.split('%')[0];
+    const record = parseTelemetry(payload);
+    if (!record) {
+      telemetryLogger.warning(`Malformed telemetry from ${ip}, ${payload.length} bytes`);
+      return;
+    }
+
+    const node = this.nodes.get(ip) || {};
+    this.nodes.delete(ip);
+    if (this.nodes.size >= MAX_TRACKED_NODES) {
+      this.nodes.delete(this.nodes.keys().next().value);
+    }
+    this.nodes.set(ip, node);
+    const hadTotals = !!node.totals;
+    const samples = applyTelemetryRecord(node, record);
+    if (!samples) {
+      return;
+    }
+    if (hadTotals && !node.totals) {
+      telemetryLogger.info(
+        `Telemetry of ${ip} out of step at #${record.seq}, waiting for a keyframe`
+      );
+    }
+
+    const time = Date.now();
+    try {
+      await telemetryOperations.addSamples(samples.map(sample => ({ip, time, ...sample})));
+      this.io.emit('telemetry', {ip, time, samples});
+    } catch (error) {
+      telemetryLogger.error(`Failed to store telemetry of ${ip}: ${error.message}`);
+    }
+  };
+
+  /**
+   * Delete the samples older than the retention time
+   */
+  prune = async () => {
+    const retentionMs = CONSTANTS.TELEMETRY_RETENTION_DAYS * 24 * 60 * 60 * 1000;
+    try {
+      const {deleted} = await telemetryOperations.deleteSamplesBefore(Date.now() - retentionMs);
+      if (deleted) {
+        telemetryLogger.info(`Deleted ${deleted} telemetry samples`);
+      }
+    } catch (error) {
+      telemetryLogger.error(`Failed to prune telemetry: ${error.message}`);
+    }
+  };
+
+  /**
+   * Stop receiving
+   */
+  exit() {
+    clearInterval(this.pruneTimer);
+    this.socket.close();
+  }
+}
+
+module.exports = {
+  TelemetryCollector,
+  applyTelemetryRecord,
+};
@@ -0,0 +1,86 @@
+const dgram = require('dgram');
+const {timeSyncLogger} = require('./logger');
+const {CONSTANTS} = require('./AppConstants');
+const {parseTimeSyncRequest} = require('./parsing');
+
+const TIME_SYNC_VERSION = 1;
+const TIME_SYNC_TYPE_RESPONSE = 2;
+const TIME_SYNC_RESPONSE_LEN = 28;
+
+/**
+ * This function builds the answer to a time request,
+ * version(1) type(1) seq(2) t1(8) t2(8) t3(8), with the
+ * request's t1 echoed and this host's receive and send times
+ * in ms since the Unix epoch
+ * @param {Object} request from parseTimeSyncRequest
+ * @param {number} receiveTime t2
+ * @param {number} transmitTime t3
+ * @returns {Buffer}
+ */
+function timeSyncResponse(request, receiveTime, transmitTime) {
+  const response = Buffer.alloc(TIME_SYNC_RESPONSE_LEN);
+  response[0] = TIME_SYNC_VERSION;
+  response[1] = TIME_SYNC_TYPE_RESPONSE;
+  response.writeUInt16BE(request.seq, 2);
+  request.t1.copy(response, 4);
+  response.writeBigUInt64BE(BigInt(receiveTime), 12);
+  response.writeBigUInt64BE(BigInt(transmitTime), 20);
+  return response;
+}
+
+/**
+ *
+ * Answer the time requests of TIME_SYNC_ENABLE nodes, so the
+ * timestamps of their FSR events and light acknowledgements are
+ * in this host's clock and the latency of each event can be
+ * measured here. See firmware/src/time_sync.c for the node side.
+ *
+ */
+class TimeSyncServer {
+  /**
+   * On creation, the time sync port is bound on all addresses
+   */
+  constructor() {
+    this.socket = dgram.createSocket({type: 'udp6', reuseAddr: true});
+    this.socket
+      .on('message', this.handleMessage)
+      .on('listening', () =>
+        timeSyncLogger.info(`Listening on UDP port ${CONSTANTS.TIME_SYNC_PORT}`)
+      )
+      .on('error', error => timeSyncLogger.error(error));
+    this.socket.bind(CONSTANTS.TIME_SYNC_PORT);
+  }
+
+  /**
+   * Answer a request right away, the time it waits here is
+   * taken out of the round trip by the node
+   * @param {Buffer} payload
+   * @param {Object} rinfo sender
+   */
+  handleMessage = (payload, rinfo) => {
+    const receiveTime = Date.now();
+    const request = parseTimeSyncRequest(payload);
+    if (!request) {
+      timeSyncLogger.warning(`Malformed time request from ${rinfo.address}, ${payload.length} bytes`);
+      return;
+    }
+    const response = timeSyncResponse(request, receiveTime, Date.now());
+    this.socket.send(response, rinfo.port, rinfo.address, error => {
+      if (error) {
+        timeSyncLogger.error(`Failed to answer ${rinfo.address}: ${error.message}`);
+      }
+    });
+  };
+
+  /**
+   * Stop answering
+   */
+  exit() {
+    this.socket.close();
+  }
+}
+
+module.exports = {
+  TimeSyncServer,
+  timeSyncResponse,
+};
@@ -0,0 +1,28 @@
+const {TimeSyncServer} = require('./TimeSyncServer');
+
+/**
+ * Test that a short datagram is dropped without throwing in the
+ * socket listener, and that a request is answered with its t1 echoed
+ */
+function testHandleMessage() {
+  const server = new TimeSyncServer();
+  const sent = [];
+  server.socket.send = (response, port, address) => sent.push({response, port, address});
+  const rinfo = {address: '2020:abcd::212:4b00:1ca1:9463', port: 0xf0b2};
+
+  let threw = false;
+  try {
+    server.handleMessage(Buffer.from('0101', 'hex'), rinfo);
+  } catch (e) {
+    threw = true;
+  }
+  console.log(!threw && sent.length === 0);
+
+  server.handleMessage(Buffer.from('010100070000000000001234', 'hex'), rinfo);
+  console.log(sent.length === 1 && sent[0].address === rinfo.address && sent[0].port === rinfo.port);
+  console.log(sent[0].response.length === 28 && sent[0].response.readUInt16BE(2) === 7);
+  console.log(sent[0].response.readBigUInt64BE(4) === 0x1234n);
+  server.exit();
+}
+
+testHandleMessage();
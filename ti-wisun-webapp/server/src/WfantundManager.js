@@ -20,13 +20,18 @@ class WfantundManager {
   /**
    * Starts wfantund and logs the different outputs
    * to the file specified by the CONSTANTS.BR_FILE_PATH.
+   * @param {number} baudRate NCP UART rate, the default rate keeps the plain port path
    */
-  start() {
+  start(baudRate = CONSTANTS.NCP_DEFAULT_BAUD_RATE) {
     // Don't start wfantund while in dev mode
     if (CONSTANTS.MANUAL_DEV_MODE) return;
 
-    wfantundLogger.info('Starting wfantund');
-    this.wfantund = spawn(CONSTANTS.WFANTUND_PATH, ['-s', CONSTANTS.BR_FILE_PATH]);
+    const socketPath =
+      baudRate === CONSTANTS.NCP_DEFAULT_BAUD_RATE
+        ? CONSTANTS.BR_FILE_PATH
+        : `serial:${CONSTANTS.BR_FILE_PATH},raw,b${baudRate}`;
+    wfantundLogger.info(`Starting wfantund on ${socketPath}`);
+    this.wfantund = spawn(CONSTANTS.WFANTUND_PATH, ['-s', socketPath]);
     this.wfantund.on('error', () => {
       wfantundLogger.error('Failed to start wfantund');
     });
@@ -1,6 +1,6 @@
 const coap = require('coap');
 const {getTopology} = require('./ClientState');
-const {canonicalIPtoExpandedIP} = require('./parsing');
+const {canonicalIPtoExpandedIP, parseNeighborMetrics} = require('./parsing');
 const fs = require('fs');
 const { observe } = require('fast-json-patch');
 
@@ -91,7 +91,14 @@ function getLEDStates(targetIP) {
   getRequest.end();
 }
 
-function turnOnLightForSetTime(targetIP, time) {
+/**
+ * Turn the light at targetIP on for time seconds
+ * @param {string} targetIP
+ * @param {number} time
+ * @param {string} [traceId] of the event, the light echoes it in its response
+ * @param {function} [onAck] called with the response payload once the light answers
+ */
+function turnOnLightForSetTime(targetIP, time, traceId, onAck) {
   const reqOptions = {
     observe: false,
     host: targetIP,
@@ -101,6 +108,9 @@ function turnOnLightForSetTime(targetIP, time) {
     retrySend: 'true',
     options: {},
   };
+  if (traceId) {
+    reqOptions.query = `trace=${traceId}`;
+  }
 
   putPayload = [];
   putPayload.push(time);
@@ -108,6 +118,9 @@ function turnOnLightForSetTime(targetIP, time) {
   const postRequest = coap.request(reqOptions);
   postRequest.on('response', postResponse => {
     //console.log('received post response for external LEDs', postResponse.code);
+    if (onAck) {
+      onAck(postResponse.payload);
+    }
   });
   // BOTH OF THESE ARE REQUIRED -> COAP ERRORS OUT OTHERWISE
   postRequest.on('timeout', e => {});
@@ -190,12 +203,11 @@ function postLEDStates(targetIP, color, newValue) {
 /**
  * This function takes an IP address and sends a CoAP
  * request to the 'rssi' endpoint to retrieve the neighbor
- * rssi information. The retrieved information is an array of
- * 32 neighbor entries, where each neighbor entry contains
- * 8 bytes of MAC address, 1 byte for rssiIn, and 1 byte for
- * rssiOut. After retrieving the response, this function
- * determines the parent from the topology, and sets the corr.
- * link's rssi values based on the parent's neighbor entry.
+ * rssi information. The response holds a field per neighbor
+ * with its MAC address, rssiIn and rssiOut, see
+ * parseNeighborMetrics. After retrieving the response, this
+ * function determines the parent from the topology, and sets
+ * the corr. link's rssi values based on the parent's neighbor entry.
  * @param {IPAddress} targetIP
  */
 function getRSSIValues(targetIP) {
@@ -214,54 +226,30 @@ function getRSSIValues(targetIP) {
   const getRequest = coap.request(reqOptions);
   getRequest.on('response', getResponse => {
     console.log(`get response from rssi received, code: ${getResponse.code}`);
-    let rssiIn, rssiOut;
-    if (getResponse.payload.length > 0) {
-      const payload = getResponse.payload;
-      const MAX_NUM_NEIGHBORS = 32;
-      const BYTES_PER_NEIGHBOR_ENTRY = 10;
-
-      // Get the parent info (specifically the last 8 hex digits to compare to neighbor info)
-      const link = getTopology().graph.edges.find(edge => {
-        return edge.data.target === targetIP;
-      });
-      if (!link) {
-        return;
-      }
-      let parent = canonicalIPtoExpandedIP(link.data.source);
-      parent = parent.replaceAll(':', '');
-      parentLast8HexDigitsStr = parent.substring(parent.length - 8);
-
-      // Loop through all of the neighbor entries
-      for (let i = 0; i < MAX_NUM_NEIGHBORS; i++) {
-        const startingIndex = i * BYTES_PER_NEIGHBOR_ENTRY;
-
-        // If the mac is empty, this neighbor entry is empty so go to next neighbor
-        if (payload.readBigInt64BE(startingIndex) == 0) {
-          continue;
-        }
+    const neighbors = parseNeighborMetrics(getResponse.payload);
+    if (!neighbors) {
+      return;
+    }
 
-        // Get the mac address to see if this is the node's parent (first 8 bytes of neighbor info)
-        const neighborMacAddress = payload.slice(startingIndex, startingIndex + 8).toString('hex');
-        const neighborMacAddressLast8HexDigitsStr = neighborMacAddress.substring(
-          neighborMacAddress.length - 8
-        );
-
-        // Next byte is rssiIn
-        rssiIn = payload.readUInt8(startingIndex + 8);
-        // Next byte is rssiOut
-        rssiOut = payload.readUInt8(startingIndex + 9);
-
-        // console.log(
-        //   `Parent: ${parentLast8HexDigitsStr},\nChild: ${targetIP},\nNeighbor: ${neighborMacAddressLast8HexDigitsStr},\nRSSI IN: ${rssiIn}\nRSSI OUT: ${rssiOut}\n`
-        // );
-
-        // If last 8 hex digits are the same, this is the parent of this node
-        if (neighborMacAddressLast8HexDigitsStr === parentLast8HexDigitsStr) {
-          if (!link.data.time || date.getTime() > link.data.time) {
-            link.data.time = date.getTime();
-            link.data.rssiIn = rssiIn;
-            link.data.rssiOut = rssiOut;
-          }
+    // Get the parent info (specifically the last 8 hex digits to compare to neighbor info)
+    const link = getTopology().graph.edges.find(edge => {
+      return edge.data.target === targetIP;
+    });
+    if (!link) {
+      return;
+    }
+    let parent = canonicalIPtoExpandedIP(link.data.source);
+    parent = parent.replaceAll(':', '');
+    const parentLast8HexDigitsStr = parent.substring(parent.length - 8);
+
+    for (const neighbor of neighbors) {
+      // If last 8 hex digits are the same, this is the parent of this node
+      const neighborMac = neighbor.mac || '';
+      if (neighborMac.substring(neighborMac.length - 8) === parentLast8HexDigitsStr) {
+        if (!link.data.time || date.getTime() > link.data.time) {
+          link.data.time = date.getTime();
+          link.data.rssiIn = neighbor.rssiIn;
+          link.data.rssiOut = neighbor.rssiOut;
         }
       }
     }
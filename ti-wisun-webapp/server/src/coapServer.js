@@ -1,8 +1,35 @@
 const coap = require('coap');
-const { deviceOperations, relationshipOperations } = require('./database'); 
-const { httpLogger } = require('./logger'); 
+const crypto = require('crypto');
+const { deviceOperations, relationshipOperations, telemetryOperations } = require('./database'); 
+const { httpLogger, traceLogger } = require('./logger'); 
 const {BorderRouterManager} = require('./BorderRouterManager.js'); 
 const { turnOnLightForSetTime } = require('./coapCommands.js'); 
+const { parseFsrEvent, parseLightAck } = require('./parsing');
+
+/**
+ * Store the latency of an FSR event next to the telemetry, so it is
+ * read from /api/telemetry/<metric>. The times are in this host's
+ * clock, the nodes synchronize to it, see TimeSyncServer.js.
+ * @param {string} ip node the latency is of
+ * @param {string} metric
+ * @param {number} latency ms
+ */
+function storeEventLatency(ip, metric, latency) {
+    telemetryOperations.addSamples([{ ip, time: Date.now(), metric, value: latency }])
+        .catch(error => httpLogger.error(`Failed to store ${metric} of ${ip}: ${error.message}`));
+}
+
+/**
+ * Log that an FSR event reached a stage, one JSON object a line of
+ * trace.log. src/traceWaterfall.js builds the per event waterfalls
+ * and the per stage percentiles from them.
+ * @param {string} trace ID of the event
+ * @param {string} stage
+ * @param {Object} [fields] time defaults to now, node times are in this host's clock
+ */
+function traceStage(trace, stage, fields = {}) {
+    traceLogger.info(JSON.stringify({ trace, stage, time: Date.now(), ...fields }));
+}
 
 const server = coap.createServer(
     {
@@ -112,18 +139,28 @@ function startCoapServer(borderRouterManager, io) {
             }
         } else if (req.method === 'POST' && req.url === '/fsr_activated') {
             const sensorIPv6 = req.rsinfo.address;
+            const receivedTime = Date.now();
             let receivedDirection = -1;
 
-            try {
-                const directionInt = req.payload.readUInt8(0);
-                if (directionInt >= 0 && directionInt <= 3) {
-                    receivedDirection = directionInt;
-                    httpLogger.info(`Parsed ${sensorIPv6}'s direction from payload: ${receivedDirection}`);
-                } else {
-                    httpLogger.warn(`Invalid or missing 'direction' in FSR payload from ${sensorIPv6}.`);
-                }
-            } catch (error) {
-                httpLogger.error(`Failed to parse uint8 payload for FSR activation from ${sensorIPv6}: ${error.message}`);
+            const fsrEvent = parseFsrEvent(req.payload);
+            if (!fsrEvent) {
+                httpLogger.error(`Empty payload for FSR activation from ${sensorIPv6}`);
+            } else if (fsrEvent.direction <= 3) {
+                receivedDirection = fsrEvent.direction;
+                httpLogger.info(`Parsed ${sensorIPv6}'s direction from payload: ${receivedDirection}`);
+            } else {
+                httpLogger.warn(`Invalid or missing 'direction' in FSR payload from ${sensorIPv6}.`);
+            }
+            // Only nodes with a synchronized clock stamp their events, older nodes send no trace ID
+            const eventTime = fsrEvent ? fsrEvent.eventTime : null;
+            const traceId = (fsrEvent && fsrEvent.traceId) || crypto.randomBytes(4).toString('hex');
+            if (eventTime) {
+                traceStage(traceId, 'event', { time: eventTime, ip: sensorIPv6 });
+            }
+            traceStage(traceId, 'received', { time: receivedTime, ip: sensorIPv6 });
+            if (eventTime) {
+                httpLogger.info(`FSR event of ${sensorIPv6} took ${receivedTime - eventTime} ms to arrive`);
+                storeEventLatency(sensorIPv6, 'fsrUplinkMs', receivedTime - eventTime);
             }
 
             try {
@@ -136,6 +173,7 @@ function startCoapServer(borderRouterManager, io) {
                     return;
                 }
                 const sensorMac = sensorDevice.mac_address;
+                traceStage(traceId, 'sensorFound');
                 //httpLogger.info(`${sensorIPv6} fsr activation identified from sensor MAC: ${sensorMac}`);
 
                 // 2. Find relationships where this device is the sensor
@@ -148,6 +186,7 @@ function startCoapServer(borderRouterManager, io) {
                 } else {
                     httpLogger.warn(`Proceeding without direction filtering as it was not valid in payload for sensor ${sensorMac}.`);
                 }
+                traceStage(traceId, 'relationshipsFound', { count: relationships ? relationships.length : 0 });
 
                 if (!relationships || relationships.length === 0) {
                     httpLogger.info(`No relationships with direction ${receivedDirection} found for sensor MAC: ${sensorMac}`);
@@ -165,6 +204,7 @@ function startCoapServer(borderRouterManager, io) {
                     const actuatorMac = relationship.actuator_mac;
                     const actuatorDevice = await deviceOperations.getDeviceByMac(actuatorMac);
                     const setTime = relationship.set_time || 1;
+                    traceStage(traceId, 'actuatorFound', { actuator: actuatorMac });
 
                     if (!actuatorDevice) {
                         httpLogger.warn(`Actuator ${actuatorMac} in relationship ${relationship.id} not found in database.`);
@@ -190,8 +230,27 @@ function startCoapServer(borderRouterManager, io) {
                             httpLogger.error(`Error updating DB for relationship ${relationship.id} activation: ${dbUpdateError.message}`);
                         }
 
-                        // Trigger the light
-                        turnOnLightForSetTime(actuatorDevice.ipv6_address, setTime);
+                        // Trigger the light, a synchronized light answers with when it went on
+                        const sentTime = Date.now();
+                        traceStage(traceId, 'dispatched', { time: sentTime, actuator: actuatorMac });
+                        turnOnLightForSetTime(actuatorDevice.ipv6_address, setTime, traceId, payload => {
+                            const { onTime, traceId: echoedTraceId } = parseLightAck(payload);
+                            // The response comes once the light is on
+                            traceStage(traceId, 'acked', { actuator: actuatorMac });
+                            if (echoedTraceId && echoedTraceId !== traceId) {
+                                httpLogger.warning(`Light ${actuatorMac} answered trace ${echoedTraceId} for ${traceId}`);
+                            }
+                            if (!onTime) {
+                                return;
+                            }
+                            traceStage(traceId, 'applied', { time: onTime, actuator: actuatorMac });
+                            const actuatorIPv6 = actuatorDevice.ipv6_address;
+                            storeEventLatency(actuatorIPv6, 'lightDownlinkMs', onTime - sentTime);
+                            if (eventTime) {
+                                httpLogger.info(`Light ${actuatorMac} went on ${onTime - eventTime} ms after the FSR event of ${sensorMac}`);
+                                storeEventLatency(actuatorIPv6, 'fsrToLightMs', onTime - eventTime);
+                            }
+                        });
                         actuatorsTriggered++;
 
                         // Set a timer to deactivate
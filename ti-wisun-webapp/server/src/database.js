@@ -59,10 +59,31 @@ const initializeDatabase = () => {
           if (err) {
             httpLogger.error(`Failed to create relationships table: ${err.message}`);
             reject(err);
-          } else {
-            httpLogger.info('Database tables created successfully');
-            resolve(db);
+            return;
           }
+
+          // Create telemetry table, one row per metric of each pushed record
+          db.run(`CREATE TABLE IF NOT EXISTS telemetry (
+            ip TEXT NOT NULL,
+            time INTEGER NOT NULL,
+            metric TEXT NOT NULL,
+            value REAL NOT NULL
+          )`, (err) => {
+            if (err) {
+              httpLogger.error(`Failed to create telemetry table: ${err.message}`);
+              reject(err);
+              return;
+            }
+            db.run('CREATE INDEX IF NOT EXISTS telemetry_metric_time ON telemetry (metric, time)', (err) => {
+              if (err) {
+                httpLogger.error(`Failed to create telemetry index: ${err.message}`);
+                reject(err);
+              } else {
+                httpLogger.info('Database tables created successfully');
+                resolve(db);
+              }
+            });
+          });
         });
       });
     });
@@ -413,9 +434,80 @@ const relationshipOperations = {
   },
 };
 
+// Telemetry operations
+const telemetryOperations = {
+  // Store samples [{ip, time, metric, value}] in one transaction
+  addSamples: (samples) => {
+    return new Promise((resolve, reject) => {
+      const db = getDatabase();
+      db.serialize(() => {
+        db.run('BEGIN TRANSACTION');
+        const statement = db.prepare('INSERT INTO telemetry (ip, time, metric, value) VALUES (?, ?, ?, ?)');
+        samples.forEach(sample => statement.run([sample.ip, sample.time, sample.metric, sample.value]));
+        statement.finalize();
+        db.run('COMMIT', (err) => {
+          db.close();
+          if (err) {
+            reject(err);
+            return;
+          }
+          resolve({ added: samples.length });
+        });
+      });
+    });
+  },
+
+  // Samples of one metric since a time in ms, of every node unless ip is given
+  getSamples: (metric, since, ip) => {
+    return new Promise((resolve, reject) => {
+      const db = getDatabase();
+      const query = ip
+        ? 'SELECT ip, time, value FROM telemetry WHERE metric = ? AND time >= ? AND ip = ? ORDER BY time'
+        : 'SELECT ip, time, value FROM telemetry WHERE metric = ? AND time >= ? ORDER BY time';
+      db.all(query, ip ? [metric, since, ip] : [metric, since], (err, rows) => {
+        db.close();
+        if (err) {
+          reject(err);
+          return;
+        }
+        resolve(rows);
+      });
+    });
+  },
+
+  getMetricNames: () => {
+    return new Promise((resolve, reject) => {
+      const db = getDatabase();
+      db.all('SELECT DISTINCT metric FROM telemetry ORDER BY metric', [], (err, rows) => {
+        db.close();
+        if (err) {
+          reject(err);
+          return;
+        }
+        resolve(rows.map(row => row.metric));
+      });
+    });
+  },
+
+  deleteSamplesBefore: (time) => {
+    return new Promise((resolve, reject) => {
+      const db = getDatabase();
+      db.run('DELETE FROM telemetry WHERE time < ?', [time], function(err) {
+        db.close();
+        if (err) {
+          reject(err);
+          return;
+        }
+        resolve({ deleted: this.changes });
+      });
+    });
+  },
+};
+
 module.exports = {
   initializeDatabase,
   getDatabase,
   deviceOperations,
   relationshipOperations,
+  telemetryOperations,
 };
@@ -0,0 +1,93 @@
+/**
+ * HDLC-lite framing used by Spinel on the NCP UART:
+ * frames are delimited by 0x7E, 0x7E and 0x7D are escaped
+ * as 0x7D followed by the byte xor 0x20, and the payload is
+ * followed by its CRC-16/X.25 (FCS), least significant byte first.
+ */
+const HDLC_FLAG = 0x7e;
+const HDLC_ESCAPE = 0x7d;
+const HDLC_ESCAPE_XOR = 0x20;
+
+/**
+ * Spinel command and property ids used by the webapp
+ */
+const SPINEL = {
+  HEADER_FLAG: 0x80,
+  CMD_RESET: 0x01,
+  CMD_PROP_VALUE_GET: 0x02,
+  CMD_PROP_VALUE_IS: 0x06,
+  PROP_PROTOCOL_VERSION: 0x01,
+};
+
+/**
+ * This function computes the HDLC FCS (CRC-16/X.25) of the data
+ * @param {Buffer} data
+ * @returns {number}
+ */
+function hdlcFCS(data) {
+  let fcs = 0xffff;
+  for (const byte of data) {
+    fcs ^= byte;
+    for (let bit = 0; bit < 8; bit++) {
+      fcs = fcs & 1 ? (fcs >>> 1) ^ 0x8408 : fcs >>> 1;
+    }
+  }
+  return fcs ^ 0xffff;
+}
+
+/**
+ * This function wraps a Spinel frame for the UART
+ * @param {Buffer} payload
+ * @returns {Buffer}
+ */
+function hdlcEncode(payload) {
+  const fcs = hdlcFCS(payload);
+  const raw = Buffer.concat([payload, Buffer.from([fcs & 0xff, fcs >>> 8])]);
+  const bytes = [HDLC_FLAG];
+  for (const byte of raw) {
+    if (byte === HDLC_FLAG || byte === HDLC_ESCAPE) {
+      bytes.push(HDLC_ESCAPE, byte ^ HDLC_ESCAPE_XOR);
+    } else {
+      bytes.push(byte);
+    }
+  }
+  bytes.push(HDLC_FLAG);
+  return Buffer.from(bytes);
+}
+
+/**
+ * This function splits received UART data into Spinel frames.
+ * Frames with a bad FCS are dropped, and the bytes after the last
+ * flag are returned so they can be prepended to the next chunk.
+ * @param {Buffer} data
+ * @returns {{frames: Buffer[], rest: Buffer}}
+ */
+function hdlcDecode(data) {
+  const frames = [];
+  let start = 0;
+  for (let i = 0; i < data.length; i++) {
+    if (data[i] !== HDLC_FLAG) {
+      continue;
+    }
+    const bytes = [];
+    for (let j = start; j < i; j++) {
+      if (data[j] === HDLC_ESCAPE && j + 1 < i) {
+        bytes.push(data[++j] ^ HDLC_ESCAPE_XOR);
+      } else {
+        bytes.push(data[j]);
+      }
+    }
+    start = i + 1;
+    if (bytes.length < 3) {
+      continue;
+    }
+    const frame = Buffer.from(bytes);
+    const payload = frame.subarray(0, frame.length - 2);
+    if (hdlcFCS(payload) === frame.readUInt16LE(frame.length - 2)) {
+      frames.push(payload);
+    }
+  }
+  return {frames, rest: data.subarray(start)};
+}
+
+module.exports = {SPINEL, hdlcFCS, hdlcEncode, hdlcDecode};
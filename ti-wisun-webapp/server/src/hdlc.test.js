@@ -0,0 +1,28 @@
+const {SPINEL, hdlcEncode, hdlcDecode} = require('./hdlc');
+
+/**
+ * Test that the Spinel reset frame sent by the BorderRouterManager is encoded
+ */
+function testHdlcEncodeReset() {
+  const frame = hdlcEncode(Buffer.from([SPINEL.HEADER_FLAG | 1, SPINEL.CMD_RESET]));
+  console.log(frame.toString('hex') === '7e8101da8b7e');
+}
+
+/**
+ * Test that frames split over chunks, escaped bytes and bad FCS are handled
+ */
+function testHdlcDecode() {
+  const payload = Buffer.from([0x81, 0x06, 0x01, 0x7e, 0x7d, 0x04]);
+  const frame = hdlcEncode(payload);
+  const corrupt = Buffer.from(frame);
+  corrupt[3] ^= 0xff;
+
+  const first = hdlcDecode(Buffer.concat([corrupt, frame.subarray(0, 5)]));
+  console.log(first.frames.length === 0);
+  const second = hdlcDecode(Buffer.concat([first.rest, frame.subarray(5)]));
+  console.log(second.frames.length === 1 && second.frames[0].equals(payload));
+  console.log(second.rest.length === 0);
+}
+
+testHdlcEncodeReset();
+testHdlcDecode();
@@ -3,6 +3,9 @@ const {httpLogger} = require('./logger.js');
 const {initializeRoutes} = require('./routes.js');
 const {startCoapServer} = require('./coapServer.js');
 const {BorderRouterManager} = require('./BorderRouterManager.js');
+const {KeaLeaseWatcher} = require('./KeaLeaseWatcher.js');
+const {TelemetryCollector} = require('./TelemetryCollector.js');
+const {TimeSyncServer} = require('./TimeSyncServer.js');
 const {getPingExecutor} = require('./PingExecutor.js');
 const http = require('http');
 const SocketIOServer = require('socket.io').Server;
@@ -47,6 +50,15 @@ function main() {
   const pingExecutor = getPingExecutor();
   initializeRoutes(app, pingExecutor, brManager, io);
   startCoapServer(brManager, io);
+  if (CONSTANTS.KEA_LEGAL_LOG_DIR) {
+    new KeaLeaseWatcher(io);
+  }
+  if (CONSTANTS.TELEMETRY_PORT) {
+    new TelemetryCollector(io);
+  }
+  if (CONSTANTS.TIME_SYNC_PORT) {
+    new TimeSyncServer();
+  }
 
   httpServer.listen(CONSTANTS.PORT, CONSTANTS.HOST, () => {
     httpLogger.info(`Listening on http://${CONSTANTS.HOST}:${CONSTANTS.PORT}`);
@@ -83,6 +83,10 @@ const pingLogger = makeLogger('PING');
 const wfantundLogger = makeLogger('WFANTUND', false, 'wfantund.log');
 const borderRouterLogger = makeLogger('BORDER ROUTER');
 const appStateLogger = makeLogger('APP_STATE');
+const keaLogger = makeLogger('KEA');
+const telemetryLogger = makeLogger('TELEMETRY');
+const timeSyncLogger = makeLogger('TIME_SYNC');
+const traceLogger = makeLogger('TRACE', false, 'trace.log');
 
 module.exports = {
   dbusLogger,
@@ -92,4 +96,8 @@ module.exports = {
   wfantundLogger,
   borderRouterLogger,
   appStateLogger,
+  keaLogger,
+  telemetryLogger,
+  timeSyncLogger,
+  traceLogger,
 };
@@ -0,0 +1,249 @@
+const coap = require('coap');
+const http = require('http');
+const {Command} = require('commander');
+const {parseMplLatency, mplLatencyBucketHigh} = require('./parsing.js');
+
+/**
+ * Fleet MPL latency report.
+ *
+ * Nodes built with WISUN_TEST_MPL_UDP keep a histogram of the latency of
+ * the MPL test multicasts they receive and serve it on the 'mpllat' CoAP
+ * resource. This script reads the histogram of every node, merges the
+ * buckets and prints per node and fleet wide percentiles.
+ *
+ * Nodes are taken from the topology of the running webapp unless
+ * addresses are given on the command line:
+ *   npm run mpl-report -- [-w http://localhost:80] [--reset] [ip...]
+ */
+const MPL_LATENCY_URI = 'mpllat';
+
+/**
+ * Requests in flight at once, the mesh does not like bursts
+ */
+const MAX_PARALLEL_REQUESTS = 4;
+
+/**
+ * This function returns the connected device addresses
+ * from the /topology endpoint of the running webapp.
+ * @param {string} webappURL
+ * @returns {Promise<string[]>}
+ */
+function getTopologyIPs(webappURL) {
+  return new Promise((resolve, reject) => {
+    http
+      .get(`${webappURL}/topology`, res => {
+        let body = '';
+        res.on('data', chunk => (body += chunk));
+        res.on('end', () => {
+          try {
+            resolve(JSON.parse(body).connectedDevices);
+          } catch (e) {
+            reject(e);
+          }
+        });
+      })
+      .on('error', reject);
+  });
+}
+
+/**
+ * This function sends a CoAP request to the MPL latency
+ * resource of a node and resolves with the response, or
+ * null if the node did not answer in time.
+ * @param {string} targetIP
+ * @param {string} method
+ * @param {number} timeoutMs
+ * @returns {Promise<Object|null>}
+ */
+function mplLatencyRequest(targetIP, method, timeoutMs) {
+  return new Promise(resolve => {
+    const reqOptions = {
+      observe: false,
+      host: targetIP,
+      pathname: MPL_LATENCY_URI,
+      method,
+      confirmable: true,
+      retrySend: 0,
+      options: {},
+    };
+    const timer = setTimeout(() => resolve(null), timeoutMs);
+    const request = coap.request(reqOptions);
+    request.on('response', response => {
+      clearTimeout(timer);
+      resolve(response);
+    });
+    // BOTH OF THESE ARE REQUIRED -> COAP ERRORS OUT OTHERWISE
+    request.on('timeout', () => {});
+    request.on('error', () => {});
+    request.end();
+  });
+}
+
+/**
+ * This function runs the handler over all addresses with
+ * at most MAX_PARALLEL_REQUESTS outstanding.
+ * @param {string[]} ips
+ * @param {function} handler
+ * @returns {Promise<Array>} results in the order of ips
+ */
+async function forEachNode(ips, handler) {
+  const results = new Array(ips.length);
+  let next = 0;
+  const worker = async () => {
+    while (next < ips.length) {
+      const i = next++;
+      results[i] = await handler(ips[i]);
+    }
+  };
+  await Promise.all(Array.from({length: Math.min(MAX_PARALLEL_REQUESTS, ips.length)}, worker));
+  return results;
+}
+
+/**
+ * This function estimates a percentile from histogram buckets
+ * the way the nodes do: the top of the bucket holding the rank,
+ * clamped to the recorded min and max.
+ * @param {Map<number, number>} buckets bucket index to count
+ * @param {number} subBits
+ * @param {number} percent
+ * @param {number} min
+ * @param {number} max
+ * @returns {number}
+ */
+function bucketPercentile(buckets, subBits, percent, min, max) {
+  const indexes = [...buckets.keys()].sort((a, b) => a - b);
+  const total = indexes.reduce((sum, index) => sum + buckets.get(index), 0);
+  if (total === 0) {
+    return 0;
+  }
+  const rank = Math.ceil((total * percent) / 100);
+  let seen = 0;
+  for (const index of indexes) {
+    seen += buckets.get(index);
+    if (seen >= rank) {
+      return Math.min(Math.max(mplLatencyBucketHigh(index, subBits), min), max);
+    }
+  }
+  return max;
+}
+
+/**
+ * This function merges the node histograms into one
+ * fleet histogram. Records with a different bucket layout
+ * than the first one cannot be merged and are skipped.
+ * @param {Object[]} records parsed with parseMplLatency
+ * @returns {Object|null}
+ */
+function mergeMplLatency(records) {
+  const usable = records.filter(record => record.count > 0);
+  if (usable.length === 0) {
+    return null;
+  }
+  const subBits = usable[0].subBits;
+  const buckets = new Map();
+  const fleet = {count: 0, min: Infinity, max: 0, sum: 0, nodes: 0};
+  for (const record of usable) {
+    if (record.subBits !== subBits) {
+      continue;
+    }
+    fleet.nodes++;
+    fleet.count += record.count;
+    fleet.sum += record.mean * record.count;
+    fleet.min = Math.min(fleet.min, record.min);
+    fleet.max = Math.max(fleet.max, record.max);
+    record.buckets.forEach(({index, count}) => {
+      buckets.set(index, (buckets.get(index) || 0) + count);
+    });
+  }
+  return {
+    nodes: fleet.nodes,
+    count: fleet.count,
+    min: fleet.min,
+    max: fleet.max,
+    mean: Math.round(fleet.sum / fleet.count),
+    p50: bucketPercentile(buckets, subBits, 50, fleet.min, fleet.max),
+    p90: bucketPercentile(buckets, subBits, 90, fleet.min, fleet.max),
+    p99: bucketPercentile(buckets, subBits, 99, fleet.min, fleet.max),
+  };
+}
+
+/**
+ * This function prints one line of the report table.
+ * @param {string} name
+ * @param {Object} stats
+ */
+function printRow(name, stats) {
+  const columns = ['count', 'min', 'p50', 'p90', 'p99', 'max', 'mean'].map(key =>
+    String(stats[key]).padStart(8)
+  );
+  console.log(`${name.padEnd(40)}${columns.join('')}`);
+}
+
+async function main() {
+  const program = new Command();
+  program
+    .option('-w, --webapp <url>', 'Webapp to read the node list from', 'http://localhost:80')
+    .option('-t, --timeout <seconds>', 'Time to wait for each node', '10')
+    .option('-r, --reset', 'Reset the node histograms after reading them')
+    .option('-j, --json', 'Print the report as JSON')
+    .argument('[ips...]', 'Node addresses, instead of the webapp topology');
+  program.parse(process.argv);
+  const options = program.opts();
+  const timeoutMs = parseInt(options.timeout, 10) * 1000;
+
+  let ips = program.args;
+  if (ips.length === 0) {
+    ips = await getTopologyIPs(options.webapp);
+  }
+
+  const records = await forEachNode(ips, async ip => {
+    const response = await mplLatencyRequest(ip, 'get', timeoutMs);
+    if (!response || response.code !== '2.05') {
+      return null;
+    }
+    const record = parseMplLatency(response.payload);
+    if (record && options.reset) {
+      await mplLatencyRequest(ip, 'put', timeoutMs);
+    }
+    return record;
+  });
+
+  const fleet = mergeMplLatency(records.filter(record => record));
+  if (options.json) {
+    const nodes = Object.fromEntries(ips.map((ip, i) => [ip, records[i]]));
+    console.log(JSON.stringify({fleet, nodes}, null, 2));
+    return;
+  }
+
+  printRow('node', {
+    count: 'count',
+    min: 'min',
+    p50: 'p50',
+    p90: 'p90',
+    p99: 'p99',
+    max: 'max',
+    mean: 'mean',
+  });
+  ips.forEach((ip, i) => {
+    if (!records[i]) {
+      console.log(`${ip.padEnd(40)}no response`);
+    } else {
+      printRow(ip, records[i]);
+    }
+  });
+  if (fleet) {
+    printRow(`fleet (${fleet.nodes} nodes)`, fleet);
+  }
+}
+
+if (require.main === module) {
+  main().then(
+    () => process.exit(0),
+    e => {
+      console.error(e.message);
+      process.exit(1);
+    }
+  );
+}
+
+module.exports = {mergeMplLatency, bucketPercentile, getTopologyIPs, forEachNode};
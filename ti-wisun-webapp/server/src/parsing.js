@@ -194,6 +194,748 @@ function parseChList(text) {
   else return finalString;
 }
 
+/**
+ * Vendor-specific Information sub-options sent by the nodes in DHCPv6
+ * option 17 (enterprise 294), see firmware/src/dhcpv6_client_service.c
+ */
+const VENDOR_ENTERPRISE_NUMBER = 294;
+const VENDOR_SUB_OPTIONS = {
+  1: 'deviceClass',
+  2: 'firmwareVersion',
+  3: 'capabilities',
+  4: 'channelCount',
+};
+
+/**
+ * This function takes the hex data of a DHCPv6 Vendor-specific
+ * Information option (enterprise number followed by sub-options)
+ * and decodes the known sub-options. Unknown sub-options are skipped.
+ * @param {string} hex
+ * @returns {Object|null} null if the option is not ours or is malformed
+ */
+function parseVendorOptions(hex) {
+  const data = Buffer.from(hex, 'hex');
+  if (data.length < 4 || data.readUInt32BE(0) !== VENDOR_ENTERPRISE_NUMBER) {
+    return null;
+  }
+  const vendorOptions = {};
+  let offset = 4;
+  while (offset + 4 <= data.length) {
+    const code = data.readUInt16BE(offset);
+    const length = data.readUInt16BE(offset + 2);
+    offset += 4;
+    if (offset + length > data.length) {
+      return null;
+    }
+    const value = data.subarray(offset, offset + length);
+    const name = VENDOR_SUB_OPTIONS[code];
+    if (name === 'deviceClass' || name === 'firmwareVersion') {
+      vendorOptions[name] = value.toString('utf8');
+    } else if (name === 'capabilities' && length === 2) {
+      vendorOptions[name] = value.readUInt16BE(0);
+    } else if (name === 'channelCount' && length === 1) {
+      vendorOptions[name] = value.readUInt8(0);
+    }
+    offset += length;
+  }
+  return vendorOptions;
+}
+
+/**
+ * This function takes a client DUID in hex and returns the link layer
+ * address formatted as AA:BB:..., the same format the CoAP registration
+ * uses. Only DUID-LLT (1) and DUID-LL (3) carry a link layer address.
+ * @param {string} duidHex
+ * @returns {string|null}
+ */
+function macFromDuid(duidHex) {
+  const duid = Buffer.from(duidHex, 'hex');
+  if (duid.length < 4) {
+    return null;
+  }
+  const duidType = duid.readUInt16BE(0);
+  let mac;
+  if (duidType === 3) {
+    mac = duid.subarray(4);
+  } else if (duidType === 1 && duid.length > 8) {
+    mac = duid.subarray(8);
+  } else {
+    return null;
+  }
+  if (mac.length !== 6 && mac.length !== 8) {
+    return null;
+  }
+  return mac.toString('hex').toUpperCase().match(/.{2}/g).join(':');
+}
+
+/**
+ * This function takes a line of the Kea forensic (legal) log written
+ * with the wisun parser formats in bp-files/kea-dhcp6.conf and returns
+ * the vendor or lease record it carries. Kea prefixes each entry with a
+ * timestamp, so only the part from the wisun- tag on is parsed.
+ * @param {string} line
+ * @returns {Object|null}
+ */
+function parseKeaLegalLine(line) {
+  const match = line.match(/wisun-(vendor|lease)((?:\s+\w+=\S*)+)/);
+  if (!match) {
+    return null;
+  }
+  const fields = {};
+  match[2]
+    .trim()
+    .split(/\s+/)
+    .forEach(field => {
+      const [key, value] = field.split('=');
+      fields[key] = value;
+    });
+  if (!fields.duid) {
+    return null;
+  }
+
+  if (match[1] === 'vendor') {
+    const vendorOptions = fields.opts ? parseVendorOptions(fields.opts) : null;
+    if (!vendorOptions) {
+      return null;
+    }
+    return {type: 'vendor', duid: fields.duid, vendorOptions};
+  }
+
+  const valid = parseInt(fields.valid, 10);
+  if (!fields.addr || isNaN(valid)) {
+    return null;
+  }
+  return {type: 'lease', duid: fields.duid, address: fields.addr, valid};
+}
+
+/**
+ * Version of the MPL latency histogram record served by the nodes on the
+ * 'mpllat' CoAP resource, see MPL_LAT_RECORD_VERSION in firmware/src/application.c
+ */
+const MPL_LATENCY_RECORD_VERSION = 1;
+const MPL_LATENCY_SUMMARY_LEN = 31;
+
+/**
+ * This function returns the highest latency (ms) counted in a bucket of
+ * the node MPL latency histogram. Buckets below 2 << subBits hold one
+ * value each, above that every power of two range has 1 << subBits buckets.
+ * @param {number} index
+ * @param {number} subBits
+ * @returns {number}
+ */
+function mplLatencyBucketHigh(index, subBits) {
+  const subCount = 1 << subBits;
+  if (index < 2 * subCount) {
+    return index;
+  }
+  const shift = Math.floor(index / subCount) - 1;
+  return ((index % subCount) + subCount + 1) * 2 ** shift - 1;
+}
+
+/**
+ * This function takes the payload of the 'mpllat' CoAP resource and
+ * decodes the latency summary and the non-empty histogram buckets.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the record is malformed or of another version
+ */
+function parseMplLatency(payload) {
+  if (
+    payload.length < MPL_LATENCY_SUMMARY_LEN ||
+    payload.readUInt8(0) !== MPL_LATENCY_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numBuckets = payload.readUInt8(30);
+  if (payload.length < MPL_LATENCY_SUMMARY_LEN + 3 * numBuckets) {
+    return null;
+  }
+  const buckets = [];
+  for (let i = 0; i < numBuckets; i++) {
+    const offset = MPL_LATENCY_SUMMARY_LEN + 3 * i;
+    buckets.push({index: payload.readUInt8(offset), count: payload.readUInt16BE(offset + 1)});
+  }
+  return {
+    subBits: payload.readUInt8(1),
+    count: payload.readUInt32BE(2),
+    min: payload.readUInt32BE(6),
+    max: payload.readUInt32BE(10),
+    mean: payload.readUInt32BE(14),
+    p50: payload.readUInt32BE(18),
+    p90: payload.readUInt32BE(22),
+    p99: payload.readUInt32BE(26),
+    buckets,
+  };
+}
+
+/**
+ * Version of the task stack and CPU record served on the 'tasks' CoAP
+ * resource and carried in 'metrics', see TASK_STATS_RECORD_VERSION
+ * in firmware/src/task_stats.c
+ */
+const TASK_STATS_RECORD_VERSION = 1;
+const TASK_STATS_HEADER_LEN = 4;
+const TASK_STATS_ENTRY_LEN = 7;
+
+/**
+ * This function takes a task stats record and decodes the CPU load and
+ * the stack size, free stack at the high water mark and CPU load of each
+ * task. Loads are in percent. A stack size of 0 means the RTOS does not
+ * report it.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the record is malformed or of another version
+ */
+function parseTaskStats(payload) {
+  if (
+    payload.length < TASK_STATS_HEADER_LEN ||
+    payload.readUInt8(0) !== TASK_STATS_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numTasks = payload.readUInt8(1);
+  if (payload.length < TASK_STATS_HEADER_LEN + TASK_STATS_ENTRY_LEN * numTasks) {
+    return null;
+  }
+  const tasks = [];
+  for (let i = 0; i < numTasks; i++) {
+    const offset = TASK_STATS_HEADER_LEN + TASK_STATS_ENTRY_LEN * i;
+    tasks.push({
+      priority: payload.readUInt8(offset),
+      stackSize: payload.readUInt16BE(offset + 1),
+      stackFree: payload.readUInt16BE(offset + 3),
+      cpuLoad: payload.readUInt16BE(offset + 5) / 100,
+    });
+  }
+  return {cpuLoad: payload.readUInt16BE(2) / 100, tasks};
+}
+
+/**
+ * Version of the heap record served on the 'heap' CoAP resource of
+ * HEAP_TRACK_ENABLE builds, see HEAP_TRACK_RECORD_VERSION in
+ * firmware/src/heap_track.c
+ */
+const HEAP_TRACK_RECORD_VERSION = 1;
+const HEAP_TRACK_HEADER_LEN = 24;
+const HEAP_TRACK_ENTRY_LEN = 18;
+
+/**
+ * This function takes a heap record and decodes the fragmentation of the
+ * heap and the allocation sites holding the most memory. A site is the
+ * code address the allocation returns to, look it up in the map file of
+ * the image. Address 0 collects the sites that did not fit the table.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the record is malformed or of another version
+ */
+function parseHeapTrack(payload) {
+  if (
+    payload.length < HEAP_TRACK_HEADER_LEN ||
+    payload.readUInt8(0) !== HEAP_TRACK_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numSites = payload.readUInt8(1);
+  if (payload.length < HEAP_TRACK_HEADER_LEN + HEAP_TRACK_ENTRY_LEN * numSites) {
+    return null;
+  }
+  const sites = [];
+  for (let i = 0; i < numSites; i++) {
+    const offset = HEAP_TRACK_HEADER_LEN + HEAP_TRACK_ENTRY_LEN * i;
+    sites.push({
+      address: '0x' + payload.readUInt32BE(offset).toString(16).padStart(8, '0'),
+      liveBytes: payload.readUInt32BE(offset + 4),
+      peakBytes: payload.readUInt32BE(offset + 8),
+      allocs: payload.readUInt32BE(offset + 12),
+      liveBlocks: payload.readUInt16BE(offset + 16),
+    });
+  }
+  return {
+    freeBlocks: payload.readUInt16BE(2),
+    largestFreeBlock: payload.readUInt32BE(4),
+    heapSize: payload.readUInt32BE(8),
+    allocatedBytes: payload.readUInt32BE(12),
+    allocatedBytesMax: payload.readUInt32BE(16),
+    allocFailures: payload.readUInt32BE(20),
+    sites,
+  };
+}
+
+/**
+ * Version of the link quality record served on the 'linkq' CoAP resource
+ * of LINK_QUALITY_ENABLE builds, see LINK_QUALITY_RECORD_VERSION in
+ * firmware/src/link_quality.c
+ */
+const LINK_QUALITY_RECORD_VERSION = 1;
+const LINK_QUALITY_HEADER_LEN = 3;
+const LINK_QUALITY_UNKNOWN = -32768;
+
+/**
+ * This function takes a link quality record and decodes the signal level
+ * and transmission trends of each neighbor. RSSI values are in dBm and
+ * null until the first sample, the ETX is null until the first unicast.
+ * A tx history entry is the attempts a frame took, 0 if it failed.
+ * @param {Buffer} payload
+ * @returns {Object[]|null} null if the record is malformed or of another version
+ */
+function parseLinkQuality(payload) {
+  if (
+    payload.length < LINK_QUALITY_HEADER_LEN ||
+    payload.readUInt8(0) !== LINK_QUALITY_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numNeighbors = payload.readUInt8(1);
+  const samples = payload.readUInt8(2);
+  const entryLen = 20 + 2 * samples;
+  if (payload.length < LINK_QUALITY_HEADER_LEN + entryLen * numNeighbors) {
+    return null;
+  }
+  const rssi = value => (value === LINK_QUALITY_UNKNOWN ? null : value / 16);
+  const neighbors = [];
+  for (let i = 0; i < numNeighbors; i++) {
+    const offset = LINK_QUALITY_HEADER_LEN + entryLen * i;
+    const rssiCount = Math.min(payload.readUInt8(offset + 18), samples);
+    const txOffset = offset + 19 + samples;
+    const txCount = Math.min(payload.readUInt8(txOffset), samples);
+    const etx = payload.readUInt16BE(offset + 12);
+    neighbors.push({
+      eui64: payload.toString('hex', offset, offset + 8),
+      rssiIn: rssi(payload.readInt16BE(offset + 8)),
+      rssiOut: rssi(payload.readInt16BE(offset + 10)),
+      etx: etx === 0 ? null : etx / 128,
+      txOk: payload.readUInt16BE(offset + 14),
+      txFailed: payload.readUInt16BE(offset + 16),
+      rssiHistory: Array.from({length: rssiCount}, (_, j) => payload.readInt8(offset + 19 + j)),
+      txHistory: Array.from({length: txCount}, (_, j) => payload.readUInt8(txOffset + 1 + j)),
+    });
+  }
+  return neighbors;
+}
+
+/**
+ * Version of the RPL event record served on the 'rplev' CoAP resource of
+ * RPL_EVENTS_ENABLE builds, see RPL_EVENTS_RECORD_VERSION in
+ * firmware/src/rpl_events.c
+ */
+const RPL_EVENTS_RECORD_VERSION = 1;
+const RPL_EVENTS_HEADER_LEN = 30;
+const RPL_EVENTS_ENTRY_LEN = 32;
+
+/**
+ * This function takes an RPL event record and decodes the parent, rank and
+ * DODAG version changes it holds along with the DIO/DAO counters. Times are
+ * milliseconds since the node booted modulo 2^32, timeMs is the time of the read. Events
+ * between a cursor and oldestSeq were overwritten before they were read.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the record is malformed or of another version
+ */
+function parseRplEvents(payload) {
+  if (
+    payload.length < RPL_EVENTS_HEADER_LEN ||
+    payload.readUInt8(0) !== RPL_EVENTS_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numEvents = payload.readUInt8(1);
+  if (payload.length < RPL_EVENTS_HEADER_LEN + RPL_EVENTS_ENTRY_LEN * numEvents) {
+    return null;
+  }
+  const events = [];
+  for (let i = 0; i < numEvents; i++) {
+    const offset = RPL_EVENTS_HEADER_LEN + RPL_EVENTS_ENTRY_LEN * i;
+    const changes = payload.readUInt8(offset + 8);
+    events.push({
+      seq: payload.readUInt32BE(offset),
+      timeMs: payload.readUInt32BE(offset + 4),
+      parentChanged: (changes & 0x01) !== 0,
+      rankChanged: (changes & 0x02) !== 0,
+      versionChanged: (changes & 0x04) !== 0,
+      detached: (changes & 0x08) !== 0,
+      dodagVersion: payload.readUInt8(offset + 9),
+      rank: payload.readUInt16BE(offset + 10),
+      parent: payload.toString('hex', offset + 12, offset + 20),
+      dioReceived: payload.readUInt32BE(offset + 20),
+      dioInconsistent: payload.readUInt32BE(offset + 24),
+      daoSent: payload.readUInt32BE(offset + 28),
+    });
+  }
+  return {
+    timeMs: payload.readUInt32BE(2),
+    nextSeq: payload.readUInt32BE(6),
+    oldestSeq: payload.readUInt32BE(10),
+    dioReceived: payload.readUInt32BE(14),
+    dioInconsistent: payload.readUInt32BE(18),
+    daoSent: payload.readUInt32BE(22),
+    daoAcked: payload.readUInt32BE(26),
+    events,
+  };
+}
+
+/**
+ * Version of the channel policy record served on the 'chpol' CoAP
+ * resource of CHANNEL_POLICY_ENABLE builds, see
+ * CHANNEL_POLICY_RECORD_VERSION in firmware/src/channel_policy.c
+ */
+const CHANNEL_POLICY_RECORD_VERSION = 1;
+const CHANNEL_POLICY_MASK_LEN = 32;
+const CHANNEL_POLICY_HEADER_LEN = 8 + CHANNEL_POLICY_MASK_LEN;
+const CHANNEL_POLICY_ENTRY_LEN = 8;
+
+/**
+ * This function takes a channel policy record and decodes the unicast
+ * channels the node excluded and the failures seen per channel. The
+ * failure ratio is an average over the past periods, the counts are of
+ * the period in progress.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the record is malformed or of another version
+ */
+function parseChannelPolicy(payload) {
+  if (
+    payload.length < CHANNEL_POLICY_HEADER_LEN ||
+    payload.readUInt8(0) !== CHANNEL_POLICY_RECORD_VERSION
+  ) {
+    return null;
+  }
+  const numChannels = payload.readUInt8(1);
+  if (payload.length < CHANNEL_POLICY_HEADER_LEN + CHANNEL_POLICY_ENTRY_LEN * numChannels) {
+    return null;
+  }
+  const excludedChannels = [];
+  for (let channel = 0; channel < CHANNEL_POLICY_MASK_LEN * 8; channel++) {
+    if (payload.readUInt8(8 + Math.floor(channel / 8)) & (1 << channel % 8)) {
+      excludedChannels.push(channel);
+    }
+  }
+  const channels = [];
+  for (let i = 0; i < numChannels; i++) {
+    const offset = CHANNEL_POLICY_HEADER_LEN + CHANNEL_POLICY_ENTRY_LEN * i;
+    channels.push({
+      channel: payload.readUInt8(offset),
+      failurePercent: payload.readUInt8(offset + 1),
+      frames: payload.readUInt16BE(offset + 2),
+      ccaFailures: payload.readUInt16BE(offset + 4),
+      noAck: payload.readUInt16BE(offset + 6),
+    });
+  }
+  return {
+    excluded: payload.readUInt8(2),
+    allowed: payload.readUInt8(3),
+    periodSeconds: payload.readUInt16BE(4),
+    excludePercent: payload.readUInt8(6),
+    holdPeriods: payload.readUInt8(7),
+    excludedChannels,
+    channels,
+  };
+}
+
+/**
+ * Schema of the self describing metrics payloads, see
+ * METRICS_TLV_SCHEMA_VERSION in firmware/src/metrics_tlv.h
+ */
+const METRICS_TLV_SCHEMA_VERSION = 2;
+
+/**
+ * Names of the MAC perf data fields in the order of the stack's
+ * struct, the same order the test metrics are read in
+ */
+const MAC_PERF_NAMES = [
+  'macAsyncReq0',
+  'macAsyncReq1',
+  'macAsyncReq2',
+  'macAsyncReq3',
+  'macTxBroadcast',
+  'macTxUnicast',
+  'macTxConfOk',
+  'macTxConfNoAck',
+  'macTxConfNoEntry',
+  'macTxConfChannelBusy',
+  'macTxConfOther',
+  'macRxAsyncInd0',
+  'macRxAsyncInd1',
+  'macRxAsyncInd2',
+  'macRxAsyncInd3',
+  'macRxInd',
+];
+
+/**
+ * Fields inside a 'neighbors' entry
+ */
+const METRICS_NEIGHBOR_FIELDS = [
+  {id: 0x01, name: 'mac', type: 'hex'},
+  {id: 0x02, name: 'rssiIn'},
+  {id: 0x03, name: 'rssiOut'},
+];
+
+/**
+ * Fields of the metrics payloads by ID. Integers are the default type,
+ * a count makes a range of IDs named from names or numbered after name,
+ * counter marks the fields telemetry sends as changes. Fields the node
+ * left out are 0, or absent for ranges without names, records and hex.
+ */
+const METRICS_FIELDS = [
+  {id: 0x01, name: 'revision'},
+  {id: 0x02, name: 'heapSize'},
+  {id: 0x03, name: 'heapAllocated'},
+  {id: 0x04, name: 'heapAllocatedMax'},
+  {id: 0x05, name: 'rank'},
+  {id: 0x06, name: 'udpReceived', counter: true},
+  {id: 0x07, name: 'uptimeSeconds'},
+  {id: 0x08, name: 'seq'},
+  {id: 0x09, name: 'flags'},
+  {id: 0x0a, name: 'intervalSeconds'},
+  {id: 0x10, count: 5, name: 'joinTime'},
+  {id: 0x20, name: 'brDisconnects', counter: true},
+  {id: 0x21, name: 'devTableSize'},
+  {id: 0x22, name: 'fhNtNumNodes'},
+  {id: 0x40, count: 16, name: 'macPerf', names: MAC_PERF_NAMES, counter: true},
+  {id: 0x60, name: 'mplLatency', type: 'record', decode: buffer => parseMplLatency(buffer)},
+  {id: 0x61, name: 'taskStats', type: 'record', decode: buffer => parseTaskStats(buffer)},
+  {id: 0x70, name: 'neighbors', type: 'nested', fields: METRICS_NEIGHBOR_FIELDS},
+];
+
+/**
+ * This function builds the ID lookup of a field table, ranges
+ * are expanded to one entry per ID.
+ * @param {Object[]} fields
+ * @returns {Map<number, Object>}
+ */
+function metricsFieldsById(fields) {
+  const byId = new Map();
+  for (const field of fields) {
+    for (let i = 0; i < (field.count || 1); i++) {
+      const names = field.names || [];
+      const name = field.count ? names[i] || `${field.name}${i}` : field.name;
+      byId.set(field.id + i, {
+        ...field,
+        name,
+        named: !field.count || i < names.length,
+        fieldsById: field.fields && metricsFieldsById(field.fields),
+      });
+    }
+  }
+  return byId;
+}
+const METRICS_FIELDS_BY_ID = metricsFieldsById(METRICS_FIELDS);
+
+/**
+ * This function decodes the fields of a TLV buffer with a field
+ * table. IDs not in the table are skipped, so newer nodes can add
+ * fields without breaking older servers.
+ * @param {Buffer} buffer fields, without the schema version
+ * @param {Map<number, Object>} fieldsById from metricsFieldsById
+ * @returns {Object|null} null if a field runs past the buffer
+ */
+function decodeMetricsFields(buffer, fieldsById) {
+  const result = {};
+  for (const field of fieldsById.values()) {
+    if (field.type === 'nested') {
+      result[field.name] = [];
+    } else if (!field.type && field.named) {
+      result[field.name] = 0;
+    }
+  }
+
+  let offset = 0;
+  while (offset < buffer.length) {
+    const id = buffer.readUInt8(offset++);
+    let length = 0;
+    let shift = 0;
+    let byte;
+    do {
+      if (offset >= buffer.length || shift > 14) {
+        return null;
+      }
+      byte = buffer.readUInt8(offset++);
+      length += (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    if (offset + length > buffer.length) {
+      return null;
+    }
+    const value = buffer.subarray(offset, offset + length);
+    offset += length;
+
+    const field = fieldsById.get(id);
+    if (!field) {
+      continue;
+    }
+    if (field.type === 'hex') {
+      result[field.name] = value.toString('hex');
+    } else if (field.type === 'record') {
+      result[field.name] = field.decode(value);
+    } else if (field.type === 'nested') {
+      const entry = decodeMetricsFields(value, field.fieldsById);
+      if (!entry) {
+        return null;
+      }
+      result[field.name].push(entry);
+    } else if (length > 0 && length <= 6) {
+      result[field.name] = value.readUIntBE(0, length);
+    }
+  }
+  return result;
+}
+
+/**
+ * This function decodes a self describing metrics payload, as sent
+ * by the 'metrics' and 'rssi' CoAP resources and the telemetry push.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the payload is malformed or of another schema
+ */
+function parseMetrics(payload) {
+  if (payload.length < 1 || payload.readUInt8(0) !== METRICS_TLV_SCHEMA_VERSION) {
+    return null;
+  }
+  return decodeMetricsFields(payload.subarray(1), METRICS_FIELDS_BY_ID);
+}
+
+/**
+ * This function decodes the neighbors of an 'rssi' payload.
+ * @param {Buffer} payload
+ * @returns {Object[]|null} [{mac, rssiIn, rssiOut}], null if malformed
+ */
+function parseNeighborMetrics(payload) {
+  const metrics = parseMetrics(payload);
+  return metrics ? metrics.neighbors : null;
+}
+
+const TELEMETRY_FLAG_KEYFRAME = 0x01;
+
+/**
+ * This function decodes a telemetry datagram. In a keyframe the
+ * counters hold their values, otherwise the change since the
+ * previous datagram, 0 for the counters the node left out.
+ * @param {Buffer} payload
+ * @returns {Object|null} null if the datagram is malformed or of another schema
+ */
+function parseTelemetry(payload) {
+  const metrics = parseMetrics(payload);
+  if (!metrics) {
+    return null;
+  }
+  const keyframe = (metrics.flags & TELEMETRY_FLAG_KEYFRAME) !== 0;
+  const counters = {};
+  for (const field of METRICS_FIELDS_BY_ID.values()) {
+    if (field.counter && field.name in metrics) {
+      const value = metrics[field.name];
+      // Changes are zigzag encoded, small changes either way stay short
+      counters[field.name] = keyframe ? value : value % 2 ? -(value + 1) / 2 : value / 2;
+    }
+  }
+  return {
+    keyframe,
+    seq: metrics.seq,
+    uptimeSeconds: metrics.uptimeSeconds,
+    intervalSeconds: metrics.intervalSeconds,
+    heapSize: metrics.heapSize,
+    heapAllocated: metrics.heapAllocated,
+    heapAllocatedMax: metrics.heapAllocatedMax,
+    rank: metrics.rank,
+    devTableSize: metrics.devTableSize,
+    fhNtNumNodes: metrics.fhNtNumNodes,
+    counters,
+  };
+}
+
+const TIME_SYNC_VERSION = 1;
+const TIME_SYNC_TYPE_REQUEST = 1;
+const TIME_SYNC_REQUEST_LEN = 12;
+
+/**
+ * This function decodes a time request of a TIME_SYNC_ENABLE node,
+ * version(1) type(1) seq(2) t1(8). t1 is in the node's clock and
+ * is only echoed, so it is kept as the raw bytes.
+ * @param {Buffer} payload
+ * @returns {Object|null} {seq, t1}, null if malformed or of another version
+ */
+function parseTimeSyncRequest(payload) {
+  if (
+    payload.length < TIME_SYNC_REQUEST_LEN ||
+    payload[0] !== TIME_SYNC_VERSION ||
+    payload[1] !== TIME_SYNC_TYPE_REQUEST
+  ) {
+    return null;
+  }
+  return {seq: payload.readUInt16BE(2), t1: payload.subarray(4, 12)};
+}
+
+/**
+ * Read an 8 byte ms timestamp of the synchronized node clock
+ * @param {Buffer} payload
+ * @param {number} offset
+ * @returns {number|null} ms since the Unix epoch, null if not there
+ */
+function readSyncedTime(payload, offset) {
+  if (payload.length < offset + 8) {
+    return null;
+  }
+  return Number(payload.readBigUInt64BE(offset)) || null;
+}
+
+/**
+ * Read a 4 byte trace ID
+ * @param {Buffer} payload
+ * @param {number} offset
+ * @returns {string|null} 8 hex digits, null if not there
+ */
+function readTraceId(payload, offset) {
+  if (payload.length < offset + 4 || !payload.readUInt32BE(offset)) {
+    return null;
+  }
+  return payload.toString('hex', offset, offset + 4);
+}
+
+/**
+ * This function decodes the payload of an fsr_activated request,
+ * direction(1) event time(8) trace ID(4). Older nodes send the
+ * direction alone or with the event time, which is 0 when the
+ * node's clock is not synchronized.
+ * @param {Buffer} payload
+ * @returns {Object|null} {direction, eventTime, traceId}, null for the fields not sent
+ */
+function parseFsrEvent(payload) {
+  if (payload.length < 1) {
+    return null;
+  }
+  return {
+    direction: payload[0],
+    eventTime: readSyncedTime(payload, 1),
+    traceId: readTraceId(payload, 9),
+  };
+}
+
+/**
+ * This function decodes the response to activate_light, empty or
+ * the time the light went on(8) and the trace ID(4) of the request.
+ * The time is 0 when the light stayed off or its clock is not
+ * synchronized, older nodes leave out the trace ID.
+ * @param {Buffer} payload
+ * @returns {Object} {onTime, traceId}, null for the fields not sent
+ */
+function parseLightAck(payload) {
+  return {onTime: readSyncedTime(payload, 0), traceId: readTraceId(payload, 8)};
+}
+
+/**
+ * This function decodes a line of the trace log, see traceStage()
+ * in coapServer.js
+ * @param {string} line
+ * @returns {Object|null} {trace, stage, time, ...}, null for other lines
+ */
+function parseTraceLine(line) {
+  const match = line.match(/<TRACE>\s*(\{.*\})\s*$/);
+  if (!match) {
+    return null;
+  }
+  try {
+    const entry = JSON.parse(match[1]);
+    if (typeof entry.trace !== 'string' || typeof entry.stage !== 'string') {
+      return null;
+    }
+    return Number.isFinite(entry.time) ? entry : null;
+  } catch (error) {
+    return null;
+  }
+}
+
 module.exports = {
   parseConnectedDevices,
   parseDodagRoute,
@@ -202,4 +944,21 @@ module.exports = {
   parseMacFilterList,
   parseNCPIPv6,
   parseChList,
+  parseVendorOptions,
+  macFromDuid,
+  parseKeaLegalLine,
+  mplLatencyBucketHigh,
+  parseMplLatency,
+  parseTaskStats,
+  parseHeapTrack,
+  parseLinkQuality,
+  parseRplEvents,
+  parseChannelPolicy,
+  parseTelemetry,
+  parseMetrics,
+  parseNeighborMetrics,
+  parseTimeSyncRequest,
+  parseFsrEvent,
+  parseLightAck,
+  parseTraceLine,
 };
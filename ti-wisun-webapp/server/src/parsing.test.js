@@ -1,4 +1,23 @@
-const {parseNCPIPv6, canonicalIPtoExpandedIP, expandedIPToCanonicalIP} = require('./parsing');
+const {
+  parseNCPIPv6,
+  canonicalIPtoExpandedIP,
+  expandedIPToCanonicalIP,
+  parseKeaLegalLine,
+  mplLatencyBucketHigh,
+  parseMplLatency,
+  parseTaskStats,
+  parseHeapTrack,
+  parseLinkQuality,
+  parseRplEvents,
+  parseChannelPolicy,
+  parseTelemetry,
+  parseMetrics,
+  parseNeighborMetrics,
+  parseTimeSyncRequest,
+  parseFsrEvent,
+  parseLightAck,
+  parseTraceLine,
+} = require('./parsing');
 const {repeatNTimes} = require('./utils');
 
 /**
@@ -56,3 +75,426 @@ function testExpandedIPToCanonicalIP() {
   console.log(result, canonicalIP);
   console.log(result === canonicalIP);
 }
+
+/**
+ * Test that Kea forensic log lines with the wisun formats are parsed
+ */
+function testParseKeaLegalLine() {
+  const vendorLine =
+    '2024-05-01 10:00:00 CDT wisun-vendor duid=0003001b00124b0014f82b8f ' +
+    'opts=000001260001000366737200020005312e302e3000030002000900040001' +
+    '04';
+  const leaseLine =
+    '2024-05-01 10:00:00 CDT wisun-lease duid=0003001b00124b0014f82b8f ' +
+    'addr=2020:abcd::2 valid=4000';
+
+  const vendor = parseKeaLegalLine(vendorLine);
+  console.log(
+    JSON.stringify(vendor) ===
+      JSON.stringify({
+        type: 'vendor',
+        duid: '0003001b00124b0014f82b8f',
+        vendorOptions: {
+          deviceClass: 'fsr',
+          firmwareVersion: '1.0.0',
+          capabilities: 9,
+          channelCount: 4,
+        },
+      })
+  );
+
+  const lease = parseKeaLegalLine(leaseLine);
+  console.log(
+    JSON.stringify(lease) ===
+      JSON.stringify({
+        type: 'lease',
+        duid: '0003001b00124b0014f82b8f',
+        address: '2020:abcd::2',
+        valid: 4000,
+      })
+  );
+
+  console.log(parseKeaLegalLine('2024-05-01 10:00:00 CDT Address: 2020:abcd::2') === null);
+}
+testParseKeaLegalLine();
+
+/**
+ * Test that an MPL latency histogram record from a node is decoded
+ */
+function testParseMplLatency() {
+  const record = Buffer.from(
+    '0103' + // version, sub bits
+      '00000003' + // count
+      '0000000a' + // min
+      '00000118' + // max
+      '00000064' + // mean
+      '0000000a' + // p50
+      '00000118' + // p90
+      '00000118' + // p99
+      '02' + // bucket entries
+      '0a0002' + // bucket 10 (10 ms) x2
+      '300001', // bucket 48 (256-287 ms) x1
+    'hex'
+  );
+  const result = parseMplLatency(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify({
+        subBits: 3,
+        count: 3,
+        min: 10,
+        max: 280,
+        mean: 100,
+        p50: 10,
+        p90: 280,
+        p99: 280,
+        buckets: [
+          {index: 10, count: 2},
+          {index: 48, count: 1},
+        ],
+      })
+  );
+  console.log(parseMplLatency(record.subarray(0, 33)) === null);
+  console.log(mplLatencyBucketHigh(15, 3) === 15);
+  console.log(mplLatencyBucketHigh(16, 3) === 17);
+  console.log(mplLatencyBucketHigh(48, 3) === 287);
+  console.log(mplLatencyBucketHigh(127, 3) === 262143);
+}
+testParseMplLatency();
+
+/**
+ * Test that the task stack and CPU record is decoded
+ */
+function testParseTaskStats() {
+  const record = Buffer.from(
+    '0102' + // version, tasks
+      '0d05' + // cpu load 33.33%
+      '01' + // priority 1
+      '0400' + // stack 1024
+      '0058' + // 88 bytes free
+      '0c1c' + // 31%
+      '00' + // idle task
+      '0200' + // stack 512
+      '0130' + // 304 bytes free
+      '1a0a', // 66.66%
+    'hex'
+  );
+  const result = parseTaskStats(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify({
+        cpuLoad: 33.33,
+        tasks: [
+          {priority: 1, stackSize: 1024, stackFree: 88, cpuLoad: 31},
+          {priority: 0, stackSize: 512, stackFree: 304, cpuLoad: 66.66},
+        ],
+      })
+  );
+  console.log(parseTaskStats(record.subarray(0, 10)) === null);
+}
+testParseTaskStats();
+
+/**
+ * Test that the heap record is decoded
+ * and that a truncated record is rejected
+ */
+function testParseHeapTrack() {
+  const record = Buffer.from(
+    '0101' + // version, sites
+      '0003' + // 3 free blocks
+      '00000800' + // largest 2048
+      '00008000' + // heap 32768
+      '00004000' + // 16384 allocated
+      '00006000' + // max 24576
+      '00000002' + // 2 failures
+      '00012345' + // site
+      '00000200' + // 512 live
+      '00000300' + // peak 768
+      '00000010' + // 16 allocs
+      '0004', // 4 blocks
+    'hex'
+  );
+  const result = parseHeapTrack(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify({
+        freeBlocks: 3,
+        largestFreeBlock: 2048,
+        heapSize: 32768,
+        allocatedBytes: 16384,
+        allocatedBytesMax: 24576,
+        allocFailures: 2,
+        sites: [
+          {address: '0x00012345', liveBytes: 512, peakBytes: 768, allocs: 16, liveBlocks: 4},
+        ],
+      })
+  );
+  console.log(parseHeapTrack(record.subarray(0, 30)) === null);
+}
+testParseHeapTrack();
+
+/**
+ * Test that the link quality record is decoded, including a neighbor
+ * without samples, and that a truncated record is rejected
+ */
+function testParseLinkQuality() {
+  const record = Buffer.from(
+    '010202' + // version, neighbors, samples per history
+      '0212f40001020304' + // EUI-64
+      'fc40' + // in -60 dBm
+      'fba0' + // out -70 dBm
+      '0140' + // ETX 2.5
+      '0007' + // 7 ok
+      '0001' + // 1 failed
+      '02c4c2' + // -60, -62
+      '010300' + // 3 attempts
+      '0212f40005060708' +
+      '8000' + // no samples yet
+      '8000' +
+      '0000' +
+      '0000' +
+      '0000' +
+      '000000' +
+      '000000',
+    'hex'
+  );
+  const result = parseLinkQuality(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify([
+        {
+          eui64: '0212f40001020304',
+          rssiIn: -60,
+          rssiOut: -70,
+          etx: 2.5,
+          txOk: 7,
+          txFailed: 1,
+          rssiHistory: [-60, -62],
+          txHistory: [3],
+        },
+        {
+          eui64: '0212f40005060708',
+          rssiIn: null,
+          rssiOut: null,
+          etx: null,
+          txOk: 0,
+          txFailed: 0,
+          rssiHistory: [],
+          txHistory: [],
+        },
+      ])
+  );
+  console.log(parseLinkQuality(record.subarray(0, 40)) === null);
+}
+testParseLinkQuality();
+
+/**
+ * Test that the RPL event record is decoded
+ * and that a truncated record is rejected
+ */
+function testParseRplEvents() {
+  const record = Buffer.from(
+    '0101' + // version, events
+      '00002710' + // read at 10 s
+      '00000006' + // next sequence 6
+      '00000002' + // oldest sequence 2
+      '00000040' + // 64 DIOs
+      '00000003' + // 3 inconsistent
+      '00000009' + // 9 DAOs
+      '00000008' + // 8 DAO-ACKs
+      '00000005' + // sequence 5
+      '00001f40' + // at 8 s
+      '03' + // parent and rank
+      'f0' + // DODAG version 240
+      '0280' + // rank 640
+      '0212f40001020304' + // parent
+      '00000030' + // 48 DIOs
+      '00000002' + // 2 inconsistent
+      '00000007', // 7 DAOs
+    'hex'
+  );
+  const result = parseRplEvents(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify({
+        timeMs: 10000,
+        nextSeq: 6,
+        oldestSeq: 2,
+        dioReceived: 64,
+        dioInconsistent: 3,
+        daoSent: 9,
+        daoAcked: 8,
+        events: [
+          {
+            seq: 5,
+            timeMs: 8000,
+            parentChanged: true,
+            rankChanged: true,
+            versionChanged: false,
+            detached: false,
+            dodagVersion: 240,
+            rank: 640,
+            parent: '0212f40001020304',
+            dioReceived: 48,
+            dioInconsistent: 2,
+            daoSent: 7,
+          },
+        ],
+      })
+  );
+  console.log(parseRplEvents(record.subarray(0, 40)) === null);
+}
+testParseRplEvents();
+
+/**
+ * Test that the channel policy record is decoded
+ * and that a truncated record is rejected
+ */
+function testParseChannelPolicy() {
+  const record = Buffer.from(
+    '0102' + // version, channels
+      '0180' + // 1 excluded, 128 allowed
+      '003c' + // 60 s periods
+      '28' + // exclude from 40%
+      '0a' + // hold 10 periods
+      '2000' + // channel 5 excluded
+      '00'.repeat(30) +
+      '05330000000000' + // channel 5, 51%, no frames while excluded
+      '00' +
+      '06050014' + // channel 6, 5%, 20 frames
+      '00010002', // 1 CCA failure, 2 without ACK
+    'hex'
+  );
+  const result = parseChannelPolicy(record);
+  console.log(
+    JSON.stringify(result) ===
+      JSON.stringify({
+        excluded: 1,
+        allowed: 128,
+        periodSeconds: 60,
+        excludePercent: 40,
+        holdPeriods: 10,
+        excludedChannels: [5],
+        channels: [
+          {channel: 5, failurePercent: 51, frames: 0, ccaFailures: 0, noAck: 0},
+          {channel: 6, failurePercent: 5, frames: 20, ccaFailures: 1, noAck: 2},
+        ],
+      })
+  );
+  console.log(parseChannelPolicy(record.subarray(0, 50)) === null);
+}
+testParseChannelPolicy();
+
+/**
+ * Test that metrics payloads are decoded by field ID, that left out
+ * fields read as 0, that unknown IDs are skipped and that truncated
+ * fields are rejected
+ */
+function testParseMetrics() {
+  const payload = Buffer.from(
+    '02' + // schema version
+      '700d' + // neighbor, 13 bytes
+      '010800124b0014f82af0' + // MAC
+      '0301c8' + // rssi out 200, rssi in left out
+      '41021234' + // macAsyncReq1
+      'ff0100' + // unknown to this server
+      '4203010000' + // macAsyncReq2
+      '21020102' + // devTableSize, 16 bits of its own
+      '220103', // fhNtNumNodes
+    'hex'
+  );
+  const metrics = parseMetrics(payload);
+  console.log(
+    JSON.stringify(metrics.neighbors) ===
+      JSON.stringify([{rssiIn: 0, rssiOut: 200, mac: '00124b0014f82af0'}])
+  );
+  console.log(metrics.macAsyncReq0 === 0);
+  console.log(metrics.macAsyncReq1 === 0x1234);
+  console.log(metrics.macAsyncReq2 === 0x10000);
+  console.log(metrics.devTableSize === 0x102 && metrics.fhNtNumNodes === 3);
+  console.log(metrics.rank === 0 && !('joinTime0' in metrics) && !('taskStats' in metrics));
+  console.log(parseNeighborMetrics(payload).length === 1);
+  console.log(parseMetrics(payload.subarray(0, payload.length - 1)) === null);
+  // Schema 1 packed the 16-bit MAC debug counts into one 32-bit field
+  console.log(parseMetrics(Buffer.from('01', 'hex')) === null);
+}
+testParseMetrics();
+
+/**
+ * Test that telemetry keyframes hold the counter values and that the
+ * other datagrams hold zigzag encoded changes, with the counters that
+ * did not change left out
+ */
+function testParseTelemetry() {
+  const keyframe = parseTelemetry(
+    Buffer.from('020901010a013c07020e1002021000050202000601054002012c200107210110', 'hex')
+  );
+  console.log(keyframe.keyframe === true && keyframe.seq === 0);
+  console.log(keyframe.uptimeSeconds === 3600 && keyframe.intervalSeconds === 60);
+  console.log(keyframe.heapSize === 4096 && keyframe.heapAllocated === 0 && keyframe.rank === 512);
+  console.log(
+    keyframe.counters.udpReceived === 5 &&
+      keyframe.counters.macAsyncReq0 === 300 &&
+      keyframe.counters.macRxInd === 0 &&
+      keyframe.counters.brDisconnects === 7
+  );
+  console.log(keyframe.devTableSize === 16 && keyframe.fhNtNumNodes === 0);
+  const delta = parseTelemetry(
+    Buffer.from('020801010a013c07020e100202100005020200060114410104200101210110', 'hex')
+  );
+  console.log(delta.keyframe === false && delta.seq === 1);
+  console.log(
+    delta.counters.udpReceived === 10 &&
+      delta.counters.macAsyncReq0 === 0 &&
+      delta.counters.macAsyncReq1 === 2 &&
+      delta.counters.brDisconnects === -1 &&
+      !('devTableSize' in delta.counters) &&
+      delta.devTableSize === 16
+  );
+}
+testParseTelemetry();
+
+/**
+ * Test the time request of a node and the synchronized timestamps
+ * of the FSR events and light acknowledgements, which older nodes
+ * leave out
+ */
+function testParseSyncedTimes() {
+  const request = parseTimeSyncRequest(Buffer.from('01010007000000000001d4c1', 'hex'));
+  console.log(request.seq === 7 && request.t1.toString('hex') === '000000000001d4c1');
+  console.log(parseTimeSyncRequest(Buffer.from('01020007000000000001d4c1', 'hex')) === null);
+  console.log(parseTimeSyncRequest(Buffer.from('0101000700', 'hex')) === null);
+
+  const fsrEvent = parseFsrEvent(Buffer.from('020000018f0e3c5a10', 'hex'));
+  console.log(fsrEvent.direction === 2 && fsrEvent.eventTime === 1713930787344);
+  const oldFsrEvent = parseFsrEvent(Buffer.from('01', 'hex'));
+  console.log(oldFsrEvent.direction === 1 && oldFsrEvent.eventTime === null);
+  console.log(parseFsrEvent(Buffer.alloc(0)) === null);
+
+  console.log(parseLightAck(Buffer.from('0000018f0e3c5b0a', 'hex')).onTime === 1713930787594);
+  console.log(parseLightAck(Buffer.alloc(0)).onTime === null);
+}
+testParseSyncedTimes();
+
+/**
+ * Test the trace IDs of the FSR events and light acknowledgements,
+ * with the event time 0 of a node whose clock is not synchronized,
+ * and the lines of the trace log
+ */
+function testParseTraceIds() {
+  const fsrEvent = parseFsrEvent(Buffer.from('03000000000000000089abcdef', 'hex'));
+  console.log(
+    fsrEvent.direction === 3 && fsrEvent.eventTime === null && fsrEvent.traceId === '89abcdef'
+  );
+  const lightAck = parseLightAck(Buffer.from('0000018f0e3c5b0a89abcdef', 'hex'));
+  console.log(lightAck.onTime === 1713930787594 && lightAck.traceId === '89abcdef');
+  console.log(parseLightAck(Buffer.from('000000000000000000000000', 'hex')).traceId === null);
+
+  const entry = parseTraceLine(
+    '[2024.04.24 10:00:00 - info] <TRACE> \t{"trace":"89abcdef","stage":"received","time":1000}'
+  );
+  console.log(entry.trace === '89abcdef' && entry.stage === 'received' && entry.time === 1000);
+  console.log(parseTraceLine('[2024.04.24 10:00:00 - info] <HTTP> {"trace":"89abcdef"}') === null);
+  console.log(parseTraceLine('[2024.04.24 10:00:00 - info] <TRACE> {"trace":') === null);
+}
+testParseTraceIds();
@@ -9,7 +9,7 @@ const {sendDBusMessage} = require('./dbusCommands.js');
 const {CONSTANTS} = require('./AppConstants');
 const {SerialPort} = require('serialport');
 const {postLEDStates, getOADFirmwareVersion, startOAD, turnOnLightManual} = require('./coapCommands.js');
-const {deviceOperations, relationshipOperations} = require('./database.js');
+const {deviceOperations, relationshipOperations, telemetryOperations} = require('./database.js');
 const multer = require('multer');
 const fs = require('fs');
 
@@ -562,6 +562,33 @@ function initializeRoutes(app, pingExecutor, borderRouterManager, io) {
     }
   });
 
+  /**
+   * Telemetry pushed by the nodes, see TelemetryCollector.js
+   */
+  // Get the names of the metrics received
+  app.get('/api/telemetry', async (req, res) => {
+    try {
+      res.json(await telemetryOperations.getMetricNames());
+    } catch (error) {
+      httpLogger.error(`Error fetching telemetry metrics: ${error.message}`);
+      res.status(500).json({ error: error.message });
+    }
+  });
+
+  // Get the samples of a metric, ?since=<ms> (default the last hour) and ?ip=<node>
+  app.get('/api/telemetry/:metric', async (req, res) => {
+    const since = req.query.since ? parseInt(req.query.since, 10) : Date.now() - 60 * 60 * 1000;
+    if (Number.isNaN(since)) {
+      return res.status(400).json({ error: 'since must be a time in ms' });
+    }
+    try {
+      res.json(await telemetryOperations.getSamples(req.params.metric, since, req.query.ip));
+    } catch (error) {
+      httpLogger.error(`Error fetching telemetry: ${error.message}`);
+      res.status(500).json({ error: error.message });
+    }
+  });
+
   // Serve static files for device images
   app.use('/data/images', express.static(path.join(__dirname, '../data/images')));
 }
@@ -0,0 +1,200 @@
+const coap = require('coap');
+const {Command} = require('commander');
+const {parseRplEvents} = require('./parsing.js');
+const {getTopologyIPs, forEachNode} = require('./mplLatencyReport.js');
+
+/**
+ * RPL topology change timeline.
+ *
+ * Nodes built with RPL_EVENTS_ENABLE log their parent, rank and DODAG
+ * version changes in a ring served on the 'rplev' CoAP resource. This
+ * script follows the ring of every node with a sequence number cursor,
+ * so each poll only carries the events that are new, and prints them as
+ * one timeline with the DIO/DAO activity in between.
+ *
+ * Nodes are taken from the topology of the running webapp unless
+ * addresses are given on the command line:
+ *   npm run rpl-timeline -- [-w http://localhost:80] [-i 10] [--once] [ip...]
+ */
+const RPL_EVENTS_URI = 'rplev';
+
+/**
+ * Drift allowed between the node time and the wall clock time that
+ * passed between two reads, beyond it the node has restarted
+ */
+const RPL_CLOCK_TOLERANCE_MS = 5000;
+
+/**
+ * This function reads the events of a node after the cursor
+ * and resolves with the parsed record, or null if the node
+ * did not answer in time.
+ * @param {string} targetIP
+ * @param {number} since
+ * @param {number} timeoutMs
+ * @returns {Promise<Object|null>}
+ */
+function rplEventsRequest(targetIP, since, timeoutMs) {
+  return new Promise(resolve => {
+    const reqOptions = {
+      observe: false,
+      host: targetIP,
+      pathname: RPL_EVENTS_URI,
+      query: `since=${since}`,
+      method: 'get',
+      confirmable: true,
+      retrySend: 0,
+      options: {},
+    };
+    const timer = setTimeout(() => resolve(null), timeoutMs);
+    const request = coap.request(reqOptions);
+    request.on('response', response => {
+      clearTimeout(timer);
+      resolve(response.code === '2.05' ? parseRplEvents(response.payload) : null);
+    });
+    // BOTH OF THESE ARE REQUIRED -> COAP ERRORS OUT OTHERWISE
+    request.on('timeout', () => {});
+    request.on('error', () => {});
+    request.end();
+  });
+}
+
+/**
+ * This function turns the events of a record into timeline
+ * entries and advances the cursor of the node. Node times are
+ * mapped to wall clock time through the time of the read.
+ * @param {Object} node cursor, last event and last read time of the node
+ * @param {Object} record parsed with parseRplEvents
+ * @param {number} receivedAt wall clock time of the response in ms
+ * @returns {Object[]} entries, with notes for reboots and lost events
+ */
+function advanceTimeline(node, record, receivedAt) {
+  const entries = [];
+  const note = text => entries.push({time: receivedAt, note: text});
+
+  // The node time runs with the wall clock between reads. If it went back or jumped, the node
+  // restarted, even when its new log has already passed the cursor. A log behind the cursor
+  // also means a restart. The log is then read from its start.
+  const clock = node.clock;
+  node.clock = {timeMs: record.timeMs, receivedAt};
+  const drift = clock ? ((record.timeMs - clock.timeMs) | 0) - (receivedAt - clock.receivedAt) : 0;
+  if (Math.abs(drift) > RPL_CLOCK_TOLERANCE_MS || record.nextSeq - 1 < node.cursor) {
+    note('node restarted, event log read from its start');
+    node.cursor = 0;
+    node.last = null;
+  }
+  const first = record.events.length ? record.events[0].seq : record.nextSeq;
+  // Events read after an old cursor skip the start of the new log, they are read again from it
+  if (node.cursor === 0 && first > record.oldestSeq) {
+    return entries;
+  }
+  if (first > node.cursor + 1 && node.cursor > 0) {
+    note(`${first - node.cursor - 1} events overwritten before they were read`);
+  }
+  for (const event of record.events) {
+    const last = node.last;
+    entries.push({
+      // Node times are 32 bits and wrap, so the age is taken modulo 2^32
+      time: receivedAt - ((record.timeMs - event.timeMs) >>> 0),
+      event,
+      dioReceived: last ? event.dioReceived - last.dioReceived : null,
+      daoSent: last ? event.daoSent - last.daoSent : null,
+    });
+    node.last = event;
+    node.cursor = event.seq;
+  }
+  return entries;
+}
+
+/**
+ * This function formats one timeline entry.
+ * @param {string} ip
+ * @param {Object} entry
+ * @returns {string}
+ */
+function formatEntry(ip, entry) {
+  const prefix = `${new Date(entry.time).toISOString()} ${ip}`;
+  if (entry.note) {
+    return `${prefix} -- ${entry.note}`;
+  }
+  const event = entry.event;
+  if (event.detached) {
+    return `${prefix} #${event.seq} detached`;
+  }
+  const changes = [
+    event.parentChanged && 'parent',
+    event.rankChanged && 'rank',
+    event.versionChanged && 'version',
+  ].filter(change => change);
+  const activity =
+    entry.dioReceived === null ? '' : ` (+${entry.dioReceived} DIO, +${entry.daoSent} DAO)`;
+  return (
+    `${prefix} #${event.seq} ${changes.join('+')}: parent ${event.parent} ` +
+    `rank ${event.rank} version ${event.dodagVersion}${activity}`
+  );
+}
+
+async function main() {
+  const program = new Command();
+  program
+    .option('-w, --webapp <url>', 'Webapp to read the node list from', 'http://localhost:80')
+    .option('-t, --timeout <seconds>', 'Time to wait for each node', '10')
+    .option('-i, --interval <seconds>', 'Time between polls of the nodes', '10')
+    .option('-o, --once', 'Read the logs once and exit')
+    .option('-j, --json', 'Print the timeline entries as JSON lines')
+    .argument('[ips...]', 'Node addresses, instead of the webapp topology');
+  program.parse(process.argv);
+  const options = program.opts();
+  const timeoutMs = parseInt(options.timeout, 10) * 1000;
+  const intervalMs = parseInt(options.interval, 10) * 1000;
+  const nodes = new Map();
+
+  for (;;) {
+    const ips = program.args.length ? program.args : await getTopologyIPs(options.webapp);
+    const batches = await forEachNode(ips, async ip => {
+      if (!nodes.has(ip)) {
+        nodes.set(ip, {cursor: 0, last: null, clock: null});
+      }
+      const node = nodes.get(ip);
+      const entries = [];
+      // A response holds as many events as fit, read on until the node has no newer ones
+      for (;;) {
+        const record = await rplEventsRequest(ip, node.cursor, timeoutMs);
+        if (!record) {
+          break;
+        }
+        entries.push(...advanceTimeline(node, record, Date.now()));
+        if (record.events.length === 0 || node.cursor >= record.nextSeq - 1) {
+          break;
+        }
+      }
+      return entries.map(entry => ({ip, ...entry}));
+    });
+
+    batches
+      .flat()
+      .sort((a, b) => a.time - b.time)
+      .forEach(entry => {
+        if (options.json) {
+          console.log(JSON.stringify(entry));
+        } else {
+          console.log(formatEntry(entry.ip, entry));
+        }
+      });
+    if (options.once) {
+      return;
+    }
+    await new Promise(resolve => setTimeout(resolve, intervalMs));
+  }
+}
+
+if (require.main === module) {
+  main().then(
+    () => process.exit(0),
+    e => {
+      console.error(e.message);
+      process.exit(1);
+    }
+  );
+}
+
+module.exports = {advanceTimeline, formatEntry};
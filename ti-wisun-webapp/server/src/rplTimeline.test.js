@@ -0,0 +1,52 @@
+const {advanceTimeline} = require('./rplTimeline');
+
+/**
+ * Build a parsed rplev record with events firstSeq..nextSeq - 1
+ */
+function record(timeMs, firstSeq, nextSeq) {
+  const events = [];
+  for (let seq = firstSeq; seq < nextSeq; seq++) {
+    events.push({seq, timeMs: timeMs - (nextSeq - seq) * 1000, dioReceived: seq, daoSent: seq});
+  }
+  return {timeMs, nextSeq, oldestSeq: 1, events};
+}
+
+/**
+ * Test that the cursor follows the log across reads, and that a node
+ * whose time went back is read from the start of its log again, even
+ * when its new log has already passed the cursor
+ */
+function testRestart() {
+  const node = {cursor: 0, last: null, clock: null};
+  const start = 1700000000000;
+
+  let entries = advanceTimeline(node, record(60000, 1, 4), start);
+  console.log(entries.length === 3 && node.cursor === 3);
+
+  // 10 s later on both clocks, events 4 and 5 are new
+  entries = advanceTimeline(node, record(70000, 4, 6), start + 10000);
+  console.log(entries.length === 2 && !entries.some(entry => entry.note) && node.cursor === 5);
+
+  // Rebooted 8 s ago with 7 events already, the read after cursor 5 only has 6 and 7
+  entries = advanceTimeline(node, record(8000, 6, 8), start + 20000);
+  console.log(entries.length === 1 && entries[0].note !== undefined && node.cursor === 0);
+
+  // The next read from the start gets the whole new log
+  entries = advanceTimeline(node, record(8100, 1, 8), start + 20100);
+  console.log(entries.length === 7 && entries[6].event.seq === 7 && node.cursor === 7);
+}
+
+/**
+ * Test that a node time wrapping around 2^32 is not taken for a restart
+ */
+function testWrap() {
+  const node = {cursor: 0, last: null, clock: null};
+  const start = 1700000000000;
+
+  advanceTimeline(node, record(0xffffe000, 1, 3), start);
+  const entries = advanceTimeline(node, record(0x2000, 3, 4), start + 0x4000);
+  console.log(entries.length === 1 && entries[0].event.seq === 3 && node.cursor === 3);
+}
+
+testRestart();
+testWrap();
@@ -0,0 +1,225 @@
+const fs = require('fs');
+const path = require('path');
+const {Command} = require('commander');
+const {parseTraceLine} = require('./parsing.js');
+
+/**
+ * FSR event latency waterfalls.
+ *
+ * Every FSR event carries a trace ID from the sensor node through the
+ * server to the lights it turns on. The server logs the time each event
+ * reaches a stage to trace.log, the node stages come from their
+ * synchronized clocks (TIME_SYNC_ENABLE). This script prints the
+ * waterfall of the latest events and the percentiles of each stage.
+ *
+ *   npm run trace-waterfall -- [-n 10] [--json] [trace.log...]
+ */
+const TRACE_LOG_PATH = '/tmp/ti-wisun-webapp/logs/trace.log';
+
+/**
+ * Stages of an event up to the server turning to the lights
+ */
+const EVENT_STAGES = ['event', 'received', 'sensorFound', 'relationshipsFound'];
+
+/**
+ * Stages of each light the event turns on
+ */
+const ACTUATOR_STAGES = ['actuatorFound', 'dispatched', 'applied', 'acked'];
+
+/**
+ * The time between two stages, named after what happens in it
+ */
+const SPANS = [
+  {name: 'uplink (sensor, mesh)', from: 'event', to: 'received'},
+  {name: 'sensor lookup (db)', from: 'received', to: 'sensorFound'},
+  {name: 'relationships (db)', from: 'sensorFound', to: 'relationshipsFound'},
+  {name: 'actuator lookup (db)', from: 'relationshipsFound', to: 'actuatorFound'},
+  {name: 'activation (db)', from: 'actuatorFound', to: 'dispatched'},
+  {name: 'downlink (mesh, light)', from: 'dispatched', to: 'applied'},
+];
+
+/**
+ * The light answers once it is on, the round trip overlaps the
+ * downlink and is left out of the total
+ */
+const ACK_SPAN = {name: 'light ack (round trip)', from: 'dispatched', to: 'acked'};
+
+const BAR_WIDTH = 50;
+
+/**
+ * This function groups trace log entries by event, with the
+ * light stages kept per actuator
+ * @param {Object[]} entries from parseTraceLine
+ * @returns {Map<string, Object>} trace ID to {stages, actuators, ip}
+ */
+function collectTraces(entries) {
+  const traces = new Map();
+  for (const entry of entries) {
+    if (!traces.has(entry.trace)) {
+      traces.set(entry.trace, {trace: entry.trace, stages: {}, actuators: new Map()});
+    }
+    const trace = traces.get(entry.trace);
+    if (entry.ip && !trace.ip) {
+      trace.ip = entry.ip;
+    }
+    if (EVENT_STAGES.includes(entry.stage)) {
+      trace.stages[entry.stage] = entry.time;
+    } else if (entry.actuator && ACTUATOR_STAGES.includes(entry.stage)) {
+      if (!trace.actuators.has(entry.actuator)) {
+        trace.actuators.set(entry.actuator, {});
+      }
+      trace.actuators.get(entry.actuator)[entry.stage] = entry.time;
+    }
+  }
+  return traces;
+}
+
+/**
+ * This function lays out the path of an event to each of its lights,
+ * or to the server alone when it turned on none
+ * @param {Object} trace from collectTraces
+ * @returns {Object[]} [{trace, ip, actuator, start, spans: [{name, start, duration}]}]
+ */
+function traceWaterfalls(trace) {
+  const actuators = trace.actuators.size ? [...trace.actuators] : [[null, {}]];
+  return actuators.map(([actuator, actuatorStages]) => {
+    const times = {...trace.stages, ...actuatorStages};
+    const spans = [...SPANS, ACK_SPAN]
+      .filter(span => span.from in times && span.to in times)
+      .map(span => ({
+        name: span.name,
+        start: times[span.from],
+        duration: times[span.to] - times[span.from],
+      }));
+    const known = Object.values(times);
+    return {trace: trace.trace, ip: trace.ip, actuator, start: Math.min(...known), spans};
+  });
+}
+
+/**
+ * This function returns a percentile of sorted values, nearest rank
+ * @param {number[]} sorted
+ * @param {number} percent
+ * @returns {number}
+ */
+function percentile(sorted, percent) {
+  const rank = Math.ceil((percent / 100) * sorted.length);
+  return sorted[Math.min(Math.max(rank, 1), sorted.length) - 1];
+}
+
+/**
+ * This function summarizes the duration of each stage over the waterfalls,
+ * the stages before the lights are counted once per event
+ * @param {Object[]} waterfalls from traceWaterfalls
+ * @returns {Object[]} [{name, count, p50, p99, max}] in stage order
+ */
+function stagePercentiles(waterfalls) {
+  const durations = new Map([...SPANS, ACK_SPAN].map(span => [span.name, []]));
+  const eventSpans = new Set(
+    SPANS.filter(span => EVENT_STAGES.includes(span.to)).map(span => span.name)
+  );
+  const seen = new Set();
+  const totals = [];
+  for (const waterfall of waterfalls) {
+    const firstOfEvent = !seen.has(waterfall.trace);
+    seen.add(waterfall.trace);
+    for (const span of waterfall.spans) {
+      if (firstOfEvent || !eventSpans.has(span.name)) {
+        durations.get(span.name).push(span.duration);
+      }
+    }
+    const stages = waterfall.spans.filter(span => span.name !== ACK_SPAN.name);
+    if (stages.length === SPANS.length) {
+      const last = stages[stages.length - 1];
+      totals.push(last.start + last.duration - stages[0].start);
+    }
+  }
+  durations.set('total (event to light on)', totals);
+  return [...durations]
+    .filter(([, values]) => values.length)
+    .map(([name, values]) => {
+      const sorted = values.sort((a, b) => a - b);
+      return {
+        name,
+        count: sorted.length,
+        p50: percentile(sorted, 50),
+        p99: percentile(sorted, 99),
+        max: sorted[sorted.length - 1],
+      };
+    });
+}
+
+/**
+ * This function prints a waterfall, each stage as a bar placed
+ * at its start in the event
+ * @param {Object} waterfall
+ */
+function printWaterfall(waterfall) {
+  const end = Math.max(waterfall.start, ...waterfall.spans.map(span => span.start + span.duration));
+  const scale = BAR_WIDTH / Math.max(end - waterfall.start, 1);
+  const target = waterfall.actuator ? ` -> ${waterfall.actuator}` : '';
+  console.log(
+    `trace ${waterfall.trace} ${new Date(waterfall.start).toISOString()} ` +
+      `${waterfall.ip || ''}${target}, ${end - waterfall.start} ms`
+  );
+  for (const span of waterfall.spans) {
+    const offset = Math.round((span.start - waterfall.start) * scale);
+    const width = Math.max(Math.round(span.duration * scale), 1);
+    console.log(
+      `  ${span.name.padEnd(26)}${String(span.duration).padStart(7)} ms ` +
+        `|${' '.repeat(offset)}${'#'.repeat(width)}`
+    );
+  }
+}
+
+/**
+ * This function prints one line of the stage table.
+ * @param {Object} stage
+ */
+function printRow(stage) {
+  const columns = ['count', 'p50', 'p99', 'max'].map(key => String(stage[key]).padStart(8));
+  console.log(`${stage.name.padEnd(28)}${columns.join('')}`);
+}
+
+async function main() {
+  const program = new Command();
+  program
+    .option('-n, --events <count>', 'Waterfalls of this many latest events', '10')
+    .option('-j, --json', 'Print the waterfalls and percentiles as JSON')
+    .argument('[files...]', `Trace logs, ${TRACE_LOG_PATH} by default`);
+  program.parse(process.argv);
+  const options = program.opts();
+  const files = program.args.length ? program.args : [TRACE_LOG_PATH];
+
+  const entries = [];
+  for (const file of files) {
+    const lines = fs.readFileSync(path.resolve(file), 'utf8').split('\n');
+    entries.push(...lines.map(parseTraceLine).filter(entry => entry));
+  }
+  const waterfalls = [...collectTraces(entries).values()]
+    .flatMap(traceWaterfalls)
+    .sort((a, b) => a.start - b.start);
+  const stats = stagePercentiles(waterfalls);
+  const latest = waterfalls.slice(-parseInt(options.events, 10));
+
+  if (options.json) {
+    console.log(JSON.stringify({waterfalls: latest, stages: stats}, null, 2));
+    return;
+  }
+  latest.forEach(printWaterfall);
+  console.log('');
+  printRow({name: 'stage', count: 'count', p50: 'p50', p99: 'p99', max: 'max'});
+  stats.forEach(printRow);
+}
+
+if (require.main === module) {
+  main().then(
+    () => process.exit(0),
+    e => {
+      console.error(e.message);
+      process.exit(1);
+    }
+  );
+}
+
+module.exports = {collectTraces, traceWaterfalls, stagePercentiles};
@@ -143,6 +143,15 @@ TEST_METRICS_CURR_RANK_INDEX           = TEST_METRICS_NUM_UDP_PKTS_INDEX + TEST_
 NODE_TYPE_BR   = 1
 NODE_TYPE_COAP = 2
 
+# The CoAP nodes send their metrics as ID/length/value fields, see firmware/src/metrics_tlv.h.
+# The offsets above are only used for the BR metrics read over Spinel.
+METRICS_TLV_SCHEMA_VERSION = 2
+METRICS_TLV_JOIN_TIME_IDS  = list(range(0x10, 0x15))
+# Field IDs in the order of the CSV columns: revision, join times, BR disconnects, device table
+# size, FH NT num nodes, heap size, current and highest heap use, MAC perf data, UDP packets, rank
+METRICS_TLV_CSV_IDS = ([0x01] + METRICS_TLV_JOIN_TIME_IDS + [0x20, 0x21, 0x22, 0x02, 0x03, 0x04] +
+                       list(range(0x40, 0x50)) + [0x06, 0x05])
+
 # COAP constants
 COAP_PORT    = 5683
 DEFAULT_TKL  = 8
@@ -701,6 +710,45 @@ class SpinelCliCmd(Cmd, SpinelCodec):
 
         return test_metrics_data
 
+    def parseMetricsTlv(self, payload):
+        # Fields are ID(1) length(varint) value(length), integers big endian, left out when 0
+        if len(payload) < 1 or payload[0] != METRICS_TLV_SCHEMA_VERSION:
+            print("Error: unknown Test Metrics schema {}".format(payload[0] if len(payload) else None))
+            return []
+        fields = {}
+        index = 1
+        while index < len(payload):
+            field_id = payload[index]
+            index += 1
+            length = 0
+            shift = 0
+            while True:
+                if index >= len(payload):
+                    print("Error: truncated Test Metrics field")
+                    return []
+                byte = payload[index]
+                index += 1
+                length |= (byte & 0x7f) << shift
+                shift += 7
+                if not (byte & 0x80):
+                    break
+            if index + length > len(payload):
+                print("Error: truncated Test Metrics field")
+                return []
+            # IDs this script does not know, and the records, are skipped
+            if field_id in METRICS_TLV_CSV_IDS:
+                fields[field_id] = int.from_bytes(bytes(payload[index:index + length]), "big")
+            index += length
+
+        test_metrics_data = []
+        for field_id in METRICS_TLV_CSV_IDS:
+            value = fields.get(field_id, 0)
+            # Joining time (in ticks - 1 tick = 10uSec)
+            if field_id in METRICS_TLV_JOIN_TIME_IDS:
+                value = value/100000
+            test_metrics_data.append(value)
+        return test_metrics_data
+
     def saveTestMetrics (self, test_metrics_data, file_name):
         with open(file_name, "a") as test_data:
             for metric in range (len(test_metrics_data)):
@@ -1060,7 +1108,7 @@ class SpinelCliCmd(Cmd, SpinelCodec):
                             if len(p.payload) > 1:
                                 test_metrics_data.append(pkt.ipv6_header.source_address)
                                 # Parse Payload data and add to the array
-                                test_metrics_data.extend(self.parsePayLoadData(p.payload, NODE_TYPE_COAP))
+                                test_metrics_data.extend(self.parseMetricsTlv(p.payload))
 
                                 # Write all test metrics data to file
                                 self.saveTestMetrics(test_metrics_data, TEST_METRICS_FILE_NAME)